@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <random>
+#include <fstream>
+#include <json.hpp>
+#include <version.h>
+#include <command_args.h>
+#include <dsp/bench/throughput.h>
+#include <dsp/filter/fir.h>
+#include <dsp/taps/windowed_sinc.h>
+#include <dsp/multirate/power_decimator.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/channel/rx_vfo.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/loop/agc.h>
+#include <dsp/loop/pll.h>
+#include <dsp/loop/costas.h>
+#include <dsp/loop/pll_bank.h>
+#include <dsp/loop/costas_bank.h>
+#include <dsp/clock_recovery/mm.h>
+#include <dsp/clock_recovery/fd.h>
+#include <dsp/clock_recovery/multi_mm.h>
+#include <dsp/noise_reduction/fm_if.h>
+#include <dsp/noise_reduction/noise_blanker.h>
+#include <dsp/compression/sample_stream_compressor.h>
+#include <dsp/compression/sample_stream_decompressor.h>
+#include <dsp/math/phasor.h>
+
+using nlohmann::json;
+
+// Every benchmark uses the same synthetic signals, generated with a fixed seed so that runs are comparable across commits
+struct Signals {
+    dsp::complex_t* noise;  // Complex white noise with a tone
+    float* real;            // Real white noise with a tone
+    dsp::complex_t* bpsk;   // BPSK at 10 samples per symbol
+    float* fsk;             // Two level FSK baseband at 10 samples per symbol
+    dsp::complex_t* wfm;    // Stereo broadcast FM with a 57KHz RDS subcarrier at 250KS/s
+    dsp::complex_t* impulsive; // Complex white noise with random impulses, eg. ignition noise
+    uint8_t* compressed;    // noise compressed to int16
+    int compressedSize;
+};
+
+Signals sig;
+dsp::complex_t* outBuf;
+float* outBufReal;
+dsp::stereo_t* outBufStereo;
+uint8_t* outBufBytes;
+
+void generateSignals(int count) {
+    std::mt19937 rng(0x5D2B);
+    std::normal_distribution<float> gauss(0.0f, 0.1f);
+    std::uniform_int_distribution<int> bit(0, 1);
+
+    // Separate generator so that adding signals doesn't change the existing ones
+    std::mt19937 impulseRng(0x1A7E);
+    std::uniform_int_distribution<int> impulse(0, 49);
+
+    sig.noise = dsp::buffer::alloc<dsp::complex_t>(count);
+    sig.real = dsp::buffer::alloc<float>(count);
+    sig.bpsk = dsp::buffer::alloc<dsp::complex_t>(count);
+    sig.fsk = dsp::buffer::alloc<float>(count);
+    sig.wfm = dsp::buffer::alloc<dsp::complex_t>(count);
+    sig.impulsive = dsp::buffer::alloc<dsp::complex_t>(count);
+
+    int sym = 1;
+    double fmPhase = 0.0;
+    for (int i = 0; i < count; i++) {
+        dsp::complex_t tone = dsp::math::phasor(0.1f * (float)i);
+        sig.noise[i] = tone * 0.5f + dsp::complex_t{ gauss(rng), gauss(rng) };
+        sig.real[i] = 0.5f * tone.re + gauss(rng);
+
+        if (!(i % 10)) { sym = bit(rng) ? 1 : -1; }
+        sig.bpsk[i] = dsp::complex_t{ (float)sym, 0.0f } * dsp::math::phasor(0.01f * (float)i) + dsp::complex_t{ gauss(rng), gauss(rng) };
+        sig.fsk[i] = (float)sym + gauss(rng);
+        sig.impulsive[i] = dsp::complex_t{ gauss(impulseRng), gauss(impulseRng) } * (impulse(impulseRng) ? 1.0f : 200.0f);
+
+        // FM multiplex: L+R tone, 19KHz pilot, L-R tone on 38KHz and a 57KHz subcarrier
+        double t = (double)i / 250000.0;
+        double mpx = 0.4 * sin(2.0 * DB_M_PI * 1000.0 * t);
+        mpx += 0.1 * sin(2.0 * DB_M_PI * 19000.0 * t);
+        mpx += 0.3 * sin(2.0 * DB_M_PI * 3000.0 * t) * sin(2.0 * DB_M_PI * 38000.0 * t);
+        mpx += 0.05 * sin(2.0 * DB_M_PI * 57000.0 * t) * (double)sym;
+        fmPhase += 2.0 * DB_M_PI * 75000.0 * mpx / 250000.0;
+        sig.wfm[i] = dsp::math::phasor((float)fmPhase);
+    }
+
+    sig.compressed = dsp::buffer::alloc<uint8_t>(count * sizeof(dsp::complex_t) + 8);
+    sig.compressedSize = dsp::compression::SampleStreamCompressor::process(count, dsp::compression::PCM_TYPE_I16, sig.noise, sig.compressed);
+}
+
+struct Benchmark {
+    std::string name;
+    std::function<dsp::bench::ThroughputResult(int durationMs, int count)> run;
+};
+
+std::vector<Benchmark> benchmarks;
+
+void defineBenchmarks() {
+    for (int tapCount : { 16, 64, 256, 1024 }) {
+        benchmarks.push_back({ "fir_c32_" + std::to_string(tapCount) + "taps", [=](int durationMs, int count) {
+            dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 0.1 * DB_M_PI, dsp::window::nuttall);
+            dsp::filter::FIR<dsp::complex_t, float> fir(NULL, taps);
+            auto res = dsp::bench::measureThroughput(durationMs, count, [&](int n) { fir.process(n, sig.noise, outBuf); });
+            dsp::taps::free(taps);
+            return res;
+        } });
+        benchmarks.push_back({ "fir_f32_" + std::to_string(tapCount) + "taps", [=](int durationMs, int count) {
+            dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 0.1 * DB_M_PI, dsp::window::nuttall);
+            dsp::filter::FIR<float, float> fir(NULL, taps);
+            auto res = dsp::bench::measureThroughput(durationMs, count, [&](int n) { fir.process(n, sig.real, outBufReal); });
+            dsp::taps::free(taps);
+            return res;
+        } });
+    }
+
+    for (int ratio : { 2, 4, 8, 16, 32, 64 }) {
+        benchmarks.push_back({ "power_decimator_" + std::to_string(ratio), [=](int durationMs, int count) {
+            dsp::multirate::PowerDecimator<dsp::complex_t> decim(NULL, ratio);
+            return dsp::bench::measureThroughput(durationMs, count, [&](int n) { decim.process(n, sig.noise, outBuf); });
+        } });
+    }
+
+    std::vector<std::pair<double, double>> resampRates = { { 48000.0, 44100.0 }, { 250000.0, 48000.0 }, { 2400000.0, 250000.0 }, { 10000000.0, 48000.0 } };
+    for (auto [inSr, outSr] : resampRates) {
+        benchmarks.push_back({ "rational_resampler_" + std::to_string((int)inSr) + "_" + std::to_string((int)outSr), [=](int durationMs, int count) {
+            dsp::multirate::RationalResampler<dsp::complex_t> resamp(NULL, inSr, outSr);
+            return dsp::bench::measureThroughput(durationMs, count, [&](int n) { resamp.process(n, sig.noise, outBuf); });
+        } });
+    }
+
+    std::vector<std::pair<double, double>> vfoRates = { { 2400000.0, 250000.0 }, { 10000000.0, 250000.0 }, { 10000000.0, 12500.0 } };
+    for (auto [inSr, outSr] : vfoRates) {
+        benchmarks.push_back({ "rx_vfo_" + std::to_string((int)inSr) + "_" + std::to_string((int)outSr), [=](int durationMs, int count) {
+            dsp::channel::RxVFO vfo(NULL, inSr, outSr, outSr * 0.8, inSr / 10.0);
+            return dsp::bench::measureThroughput(durationMs, count, [&](int n) { vfo.process(n, sig.noise, outBuf); });
+        } });
+    }
+
+    benchmarks.push_back({ "quadrature", [](int durationMs, int count) {
+        dsp::demod::Quadrature demod(NULL, 75000.0, 250000.0);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { demod.process(n, sig.wfm, outBufReal); });
+    } });
+
+    benchmarks.push_back({ "broadcast_fm_mono", [](int durationMs, int count) {
+        dsp::demod::BroadcastFM demod;
+        demod.init(NULL, 75000.0, 250000.0, false, true, false);
+        int rdsCount;
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { demod.process(n, sig.wfm, outBufStereo, rdsCount); });
+    } });
+
+    benchmarks.push_back({ "broadcast_fm_stereo_rds", [](int durationMs, int count) {
+        dsp::demod::BroadcastFM demod;
+        demod.init(NULL, 75000.0, 250000.0, true, true, true);
+        int rdsCount;
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { demod.process(n, sig.wfm, outBufStereo, rdsCount, outBuf); });
+    } });
+
+    benchmarks.push_back({ "agc_c32", [](int durationMs, int count) {
+        dsp::loop::AGC<dsp::complex_t> agc(NULL, 1.0, 1e-3, 1e-4, 1e6, 10.0);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { agc.process(n, sig.noise, outBuf); });
+    } });
+
+    benchmarks.push_back({ "agc_c32_impulsive", [](int durationMs, int count) {
+        dsp::loop::AGC<dsp::complex_t> agc(NULL, 1.0, 1e-3, 0.5, 1e6, 10.0);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { agc.process(n, sig.impulsive, outBuf); });
+    } });
+
+    benchmarks.push_back({ "noise_blanker_scale", [](int durationMs, int count) {
+        dsp::noise_reduction::NoiseBlanker nb(NULL, 500.0 / 24000.0, 5.0, dsp::noise_reduction::NoiseBlanker::MODE_SCALE);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { nb.process(n, sig.impulsive, outBuf); });
+    } });
+
+    benchmarks.push_back({ "noise_blanker_interpolate", [](int durationMs, int count) {
+        dsp::noise_reduction::NoiseBlanker nb(NULL, 500.0 / 24000.0, 5.0, dsp::noise_reduction::NoiseBlanker::MODE_INTERPOLATE);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { nb.process(n, sig.impulsive, outBuf); });
+    } });
+
+    benchmarks.push_back({ "agc_f32", [](int durationMs, int count) {
+        dsp::loop::AGC<float> agc(NULL, 1.0, 1e-3, 1e-4, 1e6, 10.0);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { agc.process(n, sig.real, outBufReal); });
+    } });
+
+    benchmarks.push_back({ "pll", [](int durationMs, int count) {
+        dsp::loop::PLL pll(NULL, 0.01);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { pll.process(n, sig.bpsk, outBuf); });
+    } });
+
+    benchmarks.push_back({ "costas_2", [](int durationMs, int count) {
+        dsp::loop::Costas<2> costas(NULL, 0.01);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { costas.process(n, sig.bpsk, outBuf); });
+    } });
+
+    benchmarks.push_back({ "costas_4", [](int durationMs, int count) {
+        dsp::loop::Costas<4> costas(NULL, 0.01);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { costas.process(n, sig.bpsk, outBuf); });
+    } });
+
+    // Same total number of samples as the single loop benchmarks, split between the channels
+    benchmarks.push_back({ "pll_bank_32ch", [](int durationMs, int count) {
+        const int channels = 32;
+        dsp::loop::PLLBank pll(channels, 0.01);
+        std::vector<const dsp::complex_t*> ins(channels);
+        std::vector<dsp::complex_t*> outs(channels);
+        int chanCount = count / channels;
+        for (int i = 0; i < channels; i++) {
+            ins[i] = &sig.bpsk[i * chanCount];
+            outs[i] = &outBuf[i * chanCount];
+        }
+        return dsp::bench::measureThroughput(durationMs, chanCount * channels, [&](int n) { pll.process(n / channels, ins.data(), outs.data()); });
+    } });
+
+    benchmarks.push_back({ "costas_bank_4_32ch", [](int durationMs, int count) {
+        const int channels = 32;
+        dsp::loop::CostasBank<4> costas(channels, 0.01);
+        std::vector<const dsp::complex_t*> ins(channels);
+        std::vector<dsp::complex_t*> outs(channels);
+        int chanCount = count / channels;
+        for (int i = 0; i < channels; i++) {
+            ins[i] = &sig.bpsk[i * chanCount];
+            outs[i] = &outBuf[i * chanCount];
+        }
+        return dsp::bench::measureThroughput(durationMs, chanCount * channels, [&](int n) { costas.process(n / channels, ins.data(), outs.data()); });
+    } });
+
+    benchmarks.push_back({ "clock_recovery_mm_c32", [](int durationMs, int count) {
+        dsp::clock_recovery::MM<dsp::complex_t> mm(NULL, 10.0, 1e-6, 0.01, 0.01);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { mm.process(n, sig.bpsk, outBuf); });
+    } });
+
+    benchmarks.push_back({ "clock_recovery_mm_f32", [](int durationMs, int count) {
+        dsp::clock_recovery::MM<float> mm(NULL, 10.0, 1e-6, 0.01, 0.01);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { mm.process(n, sig.fsk, outBufReal); });
+    } });
+
+    // Same total number of samples as the single channel benchmarks, split between the channels
+    benchmarks.push_back({ "clock_recovery_mm_multi_32ch", [](int durationMs, int count) {
+        const int channels = 32;
+        dsp::clock_recovery::MultiMM<dsp::complex_t> mm(channels, 10.0, 1e-6, 0.01, 0.01);
+        std::vector<const dsp::complex_t*> ins(channels);
+        std::vector<dsp::complex_t*> outs(channels);
+        std::vector<int> outCounts(channels);
+        int chanCount = count / channels;
+        for (int i = 0; i < channels; i++) {
+            ins[i] = &sig.bpsk[i * chanCount];
+            outs[i] = &outBuf[i * chanCount];
+        }
+        return dsp::bench::measureThroughput(durationMs, chanCount * channels, [&](int n) { mm.process(n / channels, ins.data(), outs.data(), outCounts.data()); });
+    } });
+
+    benchmarks.push_back({ "clock_recovery_fd", [](int durationMs, int count) {
+        dsp::clock_recovery::FD fd(NULL, 10.0, 1e-6, 0.01, 0.01);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { fd.process(n, sig.fsk, outBufReal); });
+    } });
+
+    for (int bins : { 15, 32 }) {
+        for (auto [quality, name] : std::vector<std::pair<dsp::noise_reduction::FMIF::Quality, std::string>>{ { dsp::noise_reduction::FMIF::QUALITY_HIGH, "high" }, { dsp::noise_reduction::FMIF::QUALITY_LOW, "low" } }) {
+            benchmarks.push_back({ "fm_if_nr_" + std::to_string(bins) + "bins_" + name, [=](int durationMs, int count) {
+                dsp::noise_reduction::FMIF fmnr(NULL, bins, quality);
+                return dsp::bench::measureThroughput(durationMs, count, [&](int n) { fmnr.process(n, sig.wfm, outBuf); });
+            } });
+        }
+    }
+
+    for (auto [type, name] : std::vector<std::pair<dsp::compression::PCMType, std::string>>{ { dsp::compression::PCM_TYPE_I8, "i8" }, { dsp::compression::PCM_TYPE_I16, "i16" }, { dsp::compression::PCM_TYPE_F32, "f32" } }) {
+        benchmarks.push_back({ "compressor_" + name, [=](int durationMs, int count) {
+            return dsp::bench::measureThroughput(durationMs, count, [&](int n) { dsp::compression::SampleStreamCompressor::process(n, type, sig.noise, outBufBytes); });
+        } });
+    }
+
+    benchmarks.push_back({ "decompressor_i16", [](int durationMs, int count) {
+        dsp::compression::SampleStreamDecompressor decomp(NULL);
+        return dsp::bench::measureThroughput(durationMs, count, [&](int n) { decomp.process(sig.compressedSize, sig.compressed, outBuf); });
+    } });
+}
+
+int main(int argc, char* argv[]) {
+    CommandArgsParser args;
+    args.define('b', "block", "Number of samples processed per call", 8192);
+    args.define('d', "duration", "Duration of each benchmark in milliseconds", 1000);
+    args.define('f', "filter", "Only run benchmarks whose name contains this string", "");
+    args.define('h', "help", "Show help");
+    args.define('l', "list", "List the benchmarks and exit");
+    args.define('o', "output", "Write the JSON report to this file instead of stdout", "");
+    if (args.parse(argc, argv) < 0) { return -1; }
+    if (args["help"].b()) {
+        args.showHelp();
+        return 0;
+    }
+
+    int blockSize = args["block"].i();
+    int durationMs = args["duration"].i();
+    std::string filter = args["filter"].s();
+    std::string output = args["output"].s();
+    if (blockSize <= 0 || blockSize > STREAM_BUFFER_SIZE) {
+        fprintf(stderr, "Block size must be between 1 and %d\n", STREAM_BUFFER_SIZE);
+        return -1;
+    }
+
+    defineBenchmarks();
+    if (args["list"].b()) {
+        for (const auto& bm : benchmarks) { printf("%s\n", bm.name.c_str()); }
+        return 0;
+    }
+
+    // Allocate buffers large enough for the largest interpolation ratio
+    generateSignals(blockSize);
+    outBuf = dsp::buffer::alloc<dsp::complex_t>(STREAM_BUFFER_SIZE);
+    outBufReal = dsp::buffer::alloc<float>(STREAM_BUFFER_SIZE);
+    outBufStereo = dsp::buffer::alloc<dsp::stereo_t>(STREAM_BUFFER_SIZE);
+    outBufBytes = dsp::buffer::alloc<uint8_t>(STREAM_BUFFER_SIZE * sizeof(dsp::complex_t) + 8);
+
+    json report;
+    report["version"] = VERSION_STR;
+    report["blockSize"] = blockSize;
+    report["durationMs"] = durationMs;
+    report["hardwareThreads"] = std::thread::hardware_concurrency();
+    report["results"] = json::array();
+
+    for (const auto& bm : benchmarks) {
+        if (!filter.empty() && bm.name.find(filter) == std::string::npos) { continue; }
+        fprintf(stderr, "Running %s... ", bm.name.c_str());
+        dsp::bench::ThroughputResult res = bm.run(durationMs, blockSize);
+        fprintf(stderr, "%.3lf MS/s, %.3lf ns/sample\n", res.samplesPerSecond / 1e6, res.nsPerSample);
+
+        json entry;
+        entry["name"] = bm.name;
+        entry["msps"] = res.samplesPerSecond / 1e6;
+        entry["nsPerSample"] = res.nsPerSample;
+        entry["iterations"] = res.iterations;
+        report["results"].push_back(entry);
+    }
+
+    // Write the report
+    std::string str = report.dump(4);
+    if (output.empty()) {
+        printf("%s\n", str.c_str());
+    }
+    else {
+        std::ofstream file(output);
+        file << str << std::endl;
+    }
+
+    return 0;
+}
@@ -15,10 +15,14 @@ void CommandArgsParser::defineAll() {
 
         define('a', "addr", "Server mode address", "0.0.0.0");
         define('h', "help", "Show help");
+        define('i', "instances", "Comma separated module instances to run in offline mode (default: all enabled)", "");
+        define('o', "offline", "Process an IQ WAV file as fast as possible and exit", "");
         define('p', "port", "Server mode port", 5259);
         define('r', "root", "Root directory, where all config files are stored", std::filesystem::absolute(root).string());
         define('s', "server", "Run in server mode");
         define('\0', "autostart", "Automatically start the SDR after loading");
+        define('\0', "log", "Also write the log to this file, rotated every 10MB", "");
+        define('\0', "loglevel", "Minimum log level, globally and/or per module (eg. 'info,scanner=warn')", "");
 }
 
 int CommandArgsParser::parse(int argc, char* argv[]) {
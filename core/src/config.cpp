@@ -45,11 +45,19 @@ void ConfigManager::load(json def, bool lock) {
 }
 
 void ConfigManager::save(bool lock) {
-    if (lock) { mtx.lock(); }
-    std::ofstream file(path.c_str());
-    file << conf.dump(4);
-    file.close();
-    if (lock) { mtx.unlock(); }
+    // Already locked by the caller, the config can't change while writing it
+    if (!lock) {
+        changed = false;
+        write(conf, ++generation);
+        return;
+    }
+
+    mtx.lock();
+    json snapshot = conf;
+    changed = false;
+    uint64_t gen = ++generation;
+    mtx.unlock();
+    write(snapshot, gen);
 }
 
 void ConfigManager::enableAutoSave() {
@@ -75,27 +83,55 @@ void ConfigManager::acquire() {
 }
 
 void ConfigManager::release(bool modified) {
-    changed |= modified;
+    if (modified) {
+        lastChange = std::chrono::steady_clock::now();
+        if (!changed) { firstChange = lastChange; }
+        changed = true;
+    }
     mtx.unlock();
 }
 
 void ConfigManager::autoSaveWorker() {
     while (autoSaveEnabled) {
-        if (!mtx.try_lock()) {
-            flog::warn("ConfigManager locked, waiting...");
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            continue;
-        }
-        if (changed) {
+        // Take a snapshot once the changes have settled, the lock is only held for the copy
+        json snapshot;
+        uint64_t gen = 0;
+        mtx.lock();
+        auto now = std::chrono::steady_clock::now();
+        if (changed && (now - lastChange >= SAVE_DEBOUNCE || now - firstChange >= SAVE_MAX_DELAY)) {
+            snapshot = conf;
             changed = false;
-            save(false);
+            gen = ++generation;
         }
         mtx.unlock();
+        if (gen) { write(snapshot, gen); }
 
         // Sleep but listen for wakeup call
         {
             std::unique_lock<std::mutex> lock(termMtx);
-            termCond.wait_for(lock, std::chrono::milliseconds(1000), [this]() { return termFlag; });
+            termCond.wait_for(lock, std::chrono::milliseconds(250), [this]() { return termFlag; });
         }
     }
+}
+
+void ConfigManager::write(const json& snapshot, uint64_t gen) {
+    std::lock_guard<std::mutex> lck(writeMtx);
+    if (gen <= writtenGeneration) { return; }
+    writtenGeneration = gen;
+
+    // Write to a temporary file and swap it in so that a crash never leaves a truncated config
+    std::string tmpPath = path + ".tmp";
+    std::ofstream file(tmpPath.c_str());
+    file << snapshot.dump(4);
+    file.close();
+    if (file.fail()) {
+        flog::error("Could not write config file '{}'", tmpPath);
+        return;
+    }
+
+    std::error_code err;
+    std::filesystem::rename(tmpPath, path, err);
+    if (err) {
+        flog::error("Could not replace config file '{}': {}", path, err.message());
+    }
 }
\ No newline at end of file
@@ -4,9 +4,16 @@
 #include <string>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 
 using nlohmann::json;
 
+/**
+ * JSON config file with autosave.
+ * Saving copies the config while locked, then serializes the copy and writes it to a temporary file renamed over the
+ * config without holding the lock, so threads touching the config only ever wait for the copy. Autosave waits for the
+ * changes to settle before saving.
+*/
 class ConfigManager {
 public:
     ConfigManager();
@@ -23,9 +30,22 @@ public:
 
 private:
     void autoSaveWorker();
+    void write(const json& snapshot, uint64_t gen);
+
+    // Autosave once nothing changed for SAVE_DEBOUNCE, or SAVE_MAX_DELAY after the first unsaved change
+    static constexpr std::chrono::milliseconds SAVE_DEBOUNCE = std::chrono::milliseconds(500);
+    static constexpr std::chrono::milliseconds SAVE_MAX_DELAY = std::chrono::milliseconds(5000);
 
     std::string path = "";
     volatile bool changed = false;
+    std::chrono::steady_clock::time_point firstChange;
+    std::chrono::steady_clock::time_point lastChange;
+
+    // Snapshot counter, so that an older snapshot never overwrites a newer one
+    uint64_t generation = 0;
+    uint64_t writtenGeneration = 0;
+    std::mutex writeMtx;
+
     volatile bool autoSaveEnabled = false;
     std::thread autoSaveThread;
     std::mutex mtx;
@@ -1,4 +1,5 @@
 #include <server.h>
+#include <offline.h>
 #include "imgui.h"
 #include <stdio.h>
 #include <gui/main_window.h>
@@ -12,6 +13,7 @@
 #include <config.h>
 #include <core.h>
 #include <filesystem>
+#include <sstream>
 #include <gui/menus/theme.h>
 #include <backend.h>
 
@@ -41,6 +43,9 @@ namespace core {
     void setInputSampleRate(double samplerate) {
         // Forward this to the server
         if (args["server"].b()) { server::setInputSampleRate(samplerate); return; }
+
+        // In offline mode there is no GUI to update
+        if (!((std::string)args["offline"]).empty()) { sigpath::iqFrontEnd.setSampleRate(samplerate); return; }
         
         // Update IQ frontend input samplerate and get effective samplerate
         sigpath::iqFrontEnd.setSampleRate(samplerate);
@@ -57,6 +62,27 @@ namespace core {
     }
 };
 
+// Parse a comma separated list of levels, either global ("warn") or for the messages of a module ("scanner=error")
+static void setLogLevels(const std::string& levels) {
+    std::stringstream ss(levels);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) { continue; }
+        size_t sep = item.find('=');
+        flog::Type level;
+        if (!flog::parseLevel(item.substr((sep == std::string::npos) ? 0 : (sep + 1)), level)) {
+            flog::error("Invalid log level '{0}'", item);
+            continue;
+        }
+        if (sep == std::string::npos) {
+            flog::setLevel(level);
+        }
+        else {
+            flog::setLevel(item.substr(0, sep), level);
+        }
+    }
+}
+
 // main
 int sdrpp_main(int argc, char* argv[]) {
     flog::info("SDR++ v" VERSION_STR);
@@ -78,10 +104,11 @@ int sdrpp_main(int argc, char* argv[]) {
     }
 
     bool serverMode = (bool)core::args["server"];
+    bool offlineMode = !((std::string)core::args["offline"]).empty();
 
 #ifdef _WIN32
     // Free console if the user hasn't asked for a console and not in server mode
-    if (!core::args["con"].b() && !serverMode) { FreeConsole(); }
+    if (!core::args["con"].b() && !serverMode && !offlineMode) { FreeConsole(); }
 
     // Set error mode to avoid abnoxious popups
     SetErrorMode(SEM_NOOPENFILEERRORBOX | SEM_NOGPFAULTERRORBOX | SEM_FAILCRITICALERRORS);
@@ -103,6 +130,14 @@ int sdrpp_main(int argc, char* argv[]) {
         return -1;
     }
 
+    // Configure logging, then hand the writing of the log over to a background thread
+    std::string logPath = core::args["log"];
+    if (!logPath.empty() && !flog::setFile(logPath)) {
+        flog::error("Could not open log file {0}", logPath);
+    }
+    setLogLevels(core::args["loglevel"]);
+    flog::startWriter();
+
     // ======== DEFAULT CONFIG ========
     json defConfig;
     defConfig["bandColors"]["amateur"] = "#FF0000FF";
@@ -356,11 +391,19 @@ int sdrpp_main(int argc, char* argv[]) {
 
     core::configManager.release(true);
 
-    if (serverMode) { return server::main(); }
+    if (serverMode) {
+        int ret = server::main();
+        flog::stopWriter();
+        return ret;
+    }
+    if (offlineMode) {
+        int ret = offline::main();
+        flog::stopWriter();
+        return ret;
+    }
 
     core::configManager.acquire();
     std::string resDir = core::configManager.conf["resourcesDirectory"];
-    json bandColors = core::configManager.conf["bandColors"];
     core::configManager.release();
 
     // Assert that the resource directory is absolute and check existence
@@ -385,14 +428,6 @@ int sdrpp_main(int argc, char* argv[]) {
     flog::info("Loading icons");
     if (!icons::load(resDir)) { return -1; }
 
-    LoadingScreen::show("Loading band plans");
-    flog::info("Loading band plans");
-    bandplan::loadFromDir(resDir + "/bandplans");
-
-    LoadingScreen::show("Loading band plan colors");
-    flog::info("Loading band plans color table");
-    bandplan::loadColorTable(bandColors);
-
     gui::mainWindow.init();
 
     flog::info("Ready.");
@@ -417,5 +452,6 @@ int sdrpp_main(int argc, char* argv[]) {
 #endif
 
     flog::info("Exiting successfully");
+    flog::stopWriter();
     return 0;
 }
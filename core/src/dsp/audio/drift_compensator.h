@@ -0,0 +1,346 @@
+#pragma once
+#include "../sink.h"
+#include "../math/sinc.h"
+#include "../math/constants.h"
+#include "../window/nuttall.h"
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+namespace dsp::audio {
+    /**
+     * Elastic buffer between the DSP and an audio device running on its own clock.
+     * Incoming audio goes through a fractional resampler whose ratio is servoed by a PI loop on the buffer fill level,
+     * so that the latency stays at its target indefinitely despite the drift between the two clocks.
+     * The producer side runs on the block thread (or process() for simulations), the consumer side is read(),
+     * which never blocks and is meant to be called from the device callback. Both sides are lock-free, only
+     * reconfiguration excludes the consumer, which outputs silence meanwhile. The buffers are only allocated on the
+     * first start.
+    */
+    class DriftCompensator : public Sink<stereo_t> {
+        using base_type = Sink<stereo_t>;
+
+        static constexpr int TAP_COUNT = 16;
+        static constexpr int PHASE_COUNT = 128;
+
+        // Time constant of the fill level smoothing, removes the jitter of bursty producers
+        static constexpr double FILL_SMOOTHING_TIME = 1.0;
+
+        // Natural frequency of the control loop in Hz, critically damped
+        static constexpr double LOOP_BANDWIDTH = 0.02;
+
+        // Maximum correction of the rate, way above any sound card drift
+        static constexpr double MAX_CORRECTION = 0.005;
+    public:
+        DriftCompensator() {}
+
+        DriftCompensator(stream<stereo_t>* in, double sampleRate, double latency) { init(in, sampleRate, latency); }
+
+        ~DriftCompensator() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(bank);
+            buffer::free(buffer);
+            buffer::free(resampBuf);
+            buffer::free(ring);
+        }
+
+        void init(stream<stereo_t>* in, double sampleRate, double latency) {
+            _sampleRate = sampleRate;
+            _latency = latency;
+
+            // Generate one windowed sinc per fractional phase, with an extra phase to interpolate the last one
+            bank = buffer::alloc<float>((PHASE_COUNT + 1) * TAP_COUNT);
+            const double cutoff = 0.9;
+            for (int p = 0; p <= PHASE_COUNT; p++) {
+                for (int k = 0; k < TAP_COUNT; k++) {
+                    double t = (double)(k - (TAP_COUNT / 2 - 1)) - ((double)p / (double)PHASE_COUNT);
+                    bank[p * TAP_COUNT + k] = cutoff * math::sinc(DB_M_PI * cutoff * t) * window::nuttall(t + (TAP_COUNT / 2), TAP_COUNT);
+                }
+            }
+
+            targetFill = _latency * _sampleRate;
+
+            base_type::init(in);
+        }
+
+        void setSampleRate(double sampleRate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            {
+                std::lock_guard<std::mutex> rlck(readMtx);
+                _sampleRate = sampleRate;
+                reconfigure();
+            }
+            base_type::tempStart();
+        }
+
+        void setLatency(double latency) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _latency = latency;
+
+            // If the ring is large enough (or not allocated yet), the consumer converges to the new target on its own
+            int fill = _latency * _sampleRate;
+            if (!ring || 3 * fill + STREAM_BUFFER_SIZE <= ringSize) {
+                targetFill = fill;
+                return;
+            }
+
+            // Otherwise, the ring is reallocated
+            base_type::tempStop();
+            {
+                std::lock_guard<std::mutex> rlck(readMtx);
+                reconfigure();
+            }
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            {
+                std::lock_guard<std::mutex> rlck(readMtx);
+                resetState();
+            }
+            base_type::tempStart();
+        }
+
+        /**
+         * Resample audio into the buffer, used by the block thread or directly for simulations.
+         * The buffers must have been allocated, either by starting the block or with allocate().
+         * @param count Number of input samples.
+         * @param in Input samples.
+         * @return Number of samples written to the buffer.
+        */
+        int process(int count, const stereo_t* in) {
+            // Track the size of the incoming blocks, a sample waits on average half a block before being delivered
+            double ba = blockAvg.load(std::memory_order_relaxed);
+            blockAvg.store(ba + 0.1 * ((double)count - ba), std::memory_order_relaxed);
+
+            // Use the last correction computed by the consumer
+            double step = 1.0 + correction.load(std::memory_order_relaxed);
+
+            // Resample
+            memcpy(bufStart, in, count * sizeof(stereo_t));
+            int outCount = 0;
+            while (offset < count) {
+                double pf = mu * (double)PHASE_COUNT;
+                int p = (int)pf;
+                float frac = pf - (double)p;
+                stereo_t a, b;
+                volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&a, (lv_32fc_t*)&buffer[offset], &bank[p * TAP_COUNT], TAP_COUNT);
+                volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&b, (lv_32fc_t*)&buffer[offset], &bank[(p + 1) * TAP_COUNT], TAP_COUNT);
+                resampBuf[outCount++] = a + ((b - a) * frac);
+
+                mu += step;
+                int adv = (int)mu;
+                offset += adv;
+                mu -= (double)adv;
+            }
+            offset -= count;
+            memmove(buffer, &buffer[count], (TAP_COUNT - 1) * sizeof(stereo_t));
+
+            // Write as much as fits in the ring, the consumer handles the overflow by skipping ahead
+            uint64_t w = writePos.load(std::memory_order_relaxed);
+            uint64_t r = readPos.load(std::memory_order_acquire);
+            int toWrite = std::min<int>(outCount, ringSize - (int)(w - r));
+            for (int i = 0; i < toWrite; i++) {
+                ring[(w + i) & ringMask] = resampBuf[i];
+            }
+            writePos.store(w + toWrite, std::memory_order_release);
+            if (outCount != toWrite) { overflows.fetch_add(1, std::memory_order_relaxed); }
+            return toWrite;
+        }
+
+        /**
+         * Read audio at the device clock rate, never blocks.
+         * @param out Output samples.
+         * @param count Number of samples requested by the device.
+         * @return Number of samples output, always equal to count, padded with silence in case of underrun.
+        */
+        int read(stereo_t* out, int count) {
+            // Output silence while being reconfigured or before the first start
+            std::unique_lock<std::mutex> lck(readMtx, std::try_to_lock);
+            if (!lck.owns_lock() || !ring) {
+                memset(out, 0, count * sizeof(stereo_t));
+                return count;
+            }
+
+            uint64_t r = readPos.load(std::memory_order_relaxed);
+            uint64_t w = writePos.load(std::memory_order_acquire);
+            int fill = w - r;
+            int targetFill = this->targetFill.load(std::memory_order_relaxed);
+
+            // Wait for the buffer to be filled up to the target before starting or after an underrun
+            if (!primed) {
+                if (fill < targetFill + count) {
+                    memset(out, 0, count * sizeof(stereo_t));
+                    return count;
+                }
+                primed = true;
+                fillAvg.store(fill, std::memory_order_relaxed);
+                integral = 0.0;
+            }
+
+            // Skip ahead if way too much audio has accumulated (producer stall, device stopped)
+            if (fill > 2 * targetFill + count) {
+                r = w - targetFill;
+                fill = targetFill;
+                fillAvg.store(fill, std::memory_order_relaxed);
+                integral = 0.0;
+                skips.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Update the control loop on the device clock
+            updateLoop(fill, targetFill, count);
+
+            // Copy out what is available
+            int toRead = std::min<int>(fill, count);
+            for (int i = 0; i < toRead; i++) {
+                out[i] = ring[(r + i) & ringMask];
+            }
+            if (toRead < count) {
+                memset(&out[toRead], 0, (count - toRead) * sizeof(stereo_t));
+                primed = false;
+                underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+            readPos.store(r + toRead, std::memory_order_release);
+            return count;
+        }
+
+        // Smoothed latency in seconds, as seen by the consumer
+        double getLatency() { return fillAvg.load(std::memory_order_relaxed) / _sampleRate; }
+
+        // Average duration of the incoming blocks in seconds
+        double getBlockDuration() { return blockAvg.load(std::memory_order_relaxed) / _sampleRate; }
+
+        // Current rate correction in parts per million
+        double getCorrectionPPM() { return correction.load(std::memory_order_relaxed) * 1e6; }
+
+        /**
+         * Allocate the buffers, done on the first start. Only needed to use process() without starting the block.
+        */
+        void allocate() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            if (buffer) { return; }
+            std::lock_guard<std::mutex> rlck(readMtx);
+            buffer = buffer::alloc<stereo_t>(STREAM_BUFFER_SIZE + TAP_COUNT);
+            bufStart = &buffer[TAP_COUNT - 1];
+            // A full block produces up to count / (1 - MAX_CORRECTION) samples, plus one for the fractional phase
+            resampBuf = buffer::alloc<stereo_t>((int)ceil(STREAM_BUFFER_SIZE / (1.0 - MAX_CORRECTION)) + 2);
+            reconfigure();
+        }
+
+        // Written by the producer and consumer, read from anywhere
+        std::atomic<uint64_t> underruns{ 0 };
+        std::atomic<uint64_t> overflows{ 0 };
+        std::atomic<uint64_t> skips{ 0 };
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            process(count, base_type::_in->readBuf);
+
+            base_type::_in->flush();
+            return count;
+        }
+
+    protected:
+        void doStart() {
+            allocate();
+            base_type::doStart();
+        }
+
+    private:
+        // Must be called with the producer stopped and readMtx locked
+        void reconfigure() {
+            if (!buffer) {
+                targetFill = _latency * _sampleRate;
+                return;
+            }
+            allocRing();
+            resetState();
+        }
+
+        // Must be called with the producer stopped and readMtx locked
+        void resetState() {
+            if (!buffer) { return; }
+            buffer::clear(buffer, TAP_COUNT - 1);
+            offset = 0;
+            mu = 0.0;
+            writePos = 0;
+            readPos = 0;
+            primed = false;
+            integral = 0.0;
+            fillAvg = targetFill.load();
+            correction = 0.0;
+            blockAvg = 0.0;
+        }
+
+        void allocRing() {
+            targetFill = _latency * _sampleRate;
+
+            // Room for the target latency, a full stream buffer and the margin before skipping, only ever grows
+            int minSize = 3 * targetFill + STREAM_BUFFER_SIZE;
+            if (ring && ringSize >= minSize) { return; }
+            if (ring) { buffer::free(ring); }
+            ringSize = 1;
+            while (ringSize < minSize) { ringSize <<= 1; }
+            ringMask = ringSize - 1;
+            ring = buffer::alloc<stereo_t>(ringSize);
+        }
+
+        void updateLoop(int fill, int targetFill, int count) {
+            // Smooth the fill level, then run a PI loop on the latency error. The correction is the
+            // relative change of the input rate, so d(error)/dt = -correction - drift and the loop
+            // polynomial is s^2 + kp*s + ki.
+            double dt = (double)count / _sampleRate;
+            double avg = fillAvg.load(std::memory_order_relaxed);
+            avg += (std::min<double>(dt / FILL_SMOOTHING_TIME, 1.0)) * ((double)fill - avg);
+            fillAvg.store(avg, std::memory_order_relaxed);
+            double error = (avg - (double)targetFill) / _sampleRate;
+            double wn = 2.0 * DB_M_PI * LOOP_BANDWIDTH;
+            double kp = 2.0 * 0.7071 * wn;
+            double ki = wn * wn;
+
+            // Only integrate when not saturated to avoid windup
+            double corr = (kp * error) + (ki * (integral + error * dt));
+            if (fabs(corr) < MAX_CORRECTION) { integral += error * dt; }
+            correction.store(std::clamp<double>(corr, -MAX_CORRECTION, MAX_CORRECTION), std::memory_order_relaxed);
+        }
+
+        double _sampleRate;
+        double _latency;
+
+        // Resampler
+        float* bank = NULL;
+        stereo_t* buffer = NULL;
+        stereo_t* bufStart;
+        stereo_t* resampBuf = NULL;
+        int offset = 0;
+        double mu = 0.0;
+        std::atomic<double> blockAvg{ 0.0 };
+
+        // Held by the consumer while reading, and by the producer side while reconfiguring
+        std::mutex readMtx;
+
+        // Ring buffer
+        stereo_t* ring = NULL;
+        int ringSize = 0;
+        int ringMask = 0;
+        std::atomic<int> targetFill{ 0 };
+        std::atomic<uint64_t> writePos{ 0 };
+        std::atomic<uint64_t> readPos{ 0 };
+
+        // Control loop, owned by the consumer. The fill average is also read by getLatency() from anywhere.
+        bool primed = false;
+        std::atomic<double> fillAvg{ 0.0 };
+        double integral = 0.0;
+        std::atomic<double> correction{ 0.0 };
+    };
+}
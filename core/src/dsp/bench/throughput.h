@@ -0,0 +1,34 @@
+#pragma once
+#include <chrono>
+#include <stdint.h>
+
+namespace dsp::bench {
+    struct ThroughputResult {
+        double samplesPerSecond;
+        double nsPerSample;
+        uint64_t iterations;
+    };
+
+    // Calls a block's process function on the current thread for at least durationMs and measures its throughput.
+    // Unlike SpeedTester, no stream or thread is involved so the result is the cost of the DSP alone on one core.
+    template <class Func>
+    inline ThroughputResult measureThroughput(int durationMs, int count, Func process, int warmupIterations = 16) {
+        // Warm up caches and let any adaptive loops settle
+        for (int i = 0; i < warmupIterations; i++) { process(count); }
+
+        // Run by batches to keep the clock overhead negligible
+        auto start = std::chrono::high_resolution_clock::now();
+        auto deadline = start + std::chrono::milliseconds(durationMs);
+        uint64_t iterations = 0;
+        std::chrono::high_resolution_clock::time_point now;
+        do {
+            for (int i = 0; i < 8; i++) { process(count); }
+            iterations += 8;
+            now = std::chrono::high_resolution_clock::now();
+        } while (now < deadline);
+
+        double seconds = std::chrono::duration<double>(now - start).count();
+        double samples = (double)iterations * (double)count;
+        return { samples / seconds, (seconds * 1e9) / samples, iterations };
+    }
+}
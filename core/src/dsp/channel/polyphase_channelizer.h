@@ -0,0 +1,249 @@
+#pragma once
+#include "../sink.h"
+#include "../taps/tap.h"
+#include <fftw3.h>
+#include <vector>
+#include <algorithm>
+
+namespace dsp::channel {
+    /**
+     * Oversampled polyphase analysis filter bank.
+     * Splits the input into channelCount channels evenly spaced by samplerate / channelCount, channel k being centered
+     * on k * samplerate / channelCount, the upper half of the channels holding the negative frequencies.
+     * Each channel is output at twice its spacing so that signals straddling two channels can still be recovered.
+     * The cost per input sample only depends on the prototype filter length and the FFT size, not on the number of
+     * channels actually used.
+    */
+    class PolyphaseChannelizer : public Sink<complex_t> {
+        using base_type = Sink<complex_t>;
+    public:
+        PolyphaseChannelizer() {}
+
+        /**
+         * Create a channelizer.
+         * @param in Input stream.
+         * @param channelCount Number of channels, must be even.
+         * @param taps Prototype low-pass filter at the input samplerate, its cutoff typically being around half the channel spacing.
+        */
+        PolyphaseChannelizer(stream<complex_t>* in, int channelCount, tap<float>& taps) { init(in, channelCount, taps); }
+
+        ~PolyphaseChannelizer() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            destroy();
+        }
+
+        void init(stream<complex_t>* in, int channelCount, tap<float>& taps) {
+            generate(channelCount, taps);
+            base_type::init(in);
+        }
+
+        void setChannelCount(int channelCount, tap<float>& taps) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            destroy();
+            generate(channelCount, taps);
+            offset = 0;
+            oddOutput = false;
+            base_type::tempStart();
+        }
+
+        /**
+         * Send a channel to a stream.
+         * @param stream Output stream.
+         * @param channel Index of the channel, from 0 to channelCount - 1.
+        */
+        void bindChannel(stream<complex_t>* stream, int channel) {
+            assert(base_type::_block_init);
+            assert(channel >= 0 && channel < _channelCount);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream isn't already bound
+            if (std::find_if(outputs.begin(), outputs.end(), [stream](const Output& o) { return o.out == stream; }) != outputs.end()) {
+                throw std::runtime_error("[PolyphaseChannelizer] Tried to bind stream to that is already bound");
+            }
+
+            // Add to the list
+            base_type::tempStop();
+            base_type::registerOutput(stream);
+            outputs.push_back({ stream, channel });
+            base_type::tempStart();
+        }
+
+        void unbindChannel(stream<complex_t>* stream) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream is bound
+            auto it = std::find_if(outputs.begin(), outputs.end(), [stream](const Output& o) { return o.out == stream; });
+            if (it == outputs.end()) {
+                throw std::runtime_error("[PolyphaseChannelizer] Tried to unbind stream to that isn't bound");
+            }
+
+            // Remove from the list
+            base_type::tempStop();
+            outputs.erase(it);
+            base_type::unregisterOutput(stream);
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            buffer::clear(buffer, historyLen);
+            offset = 0;
+            oddOutput = false;
+            base_type::tempStart();
+        }
+
+        int getChannelCount() { return _channelCount; }
+
+        /**
+         * Get the channel closest to a frequency.
+         * @param offset Frequency relative to the center of the input.
+         * @param samplerate Samplerate of the input.
+         * @param residual Optional pointer receiving the offset of the frequency from the center of the channel.
+         * @return Index of the channel.
+        */
+        int getChannel(double offset, double samplerate, double* residual = NULL) {
+            double spacing = samplerate / (double)_channelCount;
+            int k = (int)round(offset / spacing);
+            if (residual) { *residual = offset - (k * spacing); }
+            return ((k % _channelCount) + _channelCount) % _channelCount;
+        }
+
+        /**
+         * Channelize a buffer of samples.
+         * @param count Number of input samples.
+         * @param in Input samples.
+         * @param out Output buffers, one per requested channel, each receiving up to count / (channelCount / 2) + 1 samples.
+         * @param channels Index of the requested channels.
+         * @param channelCount Number of requested channels.
+         * @return Number of samples written to each output buffer.
+        */
+        int process(int count, const complex_t* in, complex_t** out, const int* channels, int channelCount) {
+            // Copy data to work buffer
+            memcpy(bufStart, in, count * sizeof(complex_t));
+
+            int outCount = 0;
+            for (; offset < count; offset += _decimation) {
+                // Partial sum of each phase, the newest sample being at offset
+                const complex_t* newest = &bufStart[offset];
+                buffer::clear(partial, _channelCount);
+                for (int p = 0; p < tapsPerPhase; p++) {
+                    const complex_t* seg = newest - (p * _channelCount) - (_channelCount - 1);
+                    const float* ph = &phases[p * _channelCount];
+                    for (int i = 0; i < _channelCount; i++) {
+                        partial[i].re += seg[i].re * ph[i];
+                        partial[i].im += seg[i].im * ph[i];
+                    }
+                }
+                for (int i = 0; i < _channelCount; i++) { fftIn[_channelCount - 1 - i] = partial[i]; }
+
+                // Combine the phases into channels
+                fftwf_execute(plan);
+
+                // The decimation being half the FFT size, the channel mixing phase is (-1)^(k*n)
+                for (int i = 0; i < channelCount; i++) {
+                    int k = channels[i];
+                    out[i][outCount] = (oddOutput && (k & 1)) ? (fftOut[k] * -1.0f) : fftOut[k];
+                }
+                outCount++;
+                oddOutput = !oddOutput;
+            }
+            offset -= count;
+
+            // Move unused data
+            memmove(buffer, &buffer[count], historyLen * sizeof(complex_t));
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Gather the write buffers of the bound streams
+            outPtrs.resize(outputs.size());
+            outChannels.resize(outputs.size());
+            for (int i = 0; i < outputs.size(); i++) {
+                outPtrs[i] = outputs[i].out->writeBuf;
+                outChannels[i] = outputs[i].channel;
+            }
+
+            int outCount = process(count, base_type::_in->readBuf, outPtrs.data(), outChannels.data(), outputs.size());
+
+            base_type::_in->flush();
+            if (!outCount) { return count; }
+            for (const auto& o : outputs) {
+                if (!o.out->swap(outCount)) { return -1; }
+            }
+            return count;
+        }
+
+    private:
+        void generate(int channelCount, tap<float>& taps) {
+            assert(channelCount >= 2 && !(channelCount & 1));
+            _channelCount = channelCount;
+            _decimation = channelCount / 2;
+
+            // Split the prototype into its phases, each stored reversed so that the partial sums are contiguous products
+            tapsPerPhase = (taps.size + channelCount - 1) / channelCount;
+            phases = buffer::alloc<float>(tapsPerPhase * channelCount);
+            for (int p = 0; p < tapsPerPhase; p++) {
+                for (int i = 0; i < channelCount; i++) {
+                    int id = (p * channelCount) + (channelCount - 1 - i);
+                    phases[(p * channelCount) + i] = (id < taps.size) ? taps.taps[id] : 0.0f;
+                }
+            }
+
+            // Allocate the history, big enough for a whole stream buffer
+            historyLen = (tapsPerPhase * channelCount) - 1;
+            buffer = buffer::alloc<complex_t>(STREAM_BUFFER_SIZE + historyLen);
+            bufStart = &buffer[historyLen];
+            buffer::clear(buffer, historyLen);
+            partial = buffer::alloc<complex_t>(channelCount);
+
+            // Plan the FFT combining the phases into channels
+            fftIn = (complex_t*)fftwf_malloc(channelCount * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(channelCount * sizeof(complex_t));
+            plan = fftwf_plan_dft_1d(channelCount, (fftwf_complex*)fftIn, (fftwf_complex*)fftOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+        }
+
+        void destroy() {
+            fftwf_destroy_plan(plan);
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            buffer::free(phases);
+            buffer::free(partial);
+            buffer::free(buffer);
+        }
+
+        struct Output {
+            stream<complex_t>* out;
+            int channel;
+        };
+
+        int _channelCount;
+        int _decimation;
+        int tapsPerPhase;
+        int historyLen;
+        float* phases;
+
+        complex_t* buffer;
+        complex_t* bufStart;
+        complex_t* partial;
+        int offset = 0;
+        bool oddOutput = false;
+
+        complex_t* fftIn;
+        complex_t* fftOut;
+        fftwf_plan plan;
+
+        std::vector<Output> outputs;
+        std::vector<complex_t*> outPtrs;
+        std::vector<int> outChannels;
+    };
+}
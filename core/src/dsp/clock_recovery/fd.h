@@ -4,6 +4,7 @@
 #include "../taps/windowed_sinc.h"
 #include "../multirate/polyphase_bank.h"
 #include "../math/step.h"
+#include "interpolator.h"
 
 namespace dsp::clock_recovery {
     class FD : public Processor<float, float> {
@@ -97,7 +98,48 @@ namespace dsp::clock_recovery {
             // Copy data to work buffer
             memcpy(bufStart, in, count * sizeof(float));
 
-            // Process all samples
+            // Process all samples, with a fully inlined interpolator for the usual tap counts
+            int outCount;
+            switch (_interpTapCount) {
+            case 4:
+                outCount = processSymbols<4>(count, out);
+                break;
+            case 8:
+                outCount = processSymbols<8>(count, out);
+                break;
+            case 16:
+                outCount = processSymbols<16>(count, out);
+                break;
+            default:
+                outCount = processSymbols<0>(count, out);
+                break;
+            }
+
+            // Update delay buffer
+            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(float));
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+        loop::PhaseControlLoop<float, false> pcl;
+
+    protected:
+        template <int TAP_COUNT>
+        inline int processSymbols(int count, float* out) {
             int outCount = 0;
             while (offset < count) {
                 float error;
@@ -106,25 +148,21 @@ namespace dsp::clock_recovery {
 
                 // Calculate new output value
                 int phase = std::clamp<int>(floorf(pcl.phase * (float)_interpPhaseCount), 0, _interpPhaseCount - 1);
-                volk_32f_x2_dot_prod_32f(&outVal, &buffer[offset], interpBank.phases[phase], _interpTapCount);
+                outVal = interpolate<TAP_COUNT>(&buffer[offset], interpBank.phases[phase], _interpTapCount);
                 out[outCount++] = outVal;
 
                 // Calculate derivative of the signal
                 if (phase == 0) {
-                    float fT1;
-                    volk_32f_x2_dot_prod_32f(&fT1, &buffer[offset], interpBank.phases[phase+1], _interpTapCount);
+                    float fT1 = interpolate<TAP_COUNT>(&buffer[offset], interpBank.phases[phase+1], _interpTapCount);
                     dfdt = fT1 - outVal;
                 }
                 else if (phase == _interpPhaseCount - 1) {
-                    float fT_1;
-                    volk_32f_x2_dot_prod_32f(&fT_1, &buffer[offset], interpBank.phases[phase-1], _interpTapCount);
+                    float fT_1 = interpolate<TAP_COUNT>(&buffer[offset], interpBank.phases[phase-1], _interpTapCount);
                     dfdt = outVal - fT_1;
                 }
                 else {
-                    float fT_1;
-                    float fT1;
-                    volk_32f_x2_dot_prod_32f(&fT_1, &buffer[offset], interpBank.phases[phase-1], _interpTapCount);
-                    volk_32f_x2_dot_prod_32f(&fT1, &buffer[offset], interpBank.phases[phase+1], _interpTapCount);
+                    float fT_1 = interpolate<TAP_COUNT>(&buffer[offset], interpBank.phases[phase-1], _interpTapCount);
+                    float fT1 = interpolate<TAP_COUNT>(&buffer[offset], interpBank.phases[phase+1], _interpTapCount);
                     dfdt = (fT1 - fT_1) * 0.5f;
                 }
                 
@@ -142,30 +180,9 @@ namespace dsp::clock_recovery {
                 pcl.phase -= delta;
             }
             offset -= count;
-
-            // Update delay buffer
-            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(float));
-
             return outCount;
         }
 
-        int run() {
-            int count = base_type::_in->read();
-            if (count < 0) { return -1; }
-
-            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
-
-            // Swap if some data was generated
-            base_type::_in->flush();
-            if (outCount) {
-                if (!base_type::out.swap(outCount)) { return -1; }
-            }
-            return outCount;
-        }
-
-        loop::PhaseControlLoop<float, false> pcl;
-
-    protected:
         void generateInterpTaps() {
             double bw = 0.5 / (double)_interpPhaseCount;
             dsp::tap<float> lp = dsp::taps::windowedSinc<float>(_interpPhaseCount * _interpTapCount, dsp::math::hzToRads(bw, 1.0), dsp::window::nuttall, _interpPhaseCount);
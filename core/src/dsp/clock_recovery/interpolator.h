@@ -0,0 +1,49 @@
+#pragma once
+#include "../types.h"
+#include <volk/volk.h>
+
+namespace dsp::clock_recovery {
+    /**
+     * Dot product of a few samples with one phase of the interpolator bank.
+     * With a compile-time tap count the products and the pairwise sum are fully unrolled, letting the compiler inline
+     * them as SIMD instead of paying the VOLK dispatch for a handful of taps at every symbol.
+     * @param in Samples, tapCount of them.
+     * @param taps Taps of the interpolator phase.
+     * @param tapCount Number of taps, only used when TAP_COUNT is 0.
+     * @return Interpolated value.
+    */
+    template <int TAP_COUNT, class T>
+    inline T interpolate(const T* in, const float* taps, int tapCount = TAP_COUNT) {
+        if constexpr (TAP_COUNT == 0) {
+            T outVal;
+            if constexpr (std::is_same_v<T, float>) {
+                volk_32f_x2_dot_prod_32f(&outVal, in, taps, tapCount);
+            }
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&outVal, (lv_32fc_t*)in, taps, tapCount);
+            }
+            return outVal;
+        }
+        else {
+            static_assert((TAP_COUNT & (TAP_COUNT - 1)) == 0, "The tap count must be a power of two");
+            if constexpr (std::is_same_v<T, float>) {
+                float prod[TAP_COUNT];
+                for (int i = 0; i < TAP_COUNT; i++) { prod[i] = in[i] * taps[i]; }
+                for (int w = TAP_COUNT / 2; w > 0; w /= 2) {
+                    for (int i = 0; i < w; i++) { prod[i] += prod[i + w]; }
+                }
+                return prod[0];
+            }
+            if constexpr (std::is_same_v<T, complex_t>) {
+                // Real and imaginary parts are kept interleaved so that the loads map directly to vector registers
+                float prod[2 * TAP_COUNT];
+                const float* fin = (const float*)in;
+                for (int i = 0; i < 2 * TAP_COUNT; i++) { prod[i] = fin[i] * taps[i / 2]; }
+                for (int w = TAP_COUNT; w > 1; w /= 2) {
+                    for (int i = 0; i < w; i++) { prod[i] += prod[i + w]; }
+                }
+                return { prod[0], prod[1] };
+            }
+        }
+    }
+}
@@ -4,6 +4,7 @@
 #include "../taps/windowed_sinc.h"
 #include "../multirate/polyphase_bank.h"
 #include "../math/step.h"
+#include "interpolator.h"
 
 namespace dsp::clock_recovery {
     template<class T>
@@ -101,7 +102,46 @@ namespace dsp::clock_recovery {
             // Copy data to work buffer
             memcpy(bufStart, in, count * sizeof(T));
 
-            // Process all samples
+            // Process all samples, with a fully inlined interpolator for the usual tap counts
+            int outCount;
+            switch (_interpTapCount) {
+            case 4:
+                outCount = processSymbols<4>(count, out);
+                break;
+            case 8:
+                outCount = processSymbols<8>(count, out);
+                break;
+            case 16:
+                outCount = processSymbols<16>(count, out);
+                break;
+            default:
+                outCount = processSymbols<0>(count, out);
+                break;
+            }
+
+            // Update delay buffer
+            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(T));
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        template <int TAP_COUNT>
+        inline int processSymbols(int count, T* out) {
             int outCount = 0;
             while (offset < count) {
                 float error;
@@ -109,12 +149,7 @@ namespace dsp::clock_recovery {
 
                 // Calculate new output value
                 int phase = std::clamp<int>(floorf(pcl.phase * (float)_interpPhaseCount), 0, _interpPhaseCount - 1);
-                if constexpr (std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&outVal, &buffer[offset], interpBank.phases[phase], _interpTapCount);
-                }
-                if constexpr (std::is_same_v<T, complex_t>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&outVal, (lv_32fc_t*)&buffer[offset], interpBank.phases[phase], _interpTapCount);
-                }
+                outVal = interpolate<TAP_COUNT>(&buffer[offset], interpBank.phases[phase], _interpTapCount);
                 out[outCount++] = outVal;
 
                 // Calculate symbol phase error
@@ -148,28 +183,9 @@ namespace dsp::clock_recovery {
                 pcl.phase -= delta;
             }
             offset -= count;
-
-            // Update delay buffer
-            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(T));
-
             return outCount;
         }
 
-        int run() {
-            int count = base_type::_in->read();
-            if (count < 0) { return -1; }
-
-            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
-
-            // Swap if some data was generated
-            base_type::_in->flush();
-            if (outCount) {
-                if (!base_type::out.swap(outCount)) { return -1; }
-            }
-            return outCount;
-        }
-
-    protected:
         void generateInterpTaps() {
             double bw = 0.5 / (double)_interpPhaseCount;
             dsp::tap<float> lp = dsp::taps::windowedSinc<float>(_interpPhaseCount * _interpTapCount, dsp::math::hzToRads(bw, 1.0), dsp::window::nuttall, _interpPhaseCount);
@@ -0,0 +1,213 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "../types.h"
+#include "../stream.h"
+#include "../buffer/buffer.h"
+#include "../taps/windowed_sinc.h"
+#include "../multirate/polyphase_bank.h"
+#include "../math/step.h"
+#include "interpolator.h"
+
+namespace dsp::clock_recovery {
+    /**
+     * Mueller & Muller clock recovery of many independent channels in a single call, eg. the channels of a channelizer.
+     * Same algorithm as MM, but the loop state of all channels is stored as one array per variable and the interpolator
+     * tap count is a compile-time parameter so that the whole symbol loop is inlined. This isn't a block, the caller
+     * provides the buffers of each channel.
+     * @tparam T Sample type, float or complex_t.
+     * @tparam TAP_COUNT Number of taps of the interpolator, a power of two.
+    */
+    template <class T, int TAP_COUNT = 8>
+    class MultiMM {
+    public:
+        MultiMM() {}
+
+        /**
+         * Create a clock recovery.
+         * @param channelCount Number of channels.
+         * @param omega Initial samples per symbol of all channels.
+         * @param omegaGain Gain of the samples per symbol loop.
+         * @param muGain Gain of the symbol phase loop.
+         * @param omegaRelLimit Maximum deviation of the samples per symbol relative to omega.
+         * @param interpPhaseCount Number of phases of the interpolator.
+        */
+        MultiMM(int channelCount, double omega, double omegaGain, double muGain, double omegaRelLimit, int interpPhaseCount = 128) {
+            init(channelCount, omega, omegaGain, muGain, omegaRelLimit, interpPhaseCount);
+        }
+
+        ~MultiMM() {
+            if (!_init) { return; }
+            dsp::multirate::freePolyphaseBank(interpBank);
+        }
+
+        void init(int channelCount, double omega, double omegaGain, double muGain, double omegaRelLimit, int interpPhaseCount = 128) {
+            _omegaGain = omegaGain;
+            _muGain = muGain;
+            _omegaRelLimit = omegaRelLimit;
+            _interpPhaseCount = interpPhaseCount;
+
+            double bw = 0.5 / (double)_interpPhaseCount;
+            dsp::tap<float> lp = dsp::taps::windowedSinc<float>(_interpPhaseCount * TAP_COUNT, dsp::math::hzToRads(bw, 1.0), dsp::window::nuttall, _interpPhaseCount);
+            interpBank = dsp::multirate::buildPolyphaseBank<float>(_interpPhaseCount, lp);
+            taps::free(lp);
+
+            setChannelCount(channelCount, omega);
+            _init = true;
+        }
+
+        /**
+         * Set the number of channels, resetting all of them.
+         * @param channelCount Number of channels.
+         * @param omega Initial samples per symbol of all channels.
+        */
+        void setChannelCount(int channelCount, double omega) {
+            _channelCount = channelCount;
+            omegas.assign(channelCount, omega);
+            minFreq.resize(channelCount);
+            maxFreq.resize(channelCount);
+            freq.resize(channelCount);
+            phase.resize(channelCount);
+            offset.resize(channelCount);
+            edges.resize(channelCount * EDGE_SIZE);
+            lastOut.resize(channelCount);
+            p1T.resize(channelCount);
+            p2T.resize(channelCount);
+            c1T.resize(channelCount);
+            c2T.resize(channelCount);
+            for (int i = 0; i < channelCount; i++) {
+                setOmega(i, omega);
+                reset(i);
+            }
+        }
+
+        int getChannelCount() { return _channelCount; }
+
+        void setOmega(int channel, double omega) {
+            omegas[channel] = omega;
+            minFreq[channel] = omega * (1.0 - _omegaRelLimit);
+            maxFreq[channel] = omega * (1.0 + _omegaRelLimit);
+            freq[channel] = omega;
+        }
+
+        void setOmegaGain(double omegaGain) {
+            _omegaGain = omegaGain;
+        }
+
+        void setMuGain(double muGain) {
+            _muGain = muGain;
+        }
+
+        void reset(int channel) {
+            freq[channel] = omegas[channel];
+            phase[channel] = 0.0f;
+            offset[channel] = 0;
+            for (int i = 0; i < EDGE_SIZE; i++) { edges[(channel * EDGE_SIZE) + i] = T(); }
+            lastOut[channel] = 0.0f;
+            p1T[channel] = { 0.0f, 0.0f }; p2T[channel] = { 0.0f, 0.0f };
+            c1T[channel] = { 0.0f, 0.0f }; c2T[channel] = { 0.0f, 0.0f };
+        }
+
+        /**
+         * Recover the symbols of all channels.
+         * @param count Number of input samples of each channel.
+         * @param in Input samples of each channel.
+         * @param out Output symbols of each channel, at most count / (omega * (1 - omegaRelLimit)) + 1 of them.
+         * @param outCounts Receives the number of symbols output for each channel.
+        */
+        void process(int count, const T* const* in, T* const* out, int* outCounts) {
+            // Symbols overlapping the previous call are interpolated from the saved samples followed by the first new ones
+            for (int ch = 0; ch < _channelCount; ch++) {
+                T* edge = &edges[ch * EDGE_SIZE];
+                int len = std::min<int>(count, TAP_COUNT - 1);
+                memcpy(&edge[TAP_COUNT - 1], in[ch], len * sizeof(T));
+                for (int i = len; i < TAP_COUNT - 1; i++) { edge[TAP_COUNT - 1 + i] = T(); }
+                outCounts[ch] = 0;
+            }
+
+            // Advance all channels by one symbol at a time. The loop of each channel is a long dependency chain,
+            // interleaving the channels lets the CPU work on several of them at once.
+            const float alpha = _muGain;
+            const float beta = _omegaGain;
+            bool active = true;
+            while (active) {
+                active = false;
+                for (int ch = 0; ch < _channelCount; ch++) {
+                    int off = offset[ch];
+                    if (off >= count) { continue; }
+                    active = true;
+
+                    // Calculate new output value
+                    float ph = phase[ch];
+                    int id = std::clamp<int>(floorf(ph * (float)_interpPhaseCount), 0, _interpPhaseCount - 1);
+                    const T* src = (off < TAP_COUNT - 1) ? &edges[(ch * EDGE_SIZE) + off] : &in[ch][off - (TAP_COUNT - 1)];
+                    T outVal = interpolate<TAP_COUNT>(src, interpBank.phases[id]);
+                    out[ch][outCounts[ch]++] = outVal;
+
+                    // Calculate symbol phase error
+                    float error;
+                    if constexpr (std::is_same_v<T, float>) {
+                        float last = lastOut[ch];
+                        error = (math::step(last) * outVal) - (last * math::step(outVal));
+                        lastOut[ch] = outVal;
+                    }
+                    if constexpr (std::is_same_v<T, complex_t>) {
+                        complex_t c_0T = math::step(outVal);
+                        error = (((outVal - p2T[ch]) * c1T[ch].conj()) - ((c_0T - c2T[ch]) * p1T[ch].conj())).re;
+                        p2T[ch] = p1T[ch];
+                        p1T[ch] = outVal;
+                        c2T[ch] = c1T[ch];
+                        c1T[ch] = c_0T;
+                    }
+
+                    // Clamp symbol phase error
+                    error = std::clamp<float>(error, -1.0f, 1.0f);
+
+                    // Advance symbol offset and phase
+                    float f = std::clamp<float>(freq[ch] + (beta * error), minFreq[ch], maxFreq[ch]);
+                    freq[ch] = f;
+                    ph += f + (alpha * error);
+                    float delta = floorf(ph);
+                    offset[ch] = off + (int)delta;
+                    phase[ch] = ph - delta;
+                }
+            }
+
+            // Keep the last samples for the next call
+            for (int ch = 0; ch < _channelCount; ch++) {
+                offset[ch] -= count;
+                T* edge = &edges[ch * EDGE_SIZE];
+                if (count >= TAP_COUNT - 1) {
+                    memcpy(edge, &in[ch][count - (TAP_COUNT - 1)], (TAP_COUNT - 1) * sizeof(T));
+                }
+                else {
+                    memmove(edge, &edge[count], (TAP_COUNT - 1) * sizeof(T));
+                }
+            }
+        }
+
+    protected:
+        static constexpr int EDGE_SIZE = 2 * (TAP_COUNT - 1);
+
+        bool _init = false;
+        int _channelCount = 0;
+        double _omegaGain;
+        double _muGain;
+        double _omegaRelLimit;
+        int _interpPhaseCount;
+
+        dsp::multirate::PolyphaseBank<float> interpBank;
+
+        // Per channel state
+        std::vector<double> omegas;
+        std::vector<float> minFreq;
+        std::vector<float> maxFreq;
+        std::vector<float> freq;
+        std::vector<float> phase;
+        std::vector<int> offset;
+        std::vector<T> edges;
+        std::vector<float> lastOut;
+        std::vector<complex_t> p1T, p2T;
+        std::vector<complex_t> c1T, c2T;
+    };
+}
@@ -0,0 +1,303 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+namespace dsp::fec {
+    // Primitive polynomial of the field used by CCSDS and most satellite downlinks
+    const uint16_t RS_PRIMITIVE_POLYNOMIAL_CCSDS = 0x187;
+
+    /**
+     * Reed-Solomon codec over GF(256).
+     * Codewords follow the libcorrect convention: the first byte is the highest order coefficient
+     * and the parity bytes follow the message. Codewords shorter than 255 bytes are treated as shortened codes.
+     * Decoding works in place. Syndromes are computed with one multiplication table per generator root,
+     * walking interleaved frames in memory order so that all codewords are processed in the same pass
+     * without de-interleaving them first. Blocks with all-zero syndromes skip the error locator search entirely.
+    */
+    class ReedSolomon {
+        static constexpr int NN = 255;
+        static constexpr int A0 = NN;
+    public:
+        ReedSolomon() {}
+
+        /**
+         * Create a codec.
+         * @param primitivePoly Field generator polynomial.
+         * @param firstConsecutiveRoot Log of the first consecutive root of the generator polynomial.
+         * @param rootGap Log distance between generator roots (primitive element).
+         * @param nroots Number of parity bytes per codeword.
+        */
+        ReedSolomon(uint16_t primitivePoly, int firstConsecutiveRoot, int rootGap, int nroots) {
+            init(primitivePoly, firstConsecutiveRoot, rootGap, nroots);
+        }
+
+        void init(uint16_t primitivePoly, int firstConsecutiveRoot, int rootGap, int nroots) {
+            fcr = firstConsecutiveRoot;
+            prim = rootGap;
+            this->nroots = nroots;
+
+            // Generate the log and anti-log tables
+            int sr = 1;
+            for (int i = 0; i < NN; i++) {
+                alphaTo[i] = sr;
+                indexOf[sr] = i;
+                sr <<= 1;
+                if (sr & 0x100) { sr ^= primitivePoly; }
+            }
+            indexOf[0] = A0;
+            alphaTo[A0] = 0;
+
+            // Find the multiplicative inverse of the root gap modulo NN, used to get locations from Chien search roots
+            for (iprim = 1; (iprim % prim) != 0; iprim += NN);
+            iprim /= prim;
+
+            // Generate the generator polynomial, in index form
+            uint8_t poly[256];
+            poly[0] = 1;
+            for (int i = 0, root = fcr * prim; i < nroots; i++, root += prim) {
+                poly[i + 1] = 1;
+                for (int j = i; j > 0; j--) {
+                    poly[j] = poly[j] ? (poly[j - 1] ^ alphaTo[modnn(indexOf[poly[j]] + root)]) : poly[j - 1];
+                }
+                poly[0] = alphaTo[modnn(indexOf[poly[0]] + root)];
+            }
+            for (int i = 0; i <= nroots; i++) { genPoly[i] = indexOf[poly[i]]; }
+
+            // Generate a multiplication table for each generator root used by the syndrome computation
+            rootMul.resize(nroots * 256);
+            for (int i = 0; i < nroots; i++) {
+                int root = modnn((fcr + i) * prim);
+                uint8_t* table = &rootMul[i * 256];
+                table[0] = 0;
+                for (int x = 1; x < 256; x++) { table[x] = alphaTo[modnn(indexOf[x] + root)]; }
+            }
+        }
+
+        /**
+         * Encode a message.
+         * @param msg Message bytes.
+         * @param msgLen Number of message bytes, at most 255 minus the number of roots.
+         * @param out Output codeword of msgLen plus nroots bytes, may be the same buffer as msg.
+         * @return Number of bytes in the codeword.
+        */
+        int encode(const uint8_t* msg, int msgLen, uint8_t* out) {
+            uint8_t parity[256];
+            memset(parity, 0, nroots);
+            for (int i = 0; i < msgLen; i++) {
+                int feedback = indexOf[msg[i] ^ parity[0]];
+                if (feedback != A0) {
+                    for (int j = 1; j < nroots; j++) { parity[j] ^= alphaTo[modnn(feedback + genPoly[nroots - j])]; }
+                }
+                memmove(&parity[0], &parity[1], nroots - 1);
+                parity[nroots - 1] = (feedback != A0) ? alphaTo[modnn(feedback + genPoly[0])] : 0;
+            }
+            if (out != msg) { memcpy(out, msg, msgLen); }
+            memcpy(&out[msgLen], parity, nroots);
+            return msgLen + nroots;
+        }
+
+        /**
+         * Correct a codeword in place.
+         * @param data Codeword.
+         * @param len Length of the codeword in bytes, at most 255.
+         * @return Number of corrected bytes or -1 if the codeword is uncorrectable.
+        */
+        int correct(uint8_t* data, int len) {
+            return correctInterleaved(data, 1, len);
+        }
+
+        /**
+         * Decode a codeword.
+         * @param in Input codeword.
+         * @param len Length of the codeword in bytes, at most 255.
+         * @param out Output message of len minus nroots bytes.
+         * @return Number of corrected bytes or -1 if the codeword is uncorrectable.
+        */
+        int decode(const uint8_t* in, int len, uint8_t* out) {
+            uint8_t block[NN];
+            memcpy(block, in, len);
+            int res = correct(block, len);
+            if (res >= 0) { memcpy(out, block, len - nroots); }
+            return res;
+        }
+
+        /**
+         * Correct a frame of byte interleaved codewords in place, byte n of the frame belonging to codeword n % depth.
+         * @param data Frame of depth*blockLen bytes.
+         * @param depth Number of interleaved codewords.
+         * @param blockLen Length of each codeword in bytes, at most 255.
+         * @param results Optional array of depth entries receiving the result of each codeword.
+         * @return Total number of corrected bytes or -1 if any codeword is uncorrectable.
+        */
+        int correctInterleaved(uint8_t* data, int depth, int blockLen, int* results = NULL) {
+            computeSyndromes(data, depth, blockLen);
+
+            int total = 0;
+            for (int c = 0; c < depth; c++) {
+                int res = correctCodeword(data, c, depth, blockLen);
+                if (results) { results[c] = res; }
+                total = (total < 0 || res < 0) ? -1 : (total + res);
+            }
+            return total;
+        }
+
+        /**
+         * Correct contiguous codewords in place.
+         * @param data Codewords stored back to back.
+         * @param count Number of codewords.
+         * @param blockLen Length of each codeword in bytes, at most 255.
+         * @param results Optional array of count entries receiving the result of each codeword.
+         * @return Total number of corrected bytes or -1 if any codeword is uncorrectable.
+        */
+        int correctBatch(uint8_t* data, int count, int blockLen, int* results = NULL) {
+            int total = 0;
+            for (int i = 0; i < count; i++) {
+                int res = correct(&data[i * blockLen], blockLen);
+                if (results) { results[i] = res; }
+                total = (total < 0 || res < 0) ? -1 : (total + res);
+            }
+            return total;
+        }
+
+        int getRootCount() { return nroots; }
+
+    private:
+        static inline int modnn(int x) {
+            while (x >= NN) {
+                x -= NN;
+                x = (x >> 8) + (x & NN);
+            }
+            return x;
+        }
+
+        void computeSyndromes(const uint8_t* data, int depth, int blockLen) {
+            // Horner evaluation of every codeword at every root, syndromes are stored root major
+            syndromes.resize(nroots * depth);
+            for (int i = 0; i < nroots; i++) { memcpy(&syndromes[i * depth], data, depth); }
+            for (int j = 1; j < blockLen; j++) {
+                const uint8_t* in = &data[j * depth];
+                for (int i = 0; i < nroots; i++) {
+                    const uint8_t* table = &rootMul[i * 256];
+                    uint8_t* syn = &syndromes[i * depth];
+                    for (int c = 0; c < depth; c++) { syn[c] = table[syn[c]] ^ in[c]; }
+                }
+            }
+        }
+
+        int correctCodeword(uint8_t* data, int c, int depth, int blockLen) {
+            // Fast path for error-free codewords
+            uint8_t s[256];
+            bool clean = true;
+            for (int i = 0; i < nroots; i++) {
+                uint8_t syn = syndromes[i * depth + c];
+                clean &= !syn;
+                s[i] = indexOf[syn];
+            }
+            if (clean) { return 0; }
+
+            // Berlekamp-Massey to find the error locator polynomial
+            uint8_t lambda[256], b[256], t[256];
+            memset(lambda, 0, nroots + 1);
+            lambda[0] = 1;
+            for (int i = 0; i <= nroots; i++) { b[i] = indexOf[lambda[i]]; }
+            int el = 0;
+            for (int r = 1; r <= nroots; r++) {
+                int discr = 0;
+                for (int i = 0; i < r; i++) {
+                    if (lambda[i] && s[r - i - 1] != A0) { discr ^= alphaTo[modnn(indexOf[lambda[i]] + s[r - i - 1])]; }
+                }
+                discr = indexOf[discr];
+                if (discr == A0) {
+                    memmove(&b[1], b, nroots);
+                    b[0] = A0;
+                    continue;
+                }
+                t[0] = lambda[0];
+                for (int i = 0; i < nroots; i++) {
+                    t[i + 1] = (b[i] != A0) ? (lambda[i + 1] ^ alphaTo[modnn(discr + b[i])]) : lambda[i + 1];
+                }
+                if (2 * el <= r - 1) {
+                    el = r - el;
+                    for (int i = 0; i <= nroots; i++) { b[i] = lambda[i] ? modnn(indexOf[lambda[i]] - discr + NN) : A0; }
+                }
+                else {
+                    memmove(&b[1], b, nroots);
+                    b[0] = A0;
+                }
+                memcpy(lambda, t, nroots + 1);
+            }
+
+            // Convert the locator to index form
+            int degLambda = 0;
+            for (int i = 0; i <= nroots; i++) {
+                lambda[i] = indexOf[lambda[i]];
+                if (lambda[i] != A0) { degLambda = i; }
+            }
+
+            // Chien search for the roots of the locator
+            uint8_t reg[256], root[256], loc[256];
+            memcpy(&reg[1], &lambda[1], nroots);
+            int count = 0;
+            for (int i = 1, k = iprim - 1; i <= NN; i++, k = modnn(k + iprim)) {
+                int q = 1;
+                for (int j = degLambda; j > 0; j--) {
+                    if (reg[j] != A0) {
+                        reg[j] = modnn(reg[j] + j);
+                        q ^= alphaTo[reg[j]];
+                    }
+                }
+                if (q) { continue; }
+                root[count] = i;
+                loc[count] = k;
+                if (++count == degLambda) { break; }
+            }
+            if (count != degLambda) { return -1; }
+
+            // Error evaluator polynomial
+            uint8_t omega[256];
+            int degOmega = degLambda - 1;
+            for (int i = 0; i <= degOmega; i++) {
+                int tmp = 0;
+                for (int j = i; j >= 0; j--) {
+                    if (s[i - j] != A0 && lambda[j] != A0) { tmp ^= alphaTo[modnn(s[i - j] + lambda[j])]; }
+                }
+                omega[i] = indexOf[tmp];
+            }
+
+            // Check all locations first so that an uncorrectable codeword is left untouched
+            int pad = NN - blockLen;
+            for (int j = 0; j < count; j++) {
+                if (loc[j] < pad) { return -1; }
+            }
+
+            // Forney algorithm for the error values
+            for (int j = count - 1; j >= 0; j--) {
+                int num1 = 0;
+                for (int i = degOmega; i >= 0; i--) {
+                    if (omega[i] != A0) { num1 ^= alphaTo[modnn(omega[i] + i * root[j])]; }
+                }
+                if (!num1) { continue; }
+                int num2 = alphaTo[modnn(root[j] * (fcr - 1) + NN)];
+                int den = 0;
+                for (int i = std::min<int>(degLambda, nroots - 1) & ~1; i >= 0; i -= 2) {
+                    if (lambda[i + 1] != A0) { den ^= alphaTo[modnn(lambda[i + 1] + i * root[j])]; }
+                }
+                data[(loc[j] - pad) * depth + c] ^= alphaTo[modnn(indexOf[num1] + indexOf[num2] + NN - indexOf[den])];
+            }
+
+            return count;
+        }
+
+        uint8_t alphaTo[256];
+        uint8_t indexOf[256];
+        uint8_t genPoly[256];
+        std::vector<uint8_t> rootMul;
+        std::vector<uint8_t> syndromes;
+        int fcr = 0;
+        int prim = 1;
+        int iprim = 1;
+        int nroots = 0;
+    };
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "../buffer/buffer.h"
+
+namespace dsp::fec {
+    // Soft symbols are unsigned bytes, 0 being a certain 0, 255 a certain 1 and 128 carrying no information
+    const uint8_t SOFT_ZERO = 0;
+    const uint8_t SOFT_ERASURE = 128;
+    const uint8_t SOFT_ONE = 255;
+
+    /**
+     * Convert hard bits (one bit per byte) to soft symbols.
+     * @param in Input bits.
+     * @param out Output soft symbols.
+     * @param count Number of bits.
+    */
+    inline void hardToSoft(const uint8_t* in, uint8_t* out, int count) {
+        for (int i = 0; i < count; i++) { out[i] = in[i] ? SOFT_ONE : SOFT_ZERO; }
+    }
+
+    /**
+     * Insert erasures where symbols were removed by puncturing.
+     * @param in Input punctured soft symbols.
+     * @param out Output depunctured soft symbols.
+     * @param outCount Number of symbols to write to the output.
+     * @param pattern Puncturing pattern, 0 where a symbol was removed.
+     * @param patternLen Length of the puncturing pattern.
+     * @return Number of input symbols consumed.
+    */
+    inline int depuncture(const uint8_t* in, uint8_t* out, int outCount, const uint8_t* pattern, int patternLen) {
+        int inOffset = 0;
+        int p = 0;
+        for (int i = 0; i < outCount; i++) {
+            out[i] = pattern[p] ? in[inOffset++] : SOFT_ERASURE;
+            if (++p == patternLen) { p = 0; }
+        }
+        return inOffset;
+    }
+
+    /**
+     * Soft decision Viterbi decoder for rate 1/N convolutional codes.
+     * The polynomials follow the libcorrect convention: the newest bit is the LSB of the shift register
+     * and the symbol of the first polynomial is transmitted first.
+     * The add-compare-select loop works on 16bit metrics in structure-of-arrays form without branches
+     * so that the compiler vectorizes it with whatever SIMD instruction set the target offers.
+     * @tparam K Constraint length.
+     * @tparam N Number of symbols per bit.
+    */
+    template <int K, int N = 2>
+    class Viterbi {
+        static_assert(K >= 3 && K <= 9, "Unsupported constraint length");
+        static_assert(N >= 2 && N <= 4, "Unsupported code rate");
+        static constexpr int STATES = 1 << (K - 1);
+        static constexpr int HALF = STATES / 2;
+        static constexpr int RENORM_INTERVAL = 32;
+    public:
+        Viterbi() {}
+
+        /**
+         * Create a decoder.
+         * @param poly The N generator polynomials.
+         * @param maxSteps Maximum number of trellis steps (decoded bits including tail) expected per frame.
+        */
+        Viterbi(const uint16_t poly[N], int maxSteps = 4096) { init(poly, maxSteps); }
+
+        ~Viterbi() {
+            if (decisions) { buffer::free(decisions); }
+        }
+
+        Viterbi(const Viterbi&) = delete;
+        Viterbi& operator=(const Viterbi&) = delete;
+
+        void init(const uint16_t poly[N], int maxSteps = 4096) {
+            // Generate the expected symbol of each branch of each butterfly as an XOR mask on the received symbol
+            for (int b = 0; b < 2; b++) {
+                for (int i = 0; i < HALF; i++) {
+                    int regLow = (i << 1) | b;
+                    int regHigh = ((i + HALF) << 1) | b;
+                    for (int j = 0; j < N; j++) {
+                        expLow[b][j][i] = parity(regLow & poly[j]) ? 0xFF : 0x00;
+                        expHigh[b][j][i] = parity(regHigh & poly[j]) ? 0xFF : 0x00;
+                    }
+                }
+            }
+            reserve(maxSteps);
+        }
+
+        /**
+         * Decode a frame of soft symbols.
+         * @param in Input soft symbols, erasures must already be inserted for punctured codes.
+         * @param count Number of input symbols, must be a multiple of N.
+         * @param out Output bits packed MSB first.
+         * @param tailBits Number of zero bits flushing the encoder at the end of the frame, these are not output.
+         * If zero, the frame is assumed to be unterminated and traceback starts from the best state.
+         * @return Number of decoded bits.
+        */
+        int decode(const uint8_t* in, int count, uint8_t* out, int tailBits = K - 1) {
+            int steps = count / N;
+            int outBits = steps - tailBits;
+            if (outBits <= 0) { return 0; }
+            reserve(steps);
+
+            // Start from the zero state, all other states are unlikely
+            uint16_t* cur = metricsA;
+            uint16_t* next = metricsB;
+            for (int i = 0; i < STATES; i++) { cur[i] = i ? 1024 : 0; }
+
+            // Forward pass
+            for (int t = 0; t < steps; t++) {
+                step(&in[N * t], cur, next, &decisions[t * STATES]);
+                if (!((t + 1) % RENORM_INTERVAL)) { renormalize(next); }
+                std::swap(cur, next);
+            }
+
+            // Traceback from the zero state for terminated frames, the best state otherwise
+            int state = 0;
+            if (!tailBits) {
+                for (int i = 1; i < STATES; i++) {
+                    if (cur[i] < cur[state]) { state = i; }
+                }
+            }
+            memset(out, 0, (outBits + 7) / 8);
+            for (int t = steps - 1; t >= 0; t--) {
+                int bit = state & 1;
+                uint8_t dec = decisions[t * STATES + (bit ? HALF : 0) + (state >> 1)];
+                if (t < outBits) { out[t >> 3] |= bit << (7 - (t & 7)); }
+                state = (state >> 1) | (dec ? HALF : 0);
+            }
+
+            return outBits;
+        }
+
+        /**
+         * Decode multiple frames of identical size back to back, reusing the trellis memory.
+         * @param in Input soft symbols of all frames, stored contiguously.
+         * @param frameCount Number of frames.
+         * @param frameSymbols Number of soft symbols per frame.
+         * @param out Output buffer, frame n is written at out + n*outStride.
+         * @param outStride Distance in bytes between the output of two frames.
+         * @param tailBits Number of zero bits flushing the encoder at the end of each frame.
+         * @return Number of decoded bits per frame.
+        */
+        int decodeBatch(const uint8_t* in, int frameCount, int frameSymbols, uint8_t* out, int outStride, int tailBits = K - 1) {
+            int bits = 0;
+            for (int i = 0; i < frameCount; i++) {
+                bits = decode(&in[i * frameSymbols], frameSymbols, &out[i * outStride], tailBits);
+            }
+            return bits;
+        }
+
+    private:
+        static inline int parity(int x) {
+            int p = 0;
+            while (x) {
+                p ^= x & 1;
+                x >>= 1;
+            }
+            return p;
+        }
+
+        void reserve(int steps) {
+            if (steps <= maxSteps) { return; }
+            if (decisions) { buffer::free(decisions); }
+            maxSteps = steps;
+            decisions = buffer::alloc<uint8_t>(maxSteps * STATES);
+        }
+
+        // Decisions are stored with all even states first, then all odd states
+        inline void step(const uint8_t* sym, const uint16_t* cur, uint16_t* next, uint8_t* dec) {
+            uint16_t s[N];
+            for (int j = 0; j < N; j++) { s[j] = sym[j]; }
+            uint16_t even[HALF];
+            uint16_t odd[HALF];
+            for (int i = 0; i < HALF; i++) {
+                // Successor 2i is reached by shifting in a zero, 2i+1 by shifting in a one
+                uint16_t m0Low = cur[i];
+                uint16_t m0High = cur[i + HALF];
+                uint16_t m1Low = cur[i];
+                uint16_t m1High = cur[i + HALF];
+                for (int j = 0; j < N; j++) {
+                    m0Low += s[j] ^ expLow[0][j][i];
+                    m0High += s[j] ^ expHigh[0][j][i];
+                    m1Low += s[j] ^ expLow[1][j][i];
+                    m1High += s[j] ^ expHigh[1][j][i];
+                }
+
+                dec[i] = m0High < m0Low;
+                dec[i + HALF] = m1High < m1Low;
+                even[i] = std::min<uint16_t>(m0Low, m0High);
+                odd[i] = std::min<uint16_t>(m1Low, m1High);
+            }
+            for (int i = 0; i < HALF; i++) {
+                next[2 * i] = even[i];
+                next[2 * i + 1] = odd[i];
+            }
+        }
+
+        inline void renormalize(uint16_t* metrics) {
+            uint16_t min = metrics[0];
+            for (int i = 1; i < STATES; i++) { min = std::min<uint16_t>(min, metrics[i]); }
+            for (int i = 0; i < STATES; i++) { metrics[i] -= min; }
+        }
+
+        alignas(32) uint16_t expLow[2][N][HALF];
+        alignas(32) uint16_t expHigh[2][N][HALF];
+        alignas(32) uint16_t metricsA[STATES];
+        alignas(32) uint16_t metricsB[STATES];
+        uint8_t* decisions = NULL;
+        int maxSteps = 0;
+    };
+}
@@ -8,9 +8,17 @@ namespace dsp::loop {
     public:
         AGC() {}
 
-        AGC(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0) { init(in, setPoint, attack, decay, maxGain, maxOutputAmp, initGain); }
+        AGC(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0, int lookAhead = 0) { init(in, setPoint, attack, decay, maxGain, maxOutputAmp, initGain, lookAhead); }
+
+        ~AGC() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(ampBuf);
+            buffer::free(gainBuf);
+            buffer::free(peakQueue);
+        }
 
-        void init(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0) {
+        void init(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0, int lookAhead = 0) {
             _setPoint = setPoint;
             _attack = attack;
             _invAttack = 1.0f - _attack;
@@ -19,7 +27,13 @@ namespace dsp::loop {
             _maxGain = maxGain;
             _maxOutputAmp = maxOutputAmp;
             _initGain = initGain;
+            _lookAhead = lookAhead;
             amp = _setPoint / _initGain;
+
+            ampBuf = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+            gainBuf = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+            peakQueue = buffer::alloc<int>(STREAM_BUFFER_SIZE);
+
             base_type::init(in);
         }
 
@@ -61,6 +75,16 @@ namespace dsp::loop {
             _initGain = initGain;
         }
 
+        /**
+         * Set how far the limiter looks ahead for the peak amplitude when the output would clip.
+         * @param lookAhead Number of samples, 0 to look until the end of the buffer.
+        */
+        void setLookAhead(int lookAhead) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _lookAhead = lookAhead;
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -68,43 +92,60 @@ namespace dsp::loop {
         }
 
         inline int process(int count, T* in, T* out) {
+            // Get signal amplitudes
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)in, count);
+            }
+            if constexpr (std::is_same_v<T, float>) {
+                for (int i = 0; i < count; i++) { ampBuf[i] = fabsf(in[i]); }
+            }
+
+            // Run the envelope follower. This is the only serial part, so it only tracks the average amplitude and
+            // the gains are computed afterwards in a single vector pass. The state is kept in locals so that it stays
+            // in registers despite the stores to the buffers.
+            float env = amp;
+            const float attack = _attack;
+            const float invAttack = _invAttack;
+            const float decay = _decay;
+            const float invDecay = _invDecay;
+            const float clipAmp = _maxOutputAmp / _setPoint;
+            const float clipMinAmp = _maxOutputAmp / _maxGain;
+            bool peaksReady = false;
             for (int i = 0; i < count; i++) {
-                // Get signal amplitude
-                float inAmp, gain;
-                if constexpr (std::is_same_v<T, complex_t>) {
-                    inAmp = in[i].amplitude();
-                }
-                if constexpr (std::is_same_v<T, float>) {
-                    inAmp = fabsf(in[i]);
+                float inAmp = ampBuf[i];
+                if (inAmp == 0.0f) {
+                    gainBuf[i] = 0.0f;
+                    continue;
                 }
 
                 // Update average amplitude
-                if (inAmp != 0.0f) {
-                    amp = (inAmp > amp) ? ((amp * _invAttack) + (inAmp * _attack)) : ((amp * _invDecay) + (inAmp * _decay));
-                    gain = std::min<float>(_setPoint / amp, _maxGain);
-                }
-                else {
-                    gain = 1.0f;
-                }
-
-                // If clipping is detected look ahead and correct
-                if (inAmp*gain > _maxOutputAmp) {
-                    float maxAmp = 0;
-                    for (int j = i; j < count; j++) {
-                        if constexpr (std::is_same_v<T, complex_t>) {
-                            inAmp = in[j].amplitude();
-                        }
-                        if constexpr (std::is_same_v<T, float>) {
-                            inAmp = fabsf(in[j]);
-                        }
-                        if (inAmp > maxAmp) { maxAmp = inAmp; }
+                env = (inAmp > env) ? ((env * invAttack) + (inAmp * attack)) : ((env * invDecay) + (inAmp * decay));
+
+                // If clipping is detected, correct using the peak amplitude ahead. Same as inAmp*gain > maxOutputAmp
+                // without the division.
+                if (inAmp > clipAmp * env && inAmp > clipMinAmp) {
+                    if (!peaksReady) {
+                        findPeaks(i, count);
+                        peaksReady = true;
                     }
-                    amp = maxAmp;
-                    gain = std::min<float>(_setPoint / amp, _maxGain);
+                    env = gainBuf[i];
                 }
-                
-                // Scale output by gain
-                out[i] = in[i] * gain;
+
+                gainBuf[i] = env;
+            }
+            amp = env;
+
+            // Convert the envelope to gains, silent samples being left untouched
+            for (int i = 0; i < count; i++) {
+                gainBuf[i] = (gainBuf[i] != 0.0f) ? std::min<float>(_setPoint / gainBuf[i], _maxGain) : 1.0f;
+            }
+
+            // Scale output by gain
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)out, (lv_32fc_t*)in, gainBuf, count);
+            }
+            if constexpr (std::is_same_v<T, float>) {
+                volk_32f_x2_multiply_32f(out, in, gainBuf, count);
             }
             return count;
         }
@@ -121,6 +162,22 @@ namespace dsp::loop {
         }
 
     protected:
+        // Compute the peak amplitude of the look-ahead window starting at each sample from start to count, using a monotonic
+        // queue of sample indices scanned backwards. The queue front is always the peak of the window and each index is pushed
+        // and popped once, so this is O(n) whatever the look-ahead. The peaks are stored in the gain buffer, each one being
+        // replaced by the gain once used.
+        void findPeaks(int start, int count) {
+            int window = (_lookAhead > 0) ? _lookAhead : count;
+            int front = 0;
+            int back = 0;
+            for (int i = count - 1; i >= start; i--) {
+                while (back > front && ampBuf[peakQueue[back - 1]] <= ampBuf[i]) { back--; }
+                peakQueue[back++] = i;
+                if (peakQueue[front] >= i + window) { front++; }
+                gainBuf[i] = ampBuf[peakQueue[front]];
+            }
+        }
+
         float _setPoint;
         float _attack;
         float _invAttack;
@@ -129,8 +186,13 @@ namespace dsp::loop {
         float _maxGain;
         float _maxOutputAmp;
         float _initGain;
+        int _lookAhead;
 
         float amp = 1.0;
 
+        float* ampBuf;
+        float* gainBuf;
+        int* peakQueue;
+
     };
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include "pll_bank.h"
+
+namespace dsp::loop {
+    /**
+     * Many independent Costas loops running in lockstep, see PLLBank.
+    */
+    template<int ORDER>
+    class CostasBank : public PLLBank {
+        static_assert(ORDER == 2 || ORDER == 4 || ORDER == 8, "Invalid costas order");
+        using base_type = PLLBank;
+    public:
+        CostasBank() {}
+
+        CostasBank(int channelCount, double bandwidth, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            base_type::init(channelCount, bandwidth, initPhase, initFreq, minFreq, maxFreq);
+        }
+
+        /**
+         * Lock onto the carrier of all channels.
+         * @param count Number of samples of each channel.
+         * @param in Input samples of each channel.
+         * @param out Derotated samples of each channel, count samples each.
+        */
+        void process(int count, const complex_t* const* in, complex_t* const* out) {
+            base_type::processBlocks(count, in, out, [](float re, float im, float vcoRe, float vcoIm, float& oRe, float& oIm) {
+                // Multiply by the conjugate of the VCO
+                float vre = (re * vcoRe) + (im * vcoIm);
+                float vim = (im * vcoRe) - (re * vcoIm);
+                oRe = vre;
+                oIm = vim;
+                return errorFunction(vre, vim);
+            });
+        }
+
+    protected:
+        // Same as Costas::errorFunction() with selects instead of branches
+        static inline float errorFunction(float re, float im) {
+            float sre = math::branchlessSelect(re > 0.0f, 1.0f, -1.0f);
+            float sim = math::branchlessSelect(im > 0.0f, 1.0f, -1.0f);
+            float err;
+            if constexpr (ORDER == 2) {
+                err = re * im;
+            }
+            if constexpr (ORDER == 4) {
+                err = (sre * im) - (sim * re);
+            }
+            if constexpr (ORDER == 8) {
+                const float K = sqrtf(2.0) - 1.0;
+                err = math::branchlessSelect(fabsf(re) >= fabsf(im), (sre * im) - (sim * re * K), (sre * im * K) - (sim * re));
+            }
+            err = math::branchlessSelect(err > 1.0f, 1.0f, err);
+            return math::branchlessSelect(err < -1.0f, -1.0f, err);
+        }
+    };
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "../types.h"
+#include "../math/constants.h"
+#include "../math/branchless.h"
+#include "phase_control_loop.h"
+
+namespace dsp::loop {
+    /**
+     * Many independent PLLs running in lockstep, eg. one per channel of a channelizer.
+     * Same loop as PLL, but the state of all loops is stored as one array per variable and each sample is processed for
+     * all channels at once, the channels occupying the SIMD lanes. The VCO and phase detector use branchless polynomial
+     * approximations instead of libm calls so that the compiler can vectorize the whole loop, the phase being accurate
+     * to about 1e-6 rad. All loops share the same bandwidth and frequency limits. This isn't a block, the caller provides
+     * the buffers of each channel.
+    */
+    class PLLBank {
+    public:
+        PLLBank() {}
+
+        /**
+         * Create a PLL bank.
+         * @param channelCount Number of channels.
+         * @param bandwidth Loop bandwidth.
+         * @param initPhase Initial phase of all loops.
+         * @param initFreq Initial frequency of all loops.
+         * @param minFreq Minimum frequency, at least -pi.
+         * @param maxFreq Maximum frequency, at most pi.
+        */
+        PLLBank(int channelCount, double bandwidth, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            init(channelCount, bandwidth, initPhase, initFreq, minFreq, maxFreq);
+        }
+
+        void init(int channelCount, double bandwidth, double initPhase = 0.0, double initFreq = 0.0, double minFreq = -FL_M_PI, double maxFreq = FL_M_PI) {
+            _initPhase = initPhase;
+            _initFreq = initFreq;
+            setBandwidth(bandwidth);
+            setFrequencyLimits(minFreq, maxFreq);
+            setChannelCount(channelCount);
+        }
+
+        /**
+         * Set the number of channels, resetting all of them.
+         * @param channelCount Number of channels.
+        */
+        void setChannelCount(int channelCount) {
+            _channelCount = channelCount;
+            phase.assign(channelCount, _initPhase);
+            freq.assign(channelCount, _initFreq);
+            inRe.resize(BLOCK_SIZE * channelCount);
+            inIm.resize(BLOCK_SIZE * channelCount);
+            outRe.resize(BLOCK_SIZE * channelCount);
+            outIm.resize(BLOCK_SIZE * channelCount);
+        }
+
+        int getChannelCount() { return _channelCount; }
+
+        void setBandwidth(double bandwidth) {
+            PhaseControlLoop<float>::criticallyDamped(bandwidth, _alpha, _beta);
+        }
+
+        void setInitialPhase(double initPhase) {
+            _initPhase = initPhase;
+        }
+
+        void setInitialFreq(double initFreq) {
+            _initFreq = initFreq;
+        }
+
+        void setFrequencyLimits(double minFreq, double maxFreq) {
+            assert(maxFreq > minFreq);
+            // A single wrap of the phase per sample is only enough if the frequency stays within +-pi
+            _minFreq = std::max<float>(minFreq, -FL_M_PI);
+            _maxFreq = std::min<float>(maxFreq, FL_M_PI);
+            for (auto& f : freq) { f = std::clamp<float>(f, _minFreq, _maxFreq); }
+        }
+
+        void reset(int channel) {
+            phase[channel] = _initPhase;
+            freq[channel] = _initFreq;
+        }
+
+        // Current frequency of a loop in radians per sample
+        float getFrequency(int channel) { return freq[channel]; }
+
+        /**
+         * Track the carrier of all channels.
+         * @param count Number of samples of each channel.
+         * @param in Input samples of each channel.
+         * @param out VCO output of each channel, count samples each.
+        */
+        void process(int count, const complex_t* const* in, complex_t* const* out) {
+            processBlocks(count, in, out, [](float re, float im, float vcoRe, float vcoIm, float& oRe, float& oIm) {
+                oRe = vcoRe;
+                oIm = vcoIm;
+                // Phase of the input relative to the VCO, already normalized
+                return math::branchlessAtan2((im * vcoRe) - (re * vcoIm), (re * vcoRe) + (im * vcoIm));
+            });
+        }
+
+    protected:
+        // Number of samples of each channel transposed at once
+        static constexpr int BLOCK_SIZE = 64;
+
+        /**
+         * Run all loops over the input.
+         * @param detector Called for each sample with the input, the VCO and references to the output, returns the phase error.
+        */
+        template <class Func>
+        void processBlocks(int count, const complex_t* const* in, complex_t* const* out, Func detector) {
+            const int n = _channelCount;
+            for (int i = 0; i < count; i += BLOCK_SIZE) {
+                int len = std::min<int>(BLOCK_SIZE, count - i);
+
+                // Transpose the block so that consecutive channels are contiguous
+                for (int ch = 0; ch < n; ch++) {
+                    const complex_t* src = &in[ch][i];
+                    for (int j = 0; j < len; j++) {
+                        inRe[(j * n) + ch] = src[j].re;
+                        inIm[(j * n) + ch] = src[j].im;
+                    }
+                }
+
+                for (int j = 0; j < len; j++) {
+                    advance(n, &inRe[j * n], &inIm[j * n], &outRe[j * n], &outIm[j * n], phase.data(), freq.data(), detector);
+                }
+
+                // Transpose back
+                for (int ch = 0; ch < n; ch++) {
+                    complex_t* dst = &out[ch][i];
+                    for (int j = 0; j < len; j++) {
+                        dst[j].re = outRe[(j * n) + ch];
+                        dst[j].im = outIm[(j * n) + ch];
+                    }
+                }
+            }
+        }
+
+        // Advance all loops by one sample. The arrays never overlap, without restrict the compiler gives up on checking it at runtime.
+        template <class Func>
+        inline void advance(int n, const float* __restrict ire, const float* __restrict iim, float* __restrict ore, float* __restrict oim, float* __restrict ph, float* __restrict fr, Func& detector) {
+            const float alpha = _alpha;
+            const float beta = _beta;
+            const float minFreq = _minFreq;
+            const float maxFreq = _maxFreq;
+            for (int ch = 0; ch < n; ch++) {
+                float vcoIm, vcoRe;
+                math::branchlessSinCos(ph[ch], vcoIm, vcoRe);
+                float err = detector(ire[ch], iim[ch], vcoRe, vcoIm, ore[ch], oim[ch]);
+
+                // Loop filter, same as PhaseControlLoop::advance()
+                float f = fr[ch] + (beta * err);
+                f = math::branchlessSelect(f > maxFreq, maxFreq, f);
+                f = math::branchlessSelect(f < minFreq, minFreq, f);
+                fr[ch] = f;
+                float p = ph[ch] + f + (alpha * err);
+                p = math::branchlessSelect(p > FL_M_PI, p - (2.0f * FL_M_PI), p);
+                p = math::branchlessSelect(p < -FL_M_PI, p + (2.0f * FL_M_PI), p);
+                ph[ch] = p;
+            }
+        }
+
+        int _channelCount = 0;
+        float _alpha;
+        float _beta;
+        float _initPhase;
+        float _initFreq;
+        float _minFreq;
+        float _maxFreq;
+
+        // Per channel state
+        std::vector<float> phase;
+        std::vector<float> freq;
+
+        // Transposed block, sample major
+        std::vector<float> inRe;
+        std::vector<float> inIm;
+        std::vector<float> outRe;
+        std::vector<float> outIm;
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "constants.h"
+
+// Math without branches or libm calls, for loops that the compiler is meant to vectorize
+
+namespace dsp::math {
+    /**
+     * Select one of two values with a bit mask. Unlike the ternary operator, the compiler can't turn it back into a
+     * branch, which would prevent vectorization as long as floating point exceptions are enabled (the default).
+     * @param cond Condition.
+     * @param a Value returned if the condition is true.
+     * @param b Value returned otherwise.
+    */
+    inline float branchlessSelect(bool cond, float a, float b) {
+        uint32_t ai, bi;
+        memcpy(&ai, &a, sizeof(float));
+        memcpy(&bi, &b, sizeof(float));
+        uint32_t mask = -(uint32_t)cond;
+        uint32_t ri = (ai & mask) | (bi & ~mask);
+        float r;
+        memcpy(&r, &ri, sizeof(float));
+        return r;
+    }
+
+    /**
+     * Sine and cosine using the Taylor series of the half angle, the error is below 4e-7.
+     * @param x Angle in radians, between -pi and pi.
+     * @param s Receives the sine.
+     * @param c Receives the cosine.
+    */
+    inline void branchlessSinCos(float x, float& s, float& c) {
+        float h = 0.5f * x;
+        float z = h * h;
+        float sh = h + (h * z * (-1.0f / 6.0f + z * (1.0f / 120.0f + z * (-1.0f / 5040.0f + z * (1.0f / 362880.0f + z * (-1.0f / 39916800.0f))))));
+        float ch = 1.0f + (z * (-1.0f / 2.0f + z * (1.0f / 24.0f + z * (-1.0f / 720.0f + z * (1.0f / 40320.0f + z * (-1.0f / 3628800.0f + z * (1.0f / 479001600.0f)))))));
+        s = 2.0f * sh * ch;
+        c = (ch * ch) - (sh * sh);
+    }
+
+    /**
+     * Four quadrant arctangent using the polynomial of the cephes atanf, the error is below 3e-7. Returns 0 for (0, 0).
+     * @param y Imaginary part.
+     * @param x Real part.
+     * @return Angle in radians, between -pi and pi.
+    */
+    inline float branchlessAtan2(float y, float x) {
+        float ax = fabsf(x);
+        float ay = fabsf(y);
+        float mx = (ax > ay) ? ax : ay;
+        float mn = (ax > ay) ? ay : ax;
+        float a = mn / ((mx > 1e-30f) ? mx : 1e-30f);
+
+        // Reduce to [-tan(pi/8), tan(pi/8)]
+        bool big = (a > 0.41421356f);
+        float t = branchlessSelect(big, (a - 1.0f) / (a + 1.0f), a);
+        float z = t * t;
+        float r = (((((8.05374449538e-2f * z) - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * t) + t;
+        r += branchlessSelect(big, FL_M_PI / 4.0f, 0.0f);
+
+        // Unfold the octant
+        r = branchlessSelect(ay > ax, (FL_M_PI / 2.0f) - r, r);
+        r = branchlessSelect(x < 0.0f, FL_M_PI - r, r);
+        return branchlessSelect(y < 0.0f, -r, r);
+    }
+}
@@ -79,6 +79,13 @@ namespace dsp::multirate {
             base_type::tempStart();
         }
 
+        // Group delay of the polyphase filter in seconds, the power decimator's is negligible in comparison
+        double getDelay() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return delay;
+        }
+
         inline int process(int count, const T* in, T* out) {
             switch(mode) {
                 case Mode::BOTH:
@@ -147,6 +154,7 @@ namespace dsp::multirate {
             // If the power decimator already did all the work, don't use the resampler
             if (interp == decim) {
                 mode = useDecim ? Mode::DECIM_ONLY : Mode::NONE;
+                delay = 0.0;
                 return;
             }
 
@@ -158,6 +166,7 @@ namespace dsp::multirate {
             rtaps = taps::lowPass(tapBandwidth, tapTransWidth, tapSamplerate);
             for (int i = 0; i < rtaps.size; i++) { rtaps.taps[i] *= (float)interp; }
             resamp.setRatio(interp, decim, rtaps);
+            delay = ((double)(rtaps.size - 1) / 2.0) / tapSamplerate;
 
             printf("[Resamp] predec: %d, interp: %d, decim: %d, inacc: %lf%%, taps: %d\n", predecRatio, interp, decim, error, rtaps.size);
 
@@ -169,6 +178,7 @@ namespace dsp::multirate {
         tap<float> rtaps;
         double _inSamplerate;
         double _outSamplerate;
+        double delay = 0.0;
         Mode mode;
     };
 }
\ No newline at end of file
@@ -1,15 +1,29 @@
 #pragma once
 #include "../processor.h"
-#include "../window/nuttall.h"
+#include "../math/constants.h"
 #include <fftw3.h>
 
 namespace dsp::noise_reduction {
+    /**
+     * FM IF noise reduction. Each output sample is the strongest bin of the Nuttall windowed DFT of the last bins samples,
+     * which keeps only the carrier and rejects the noise around it.
+     * Instead of a forward and inverse FFT per sample, the DFT is slid one sample at a time with a recursive update of
+     * each bin and the window is applied in the frequency domain as a 7 tap kernel (the Nuttall window being a sum of
+     * cosines). A full FFT is only done at the start of each segment to discard the rounding errors of the recursion.
+    */
     class FMIF : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
     public:
+        enum Quality {
+            // Strongest bin searched for at every sample
+            QUALITY_HIGH,
+            // Strongest bin searched for once every bins/4 samples, only the bins around it are updated in between
+            QUALITY_LOW
+        };
+
         FMIF() {}
 
-        FMIF(stream<complex_t>* in, int bins) { init(in, bins); }
+        FMIF(stream<complex_t>* in, int bins, Quality quality = QUALITY_HIGH) { init(in, bins, quality); }
 
         ~FMIF() {
             if (!base_type::_block_init) { return; }
@@ -17,8 +31,9 @@ namespace dsp::noise_reduction {
             destroyBuffers();
         }
 
-        void init(stream<complex_t>* in, int bins) {
+        void init(stream<complex_t>* in, int bins, Quality quality = QUALITY_HIGH) {
             _bins = bins;
+            _quality = quality;
             initBuffers();
             base_type::init(in);
         }
@@ -33,41 +48,54 @@ namespace dsp::noise_reduction {
             base_type::tempStart();
         }
 
+        void setQuality(Quality quality) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _quality = quality;
+            base_type::tempStart();
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             buffer::clear(buffer, _bins - 1);
-            buffer::clear(backFFTIn, _bins);
             base_type::tempStart();
         }
 
         int process(int count, const complex_t* in, complex_t* out) {
             // Write new input data to buffer buffer
             memcpy(bufferStart, in, count * sizeof(complex_t));
-            
-            // Iterate the FFT
-            for (int i = 0; i < count; i++) {
-                // Apply windows
-                volk_32fc_32f_multiply_32fc((lv_32fc_t*)forwFFTIn, (lv_32fc_t*)&buffer[i], fftWin, _bins);
 
-                // Do forward FFT
-                fftwf_execute(forwardPlan);
-
-                // Process bins here
-                uint32_t idx;
-                volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)forwFFTOut, _bins);
-                volk_32f_index_max_32u(&idx, ampBuf, _bins);
-
-                // Keep only the bin of highest amplitude
-                backFFTIn[idx] = forwFFTOut[idx];
-
-                // Do reverse FFT and get first element
-                fftwf_execute(backwardPlan);
-                out[i] = backFFTOut[_bins / 2];
-
-                // Reset the input buffer
-                backFFTIn[idx] = { 0, 0 };
+            int segLen = (_quality == QUALITY_LOW) ? std::max<int>((_bins + 3) / 4, 1) : RESYNC_INTERVAL;
+            for (int i = 0; i < count;) {
+                int end = std::min<int>(i + segLen, count);
+
+                // Compute the DFT of the current window exactly
+                memcpy(fftIn, &buffer[i], _bins * sizeof(complex_t));
+                fftwf_execute(plan);
+                for (int k = 0; k < _bins + 6; k++) {
+                    const complex_t& val = fftOut[(k - 3 + _bins) % _bins];
+                    dftRe[k] = val.re;
+                    dftIm[k] = val.im;
+                }
+
+                if (_quality == QUALITY_LOW) {
+                    // Only the 7 bins needed to window the strongest one are updated until the end of the segment
+                    int idx = strongestBin();
+                    for (; i < end; i++) {
+                        out[i] = windowedBin(idx) * outRot[idx];
+                        if (i + 1 < end) { slide(idx, 7, buffer[i + _bins] - buffer[i]); }
+                    }
+                }
+                else {
+                    for (; i < end; i++) {
+                        int idx = strongestBin();
+                        out[i] = windowedBin(idx) * outRot[idx];
+                        if (i + 1 < end) { slide(0, _bins + 6, buffer[i + _bins] - buffer[i]); }
+                    }
+                }
             }
 
             // Move buffer buffer
@@ -89,61 +117,117 @@ namespace dsp::noise_reduction {
         }
 
     protected:
-        void initBuffers() {
-            // Allocate FFT buffers
-            forwFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            forwFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
+        // Number of samples after which the sliding DFT is recomputed with an FFT
+        static constexpr int RESYNC_INTERVAL = 1024;
+
+        // Nuttall window applied in the frequency domain, bin k being a0*X[k] + sum of an*(X[k-n] + X[k+n])
+        static constexpr float WIN_A0 = 0.355768f;
+        static constexpr float WIN_A1 = -0.487396f / 2.0f;
+        static constexpr float WIN_A2 = 0.144232f / 2.0f;
+        static constexpr float WIN_A3 = -0.012604f / 2.0f;
+
+        // Windowed value of bin k
+        inline complex_t windowedBin(int k) {
+            const float* re = &dftRe[k];
+            const float* im = &dftIm[k];
+            return {
+                (re[3] * WIN_A0) + ((re[2] + re[4]) * WIN_A1) + ((re[1] + re[5]) * WIN_A2) + ((re[0] + re[6]) * WIN_A3),
+                (im[3] * WIN_A0) + ((im[2] + im[4]) * WIN_A1) + ((im[1] + im[5]) * WIN_A2) + ((im[0] + im[6]) * WIN_A3)
+            };
+        }
 
+        inline int strongestBin() {
+            for (int k = 0; k < _bins; k++) {
+                const float* re = &dftRe[k];
+                const float* im = &dftIm[k];
+                float wre = (re[3] * WIN_A0) + ((re[2] + re[4]) * WIN_A1) + ((re[1] + re[5]) * WIN_A2) + ((re[0] + re[6]) * WIN_A3);
+                float wim = (im[3] * WIN_A0) + ((im[2] + im[4]) * WIN_A1) + ((im[1] + im[5]) * WIN_A2) + ((im[0] + im[6]) * WIN_A3);
+                ampBuf[k] = (wre * wre) + (wim * wim);
+            }
+            uint32_t idx;
+            volk_32f_index_max_32u(&idx, ampBuf, _bins);
+            return idx;
+        }
+
+        // Move the DFT forward by one sample: X[k] = (X[k] + newest - oldest) * e^(j*2*pi*k/N)
+        inline void slide(int first, int count, complex_t delta) {
+            float* re = &dftRe[first];
+            float* im = &dftIm[first];
+            const float* twRe = &twiddleRe[first];
+            const float* twIm = &twiddleIm[first];
+            for (int k = 0; k < count; k++) {
+                float r = re[k] + delta.re;
+                float j = im[k] + delta.im;
+                re[k] = (r * twRe[k]) - (j * twIm[k]);
+                im[k] = (r * twIm[k]) + (j * twRe[k]);
+            }
+        }
+
+        void initBuffers() {
             // Allocate and clear delay buffer
             buffer = buffer::alloc<complex_t>(STREAM_BUFFER_SIZE + 64000);
             bufferStart = &buffer[_bins - 1];
             buffer::clear(buffer, _bins - 1);
 
-            // Clear backward FFT input since only one value is changed and reset at a time
-            buffer::clear(backFFTIn, _bins);
+            // The DFT is stored as separate real and imaginary parts with the 3 last bins before and the 3 first bins after it
+            // so that the window never wraps. The bins are updated independently so the copies never need to be synced.
+            fftIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
+            dftRe = buffer::alloc<float>(_bins + 6);
+            dftIm = buffer::alloc<float>(_bins + 6);
+            twiddleRe = buffer::alloc<float>(_bins + 6);
+            twiddleIm = buffer::alloc<float>(_bins + 6);
+            for (int i = 0; i < _bins + 6; i++) {
+                int k = (i - 3 + _bins) % _bins;
+                double phase = 2.0 * DB_M_PI * (double)k / (double)_bins;
+                twiddleRe[i] = cos(phase);
+                twiddleIm[i] = sin(phase);
+            }
+
+            // Rotation giving the value of a bin at the center of the window, as an inverse FFT of that bin alone would
+            outRot = buffer::alloc<complex_t>(_bins);
+            for (int k = 0; k < _bins; k++) {
+                double phase = 2.0 * DB_M_PI * (double)((k * (_bins / 2)) % _bins) / (double)_bins;
+                outRot[k] = { (float)cos(phase), (float)sin(phase) };
+            }
 
             // Allocate amplitude buffer
             ampBuf = buffer::alloc<float>(_bins);
 
-            // Allocate and generate Window
-            fftWin = buffer::alloc<float>(_bins);
-            for (int i = 0; i < _bins; i++) { fftWin[i] = window::nuttall(i, _bins - 1); }
-
-            // Plan FFTs
-            forwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)forwFFTIn, (fftwf_complex*)forwFFTOut, FFTW_FORWARD, FFTW_ESTIMATE);
-            backwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)backFFTIn, (fftwf_complex*)backFFTOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+            // Plan FFT
+            plan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)fftIn, (fftwf_complex*)fftOut, FFTW_FORWARD, FFTW_ESTIMATE);
         }
 
         void destroyBuffers() {
-            fftwf_destroy_plan(forwardPlan);
-            fftwf_destroy_plan(backwardPlan);
-            fftwf_free(forwFFTIn);
-            fftwf_free(forwFFTOut);
-            fftwf_free(backFFTIn);
-            fftwf_free(backFFTOut);
+            fftwf_destroy_plan(plan);
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
             buffer::free(buffer);
+            buffer::free(dftRe);
+            buffer::free(dftIm);
+            buffer::free(twiddleRe);
+            buffer::free(twiddleIm);
+            buffer::free(outRot);
             buffer::free(ampBuf);
-            buffer::free(fftWin);
         }
 
-        complex_t* forwFFTIn;
-        complex_t* forwFFTOut;
-        complex_t* backFFTIn;
-        complex_t* backFFTOut;
+        complex_t* fftIn;
+        complex_t* fftOut;
+        fftwf_plan plan;
 
-        fftwf_plan forwardPlan;
-        fftwf_plan backwardPlan;
+        float* dftRe;
+        float* dftIm;
+        float* twiddleRe;
+        float* twiddleIm;
+        complex_t* outRot;
 
         complex_t* buffer;
         complex_t* bufferStart;
 
-        float* fftWin;
-
         float* ampBuf;
 
         int _bins;
+        Quality _quality;
 
-    }; 
-}
\ No newline at end of file
+    };
+}
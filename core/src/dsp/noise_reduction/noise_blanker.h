@@ -1,18 +1,46 @@
 #pragma once
 #include "../processor.h"
+#include "../math/branchless.h"
 
 namespace dsp::noise_reduction {
+    /**
+     * Impulse noise blanker. Samples whose amplitude exceeds the running average amplitude by more than a given level are
+     * either scaled down to the average or replaced by a linear interpolation of the surrounding samples.
+     * Everything is done in bulk passes over the buffer without branches, except for the running average (a first order
+     * IIR) which is unrolled so that its dependency chain is a fraction of the samples.
+    */
     class NoiseBlanker : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
     public:
+        enum Mode {
+            // Scale the impulses down to the average amplitude
+            MODE_SCALE,
+            // Replace the impulses by a linear interpolation between the samples around them
+            MODE_INTERPOLATE
+        };
+
         NoiseBlanker() {}
 
-        NoiseBlanker(stream<complex_t>* in, double rate, double level) { init(in, rate, level); }
+        NoiseBlanker(stream<complex_t>* in, double rate, double level, Mode mode = MODE_SCALE) { init(in, rate, level, mode); }
+
+        ~NoiseBlanker() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(ampBuf);
+            buffer::free(envBuf);
+            buffer::free(gainBuf);
+        }
 
-        void init(stream<complex_t>* in, double rate, double level) {
+        void init(stream<complex_t>* in, double rate, double level, Mode mode = MODE_SCALE) {
             _rate = rate;
             _invRate = 1.0f - _rate;
             _level = level;
+            _mode = mode;
+
+            ampBuf = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+            envBuf = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+            gainBuf = buffer::alloc<float>(STREAM_BUFFER_SIZE);
+
             base_type::init(in);
         }
 
@@ -29,30 +57,42 @@ namespace dsp::noise_reduction {
             _level = level;
         }
 
+        void setMode(Mode mode) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _mode = mode;
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             amp = 1.0f;
+            lastGood = { 0.0f, 0.0f };
         }
 
         inline int process(int count, complex_t* in, complex_t* out) {
-            for (int i = 0; i < count; i++) {
-                // Get signal amplitude
-                float inAmp = in[i].amplitude();
-
-                // Update average amplitude
-                float gain = 1.0f;
-                if (inAmp != 0.0f) {
-                    amp = (amp * _invRate) + (inAmp * _rate);
-                    float excess = inAmp / amp;
-                    if (excess > _level) {
-                        gain = 1.0f / excess;
-                    }
+            // Get signal amplitudes and their running average
+            volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)in, count);
+            average(count);
+
+            // Find the impulses. Same as amp / average > level without the division.
+            const float level = _level;
+            if (_mode == MODE_SCALE) {
+                for (int i = 0; i < count; i++) {
+                    float inAmp = ampBuf[i];
+                    float env = envBuf[i];
+                    gainBuf[i] = math::branchlessSelect(inAmp > level * env, env / inAmp, 1.0f);
                 }
-                
-                // Scale output by gain
-                out[i] = in[i] * gain;
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)out, (lv_32fc_t*)in, gainBuf, count);
             }
+            else {
+                for (int i = 0; i < count; i++) {
+                    gainBuf[i] = math::branchlessSelect(ampBuf[i] > level * envBuf[i], 0.0f, 1.0f);
+                }
+                if (out != in) { memcpy(out, in, count * sizeof(complex_t)); }
+                interpolateGaps(count, in, out);
+            }
+
             return count;
         }
 
@@ -68,11 +108,101 @@ namespace dsp::noise_reduction {
         }
 
     protected:
+        // Number of samples of the running average computed per step of its dependency chain
+        static constexpr int STEP = 4;
+
+        /**
+         * Compute the running average amplitude into envBuf.
+         * Each sample does avg = (1 - rate)*avg + rate*amp, silent samples leaving it untouched. Unrolled by STEP samples,
+         * avg[i+k] = t[k] + (1 - rate)^(k+1)*avg[i-1] where t[k] is the average of the STEP samples alone. The t[k] don't
+         * depend on the previous average so only one multiply-add per STEP samples remains on the dependency chain.
+        */
+        void average(int count) {
+            const float rate = _rate;
+            const float invRate = _invRate;
+            float pw[STEP];
+            pw[0] = invRate;
+            for (int k = 1; k < STEP; k++) { pw[k] = pw[k - 1] * invRate; }
+
+            float avg = amp;
+            int i = 0;
+            for (; i + STEP <= count; i += STEP) {
+                const float* inAmp = &ampBuf[i];
+                float* env = &envBuf[i];
+
+                // Silent samples break the formula, do these steps one sample at a time
+                bool silent = false;
+                for (int k = 0; k < STEP; k++) { silent |= (inAmp[k] == 0.0f); }
+                if (silent) {
+                    for (int k = 0; k < STEP; k++) {
+                        if (inAmp[k] != 0.0f) { avg = (avg * invRate) + (inAmp[k] * rate); }
+                        env[k] = avg;
+                    }
+                    continue;
+                }
+
+                float t = inAmp[0] * rate;
+                env[0] = t + (pw[0] * avg);
+                for (int k = 1; k < STEP; k++) {
+                    t = (t * invRate) + (inAmp[k] * rate);
+                    env[k] = t + (pw[k] * avg);
+                }
+                avg = env[STEP - 1];
+            }
+
+            // Remainder
+            for (; i < count; i++) {
+                if (ampBuf[i] != 0.0f) { avg = (avg * invRate) + (ampBuf[i] * rate); }
+                envBuf[i] = avg;
+            }
+            amp = avg;
+        }
+
+        /**
+         * Replace the samples whose gain is zero by a line between the samples before and after them.
+         * A gap reaching the end of the buffer holds the last good sample since the next one isn't known yet.
+        */
+        void interpolateGaps(int count, complex_t* in, complex_t* out) {
+            int i = 0;
+            while (i < count) {
+                // Skip good samples
+                if (gainBuf[i] != 0.0f) {
+                    i++;
+                    continue;
+                }
+
+                // Find the end of the gap
+                int start = i;
+                while (i < count && gainBuf[i] == 0.0f) { i++; }
+                complex_t left = (start > 0) ? in[start - 1] : lastGood;
+                if (i == count) {
+                    for (int j = start; j < count; j++) { out[j] = left; }
+                    break;
+                }
+                complex_t step = (in[i] - left) * (1.0f / (float)(i - start + 1));
+                for (int j = start; j < i; j++) { out[j] = left + step * (float)(j - start + 1); }
+            }
+
+            // Keep the last good sample as the start of a gap at the beginning of the next buffer
+            for (int j = count - 1; j >= 0; j--) {
+                if (gainBuf[j] != 0.0f) {
+                    lastGood = in[j];
+                    break;
+                }
+            }
+        }
+
         float _rate;
         float _invRate;
         float _level;
+        Mode _mode;
 
         float amp = 1.0;
+        complex_t lastGood = { 0.0f, 0.0f };
+
+        float* ampBuf;
+        float* envBuf;
+        float* gainBuf;
 
     };
-}
\ No newline at end of file
+}
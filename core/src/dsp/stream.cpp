@@ -0,0 +1,7 @@
+#include "stream.h"
+
+namespace dsp {
+    std::atomic<bool> streamTracking(false);
+    std::atomic<int64_t> streamsInFlight(0);
+    std::atomic<uint64_t> streamSwaps(0);
+}
@@ -2,13 +2,35 @@
 #include <string.h>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <stdint.h>
 #include <volk/volk.h>
 #include "buffer/buffer.h"
 
 // 1MSample buffer
 #define STREAM_BUFFER_SIZE 1000000
 
+// The activity counters are defined in the core so that the streams of all modules share them
+#ifdef _WIN32
+#ifdef SDRPP_IS_CORE
+#define DSP_STREAM_EXPORT __declspec(dllexport)
+#else
+#define DSP_STREAM_EXPORT __declspec(dllimport)
+#endif
+#else
+#define DSP_STREAM_EXPORT
+#endif
+
 namespace dsp {
+    // Enables the activity counters below, only set by offline mode so that the streams don't share counters otherwise
+    extern DSP_STREAM_EXPORT std::atomic<bool> streamTracking;
+
+    // Number of streams holding data not yet flushed by their reader. Streams whose reader never ran aren't counted.
+    extern DSP_STREAM_EXPORT std::atomic<int64_t> streamsInFlight;
+
+    // Number of swaps done by all streams, together with streamsInFlight tells when a graph has gone idle
+    extern DSP_STREAM_EXPORT std::atomic<uint64_t> streamSwaps;
+
     class untyped_stream {
     public:
         virtual ~untyped_stream() {}
@@ -30,6 +52,7 @@ namespace dsp {
         }
 
         virtual ~stream() {
+            if (inFlight) { streamsInFlight.fetch_sub(1, std::memory_order_relaxed); }
             free();
         }
 
@@ -61,6 +84,13 @@ namespace dsp {
             {
                 std::lock_guard<std::mutex> lck(rdyMtx);
                 dataReady = true;
+                if (streamTracking.load(std::memory_order_relaxed)) {
+                    if (!inFlight && everFlushed) {
+                        inFlight = true;
+                        streamsInFlight.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    streamSwaps.fetch_add(1, std::memory_order_relaxed);
+                }
             }
             rdyCV.notify_all();
 
@@ -79,7 +109,12 @@ namespace dsp {
             // Clear data ready
             {
                 std::lock_guard<std::mutex> lck(rdyMtx);
+                if (inFlight) {
+                    inFlight = false;
+                    streamsInFlight.fetch_sub(1, std::memory_order_relaxed);
+                }
                 dataReady = false;
+                everFlushed = true;
             }
 
             // Notify writer that buffers can be swapped
@@ -134,6 +169,10 @@ namespace dsp {
         std::condition_variable rdyCV;
         bool dataReady = false;
 
+        // Activity tracking state, see streamTracking
+        bool everFlushed = false;
+        bool inFlight = false;
+
         bool readerStop = false;
         bool writerStop = false;
 
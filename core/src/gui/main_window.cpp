@@ -28,6 +28,34 @@
 #include <gui/widgets/snr_meter.h>
 #include <gui/tuner.h>
 
+// Band plans and color maps, loaded in the background while the modules load
+static void loadResources(std::string resourcesDir, json bandColors) {
+    auto start = std::chrono::steady_clock::now();
+
+    flog::info("Loading band plans");
+    bandplan::loadFromDir(resourcesDir + "/bandplans");
+    flog::info("Loading band plans color table");
+    bandplan::loadColorTable(bandColors);
+
+    flog::info("Loading color maps");
+    if (std::filesystem::is_directory(resourcesDir + "/colormaps")) {
+        for (const auto& file : std::filesystem::directory_iterator(resourcesDir + "/colormaps")) {
+            std::string path = file.path().generic_string();
+            flog::info("Loading {0}", path);
+            if (file.path().extension().generic_string() != ".json") {
+                continue;
+            }
+            if (!file.is_regular_file()) { continue; }
+            colormaps::loadMap(path);
+        }
+    }
+    else {
+        flog::warn("Color map directory {0} does not exist, not loading color maps from directory", resourcesDir + "/colormaps");
+    }
+
+    flog::info("Band plans and color maps loaded in {}ms", (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
 void MainWindow::init() {
     LoadingScreen::show("Initializing UI");
     gui::waterfall.init();
@@ -39,6 +67,7 @@ void MainWindow::init() {
     json menuElements = core::configManager.conf["menuElements"];
     std::string modulesDir = core::configManager.conf["modulesDirectory"];
     std::string resourcesDir = core::configManager.conf["resourcesDirectory"];
+    json bandColors = core::configManager.conf["bandColors"];
     core::configManager.release();
 
     // Assert that directories are absolute
@@ -88,16 +117,22 @@ void MainWindow::init() {
     fft_out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
     fftwPlan = fftwf_plan_dft_1d(fftSize, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
 
-    sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, acquireFFTBuffer, releaseFFTBuffer, this);
+    sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL);
+    sigpath::spectrumBus.subscribe(&fftSubscriber);
     sigpath::iqFrontEnd.start();
 
     vfoCreatedHandler.handler = vfoAddedHandler;
     vfoCreatedHandler.ctx = this;
     sigpath::vfoManager.onVfoCreated.bindHandler(&vfoCreatedHandler);
 
+    // Nothing touches the band plans or color maps until the modules are loaded
+    std::thread resourceLoader(loadResources, resourcesDir, bandColors);
+
     flog::info("Loading modules");
+    LoadingScreen::show("Loading modules");
 
-    // Load modules from /module directory
+    // Find modules in /module directory
+    std::vector<std::string> modulePaths;
     if (std::filesystem::is_directory(modulesDir)) {
         for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
             std::string path = file.path().generic_string();
@@ -105,9 +140,7 @@ void MainWindow::init() {
                 continue;
             }
             if (!file.is_regular_file()) { continue; }
-            flog::info("Loading {0}", path);
-            LoadingScreen::show("Loading " + file.path().filename().string());
-            core::moduleManager.loadModule(path);
+            modulePaths.push_back(path);
         }
     }
     else {
@@ -120,18 +153,21 @@ void MainWindow::init() {
     auto modList = core::configManager.conf["moduleInstances"].items();
     core::configManager.release();
 
-    // Load additional modules specified through config
+    // Add modules specified through config
     for (auto const& path : modules) {
 #ifndef __ANDROID__
-        std::string apath = std::filesystem::absolute(path).string();
-        flog::info("Loading {0}", apath);
-        LoadingScreen::show("Loading " + std::filesystem::path(path).filename().string());
-        core::moduleManager.loadModule(apath);
+        modulePaths.push_back(std::filesystem::absolute(path).string());
 #else
-        core::moduleManager.loadModule(path);
+        modulePaths.push_back(path);
 #endif
     }
 
+    // Load them all
+    core::moduleManager.loadModules(modulePaths, [](const std::string& path) {
+        flog::info("Loading {0}", path);
+        LoadingScreen::show("Loading " + std::filesystem::path(path).filename().string());
+    });
+
     // Create module instances
     for (auto const& [name, _module] : modList) {
         std::string mod = _module["module"];
@@ -142,24 +178,9 @@ void MainWindow::init() {
         if (!enabled) { core::moduleManager.disableInstance(name); }
     }
 
-    // Load color maps
+    // Wait for the band plans and color maps
     LoadingScreen::show("Loading color maps");
-    flog::info("Loading color maps");
-    if (std::filesystem::is_directory(resourcesDir + "/colormaps")) {
-        for (const auto& file : std::filesystem::directory_iterator(resourcesDir + "/colormaps")) {
-            std::string path = file.path().generic_string();
-            LoadingScreen::show("Loading " + file.path().filename().string());
-            flog::info("Loading {0}", path);
-            if (file.path().extension().generic_string() != ".json") {
-                continue;
-            }
-            if (!file.is_regular_file()) { continue; }
-            colormaps::loadMap(path);
-        }
-    }
-    else {
-        flog::warn("Color map directory {0} does not exist, not loading modules from directory", modulesDir);
-    }
+    resourceLoader.join();
 
     gui::waterfall.updatePalletteFromArray(colormaps::maps["Turbo"].map, colormaps::maps["Turbo"].entryCount);
 
@@ -225,14 +246,7 @@ void MainWindow::init() {
     initComplete = true;
 
     core::moduleManager.doPostInitAll();
-}
-
-float* MainWindow::acquireFFTBuffer(void* ctx) {
-    return gui::waterfall.getFFTBuffer();
-}
-
-void MainWindow::releaseFFTBuffer(void* ctx) {
-    gui::waterfall.pushFFT();
+    core::moduleManager.printStartupReport();
 }
 
 void MainWindow::vfoAddedHandler(VFOManager::VFO* vfo, void* ctx) {
@@ -545,6 +559,12 @@ void MainWindow::draw() {
 
     ImGui::BeginChild("Waterfall");
 
+    // Push all spectrum lines published since the last frame
+    SpectrumFrame frame;
+    while (fftSubscriber.read(frame)) {
+        gui::waterfall.pushFFT(frame.data, frame.size);
+    }
+
     gui::waterfall.draw();
 
     ImGui::EndChild();
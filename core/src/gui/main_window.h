@@ -4,6 +4,7 @@
 #include <dsp/types.h>
 #include <dsp/stream.h>
 #include <signal_path/vfo_manager.h>
+#include <signal_path/spectrum_bus.h>
 #include <string>
 #include <utils/event.h>
 #include <mutex>
@@ -11,6 +12,10 @@
 
 #define WINDOW_FLAGS ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoBackground
 
+// Spectrum lines queued between two UI frames, 480 lines/s at 60 FPS. Each one holds a full FFT so this bounds the
+// memory used at large FFT sizes, lines beyond it are dropped.
+#define FFT_QUEUE_DEPTH 8
+
 class MainWindow {
 public:
     void init();
@@ -19,9 +24,6 @@ public:
     bool sdrIsRunning();
     void setFirstMenuRender();
 
-    static float* acquireFFTBuffer(void* ctx);
-    static void releaseFFTBuffer(void* ctx);
-
     // TODO: Replace with it's own class
     void setVFO(double freq);
 
@@ -41,6 +43,7 @@ private:
     std::mutex fft_mtx;
     fftwf_complex *fft_in, *fft_out;
     fftwf_plan fftwPlan;
+    SpectrumSubscriber fftSubscriber{ FFT_QUEUE_DEPTH };
 
     // GUI Variables
     bool firstMenuRender = true;
@@ -203,6 +203,23 @@ namespace SmGui {
     }
 
     // Drawlist stuff
+    bool DrawList::applyDiff(const std::string& id, DrawListElem& value) {
+        int elemCount = elements.size();
+        for (int i = 0; i + 2 < elemCount; i++) {
+            // Only widgets whose value follows their ID are edited by draw()
+            DrawListElem& elem = elements[i];
+            if (elem.type != DRAW_LIST_ELEM_TYPE_DRAW_STEP) { continue; }
+            if (elem.step != DRAW_STEP_COMBO && elem.step != DRAW_STEP_SLIDER_INT && elem.step != DRAW_STEP_SLIDER_FLOAT_WITH_STEPS &&
+                elem.step != DRAW_STEP_INPUT_INT && elem.step != DRAW_STEP_CHECKBOX && elem.step != DRAW_STEP_SLIDER_FLOAT &&
+                elem.step != DRAW_STEP_INPUT_TEXT) { continue; }
+            if (elements[i+1].type != DRAW_LIST_ELEM_TYPE_STRING || elements[i+1].str != id) { continue; }
+            if (elements[i+2].type != value.type) { return false; }
+            elements[i+2] = value;
+            return true;
+        }
+        return false;
+    }
+
     void DrawList::pushStep(DrawStep step, bool forceSync) {
         DrawListElem elem;
         elem.type = DRAW_LIST_ELEM_TYPE_DRAW_STEP;
@@ -376,6 +393,97 @@ namespace SmGui {
         return size;
     }
 
+    bool DrawList::itemEquals(DrawListElem& a, DrawListElem& b) {
+        if (a.type != b.type) { return false; }
+        if (a.type == DRAW_LIST_ELEM_TYPE_DRAW_STEP) { return a.step == b.step && a.forceSync == b.forceSync; }
+        else if (a.type == DRAW_LIST_ELEM_TYPE_BOOL) { return a.b == b.b; }
+        else if (a.type == DRAW_LIST_ELEM_TYPE_INT) { return a.i == b.i; }
+        else if (a.type == DRAW_LIST_ELEM_TYPE_FLOAT) { return a.f == b.f; }
+        else if (a.type == DRAW_LIST_ELEM_TYPE_STRING) { return a.str == b.str; }
+        return false;
+    }
+
+    int DrawList::storeDelta(DrawList& base, void* data, int len) {
+        uint8_t* buf = (uint8_t*)data;
+        int count = elements.size();
+        int baseCount = base.elements.size();
+        if (len < 4) { return -1; }
+        *(uint32_t*)&buf[0] = count;
+        int i = 4;
+        len -= 4;
+
+        for (int id = 0; id < count;) {
+            // Skip unchanged elements
+            if (id < baseCount && itemEquals(elements[id], base.elements[id])) {
+                id++;
+                continue;
+            }
+
+            // Find the end of the run of changed elements
+            int start = id;
+            while (id < count && id - start < UINT16_MAX && (id >= baseCount || !itemEquals(elements[id], base.elements[id]))) { id++; }
+
+            // Write the run header followed by the elements
+            if (len < 6) { return -1; }
+            *(uint32_t*)&buf[i] = start;
+            *(uint16_t*)&buf[i + 4] = id - start;
+            i += 6;
+            len -= 6;
+            for (int j = start; j < id; j++) {
+                int written = storeItem(elements[j], &buf[i], len);
+                if (written < 0) { return -1; }
+                i += written;
+                len -= written;
+            }
+        }
+
+        return i;
+    }
+
+    int DrawList::loadDelta(void* data, int len) {
+        uint8_t* buf = (uint8_t*)data;
+        if (len < 4) { return -1; }
+        int64_t count = *(uint32_t*)&buf[0];
+        int baseCount = elements.size();
+        int i = 4;
+        len -= 4;
+
+        // Every new element takes at least two bytes, reject counts the delta can't possibly fill
+        if (count > baseCount + (len / 2)) { return -1; }
+
+        // Apply every run, elements past the end of the base list must all be part of one
+        std::vector<DrawListElem> newElements(elements.begin(), elements.begin() + std::min<int>(count, baseCount));
+        newElements.resize(count);
+        int64_t filled = baseCount;
+        while (len > 0) {
+            if (len < 6) { return -1; }
+            int64_t start = *(uint32_t*)&buf[i];
+            int n = *(uint16_t*)&buf[i + 4];
+            i += 6;
+            len -= 6;
+            if (start > filled || start + n > count) { return -1; }
+            for (int64_t j = start; j < start + n; j++) {
+                if (len < 1) { return -1; }
+                int consumed = loadItem(newElements[j], &buf[i], len);
+                if (consumed < 0) { return -1; }
+                i += consumed;
+                len -= consumed;
+            }
+            filled = std::max<int64_t>(filled, start + n);
+        }
+        if (filled < count) { return -1; }
+
+        // Keep the current list if the result is invalid
+        std::swap(elements, newElements);
+        if (!validate()) {
+            flog::error("Drawlist delta validation failed");
+            std::swap(elements, newElements);
+            return -1;
+        }
+
+        return i;
+    }
+
     bool DrawList::checkTypes(int firstId, int n, ...) {
         va_list args;
         va_start(args, n);
@@ -86,6 +86,14 @@ namespace SmGui {
         void pushString(std::string str);
 
         void draw(std::string& diffId, DrawListElem& diffValue, bool& syncRequired);
+
+        /**
+         * Set the value of a widget like draw() does when it's edited, so that a copy of a remote list can track the edits.
+         * @param id ID of the widget.
+         * @param value New value, as returned by draw().
+         * @return True if a widget with this ID holding a value of this type was found.
+        */
+        bool applyDiff(const std::string& id, DrawListElem& value);
         
         static int loadItem(DrawListElem& elem, uint8_t* data, int len);
         int load(void* data, int len);
@@ -93,6 +101,25 @@ namespace SmGui {
         int store(void* data, int len);
         static int getItemSize(DrawListElem& elem);
         int getSize();
+        static bool itemEquals(DrawListElem& a, DrawListElem& b);
+
+        /**
+         * Store only the elements that differ from another draw list.
+         * Layout: uint32 element count of this list, then runs of changed elements, each a uint32 index, a uint16 element
+         * count and the elements in the same format as store(). The count truncates or extends the base list.
+         * @param base Draw list the receiver already has.
+         * @param data Output buffer.
+         * @param len Size of the output buffer.
+         * @return Number of bytes written, -1 if the buffer is too small.
+        */
+        int storeDelta(DrawList& base, void* data, int len);
+
+        /**
+         * Apply a delta produced by storeDelta() to this draw list, which must be the base it was computed against.
+         * @return Number of bytes read, -1 if the delta is invalid.
+        */
+        int loadDelta(void* data, int len);
+
         bool checkTypes(int firstId, int n, ...);
         bool validate();
 
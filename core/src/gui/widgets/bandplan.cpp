@@ -4,6 +4,8 @@
 #include <filesystem>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <math.h>
 
 namespace bandplan {
     std::map<std::string, BandPlan_t> bandplans;
@@ -53,6 +55,19 @@ namespace bandplan {
         j.at("author_name").get_to(b.authorName);
         j.at("author_url").get_to(b.authorURL);
         j.at("bands").get_to(b.bands);
+
+        // Index the bands so that the visible ones can be found with a binary search
+        std::stable_sort(b.bands.begin(), b.bands.end(), [](const Band_t& a, const Band_t& b) { return a.start < b.start; });
+        b.maxEnd.resize(b.bands.size());
+        double maxEnd = -INFINITY;
+        for (int i = 0; i < b.bands.size(); i++) {
+            maxEnd = std::max<double>(maxEnd, b.bands[i].end);
+            b.maxEnd[i] = maxEnd;
+        }
+    }
+
+    int firstBandEndingAfter(const BandPlan_t& plan, double freq) {
+        return std::lower_bound(plan.maxEnd.begin(), plan.maxEnd.end(), freq) - plan.maxEnd.begin();
     }
 
     void to_json(json& j, const BandPlanColor_t& ct) {
@@ -22,7 +22,11 @@ namespace bandplan {
         std::string countryCode;
         std::string authorName;
         std::string authorURL;
+        // Sorted by start frequency
         std::vector<Band_t> bands;
+
+        // Highest end frequency of the bands up to each one, see firstBandEndingAfter()
+        std::vector<double> maxEnd;
     };
 
     void to_json(json& j, const BandPlan_t& b);
@@ -36,6 +40,14 @@ namespace bandplan {
     void to_json(json& j, const BandPlanColor_t& ct);
     void from_json(const json& j, BandPlanColor_t& ct);
 
+    /**
+     * Find the first band that ends at or after a frequency.
+     * @param plan Band plan.
+     * @param freq Frequency in Hz.
+     * @return Index of the band, all bands before it end before the frequency.
+    */
+    int firstBandEndingAfter(const BandPlan_t& plan, double freq);
+
     void loadBandPlan(std::string path);
     void loadFromDir(std::string path);
     void loadColorTable(json table);
@@ -1,13 +1,21 @@
 #include <gui/widgets/line_push_image.h>
+#include <utils/flog.h>
+#include <algorithm>
 
 namespace ImGui {
-    LinePushImage::LinePushImage(int frameWidth, int reservedIncrement) {
+    LinePushImage::LinePushImage(int frameWidth, int tileLines, int maxLines) {
         _frameWidth = frameWidth;
-        _reservedIncrement = reservedIncrement;
-        frameBuffer = (uint8_t*)malloc(_frameWidth * _reservedIncrement * 4);
-        reservedCount = reservedIncrement;
+        _tileLines = tileLines;
+        _maxLines = maxLines;
+    }
 
-        glGenTextures(1, &textureId);
+    LinePushImage::~LinePushImage() {
+        stopSave();
+        for (auto& tile : tiles) {
+            free(tile.data);
+            if (tile.textureId) { unusedTextures.push_back(tile.textureId); }
+        }
+        if (!unusedTextures.empty()) { glDeleteTextures(unusedTextures.size(), unusedTextures.data()); }
     }
 
     void LinePushImage::draw(const ImVec2& size_arg) {
@@ -17,73 +25,206 @@ namespace ImGui {
         ImGuiStyle& style = GetStyle();
         ImVec2 min = window->DC.CursorPos;
 
+        // Only lines still in memory are shown
+        int firstLine = tiles.empty() ? _lineCount : tiles.front().firstLine;
+        int lineCount = _lineCount - firstLine;
+
         // Calculate scale
         float width = CalcItemWidth();
-        float height = roundf((width / (float)_frameWidth) * (float)_lineCount);
+        float scale = width / (float)_frameWidth;
+        float height = roundf(scale * (float)lineCount);
 
         ImVec2 size = CalcItemSize(size_arg, CalcItemWidth(), height);
         ImRect bb(min, ImVec2(min.x + size.x, min.y + size.y));
 
         // If there are no lines, there is no point in drawing anything
-        if (_lineCount == 0) { return; }
+        if (lineCount == 0) { return; }
 
         ItemSize(size, style.FramePadding.y);
         if (!ItemAdd(bb, 0)) {
             return;
         }
 
-        if (newData) {
-            newData = false;
-            updateTexture();
-        }
+        updateTextures();
 
-        window->DrawList->AddImage((void*)(intptr_t)textureId, min, ImVec2(min.x + width, min.y + height));
+        // Draw each tile, only showing the lines it actually holds
+        for (auto& tile : tiles) {
+            if (!tile.lines) { continue; }
+            float top = min.y + roundf(scale * (float)(tile.firstLine - firstLine));
+            float bottom = min.y + roundf(scale * (float)(tile.firstLine + tile.lines - firstLine));
+            ImVec2 uvMax(1.0f, (float)tile.lines / (float)_tileLines);
+            window->DrawList->AddImage((void*)(intptr_t)tile.textureId, ImVec2(min.x, top), ImVec2(min.x + width, bottom), ImVec2(0, 0), uvMax);
+        }
     }
 
     uint8_t* LinePushImage::acquireNextLine(int count) {
-        bufferMtx.lock();
-
-        int oldLineCount = _lineCount;
-        _lineCount += count;
-
-        // If new data either fills up or exceeds the limit, reallocate
-        // TODO: Change it to avoid bug if count >= reservedIncrement
-        if (_lineCount > reservedCount) {
-            printf("Reallocating\n");
-            reservedCount += _reservedIncrement;
-            frameBuffer = (uint8_t*)realloc(frameBuffer, _frameWidth * reservedCount * 4);
+        writeMtx.lock();
+        std::lock_guard<std::mutex> lck(bufferMtx);
+        assert(count <= _tileLines);
+
+        // Start a new tile if the lines don't fit in the current one
+        if (tiles.empty() || tiles.back().lines + count > _tileLines) {
+            Tile tile;
+            tile.data = (uint8_t*)malloc(_frameWidth * _tileLines * 4);
+            tile.firstLine = _lineCount;
+            tile.lines = 0;
+            tile.uploadedLines = 0;
+            tile.textureId = 0;
+            tiles.push_back(tile);
+
+            // Discard the oldest tiles if over the limit, unless they still need to be saved
+            while (_maxLines && tiles.size() > 1 && (_lineCount + count - tiles.front().firstLine) > _maxLines) {
+                Tile& old = tiles.front();
+                if (saving && savedLines < old.firstLine + old.lines) { break; }
+                free(old.data);
+                if (old.textureId) { unusedTextures.push_back(old.textureId); }
+                tiles.pop_front();
+            }
         }
 
-        return &frameBuffer[_frameWidth * oldLineCount * 4];
+        pendingCount = count;
+        Tile& tile = tiles.back();
+        return &tile.data[tile.lines * _frameWidth * 4];
     }
 
     void LinePushImage::releaseNextLine() {
-        newData = true;
-        bufferMtx.unlock();
+        {
+            std::lock_guard<std::mutex> lck(bufferMtx);
+            tiles.back().lines += pendingCount;
+            _lineCount += pendingCount;
+            pendingCount = 0;
+        }
+        saveCnd.notify_all();
+        writeMtx.unlock();
     }
 
     void LinePushImage::clear() {
-        std::lock_guard<std::mutex> lck(bufferMtx);
+        std::lock_guard<std::mutex> wlck(writeMtx);
+        std::unique_lock<std::mutex> lck(bufferMtx);
+
+        // Keep saving, but let the worker write the lines still in memory first
+        saveCnd.wait(lck, [this]() { return !saving || savedLines >= _lineCount; });
+
+        for (auto& tile : tiles) {
+            free(tile.data);
+            if (tile.textureId) { unusedTextures.push_back(tile.textureId); }
+        }
+        tiles.clear();
         _lineCount = 0;
-        frameBuffer = (uint8_t*)realloc(frameBuffer, _frameWidth * _reservedIncrement * 4);
-        reservedCount = _reservedIncrement;
-        newData = true;
+        savedLines = 0;
+    }
+
+    bool LinePushImage::save(std::string path) {
+        std::lock_guard<std::mutex> slck(saveMtx);
+        stopWorker();
+        std::lock_guard<std::mutex> lck(bufferMtx);
+        if (!pngWriter.open(path, _frameWidth)) {
+            flog::error("Could not create image file '{0}'", path);
+            return false;
+        }
+
+        // Start from the oldest line still in memory
+        savedLines = tiles.empty() ? _lineCount : tiles.front().firstLine;
+        saving = true;
+        stopRequested = false;
+        saveThread = std::thread(&LinePushImage::saveWorker, this);
+        return true;
+    }
+
+    void LinePushImage::stopSave() {
+        std::lock_guard<std::mutex> slck(saveMtx);
+        stopWorker();
     }
 
-    void LinePushImage::save(std::string path) {
-        // TODO: Implement
+    void LinePushImage::stopWorker() {
+        {
+            std::lock_guard<std::mutex> lck(bufferMtx);
+            if (!saving) { return; }
+            stopRequested = true;
+        }
+        saveCnd.notify_all();
+        if (saveThread.joinable()) { saveThread.join(); }
+
+        // Only now that the worker is gone can the tiles it was reading be discarded
+        {
+            std::lock_guard<std::mutex> lck(bufferMtx);
+            saving = false;
+        }
+        saveCnd.notify_all();
+    }
+
+    bool LinePushImage::isSaving() {
+        std::lock_guard<std::mutex> lck(bufferMtx);
+        return saving && !stopRequested;
     }
 
     int LinePushImage::getLineCount() {
+        std::lock_guard<std::mutex> lck(bufferMtx);
         return _lineCount;
     }
 
-    void LinePushImage::updateTexture() {
-        glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _frameWidth, _lineCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, frameBuffer);
+    void LinePushImage::updateTextures() {
+        for (auto& tile : tiles) {
+            if (tile.uploadedLines == tile.lines) { continue; }
+
+            // Allocate the texture for the whole tile the first time, reusing the texture of a discarded tile if possible
+            if (!tile.textureId) {
+                if (!unusedTextures.empty()) {
+                    tile.textureId = unusedTextures.back();
+                    unusedTextures.pop_back();
+                    glBindTexture(GL_TEXTURE_2D, tile.textureId);
+                }
+                else {
+                    glGenTextures(1, &tile.textureId);
+                    glBindTexture(GL_TEXTURE_2D, tile.textureId);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _frameWidth, _tileLines, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+                }
+            }
+            else {
+                glBindTexture(GL_TEXTURE_2D, tile.textureId);
+            }
+
+            // Only upload the lines added since the last time
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, tile.uploadedLines, _frameWidth, tile.lines - tile.uploadedLines, GL_RGBA, GL_UNSIGNED_BYTE, &tile.data[tile.uploadedLines * _frameWidth * 4]);
+            tile.uploadedLines = tile.lines;
+        }
     }
 
-}
\ No newline at end of file
+    void LinePushImage::saveWorker() {
+        while (true) {
+            uint8_t* data;
+            int count;
+            {
+                // Wait for new lines, or for the save to be stopped once everything is written
+                std::unique_lock<std::mutex> lck(bufferMtx);
+                saveCnd.wait(lck, [this]() { return savedLines < _lineCount || stopRequested; });
+                if (savedLines >= _lineCount) { break; }
+
+                // Tiles holding unsaved lines are never discarded while the worker runs so the data can be used after
+                // unlocking. Should the lines be gone anyway, skip to the oldest line still in memory.
+                auto it = std::find_if(tiles.begin(), tiles.end(), [this](const Tile& tile) { return savedLines < tile.firstLine + tile.lines; });
+                if (it == tiles.end() || savedLines < it->firstLine) {
+                    flog::warn("Lines {0} to {1} were discarded before being saved", savedLines, (it == tiles.end()) ? _lineCount : it->firstLine);
+                    savedLines = (it == tiles.end()) ? _lineCount : it->firstLine;
+                    continue;
+                }
+                data = &it->data[(savedLines - it->firstLine) * _frameWidth * 4];
+                count = it->firstLine + it->lines - savedLines;
+            }
+
+            pngWriter.write(data, count);
+
+            {
+                std::lock_guard<std::mutex> lck(bufferMtx);
+                savedLines += count;
+            }
+            saveCnd.notify_all();
+        }
+        pngWriter.close();
+    }
+}
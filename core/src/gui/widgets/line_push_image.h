@@ -3,40 +3,98 @@
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <dsp/stream.h>
+#include <utils/png.h>
 #include <mutex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <condition_variable>
 
 #include <utils/opengl_include_code.h>
 
 namespace ImGui {
+    /**
+     * Image growing one line at a time, for example a satellite image being decoded.
+     * Lines are stored in fixed size tiles, each with its own texture, so that new lines only cause the last tile to be
+     * uploaded and memory never has to be reallocated. With a line limit, the oldest tiles are discarded.
+     * Lines being written by the decoder are outside of the visible area so drawing never waits for the decoder.
+    */
     class LinePushImage {
     public:
-        LinePushImage(int frameWidth, int reservedIncrement);
+        /**
+         * Create an image.
+         * @param frameWidth Width of the image in pixels.
+         * @param tileLines Number of lines per tile.
+         * @param maxLines Maximum number of lines kept in memory, 0 for no limit.
+        */
+        LinePushImage(int frameWidth, int tileLines, int maxLines = 0);
+        ~LinePushImage();
 
         void draw(const ImVec2& size_arg = ImVec2(0, 0));
 
+        /**
+         * Get a buffer for the next lines, the lines become visible once released.
+         * @param count Number of lines, at most the number of lines per tile.
+         * @return RGBA buffer for the lines.
+        */
         uint8_t* acquireNextLine(int count = 1);
 
         void releaseNextLine();
 
+        /**
+         * Remove all lines. An ongoing save continues with the next lines, after the lines being removed are written.
+        */
         void clear();
 
-        void save(std::string path);
+        /**
+         * Save the image to a PNG file. Lines still in memory are written, then the file is kept open and every new line
+         * is appended to it from a background thread until stopSave() is called.
+         * @param path Path of the file.
+         * @return True if the file could be created.
+        */
+        bool save(std::string path);
+
+        void stopSave();
+
+        bool isSaving();
 
         int getLineCount();
 
     private:
-        void updateTexture();
+        struct Tile {
+            uint8_t* data;
+            int firstLine;
+            int lines;
+            int uploadedLines;
+            GLuint textureId;
+        };
+
+        void updateTextures();
+        void stopWorker();
+        void saveWorker();
+
+        // Locked from acquire to release so that tiles can't be freed while being written
+        std::mutex writeMtx;
 
         std::mutex bufferMtx;
-        uint8_t* frameBuffer;
+        std::deque<Tile> tiles;
+        std::vector<GLuint> unusedTextures;
 
         int _frameWidth;
-        int _reservedIncrement;
+        int _tileLines;
+        int _maxLines;
         int _lineCount = 0;
-        int reservedCount = 0;
+        int pendingCount = 0;
 
-        GLuint textureId;
+        // Serializes save() and stopSave()
+        std::mutex saveMtx;
 
-        bool newData = false;
+        // Streaming save, protected by bufferMtx. saving stays true until the worker has exited.
+        std::condition_variable saveCnd;
+        std::thread saveThread;
+        png::Writer pngWriter;
+        bool saving = false;
+        bool stopRequested = false;
+        int savedLines = 0;
     };
-}
\ No newline at end of file
+}
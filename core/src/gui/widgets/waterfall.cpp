@@ -649,13 +649,34 @@ namespace ImGui {
         }
 
 
-        for (int i = 0; i < count; i++) {
+        // Measuring the text and looking up the colors of every band each frame is what makes large band plans slow
+        if (bandCachePlan != bandplan || bandCache.size() != count || bandCacheFontSize != ImGui::GetFontSize()) {
+            bandCache.resize(count);
+            for (int i = 0; i < count; i++) {
+                BandMetrics& m = bandCache[i];
+                m.txtSz = ImGui::CalcTextSize(bandplan->bands[i].name.c_str());
+                auto it = bandplan::colorTable.find(bandplan->bands[i].type);
+                if (it != bandplan::colorTable.end()) {
+                    m.color = it->second.colorValue;
+                    m.colorTrans = it->second.transColorValue;
+                }
+                else {
+                    m.color = IM_COL32(255, 255, 255, 255);
+                    m.colorTrans = IM_COL32(255, 255, 255, 100);
+                }
+            }
+            bandCachePlan = bandplan;
+            bandCacheFontSize = ImGui::GetFontSize();
+        }
+
+        // Bands are sorted by start frequency, skip straight to the first one that can be visible
+        for (int i = bandplan::firstBandEndingAfter(*bandplan, lowerFreq); i < count; i++) {
             start = bandplan->bands[i].start;
             end = bandplan->bands[i].end;
-            if (start < lowerFreq && end < lowerFreq) {
-                continue;
+            if (start > upperFreq) {
+                break;
             }
-            if (start > upperFreq && end > upperFreq) {
+            if (end < lowerFreq) {
                 continue;
             }
             startVis = (start > lowerFreq);
@@ -667,15 +688,9 @@ namespace ImGui {
             bPos = fftAreaMin.x + ((end - lowerFreq) * horizScale);
             cPos = fftAreaMin.x + ((center - lowerFreq) * horizScale);
             width = bPos - aPos;
-            txtSz = ImGui::CalcTextSize(bandplan->bands[i].name.c_str());
-            if (bandplan::colorTable.find(bandplan->bands[i].type.c_str()) != bandplan::colorTable.end()) {
-                color = bandplan::colorTable[bandplan->bands[i].type].colorValue;
-                colorTrans = bandplan::colorTable[bandplan->bands[i].type].transColorValue;
-            }
-            else {
-                color = IM_COL32(255, 255, 255, 255);
-                colorTrans = IM_COL32(255, 255, 255, 100);
-            }
+            txtSz = bandCache[i].txtSz;
+            color = bandCache[i].color;
+            colorTrans = bandCache[i].colorTrans;
             if (aPos <= fftAreaMin.x) {
                 aPos = fftAreaMin.x + 1;
             }
@@ -873,22 +888,24 @@ namespace ImGui {
         buf_mtx.unlock();
     }
 
-    float* WaterFall::getFFTBuffer() {
-        if (rawFFTs == NULL) { return NULL; }
-        buf_mtx.lock();
+    void WaterFall::pushFFT(const float* data, int size) {
+        std::lock_guard<std::recursive_mutex> lck(buf_mtx);
+        if (size != rawFFTSize) { setRawFFTSize(size); }
+        if (rawFFTs == NULL) { return; }
+
+        // Write the line to the raw FFT history
         if (waterfallVisible) {
             currentFFTLine--;
             fftLines++;
             currentFFTLine = ((currentFFTLine + waterfallHeight) % waterfallHeight);
             fftLines = std::min<float>(fftLines, waterfallHeight);
-            return &rawFFTs[currentFFTLine * rawFFTSize];
+            memcpy(&rawFFTs[currentFFTLine * rawFFTSize], data, size * sizeof(float));
+        }
+        else {
+            memcpy(rawFFTs, data, size * sizeof(float));
         }
-        return rawFFTs;
-    }
 
-    void WaterFall::pushFFT() {
-        if (rawFFTs == NULL) { return; }
-        std::lock_guard<std::recursive_mutex> lck(latestFFTMtx);
+        std::lock_guard<std::recursive_mutex> lck2(latestFFTMtx);
         double offsetRatio = viewOffset / (wholeBandwidth / 2.0);
         int drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
         int drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
@@ -912,7 +929,7 @@ namespace ImGui {
 
         // Apply smoothing if enabled
         if (fftSmoothing && latestFFT != NULL && smoothingBuf != NULL && fftLines != 0) {
-            std::lock_guard<std::mutex> lck2(smoothingBufMtx);
+            std::lock_guard<std::mutex> lck3(smoothingBufMtx);
             volk_32f_s32f_multiply_32f(latestFFT, latestFFT, fftSmoothingAlpha, dataWidth);
             volk_32f_s32f_multiply_32f(smoothingBuf, smoothingBuf, fftSmoothingBeta, dataWidth);
             volk_32f_x2_add_32f(smoothingBuf, latestFFT, smoothingBuf, dataWidth);
@@ -937,8 +954,6 @@ namespace ImGui {
                 latestFFTHold[i] = std::max<float>(latestFFT[i], latestFFTHold[i] - fftHoldSpeed);
             }
         }
-
-        buf_mtx.unlock();
     }
 
     void WaterFall::updatePallette(float colors[][3], int colorCount) {
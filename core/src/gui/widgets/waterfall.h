@@ -87,8 +87,9 @@ namespace ImGui {
         void init();
 
         void draw();
-        float* getFFTBuffer();
-        void pushFFT();
+
+        // Append a spectrum line, the raw FFT size follows the size of the pushed data
+        void pushFFT(const float* data, int size);
 
         void updatePallette(float colors[][3], int colorCount);
         void updatePalletteFromArray(float* colors, int colorCount);
@@ -303,6 +304,16 @@ namespace ImGui {
 
         int bandPlanPos = BANDPLAN_POS_BOTTOM;
 
+        // Text size and colors of each band, computed once per band plan and font size
+        struct BandMetrics {
+            ImVec2 txtSz;
+            uint32_t color;
+            uint32_t colorTrans;
+        };
+        std::vector<BandMetrics> bandCache;
+        bandplan::BandPlan_t* bandCachePlan = NULL;
+        float bandCacheFontSize = 0.0f;
+
         bool fftHold = false;
         float fftHoldSpeed = 0.3f;
 
@@ -1,8 +1,37 @@
 #include <module.h>
 #include <filesystem>
 #include <utils/flog.h>
+#include <algorithm>
+#include <math.h>
 
 ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
+    auto start = std::chrono::steady_clock::now();
+    Module_t mod = openModule(path);
+    double openTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return registerModule(path, mod, openTime);
+}
+
+ModuleManager::Module_t ModuleManager::loadModule(std::string path, std::function<bool(const ModuleInfo_t*)> accept) {
+    auto start = std::chrono::steady_clock::now();
+    Module_t mod = openModule(path);
+    if (mod.handle == NULL) { return mod; }
+    if (!accept(mod.info)) {
+        closeModule(mod);
+        mod.handle = NULL;
+        return mod;
+    }
+    double openTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return registerModule(path, mod, openTime);
+}
+
+void ModuleManager::loadModules(const std::vector<std::string>& paths, std::function<void(const std::string&)> onInit) {
+    for (auto const& path : paths) {
+        if (onInit) { onInit(path); }
+        loadModule(path);
+    }
+}
+
+ModuleManager::Module_t ModuleManager::openModule(std::string path) {
     Module_t mod;
 
     // On android, the path has to be relative, don't make it absolute
@@ -68,6 +97,19 @@ ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
         mod.handle = NULL;
         return mod;
     }
+    return mod;
+}
+
+void ModuleManager::closeModule(Module_t mod) {
+#ifdef _WIN32
+    FreeLibrary(mod.handle);
+#else
+    dlclose(mod.handle);
+#endif
+}
+
+ModuleManager::Module_t ModuleManager::registerModule(std::string path, Module_t mod, double openTime) {
+    if (mod.handle == NULL) { return mod; }
     if (modules.find(mod.info->name) != modules.end()) {
         flog::error("{0} has the same name as an already loaded module", path);
         mod.handle = NULL;
@@ -78,8 +120,11 @@ ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
             return _mod;
         }
     }
+    auto start = std::chrono::steady_clock::now();
     mod.init();
+    double initTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     modules[mod.info->name] = mod;
+    moduleTimes[mod.info->name] = { openTime, initTime };
     return mod;
 }
 
@@ -99,7 +144,9 @@ int ModuleManager::createInstance(std::string name, std::string module) {
     }
     Instance_t inst;
     inst.module = modules[module];
+    auto start = std::chrono::steady_clock::now();
     inst.instance = inst.module.createInstance(name);
+    instanceTimes[name].createTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     instances[name] = inst;
     onInstanceCreated.emit(name);
     return 0;
@@ -181,6 +228,29 @@ int ModuleManager::countModuleInstances(std::string module) {
 void ModuleManager::doPostInitAll() {
     for (auto& [name, inst] : instances) {
         flog::info("Running post-init for {0}", name);
+        auto start = std::chrono::steady_clock::now();
         inst.instance->postInit();
+        instanceTimes[name].postInitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+void ModuleManager::printStartupReport() {
+    // Slowest first
+    std::vector<std::pair<std::string, ModuleTiming_t>> mods(moduleTimes.begin(), moduleTimes.end());
+    std::sort(mods.begin(), mods.end(), [](const auto& a, const auto& b) {
+        return a.second.openTime + a.second.initTime > b.second.openTime + b.second.initTime;
+    });
+    std::vector<std::pair<std::string, InstanceTiming_t>> insts(instanceTimes.begin(), instanceTimes.end());
+    std::sort(insts.begin(), insts.end(), [](const auto& a, const auto& b) {
+        return a.second.createTime + a.second.postInitTime > b.second.createTime + b.second.postInitTime;
+    });
+
+    flog::info("Startup timing report (ms):");
+    for (auto const& [name, t] : mods) {
+        flog::info("  Module {}: open {}, init {}", name, (int)std::round(t.openTime), (int)std::round(t.initTime));
+    }
+    for (auto const& [name, t] : insts) {
+        if (instances.find(name) == instances.end()) { continue; }
+        flog::info("  Instance {} ({}): create {}, post-init {}", name, instances[name].module.info->name, (int)std::round(t.createTime), (int)std::round(t.postInitTime));
     }
 }
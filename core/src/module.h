@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include <chrono>
+#include <functional>
 #include <json.hpp>
 #include <utils/event.h>
 
@@ -77,8 +80,34 @@ public:
         ModuleManager::Instance* instance;
     };
 
+    // Startup costs in milliseconds
+    struct ModuleTiming_t {
+        double openTime;
+        double initTime;
+    };
+
+    struct InstanceTiming_t {
+        double createTime = 0;
+        double postInitTime = 0;
+    };
+
     ModuleManager::Module_t loadModule(std::string path);
 
+    /**
+     * Load a module only if its info is accepted, the library is closed without initializing the module otherwise.
+     * @param path Path of the module.
+     * @param accept Called with the info of the module, returns true to load it.
+     * @return The module, with a NULL handle if it couldn't be loaded or wasn't accepted.
+    */
+    ModuleManager::Module_t loadModule(std::string path, std::function<bool(const ModuleInfo_t*)> accept);
+
+    /**
+     * Load many modules in the given order.
+     * @param paths Paths of the modules.
+     * @param onInit Called with the path of each module before loading it, optional.
+    */
+    void loadModules(const std::vector<std::string>& paths, std::function<void(const std::string&)> onInit = NULL);
+
     int createInstance(std::string name, std::string module);
     int deleteInstance(std::string name);
     int deleteInstance(ModuleManager::Instance* instance);
@@ -93,12 +122,28 @@ public:
 
     void doPostInitAll();
 
+    // Log the time spent loading each module and creating each instance
+    void printStartupReport();
+
     Event<std::string> onInstanceCreated;
     Event<std::string> onInstanceDelete;
     Event<std::string> onInstanceDeleted;
 
     std::map<std::string, ModuleManager::Module_t> modules;
     std::map<std::string, ModuleManager::Instance_t> instances;
+
+    std::map<std::string, ModuleTiming_t> moduleTimes;
+    std::map<std::string, InstanceTiming_t> instanceTimes;
+
+private:
+    // Open the library and find its symbols
+    ModuleManager::Module_t openModule(std::string path);
+
+    // Close the library of a module that wasn't initialized
+    void closeModule(Module_t mod);
+
+    // Check and initialize an opened module, then add it to the loaded modules
+    ModuleManager::Module_t registerModule(std::string path, Module_t mod, double openTime);
 };
 
 #define SDRPP_MOD_INFO MOD_EXPORT const ModuleManager::ModuleInfo_t _INFO_
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "offline.h"
+#include "core.h"
+#include <utils/flog.h>
+#include <config.h>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <algorithm>
+#include <utils/wav.h>
+#include <signal_path/signal_path.h>
+#include <gui/smgui.h>
+
+// Time without stream activity after which the graph is considered drained, polling period and maximum wait
+#define DRAIN_IDLE_MS       200
+#define DRAIN_POLL_MS       10
+#define DRAIN_TIMEOUT_MS    10000
+
+namespace offline {
+    IQFileReader::~IQFileReader() {
+        close();
+    }
+
+    bool IQFileReader::open(std::string path) {
+        close();
+        file = std::ifstream(path, std::ios::binary);
+        if (!file.is_open()) { return false; }
+
+        // Check the RIFF header
+        riff::ChunkHeader riffHdr;
+        char form[4];
+        file.read((char*)&riffHdr, sizeof(riff::ChunkHeader));
+        file.read(form, 4);
+        if (!file || memcmp(riffHdr.id, "RIFF", 4) || memcmp(form, "WAVE", 4)) {
+            flog::error("{0} is not a WAV file", path);
+            return false;
+        }
+
+        // Walk the chunks until the data chunk is found
+        bool formatFound = false;
+        riff::ChunkHeader hdr;
+        while (file.read((char*)&hdr, sizeof(riff::ChunkHeader))) {
+            if (!memcmp(hdr.id, "fmt ", 4)) {
+                wav::FormatHeader fmt;
+                if (hdr.size < sizeof(wav::FormatHeader)) { break; }
+                file.read((char*)&fmt, sizeof(wav::FormatHeader));
+                file.seekg(hdr.size - sizeof(wav::FormatHeader) + (hdr.size & 1), std::ios::cur);
+                codec = fmt.codec;
+                bitDepth = fmt.bitDepth;
+                sampleRate = fmt.sampleRate;
+                if (fmt.channelCount != 2) {
+                    flog::error("Offline processing requires a 2 channel IQ file, {0} has {1} channels", path, fmt.channelCount);
+                    return false;
+                }
+                formatFound = true;
+            }
+            else if (!memcmp(hdr.id, "data", 4)) {
+                if (!formatFound) { break; }
+
+                // A size of 0 or 0xFFFFFFFF means the writer overflowed or was interrupted, read until EOF
+                uint64_t dataSize = hdr.size;
+                if (!dataSize || dataSize == 0xFFFFFFFF) {
+                    std::streampos begin = file.tellg();
+                    file.seekg(0, std::ios::end);
+                    dataSize = file.tellg() - begin;
+                    file.seekg(begin);
+                }
+                sampleCount = dataSize / (2 * (bitDepth / 8));
+                samplesLeft = sampleCount;
+                break;
+            }
+            else {
+                file.seekg(hdr.size + (hdr.size & 1), std::ios::cur);
+            }
+        }
+
+        if (!formatFound || !sampleCount) {
+            flog::error("{0} does not contain any IQ data", path);
+            return false;
+        }
+        if (!sampleRate) {
+            flog::error("Sample rate of {0} may not be zero", path);
+            return false;
+        }
+        if (!((codec == wav::CODEC_PCM && (bitDepth == 8 || bitDepth == 16 || bitDepth == 32)) || (codec == wav::CODEC_FLOAT && bitDepth == 32))) {
+            flog::error("Unsupported sample format in {0} (codec {1}, {2} bits)", path, codec, bitDepth);
+            return false;
+        }
+
+        return true;
+    }
+
+    void IQFileReader::close() {
+        if (file.is_open()) { file.close(); }
+        if (rawBuf) { dsp::buffer::free(rawBuf); }
+        rawBuf = NULL;
+        rawBufSize = 0;
+        sampleCount = 0;
+        samplesLeft = 0;
+    }
+
+    int IQFileReader::read(dsp::complex_t* data, int count) {
+        count = std::min<uint64_t>(count, samplesLeft);
+        if (count <= 0) { return 0; }
+
+        // Float files can be read directly in place
+        int bytesPerSamp = 2 * (bitDepth / 8);
+        if (codec == wav::CODEC_FLOAT) {
+            file.read((char*)data, count * bytesPerSamp);
+            count = file.gcount() / bytesPerSamp;
+            samplesLeft = count ? (samplesLeft - count) : 0;
+            return count;
+        }
+
+        // Otherwise read to the raw buffer and convert
+        if (rawBufSize < count * bytesPerSamp) {
+            if (rawBuf) { dsp::buffer::free(rawBuf); }
+            rawBufSize = count * bytesPerSamp;
+            rawBuf = dsp::buffer::alloc<uint8_t>(rawBufSize);
+        }
+        file.read((char*)rawBuf, count * bytesPerSamp);
+        count = file.gcount() / bytesPerSamp;
+        samplesLeft = count ? (samplesLeft - count) : 0;
+
+        if (bitDepth == 8) {
+            float* out = (float*)data;
+            for (int i = 0; i < count * 2; i++) { out[i] = ((float)rawBuf[i] - 128.0f) / 128.0f; }
+        }
+        else if (bitDepth == 16) {
+            volk_16i_s32f_convert_32f((float*)data, (int16_t*)rawBuf, 32768.0f, count * 2);
+        }
+        else {
+            volk_32i_s32f_convert_32f((float*)data, (int32_t*)rawBuf, 2147483648.0f, count * 2);
+        }
+
+        return count;
+    }
+
+    /**
+     * Wait for every block to be done with the data it was given, ie. no tracked stream holding unread data and
+     * no swap for DRAIN_IDLE_MS.
+     * @param lastActivity Receives the time at which the graph was last seen busy.
+     * @return False if the graph was still busy after DRAIN_TIMEOUT_MS.
+    */
+    bool waitForDrain(std::chrono::steady_clock::time_point& lastActivity) {
+        auto start = std::chrono::steady_clock::now();
+        lastActivity = start;
+        uint64_t lastSwaps = dsp::streamSwaps.load(std::memory_order_relaxed);
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_POLL_MS));
+            auto now = std::chrono::steady_clock::now();
+
+            // A block may briefly have flushed its input without having swapped its output yet, so also require the
+            // swap count to stay still for a while
+            uint64_t swaps = dsp::streamSwaps.load(std::memory_order_relaxed);
+            if (swaps != lastSwaps || dsp::streamsInFlight.load(std::memory_order_relaxed) > 0) {
+                lastSwaps = swaps;
+                lastActivity = now;
+            }
+            else if (now - lastActivity >= std::chrono::milliseconds(DRAIN_IDLE_MS)) {
+                return true;
+            }
+
+            if (now - start >= std::chrono::milliseconds(DRAIN_TIMEOUT_MS)) { return false; }
+        }
+    }
+
+    void vfoCreatedHandler(VFOManager::VFO* vfo, void* ctx) {
+        // Restore the VFO offset that was last used in the GUI
+        std::string name = vfo->getName();
+        core::configManager.acquire();
+        if (!core::configManager.conf["vfoOffsets"].contains(name)) {
+            core::configManager.release();
+            return;
+        }
+        double offset = core::configManager.conf["vfoOffsets"][name];
+        core::configManager.release();
+        sigpath::vfoManager.setCenterOffset(name, offset);
+    }
+
+    void ioRegisteredHandler(std::string name, void* ctx) {
+        *(bool*)ctx = true;
+    }
+
+    int main() {
+        flog::info("=====| OFFLINE MODE |=====");
+
+        // A batch run must never alter the configuration of the interactive instance
+        core::configManager.disableAutoSave();
+
+        // Open input file
+        std::string path = (std::string)core::args["offline"];
+        IQFileReader reader;
+        if (!reader.open(path)) { return -1; }
+        double sampleRate = reader.getSampleRate();
+        flog::info("Processing {0} ({1} samples at {2} S/s)", path, reader.getSampleCount(), sampleRate);
+
+        // Get the list of instances to run, all enabled ones if not specified
+        std::vector<std::string> selected;
+        std::stringstream ss((std::string)core::args["instances"]);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (!item.empty()) { selected.push_back(item); }
+        }
+        auto isSelected = [&](const std::string& name, bool enabled) {
+            return selected.empty() ? enabled : (std::find(selected.begin(), selected.end(), name) != selected.end());
+        };
+
+        // Load config
+        core::configManager.acquire();
+        std::string modulesDir = core::configManager.conf["modulesDirectory"];
+        std::vector<std::string> modules = core::configManager.conf["modules"];
+        json modList = core::configManager.conf["moduleInstances"];
+        int decimation = core::configManager.conf["decimation"];
+        bool dcBlocking = core::configManager.conf["iqCorrection"];
+        bool invertIQ = core::configManager.conf["invertIQ"];
+        core::configManager.release();
+        modulesDir = std::filesystem::absolute(modulesDir).string();
+
+        // Initialize SmGui in server mode so that module menus are never rendered
+        SmGui::init(true);
+
+        // Initialize the IQ frontend without buffering so that it applies back-pressure to the file reader.
+        // The spectrum has no subscriber in offline mode so the FFT is skipped entirely.
+        dsp::stream<dsp::complex_t> input;
+        sigpath::iqFrontEnd.init(&input, sampleRate, false, decimation, dcBlocking, 1024, 1.0, IQFrontEnd::FFTWindow::RECTANGULAR);
+        sigpath::iqFrontEnd.setInvertIQ(invertIQ);
+
+        EventHandler<VFOManager::VFO*> vfoHandler(vfoCreatedHandler, NULL);
+        sigpath::vfoManager.onVfoCreated.bindHandler(&vfoHandler);
+
+        // Only load the modules of the instances to run, identified by the name in their info
+        std::vector<std::string> needed;
+        for (auto const& [name, _module] : modList.items()) {
+            if (isSelected(name, _module["enabled"])) { needed.push_back(_module["module"]); }
+        }
+        auto acceptModule = [&](const ModuleManager::ModuleInfo_t* info) {
+            return std::find(needed.begin(), needed.end(), info->name) != needed.end();
+        };
+        flog::info("Loading modules");
+        std::vector<std::string> paths;
+        if (std::filesystem::is_directory(modulesDir)) {
+            for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
+                if (!file.is_regular_file()) { continue; }
+                paths.push_back(file.path().generic_string());
+            }
+        }
+        else {
+            flog::warn("Module directory {0} does not exist, not loading modules from directory", modulesDir);
+        }
+        for (auto const& apath : modules) {
+            paths.push_back(std::filesystem::absolute(apath).generic_string());
+        }
+        for (auto const& mpath : paths) {
+            std::filesystem::path file = mpath;
+            if (file.extension().generic_string() != SDRPP_MOD_EXTENTSION) { continue; }
+            if (core::moduleManager.loadModule(mpath, acceptModule).handle) { flog::info("Loaded {0}", mpath); }
+        }
+
+        // Create module instances. Sources and sinks are recognized by what they register and aren't run:
+        // the file takes the place of the source and sinks run in real time.
+        bool registeredIO = false;
+        EventHandler<std::string> ioHandler(ioRegisteredHandler, &registeredIO);
+        sigpath::sourceManager.onSourceRegistered.bindHandler(&ioHandler);
+        sigpath::sinkManager.onSinkProviderRegistered.bindHandler(&ioHandler);
+        for (auto const& [name, _module] : modList.items()) {
+            std::string mod = _module["module"];
+            if (core::moduleManager.modules.find(mod) == core::moduleManager.modules.end()) { continue; }
+            if (!isSelected(name, _module["enabled"])) { continue; }
+            flog::info("Initializing {0} ({1})", name, mod);
+            registeredIO = false;
+            core::moduleManager.createInstance(name, mod);
+            if (registeredIO) {
+                flog::info("{0} is a source or sink, not running it", name);
+                core::moduleManager.deleteInstance(name);
+            }
+        }
+        sigpath::sourceManager.onSourceRegistered.unbindHandler(&ioHandler);
+        sigpath::sinkManager.onSinkProviderRegistered.unbindHandler(&ioHandler);
+        core::moduleManager.doPostInitAll();
+
+        if (core::moduleManager.instances.empty()) {
+            flog::error("No module instance to run, check the --instances argument and the moduleInstances config");
+            return -1;
+        }
+
+        // Run the file through the graph as fast as the slowest block will allow, tracking its streams to know when
+        // it's done. Streams whose reader never runs, like those of an unused VFO, are left out.
+        flog::info("Running");
+        dsp::streamTracking = true;
+        sigpath::iqFrontEnd.start();
+        int blockSize = std::min<int>(sampleRate / 200.0, STREAM_BUFFER_SIZE);
+        uint64_t processed = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (true) {
+            int count = reader.read(input.writeBuf, blockSize);
+            if (!count) { break; }
+            if (!input.swap(count)) { break; }
+            processed += count;
+        }
+
+        // Push a short silent tail so that the last samples of the file make it through the filter delay lines
+        int tailSize = std::min<int>(sampleRate / 10.0, STREAM_BUFFER_SIZE);
+        dsp::buffer::clear(input.writeBuf, tailSize);
+        input.swap(tailSize);
+
+        // Swapping only means the first block took the data, wait for every block downstream to be done with it
+        std::chrono::steady_clock::time_point end;
+        if (!waitForDrain(end)) {
+            flog::warn("The graph was still busy {0}ms after the end of the file, the end of the output may be missing", DRAIN_TIMEOUT_MS);
+        }
+        dsp::streamTracking = false;
+
+        // Shut down the graph
+        sigpath::iqFrontEnd.stop();
+        for (auto& [name, inst] : core::moduleManager.instances) {
+            inst.instance->disable();
+        }
+        for (auto& [name, mod] : core::moduleManager.modules) {
+            mod.end();
+        }
+
+        // Report throughput
+        double wallTime = std::chrono::duration<double>(end - start).count();
+        double signalTime = (double)processed / sampleRate;
+        flog::info("Processed {0} samples ({1}s of signal) in {2}s", processed, signalTime, wallTime);
+        flog::info("Throughput: {0} MS/s ({1}x real time)", (double)processed / (wallTime * 1e6), signalTime / wallTime);
+
+        return 0;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+#include <fstream>
+#include <dsp/stream.h>
+#include <dsp/types.h>
+
+namespace offline {
+    class IQFileReader {
+    public:
+        ~IQFileReader();
+
+        bool open(std::string path);
+        void close();
+
+        // Read up to count samples, returns the number of samples read or 0 at the end of the file
+        int read(dsp::complex_t* data, int count);
+
+        double getSampleRate() { return sampleRate; }
+        uint64_t getSampleCount() { return sampleCount; }
+
+    private:
+        std::ifstream file;
+        uint16_t codec = 0;
+        uint16_t bitDepth = 0;
+        double sampleRate = 0;
+        uint64_t sampleCount = 0;
+        uint64_t samplesLeft = 0;
+        uint8_t* rawBuf = NULL;
+        int rawBufSize = 0;
+    };
+
+    int main();
+}
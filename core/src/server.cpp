@@ -44,6 +44,12 @@ namespace server {
     int sourceId = 0;
     bool running = false;
     bool compression = false;
+
+    // UI sync state of the client. With the delta protocol, draw lists are sent as changes against lastUI.
+    UIProtocol uiProtocol = UI_PROTOCOL_FULL;
+    SmGui::DrawList lastUI;
+    uint32_t uiVersion = 0;
+
     double sampleRate = 1000000.0;
 
     int main() {
@@ -90,6 +96,7 @@ namespace server {
         flog::info("Loading modules");
         // Load modules and check type to only load sources ( TODO: Have a proper type parameter int the info )
         // TODO LATER: Add whitelist/blacklist stuff
+        std::vector<std::string> modulePaths;
         if (std::filesystem::is_directory(modulesDir)) {
             for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
                 std::string path = file.path().generic_string();
@@ -99,9 +106,7 @@ namespace server {
                 }
                 if (!file.is_regular_file()) { continue; }
                 if (fn.find("source") == std::string::npos) { continue; }
-
-                flog::info("Loading {0}", path);
-                core::moduleManager.loadModule(path);
+                modulePaths.push_back(path);
             }
         }
         else {
@@ -119,10 +124,11 @@ namespace server {
             }
             if (!std::filesystem::is_regular_file(file)) { continue; }
             if (fn.find("source") == std::string::npos) { continue; }
-
-            flog::info("Loading {0}", path);
-            core::moduleManager.loadModule(path);
+            modulePaths.push_back(path);
         }
+        core::moduleManager.loadModules(modulePaths, [](const std::string& path) {
+            flog::info("Loading {0}", path);
+        });
 
         // Create module instances
         for (auto const& [name, _module] : modList) {
@@ -136,6 +142,7 @@ namespace server {
 
         // Do post-init
         core::moduleManager.doPostInitAll();
+        core::moduleManager.printStartupReport();
 
         // Generate source list
         auto list = sigpath::sourceManager.getSourceNames();
@@ -192,6 +199,9 @@ namespace server {
         sigpath::sourceManager.stop();
         comp.setPCMType(dsp::compression::PCM_TYPE_I16);
         compression = false;
+        uiProtocol = UI_PROTOCOL_FULL;
+        lastUI.elements.clear();
+        uiVersion = 0;
 
         sendSampleRate(sampleRate);
 
@@ -248,6 +258,12 @@ namespace server {
 
     void commandHandler(Command cmd, uint8_t* data, int len) {
         if (cmd == COMMAND_GET_UI) {
+            // Clients supporting a newer UI protocol announce it, tell them which one will be used before replying
+            if (len >= 1 && data[0] >= UI_PROTOCOL_DELTA && uiProtocol != UI_PROTOCOL_DELTA) {
+                uiProtocol = UI_PROTOCOL_DELTA;
+                s_cmd_data[0] = uiProtocol;
+                sendCommand(COMMAND_SET_UI_PROTOCOL, 1);
+            }
             sendUI(COMMAND_GET_UI, "", dummyElem);
         }
         else if (cmd == COMMAND_UI_ACTION && len >= 3) {
@@ -277,6 +293,9 @@ namespace server {
             }
             else {
                 renderUI(NULL, diffId.str, diffValue);
+
+                // The client already shows the new value, keep the next delta relative to what it has
+                if (uiProtocol == UI_PROTOCOL_DELTA) { lastUI.applyDiff(diffId.str, diffValue); }
             }
         }
         else if (cmd == COMMAND_START) {
@@ -346,7 +365,30 @@ namespace server {
 
         // Create response
         int size = dl.getSize();
-        dl.store(s_cmd_data, size);
+        if (uiProtocol == UI_PROTOCOL_DELTA) {
+            UIUpdateHeader* hdr = (UIUpdateHeader*)s_cmd_data;
+            uint8_t* payload = &s_cmd_data[sizeof(UIUpdateHeader)];
+            int maxLen = SERVER_MAX_PACKET_SIZE - sizeof(PacketHeader) - sizeof(CommandHeader) - sizeof(UIUpdateHeader);
+
+            // Send only the changes since the last list the client got, unless it asked for the whole UI or they aren't smaller
+            int deltaSize = -1;
+            if (originCmd != COMMAND_GET_UI) { deltaSize = dl.storeDelta(lastUI, payload, maxLen); }
+            if (deltaSize >= 0 && deltaSize < size) {
+                hdr->type = UI_UPDATE_DELTA;
+                size = deltaSize;
+            }
+            else {
+                hdr->type = UI_UPDATE_FULL;
+                dl.store(payload, size);
+            }
+            hdr->baseVersion = uiVersion;
+            hdr->version = ++uiVersion;
+            size += sizeof(UIUpdateHeader);
+            lastUI = std::move(dl);
+        }
+        else {
+            dl.store(s_cmd_data, size);
+        }
 
         // Send to network
         sendCommandAck(originCmd, size);
@@ -5,6 +5,9 @@
 
 #define SERVER_MAX_PACKET_SIZE  (STREAM_BUFFER_SIZE * sizeof(dsp::complex_t) * 2)
 
+// Highest UI protocol understood, sent as the argument of COMMAND_GET_UI. Servers predating it ignore the argument.
+#define UI_PROTOCOL_VERSION     1
+
 namespace server {
     enum PacketType {
         // Client to Server
@@ -30,7 +33,20 @@ namespace server {
 
         // Server to client
         COMMAND_SET_SAMPLERATE = 0x80,
-        COMMAND_DISCONNECT
+        COMMAND_DISCONNECT,
+        COMMAND_SET_UI_PROTOCOL
+    };
+
+    enum UIProtocol {
+        // UI acks carry the whole draw list
+        UI_PROTOCOL_FULL = 0,
+        // UI acks start with a UIUpdateHeader and carry either the whole draw list or only its changes
+        UI_PROTOCOL_DELTA
+    };
+
+    enum UIUpdateType {
+        UI_UPDATE_FULL,
+        UI_UPDATE_DELTA
     };
 
     enum Error {
@@ -49,5 +65,13 @@ namespace server {
     struct CommandHeader {
         uint32_t cmd;
     };
+
+    struct UIUpdateHeader {
+        uint8_t type;
+        // Version of the draw list a delta applies to
+        uint32_t baseVersion;
+        // Version of the draw list once the update is applied
+        uint32_t version;
+    };
 #pragma pack(pop)
 }
\ No newline at end of file
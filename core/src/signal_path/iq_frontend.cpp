@@ -2,7 +2,7 @@
 #include "../dsp/window/blackman.h"
 #include "../dsp/window/nuttall.h"
 #include <utils/flog.h>
-#include <gui/gui.h>
+#include <signal_path/signal_path.h>
 #include <core.h>
 
 IQFrontEnd::~IQFrontEnd() {
@@ -12,17 +12,15 @@ IQFrontEnd::~IQFrontEnd() {
     fftwf_destroy_plan(fftwPlan);
     fftwf_free(fftInBuf);
     fftwf_free(fftOutBuf);
+    dsp::buffer::free(fftDbOut);
 }
 
-void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow, float* (*acquireFFTBuffer)(void* ctx), void (*releaseFFTBuffer)(void* ctx), void* fftCtx) {
+void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow) {
     _sampleRate = sampleRate;
     _decimRatio = decimRatio;
     _fftSize = fftSize;
     _fftRate = fftRate;
     _fftWindow = fftWindow;
-    _acquireFFTBuffer = acquireFFTBuffer;
-    _releaseFFTBuffer = releaseFFTBuffer;
-    _fftCtx = fftCtx;
 
     effectiveSr = _sampleRate / _decimRatio;
 
@@ -60,6 +58,7 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    fftDbOut = dsp::buffer::alloc<float>(_fftSize);
 
     // Clear the rest of the FFT input buffer
     dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
@@ -184,7 +183,7 @@ void IQFrontEnd::removeVFO(std::string name) {
 
 void IQFrontEnd::setFFTSize(int size) {
     _fftSize = size;
-    updateFFTPath(true);
+    updateFFTPath();
 }
 
 void IQFrontEnd::setFFTRate(double rate) {
@@ -248,25 +247,23 @@ double IQFrontEnd::getEffectiveSamplerate() {
 void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
     IQFrontEnd* _this = (IQFrontEnd*)ctx;
 
+    // Don't waste time on the FFT if nobody is listening
+    if (!sigpath::spectrumBus.hasSubscribers()) { return; }
+
     // Apply window
     volk_32fc_32f_multiply_32fc((lv_32fc_t*)_this->fftInBuf, (lv_32fc_t*)data, _this->fftWindowBuf, _this->_nzFFTSize);
 
     // Execute FFT
     fftwf_execute(_this->fftwPlan);
 
-    // Aquire buffer
-    float* fftBuf = _this->_acquireFFTBuffer(_this->_fftCtx);
-
     // Convert the complex output of the FFT to dB amplitude
-    if (fftBuf) {
-        volk_32fc_s32f_power_spectrum_32f(fftBuf, (lv_32fc_t*)_this->fftOutBuf, _this->_fftSize, _this->_fftSize);
-    }
+    volk_32fc_s32f_power_spectrum_32f(_this->fftDbOut, (lv_32fc_t*)_this->fftOutBuf, _this->_fftSize, _this->_fftSize);
 
-    // Release buffer
-    _this->_releaseFFTBuffer(_this->_fftCtx);
+    // Publish it without ever waiting on the consumers
+    sigpath::spectrumBus.publish(_this->fftDbOut, _this->_fftSize, _this->effectiveSr);
 }
 
-void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
+void IQFrontEnd::updateFFTPath() {
     // Temp stop branch
     reshape.tempStop();
     fftSink.tempStop();
@@ -296,12 +293,13 @@ void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
     fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    dsp::buffer::free(fftDbOut);
+    fftDbOut = dsp::buffer::alloc<float>(_fftSize);
 
     // Clear the rest of the FFT input buffer
     dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
 
-    // Update waterfall (TODO: This is annoying, it makes this module non testable and will constantly clear the waterfall for any reason)
-    if (updateWaterfall) { gui::waterfall.setRawFFTSize(_fftSize); }
+    // Consumers pick up the new FFT size from the frames themselves
 
     // Restart branch
     reshape.tempStart();
@@ -20,7 +20,7 @@ public:
         NUTTALL
     };
 
-    void init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow, float* (*acquireFFTBuffer)(void* ctx), void (*releaseFFTBuffer)(void* ctx), void* fftCtx);
+    void init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow);
 
     void setInput(dsp::stream<dsp::complex_t>* in);
     void setSampleRate(double sampleRate);
@@ -50,7 +50,7 @@ public:
 
 protected:
     static void handler(dsp::complex_t* data, int count, void* ctx);
-    void updateFFTPath(bool updateWaterfall = false);
+    void updateFFTPath();
 
     static inline double genDCBlockRate(double sampleRate) {
         return 50.0 / sampleRate;
@@ -89,9 +89,6 @@ protected:
     int _fftSize;
     double _fftRate;
     FFTWindow _fftWindow;
-    float* (*_acquireFFTBuffer)(void* ctx);
-    void (*_releaseFFTBuffer)(void* ctx);
-    void* _fftCtx;
 
     // Processing data
     int _nzFFTSize;
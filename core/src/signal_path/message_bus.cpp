@@ -0,0 +1,277 @@
+#include "message_bus.h"
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+
+static void copyName(char* dst, const char* src) {
+    strncpy(dst, src, MESSAGE_MAX_NAME_LEN - 1);
+    dst[MESSAGE_MAX_NAME_LEN - 1] = 0;
+}
+
+DecodedMessage::DecodedMessage(const char* decoder, const char* type, double frequency) {
+    copyName(this->decoder, decoder);
+    copyName(this->type, type);
+    this->frequency = frequency;
+}
+
+DecodedMessage::Field* DecodedMessage::addField(const char* name, MessageFieldType type) {
+    if (fieldCount >= MESSAGE_MAX_FIELDS) { return NULL; }
+    Field* field = &fields[fieldCount++];
+    copyName(field->name, name);
+    field->type = type;
+    return field;
+}
+
+void DecodedMessage::addInt(const char* name, int64_t value) {
+    Field* field = addField(name, MESSAGE_FIELD_INT);
+    if (field) { field->integer = value; }
+}
+
+void DecodedMessage::addFloat(const char* name, double value) {
+    Field* field = addField(name, MESSAGE_FIELD_FLOAT);
+    if (field) { field->number = value; }
+}
+
+void DecodedMessage::addText(const char* name, const char* text, int len) {
+    addData(name, MESSAGE_FIELD_TEXT, (const uint8_t*)text, (len < 0) ? strlen(text) : len);
+}
+
+void DecodedMessage::addBytes(const char* name, const uint8_t* data, int len) {
+    addData(name, MESSAGE_FIELD_BYTES, data, len);
+}
+
+void DecodedMessage::addData(const char* name, MessageFieldType type, const uint8_t* data, int len) {
+    Field* field = addField(name, type);
+    if (!field) { return; }
+    len = std::min<int>(len, MESSAGE_PAYLOAD_SIZE - payloadSize);
+    memcpy(&payload[payloadSize], data, len);
+    field->data.offset = payloadSize;
+    field->data.len = len;
+    payloadSize += len;
+}
+
+// Appends to a fixed size buffer, silently truncating once full
+class OutBuffer {
+public:
+    OutBuffer(uint8_t* buf, int maxLen) : buf(buf), maxLen(maxLen) {}
+
+    void put(const void* data, int len) {
+        len = std::min<int>(len, maxLen - pos);
+        memcpy(&buf[pos], data, len);
+        pos += len;
+    }
+
+    void put(uint8_t b) {
+        if (pos < maxLen) { buf[pos++] = b; }
+    }
+
+    void put(const char* str) { put(str, strlen(str)); }
+
+    void putLE(uint64_t val, int bytes) {
+        for (int i = 0; i < bytes; i++) { put((uint8_t)(val >> (8 * i))); }
+    }
+
+    void putDouble(double val) {
+        uint64_t raw;
+        memcpy(&raw, &val, sizeof(double));
+        putLE(raw, 8);
+    }
+
+    void putJSONString(const uint8_t* str, int len) {
+        static const char HEX[] = "0123456789abcdef";
+        put('"');
+        for (int i = 0; i < len; i++) {
+            uint8_t c = str[i];
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            }
+            else if (c < 0x20 || c >= 0x7F) {
+                // Control characters and 8-bit bytes, the latter read as latin-1 so that the output is always valid UTF-8
+                char esc[7] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF], 0 };
+                put(esc, 6);
+            }
+            else {
+                put(c);
+            }
+        }
+        put('"');
+    }
+
+    void putJSONString(const char* str) { putJSONString((const uint8_t*)str, strlen(str)); }
+
+    void putJSONHex(const uint8_t* data, int len) {
+        static const char HEX[] = "0123456789abcdef";
+        put('"');
+        for (int i = 0; i < len; i++) {
+            put(HEX[data[i] >> 4]);
+            put(HEX[data[i] & 0xF]);
+        }
+        put('"');
+    }
+
+    void putJSONNumber(double val, const char* fmt) {
+        if (!std::isfinite(val)) {
+            put("null");
+            return;
+        }
+        char tmp[64];
+        put(tmp, snprintf(tmp, sizeof(tmp), fmt, val));
+    }
+
+    uint8_t* buf;
+    int maxLen;
+    int pos = 0;
+};
+
+int DecodedMessage::toJSON(char* buf, int maxLen) const {
+    OutBuffer out((uint8_t*)buf, maxLen);
+    char tmp[64];
+    out.put(tmp, snprintf(tmp, sizeof(tmp), "{\"seq\":%llu,\"time\":", (unsigned long long)sequence));
+    out.putJSONNumber(timestamp, "%.6f");
+    out.put(",\"frequency\":");
+    out.putJSONNumber(frequency, "%.1f");
+    out.put(",\"decoder\":");
+    out.putJSONString(decoder);
+    out.put(",\"type\":");
+    out.putJSONString(type);
+    for (int i = 0; i < fieldCount; i++) {
+        const Field& f = fields[i];
+        out.put(',');
+        out.putJSONString(f.name);
+        out.put(':');
+        switch (f.type) {
+        case MESSAGE_FIELD_INT:
+            out.put(tmp, snprintf(tmp, sizeof(tmp), "%lld", (long long)f.integer));
+            break;
+        case MESSAGE_FIELD_FLOAT:
+            out.putJSONNumber(f.number, "%.9g");
+            break;
+        case MESSAGE_FIELD_TEXT:
+            out.putJSONString(&payload[f.data.offset], f.data.len);
+            break;
+        case MESSAGE_FIELD_BYTES:
+            out.putJSONHex(&payload[f.data.offset], f.data.len);
+            break;
+        }
+    }
+    out.put("}\n");
+    return out.pos;
+}
+
+int DecodedMessage::toBinary(uint8_t* buf, int maxLen) const {
+    OutBuffer out(buf, maxLen);
+    out.putLE(0, 4);
+    out.putLE(sequence, 8);
+    out.putDouble(timestamp);
+    out.putDouble(frequency);
+    int decoderLen = strlen(decoder);
+    out.put((uint8_t)decoderLen);
+    out.put(decoder, decoderLen);
+    int typeLen = strlen(type);
+    out.put((uint8_t)typeLen);
+    out.put(type, typeLen);
+    out.put((uint8_t)fieldCount);
+    for (int i = 0; i < fieldCount; i++) {
+        const Field& f = fields[i];
+        int nameLen = strlen(f.name);
+        out.put((uint8_t)nameLen);
+        out.put(f.name, nameLen);
+        out.put((uint8_t)f.type);
+        switch (f.type) {
+        case MESSAGE_FIELD_INT:
+            out.putLE(f.integer, 8);
+            break;
+        case MESSAGE_FIELD_FLOAT:
+            out.putDouble(f.number);
+            break;
+        case MESSAGE_FIELD_TEXT:
+        case MESSAGE_FIELD_BYTES:
+            out.putLE(f.data.len, 2);
+            out.put(&payload[f.data.offset], f.data.len);
+            break;
+        }
+    }
+
+    // Fill in the length prefix
+    uint32_t len = out.pos - 4;
+    for (int i = 0; i < 4; i++) { buf[i] = len >> (8 * i); }
+    return out.pos;
+}
+
+MessageSubscriber::MessageSubscriber(int queueDepth) {
+    depth = queueDepth;
+    slots.resize(depth);
+}
+
+const DecodedMessage* MessageSubscriber::read() {
+    // Release the previously read message
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    if (holding) {
+        tail.store(++t, std::memory_order_release);
+        holding = false;
+    }
+    if (t == head.load(std::memory_order_acquire)) { return NULL; }
+    holding = true;
+    return &slots[t % depth];
+}
+
+bool MessageSubscriber::available() {
+    return (tail.load(std::memory_order_relaxed) + (holding ? 1 : 0)) != head.load(std::memory_order_acquire);
+}
+
+bool MessageSubscriber::wait(int timeoutMs) {
+    // A notification missed between the check and the wait only delays the consumer by the timeout
+    std::unique_lock<std::mutex> lck(waitMtx);
+    return waitCnd.wait_for(lck, std::chrono::milliseconds(timeoutMs), [this]() { return available(); });
+}
+
+void MessageSubscriber::write(const DecodedMessage& msg) {
+    // Drop the message if the consumer is too far behind
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= depth) {
+        dropped++;
+        return;
+    }
+
+    // Only copy the used part of the payload
+    DecodedMessage& slot = slots[h % depth];
+    slot.sequence = msg.sequence;
+    slot.timestamp = msg.timestamp;
+    slot.frequency = msg.frequency;
+    memcpy(slot.decoder, msg.decoder, MESSAGE_MAX_NAME_LEN);
+    memcpy(slot.type, msg.type, MESSAGE_MAX_NAME_LEN);
+    slot.fieldCount = msg.fieldCount;
+    memcpy(slot.fields, msg.fields, msg.fieldCount * sizeof(DecodedMessage::Field));
+    slot.payloadSize = msg.payloadSize;
+    memcpy(slot.payload, msg.payload, msg.payloadSize);
+
+    head.store(h + 1, std::memory_order_release);
+    waitCnd.notify_one();
+}
+
+void MessageBus::subscribe(MessageSubscriber* sub) {
+    std::lock_guard<std::mutex> lck(subMtx);
+    if (std::find(subscribers.begin(), subscribers.end(), sub) != subscribers.end()) { return; }
+    subscribers.push_back(sub);
+    subscriberCount = subscribers.size();
+}
+
+void MessageBus::unsubscribe(MessageSubscriber* sub) {
+    std::lock_guard<std::mutex> lck(subMtx);
+    auto it = std::find(subscribers.begin(), subscribers.end(), sub);
+    if (it == subscribers.end()) { return; }
+    subscribers.erase(it);
+    subscriberCount = subscribers.size();
+}
+
+void MessageBus::publish(DecodedMessage& msg) {
+    msg.timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lck(subMtx);
+    msg.sequence = ++sequence;
+    for (auto& sub : subscribers) {
+        sub->write(msg);
+    }
+}
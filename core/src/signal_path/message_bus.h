@@ -0,0 +1,165 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#define MESSAGE_MAX_NAME_LEN    24
+#define MESSAGE_MAX_FIELDS      8
+#define MESSAGE_PAYLOAD_SIZE    1024
+
+enum MessageFieldType : uint8_t {
+    MESSAGE_FIELD_INT,
+    MESSAGE_FIELD_FLOAT,
+    MESSAGE_FIELD_TEXT,
+    MESSAGE_FIELD_BYTES
+};
+
+/**
+ * Record published by a decoder on the message bus.
+ * Everything is stored inline so that a message can be built on the stack and copied into the subscriber queues
+ * without any allocation. Names and text that don't fit are truncated.
+*/
+struct DecodedMessage {
+    struct Field {
+        char name[MESSAGE_MAX_NAME_LEN];
+        MessageFieldType type;
+        union {
+            int64_t integer;
+            double number;
+            struct {
+                uint16_t offset;
+                uint16_t len;
+            } data;
+        };
+    };
+
+    /**
+     * Create a message.
+     * @param decoder Name of the protocol or decoder, eg. "POCSAG".
+     * @param type Kind of record within that decoder, eg. "page".
+     * @param frequency Frequency the message was received on in Hz, 0 if unknown.
+    */
+    DecodedMessage(const char* decoder = "", const char* type = "", double frequency = 0.0);
+
+    void addInt(const char* name, int64_t value);
+    void addFloat(const char* name, double value);
+    void addText(const char* name, const char* text, int len = -1);
+    void addText(const char* name, const std::string& text) { addText(name, text.c_str(), text.size()); }
+    void addBytes(const char* name, const uint8_t* data, int len);
+
+    /**
+     * Serialize the message as a single line JSON object, terminated by a newline.
+     * The fields are written after the sequence, time, frequency, decoder and type members. Bytes are hex encoded.
+     * @param buf Output buffer.
+     * @param maxLen Size of the output buffer, MESSAGE_MAX_JSON_LEN is always enough.
+     * @return Length written.
+    */
+    int toJSON(char* buf, int maxLen) const;
+
+    /**
+     * Serialize the message as a length-prefixed binary record, all values being little endian:
+     * u32 length of what follows, u64 sequence, f64 timestamp, f64 frequency, u8 length + decoder, u8 length + type,
+     * u8 field count, then for each field u8 length + name, u8 type and either an i64, an f64 or a u16 length + data.
+     * @param buf Output buffer.
+     * @param maxLen Size of the output buffer, MESSAGE_MAX_BINARY_LEN is always enough.
+     * @return Length written.
+    */
+    int toBinary(uint8_t* buf, int maxLen) const;
+
+    // Incremented for every message published on the bus, set when publishing
+    uint64_t sequence = 0;
+
+    // Time at which the message was published, in seconds since the unix epoch
+    double timestamp = 0;
+
+    double frequency;
+    char decoder[MESSAGE_MAX_NAME_LEN];
+    char type[MESSAGE_MAX_NAME_LEN];
+
+    int fieldCount = 0;
+    Field fields[MESSAGE_MAX_FIELDS];
+
+    // Storage for the text and bytes fields
+    int payloadSize = 0;
+    uint8_t payload[MESSAGE_PAYLOAD_SIZE];
+
+private:
+    Field* addField(const char* name, MessageFieldType type);
+    void addData(const char* name, MessageFieldType type, const uint8_t* data, int len);
+};
+
+// Worst case sizes, every payload byte being escaped as \u00XX or hex encoded
+#define MESSAGE_MAX_JSON_LEN    ((MESSAGE_PAYLOAD_SIZE * 6) + (MESSAGE_MAX_FIELDS * ((MESSAGE_MAX_NAME_LEN * 6) + 40)) + (MESSAGE_MAX_NAME_LEN * 12) + 256)
+#define MESSAGE_MAX_BINARY_LEN  (MESSAGE_PAYLOAD_SIZE + (MESSAGE_MAX_FIELDS * (MESSAGE_MAX_NAME_LEN + 12)) + 128)
+
+/**
+ * Receiving end of the message bus, owned and read by a single consumer thread.
+ * Up to queueDepth unread messages are kept in preallocated slots, newer messages being dropped while the queue is full
+ * so that the publisher never blocks.
+*/
+class MessageSubscriber {
+    friend class MessageBus;
+public:
+    MessageSubscriber(int queueDepth = 1024);
+
+    /**
+     * Get the next message, releasing the previously read one.
+     * @return Message valid until the next read, NULL if none is available.
+    */
+    const DecodedMessage* read();
+
+    /**
+     * Wait for a message to become available.
+     * @param timeoutMs Maximum time to wait in milliseconds.
+     * @return True if a message is available.
+    */
+    bool wait(int timeoutMs);
+
+    // Number of messages that were dropped because the queue was full
+    uint64_t getDropped() { return dropped; }
+
+private:
+    void write(const DecodedMessage& msg);
+    bool available();
+
+    std::vector<DecodedMessage> slots;
+    int depth;
+
+    std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint64_t> tail{ 0 };
+    bool holding = false;
+
+    // Only used to sleep, the publisher notifies without taking the mutex
+    std::mutex waitMtx;
+    std::condition_variable waitCnd;
+
+    std::atomic<uint64_t> dropped{ 0 };
+};
+
+/**
+ * Publishes the messages decoded by any module to any number of subscribers, typically file or network outputs.
+ * Publishing only copies the message into each subscriber queue, the I/O being done by the subscriber threads.
+*/
+class MessageBus {
+public:
+    void subscribe(MessageSubscriber* sub);
+    void unsubscribe(MessageSubscriber* sub);
+
+    // Cheap check allowing decoders to skip building messages when nobody listens
+    bool hasSubscribers() { return subscriberCount.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * Publish a message to all subscribers. Its sequence number and timestamp are filled in.
+     * @param msg Message to publish.
+    */
+    void publish(DecodedMessage& msg);
+
+private:
+    std::mutex subMtx;
+    std::vector<MessageSubscriber*> subscribers;
+    std::atomic<int> subscriberCount{ 0 };
+    uint64_t sequence = 0;
+};
@@ -5,4 +5,6 @@ namespace sigpath {
     VFOManager vfoManager;
     SourceManager sourceManager;
     SinkManager sinkManager;
+    SpectrumBus spectrumBus;
+    MessageBus messageBus;
 };
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "vfo_manager.h"
 #include "source.h"
 #include "sink.h"
+#include "spectrum_bus.h"
+#include "message_bus.h"
 #include <module.h>
 
 namespace sigpath {
@@ -10,4 +12,6 @@ namespace sigpath {
     SDRPP_EXPORT VFOManager vfoManager;
     SDRPP_EXPORT SourceManager sourceManager;
     SDRPP_EXPORT SinkManager sinkManager;
+    SDRPP_EXPORT SpectrumBus spectrumBus;
+    SDRPP_EXPORT MessageBus messageBus;
 };
\ No newline at end of file
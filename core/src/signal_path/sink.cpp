@@ -8,6 +8,13 @@
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+// Duration of the device buffers requested by sinks in normal and low latency modes
+#define DEVICE_BUFFER_TIME              (1.0 / 60.0)
+#define LOW_LATENCY_DEVICE_BUFFER_TIME  0.005
+
+// Margin kept in the drift compensation buffer above one input block and one device buffer
+#define MIN_BUFFER_MARGIN               0.002
+
 SinkManager::SinkManager() {
     SinkManager::SinkProvider prov;
     prov.create = SinkManager::NullSink::create;
@@ -26,6 +33,7 @@ void SinkManager::Stream::init(dsp::stream<dsp::stereo_t>* in, EventHandler<floa
     splitter.bindStream(&volumeInput);
     volumeAjust.init(&volumeInput, 1.0f, false);
     sinkOut = &volumeAjust.out;
+    driftComp.init(&volumeInput, sampleRate, driftCompLatency);
 }
 
 void SinkManager::Stream::start() {
@@ -34,7 +42,12 @@ void SinkManager::Stream::start() {
     }
 
     splitter.start();
-    volumeAjust.start();
+    if (driftCompEnabled) {
+        driftComp.start();
+    }
+    else {
+        volumeAjust.start();
+    }
     sink->start();
     running = true;
 }
@@ -44,7 +57,12 @@ void SinkManager::Stream::stop() {
         return;
     }
     splitter.stop();
-    volumeAjust.stop();
+    if (driftCompEnabled) {
+        driftComp.stop();
+    }
+    else {
+        volumeAjust.stop();
+    }
     sink->stop();
     running = false;
 }
@@ -79,9 +97,128 @@ void SinkManager::Stream::unbindStream(dsp::stream<dsp::stereo_t>* stream) {
     delete stream;
 }
 
+void SinkManager::Stream::enableDriftCompensation(double latency) {
+    {
+        std::lock_guard<std::mutex> lck(ctrlMtx);
+        driftCompLatency = latency;
+        if (!driftCompEnabled) {
+            // The drift compensator replaces the volume block, which would otherwise compete for its input
+            driftCompEnabled = true;
+            if (running) {
+                volumeAjust.stop();
+                driftComp.start();
+            }
+        }
+    }
+    updateBufferTarget();
+}
+
+void SinkManager::Stream::disableDriftCompensation() {
+    std::lock_guard<std::mutex> lck(ctrlMtx);
+    if (!driftCompEnabled) { return; }
+    if (running) {
+        driftComp.stop();
+        volumeAjust.start();
+    }
+    driftCompEnabled = false;
+    setHopLatency("Device", 0.0);
+}
+
+void SinkManager::Stream::readAudio(dsp::stereo_t* data, int count) {
+    driftComp.read(data, count);
+    volumeAjust.process(count, data, data);
+}
+
+double SinkManager::Stream::getDriftCorrection() {
+    return driftComp.getCorrectionPPM();
+}
+
+void SinkManager::Stream::setHopLatency(std::string name, double latency) {
+    {
+        std::lock_guard<std::mutex> lck(latencyMtx);
+        auto it = std::find_if(hops.begin(), hops.end(), [&name](const LatencyHop& hop) { return hop.name == name; });
+        if (latency <= 0.0) {
+            if (it != hops.end()) { hops.erase(it); }
+        }
+        else if (it != hops.end()) {
+            it->latency = latency;
+        }
+        else {
+            hops.push_back({ name, latency });
+        }
+    }
+    updateBufferTarget();
+}
+
+std::vector<SinkManager::LatencyHop> SinkManager::Stream::getLatencyReport() {
+    std::vector<LatencyHop> report;
+    {
+        std::lock_guard<std::mutex> lck(latencyMtx);
+        report = hops;
+    }
+    if (driftCompEnabled) {
+        // On average, a sample waits for half a block before being sent downstream
+        report.push_back({ "Input Blocks", driftComp.getBlockDuration() / 2.0 });
+        report.push_back({ "Buffer", driftComp.getLatency() });
+    }
+    return report;
+}
+
+double SinkManager::Stream::getLatency() {
+    double total = 0.0;
+    for (const auto& hop : getLatencyReport()) { total += hop.latency; }
+    return total;
+}
+
+void SinkManager::Stream::setLowLatency(bool enabled) {
+    lowLatency = enabled;
+    updateBufferTarget();
+
+    // Restart the sink so that it reopens its device with the new buffer size
+    if (running) {
+        sink->stop();
+        sink->start();
+    }
+}
+
+bool SinkManager::Stream::getLowLatency() {
+    return lowLatency;
+}
+
+void SinkManager::Stream::setLatencyBudget(double budget) {
+    latencyBudget = budget;
+    updateBufferTarget();
+}
+
+double SinkManager::Stream::getLatencyBudget() {
+    return latencyBudget;
+}
+
+int SinkManager::Stream::getDeviceBufferSize() {
+    return round(_sampleRate * (lowLatency ? LOW_LATENCY_DEVICE_BUFFER_TIME : DEVICE_BUFFER_TIME));
+}
+
+void SinkManager::Stream::updateBufferTarget() {
+    if (!lowLatency) {
+        driftComp.setLatency(driftCompLatency);
+        return;
+    }
+
+    // Give the buffer whatever is left of the budget once all other hops are accounted for
+    double others = 0.0;
+    {
+        std::lock_guard<std::mutex> lck(latencyMtx);
+        for (const auto& hop : hops) { others += hop.latency; }
+    }
+    double block = driftComp.getBlockDuration();
+    double minTarget = block + ((double)getDeviceBufferSize() / _sampleRate) + MIN_BUFFER_MARGIN;
+    driftComp.setLatency(std::max<double>(latencyBudget - others - (block / 2.0), minTarget));
+}
+
 void SinkManager::Stream::setSampleRate(float sampleRate) {
     std::lock_guard<std::mutex> lck(ctrlMtx);
     _sampleRate = sampleRate;
+    driftComp.setSampleRate(sampleRate);
     srChange.emit(sampleRate);
 }
 
@@ -230,6 +367,7 @@ void SinkManager::setStreamSink(std::string name, std::string providerName) {
         stream->sink->stop();
     }
     delete stream->sink;
+    stream->disableDriftCompensation();
     stream->providerId = std::distance(providerNames.begin(), std::find(providerNames.begin(), providerNames.end(), providerName));
     stream->providerName = providerName;
     SinkManager::SinkProvider prov = providers[providerName];
@@ -313,6 +451,7 @@ void SinkManager::loadStreamConfig(std::string name) {
         stream->sink->stop();
     }
     delete stream->sink;
+    stream->disableDriftCompensation();
     SinkManager::SinkProvider prov = providers[provName];
     stream->providerId = std::distance(providerNames.begin(), std::find(providerNames.begin(), providerNames.end(), provName));
     stream->providerName = provName;
@@ -322,6 +461,8 @@ void SinkManager::loadStreamConfig(std::string name) {
     }
     stream->setVolume(conf["volume"]);
     stream->volumeAjust.setMuted(conf["muted"]);
+    if (conf.contains("latencyBudget")) { stream->setLatencyBudget(conf["latencyBudget"]); }
+    if (conf.contains("lowLatency")) { stream->setLowLatency(conf["lowLatency"]); }
 }
 
 void SinkManager::saveStreamConfig(std::string name) {
@@ -330,6 +471,8 @@ void SinkManager::saveStreamConfig(std::string name) {
     conf["sink"] = providerNames[stream->providerId];
     conf["volume"] = stream->getVolume();
     conf["muted"] = stream->volumeAjust.getMuted();
+    conf["lowLatency"] = stream->lowLatency;
+    conf["latencyBudget"] = stream->latencyBudget;
     core::configManager.conf["streams"][name] = conf;
 }
 
@@ -368,6 +511,43 @@ void SinkManager::showMenu() {
 
         showVolumeSlider(name, "##_sdrpp_sink_menu_vol_", menuWidth);
 
+        if (stream->driftCompEnabled) {
+            if (ImGui::Checkbox(CONCAT("Low Latency##_sdrpp_sink_low_lat_", name), &stream->lowLatency)) {
+                stream->setLowLatency(stream->lowLatency);
+                core::configManager.acquire();
+                saveStreamConfig(name);
+                core::configManager.release(true);
+            }
+            if (stream->lowLatency) {
+                float budget = stream->latencyBudget * 1000.0;
+                ImGui::LeftLabel("Budget");
+                ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+                if (ImGui::SliderFloat(CONCAT("##_sdrpp_sink_lat_budget_", name), &budget, 5.0f, 200.0f, "%.0f ms")) {
+                    stream->setLatencyBudget(budget / 1000.0);
+                    core::configManager.acquire();
+                    saveStreamConfig(name);
+                    core::configManager.release(true);
+                }
+            }
+        }
+
+        // Show the end-to-end latency, with the detail of each hop in a tooltip
+        std::vector<LatencyHop> report = stream->getLatencyReport();
+        double latency = 0.0;
+        for (const auto& hop : report) { latency += hop.latency; }
+        if (stream->lowLatency && latency > stream->latencyBudget * 1.1) {
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Latency: %.1f ms (over budget)", latency * 1000.0);
+        }
+        else {
+            ImGui::Text("Latency: %.1f ms", latency * 1000.0);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            for (const auto& hop : report) { ImGui::Text("%s: %.1f ms", hop.name.c_str(), hop.latency * 1000.0); }
+            if (stream->driftCompEnabled) { ImGui::Text("Drift: %.0f ppm", stream->getDriftCorrection()); }
+            ImGui::EndTooltip();
+        }
+
         count++;
         if (count < maxCount) {
             ImGui::Spacing();
@@ -5,6 +5,7 @@
 #include <dsp/types.h>
 #include "../dsp/routing/splitter.h"
 #include "../dsp/audio/volume.h"
+#include "../dsp/audio/drift_compensator.h"
 #include "../dsp/sink/null_sink.h"
 #include <mutex>
 #include <utils/event.h>
@@ -22,6 +23,11 @@ public:
         virtual void menuHandler() = 0;
     };
 
+    struct LatencyHop {
+        std::string name;
+        double latency;
+    };
+
     class Stream {
     public:
         Stream() {}
@@ -40,6 +46,47 @@ public:
 
         void setInput(dsp::stream<dsp::stereo_t>* in);
 
+        /**
+         * Buffer the output in a drift compensating resampler instead of sinkOut, for sinks whose device runs on its own clock.
+         * Audio must then be pulled with readAudio() instead of reading from sinkOut, the volume being applied on the way out.
+         * @param latency Target latency of the buffer in seconds, overridden by the latency budget in low latency mode.
+        */
+        void enableDriftCompensation(double latency);
+        void disableDriftCompensation();
+
+        /**
+         * Read audio from the drift compensator, never blocks. Meant to be called from the device callback.
+         * @param data Output samples.
+         * @param count Number of samples requested by the device.
+        */
+        void readAudio(dsp::stereo_t* data, int count);
+
+        // Rate correction in ppm of the drift compensator
+        double getDriftCorrection();
+
+        /**
+         * Report the latency added by a hop of the audio path, for example a filter or the device buffer.
+         * @param name Name of the hop.
+         * @param latency Latency in seconds, zero to remove the hop from the report.
+        */
+        void setHopLatency(std::string name, double latency);
+
+        // Latency of every hop including the measured input blocks and drift compensation buffer, and their sum
+        std::vector<LatencyHop> getLatencyReport();
+        double getLatency();
+
+        /**
+         * In low latency mode, devices use small buffers and the drift compensation buffer is sized so that the
+         * end-to-end latency fits the budget, down to the minimum needed not to underrun.
+        */
+        void setLowLatency(bool enabled);
+        bool getLowLatency();
+        void setLatencyBudget(double budget);
+        double getLatencyBudget();
+
+        // Number of frames sinks should request per device callback
+        int getDeviceBufferSize();
+
         dsp::stream<dsp::stereo_t>* bindStream();
         void unbindStream(dsp::stream<dsp::stereo_t>* stream);
 
@@ -51,16 +98,26 @@ public:
         Event<float> srChange;
 
     private:
+        void updateBufferTarget();
+
         dsp::stream<dsp::stereo_t>* _in;
         dsp::routing::Splitter<dsp::stereo_t> splitter;
         SinkManager::Sink* sink;
         dsp::stream<dsp::stereo_t> volumeInput;
         dsp::audio::Volume volumeAjust;
+        dsp::audio::DriftCompensator driftComp;
         std::mutex ctrlMtx;
         float _sampleRate;
         int providerId = 0;
         std::string providerName = "";
         bool running = false;
+        bool driftCompEnabled = false;
+        double driftCompLatency = 0.05;
+
+        std::mutex latencyMtx;
+        std::vector<LatencyHop> hops;
+        bool lowLatency = false;
+        double latencyBudget = 0.03;
 
         float guiVolume = 1.0f;
     };
@@ -0,0 +1,95 @@
+#include "spectrum_bus.h"
+#include <string.h>
+#include <chrono>
+#include <algorithm>
+
+SpectrumSubscriber::SpectrumSubscriber(int queueDepth) {
+    depth = queueDepth;
+    slots.resize(depth ? depth : 3);
+}
+
+bool SpectrumSubscriber::read(SpectrumFrame& frame) {
+    Slot* slot;
+    if (depth) {
+        // Release the previously read frame
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (holding) {
+            tail.store(++t, std::memory_order_release);
+            holding = false;
+        }
+        if (t == head.load(std::memory_order_acquire)) { return false; }
+        slot = &slots[t % depth];
+        holding = true;
+    }
+    else {
+        // Swap the read buffer with the shared one if it holds an unread frame
+        if (!(sharedIdx.load(std::memory_order_relaxed) & FRESH_FLAG)) { return false; }
+        readIdx = sharedIdx.exchange(readIdx, std::memory_order_acq_rel) & ~FRESH_FLAG;
+        slot = &slots[readIdx];
+    }
+
+    frame.sequence = slot->sequence;
+    frame.timestamp = slot->timestamp;
+    frame.sampleRate = slot->sampleRate;
+    frame.data = slot->data.data();
+    frame.size = slot->data.size();
+    return true;
+}
+
+void SpectrumSubscriber::write(const float* data, int size, uint64_t sequence, double timestamp, double sampleRate) {
+    Slot* slot;
+    uint64_t h;
+    if (depth) {
+        // Drop the frame if the consumer is too far behind
+        h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= depth) {
+            dropped++;
+            return;
+        }
+        slot = &slots[h % depth];
+    }
+    else {
+        slot = &slots[writeIdx];
+    }
+
+    // Only reallocates when the FFT size changes
+    slot->data.resize(size);
+    memcpy(slot->data.data(), data, size * sizeof(float));
+    slot->sequence = sequence;
+    slot->timestamp = timestamp;
+    slot->sampleRate = sampleRate;
+
+    if (depth) {
+        head.store(h + 1, std::memory_order_release);
+    }
+    else {
+        // Publish the written buffer and take back the previous shared one, an unread frame there is overwritten
+        int prev = sharedIdx.exchange(writeIdx | FRESH_FLAG, std::memory_order_acq_rel);
+        if (prev & FRESH_FLAG) { dropped++; }
+        writeIdx = prev & ~FRESH_FLAG;
+    }
+}
+
+void SpectrumBus::subscribe(SpectrumSubscriber* sub) {
+    std::lock_guard<std::mutex> lck(subMtx);
+    if (std::find(subscribers.begin(), subscribers.end(), sub) != subscribers.end()) { return; }
+    subscribers.push_back(sub);
+    subscriberCount = subscribers.size();
+}
+
+void SpectrumBus::unsubscribe(SpectrumSubscriber* sub) {
+    std::lock_guard<std::mutex> lck(subMtx);
+    auto it = std::find(subscribers.begin(), subscribers.end(), sub);
+    if (it == subscribers.end()) { return; }
+    subscribers.erase(it);
+    subscriberCount = subscribers.size();
+}
+
+void SpectrumBus::publish(const float* data, int size, double sampleRate) {
+    double timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lck(subMtx);
+    sequence++;
+    for (auto& sub : subscribers) {
+        sub->write(data, size, sequence, timestamp, sampleRate);
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+struct SpectrumFrame {
+    // Incremented for every frame published on the bus, gaps mean frames were skipped
+    uint64_t sequence;
+
+    // Time at which the frame was published, in seconds since the unix epoch
+    double timestamp;
+
+    // Sample rate of the IQ the spectrum was computed from
+    double sampleRate;
+
+    // Power spectrum in dB with the DC bin in the middle, valid until the next read from the same subscriber
+    const float* data;
+    int size;
+};
+
+/**
+ * Receiving end of the spectrum bus, owned and read by a single consumer thread.
+ * In latest mode (queue depth of 0), frames are triple buffered and only the newest unread frame is returned.
+ * In queue mode, up to queueDepth unread frames are kept, newer frames being dropped while the queue is full.
+ * Neither mode ever blocks the publisher.
+*/
+class SpectrumSubscriber {
+    friend class SpectrumBus;
+public:
+    SpectrumSubscriber(int queueDepth = 0);
+
+    /**
+     * Get the next frame, releasing the previously read one.
+     * @param frame Receives the frame.
+     * @return True if a new frame was available.
+    */
+    bool read(SpectrumFrame& frame);
+
+    // Number of frames that were overwritten or dropped before being read
+    uint64_t getDropped() { return dropped; }
+
+private:
+    struct Slot {
+        uint64_t sequence = 0;
+        double timestamp = 0;
+        double sampleRate = 0;
+        std::vector<float> data;
+    };
+
+    void write(const float* data, int size, uint64_t sequence, double timestamp, double sampleRate);
+
+    std::vector<Slot> slots;
+    int depth;
+
+    // Latest mode, the shared index carries a flag telling if it holds an unread frame
+    static constexpr int FRESH_FLAG = 4;
+    int writeIdx = 0;
+    int readIdx = 1;
+    std::atomic<int> sharedIdx{ 2 };
+
+    // Queue mode
+    std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint64_t> tail{ 0 };
+    bool holding = false;
+
+    std::atomic<uint64_t> dropped{ 0 };
+};
+
+/**
+ * Publishes the spectrum computed by the IQ front end to any number of subscribers.
+ * The subscriber list is locked by publish() and by subscribe/unsubscribe, which only hold it briefly.
+ * Reading a subscriber never takes that lock, so consumers can't stall the DSP.
+*/
+class SpectrumBus {
+public:
+    void subscribe(SpectrumSubscriber* sub);
+    void unsubscribe(SpectrumSubscriber* sub);
+
+    // Cheap check allowing the publisher to skip computing the spectrum when nobody listens
+    bool hasSubscribers() { return subscriberCount.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * Publish a frame to all subscribers.
+     * @param data Power spectrum in dB.
+     * @param size Number of bins.
+     * @param sampleRate Sample rate of the IQ the spectrum was computed from.
+    */
+    void publish(const float* data, int size, double sampleRate);
+
+private:
+    std::mutex subMtx;
+    std::vector<SpectrumSubscriber*> subscribers;
+    std::atomic<int> subscriberCount{ 0 };
+    uint64_t sequence = 0;
+};
@@ -30,6 +30,7 @@ VFOManager::VFO::~VFO() {
 void VFOManager::VFO::setOffset(double offset) {
     wtfVFO->setOffset(offset);
     dspVFO->setOffset(wtfVFO->centerOffset);
+    onOffsetChanged.emit(wtfVFO->generalOffset);
 }
 
 double VFOManager::VFO::getOffset() {
@@ -39,6 +40,7 @@ double VFOManager::VFO::getOffset() {
 void VFOManager::VFO::setCenterOffset(double offset) {
     wtfVFO->setCenterOffset(offset);
     dspVFO->setOffset(offset);
+    onOffsetChanged.emit(wtfVFO->generalOffset);
 }
 
 void VFOManager::VFO::setBandwidth(double bandwidth, bool updateWaterfall) {
@@ -205,6 +207,7 @@ void VFOManager::updateFromWaterfall(ImGui::WaterFall* wtf) {
         if (vfo->wtfVFO->centerOffsetChanged) {
             vfo->wtfVFO->centerOffsetChanged = false;
             vfo->dspVFO->setOffset(vfo->wtfVFO->centerOffset);
+            vfo->onOffsetChanged.emit(vfo->wtfVFO->generalOffset);
         }
     }
 }
\ No newline at end of file
@@ -28,6 +28,9 @@ public:
 
         dsp::stream<dsp::complex_t>* output;
 
+        // Emitted with the new offset when it's changed by the code or by the user on the waterfall
+        Event<double> onOffsetChanged;
+
         friend class VFOManager;
 
         dsp::channel::RxVFO* dspVFO;
@@ -1,8 +1,14 @@
 #include "flog.h"
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <chrono>
+#include <map>
 #include <string.h>
 #include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -19,6 +25,13 @@
 #define FORMAT_BUF_SIZE 16
 #define ESCAPE_CHAR     '\\'
 
+// Number of call sites tracked for rate limiting and slots probed to find one, call sites that find no slot aren't limited
+#define RATE_SLOT_COUNT 256
+#define RATE_PROBE_COUNT 8
+
+// Maximum time the writer sleeps before checking the queue, a producer only wakes it up if it's waiting
+#define WRITER_IDLE_MS  50
+
 namespace flog {
     std::mutex outMtx;
 
@@ -56,17 +69,184 @@ namespace flog {
     };
 #endif
 
-    void __log__(Type type, const char* fmt, const std::vector<std::string>& args) {
-        // Reserve a buffer for the final output
-        int argCount = args.size();
-        int fmtLen = strlen(fmt) + 1;
-        int totSize = fmtLen;
-        for (const auto& a : args) { totSize += a.size(); }
-        std::string out;
-        out.reserve(totSize);
-        
-        // Get output stream depending on type
-        FILE* outStream = (type == TYPE_ERROR) ? stderr : stdout;
+    // === Levels ===
+
+    std::atomic<int> globalLevel(TYPE_DEBUG);
+    std::mutex levelMtx;
+
+    // Function-local so that sources can be looked up during static initialization, entries are never removed
+    std::map<std::string, std::atomic<int>>& sourceLevels() {
+        static std::map<std::string, std::atomic<int>> levels;
+        return levels;
+    }
+
+    // === Rate limiting ===
+
+    struct RateSlot {
+        std::atomic<const char*> fmt{ NULL };
+        std::atomic<int64_t> periodStart{ 0 };
+        std::atomic<int> count{ 0 };
+        std::atomic<uint32_t> suppressed{ 0 };
+    };
+
+    RateSlot rateSlots[RATE_SLOT_COUNT];
+    std::atomic<int> rateMaxCount(50);
+    std::atomic<int> ratePeriodMs(10000);
+
+    // === Queue ===
+
+    // Bounded multi-producer queue, each cell's sequence number telling whether it's free or holds an entry
+    struct Cell {
+        std::atomic<size_t> seq;
+        Entry entry;
+    };
+
+    Cell* cells = NULL;
+    size_t cellMask = 0;
+    std::atomic<size_t> enqueuePos(0);
+    size_t dequeuePos = 0;
+
+    std::atomic<bool> writerRunning(false);
+    std::atomic<int> activeProducers(0);
+    std::atomic<uint64_t> dropped(0);
+    std::atomic<bool> writerSleeping(false);
+    bool writerStop = false;
+    std::mutex writerMtx;
+    std::condition_variable writerCnd;
+    std::thread writerThread;
+
+    // === File sink ===
+
+    FILE* logFile = NULL;
+    std::string logPath;
+    int64_t logFileSize = 0;
+    int64_t logMaxSize = 0;
+    int logMaxFiles = 0;
+
+    // === Private functions ===
+
+    int64_t steadyMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    RateSlot* findRateSlot(const char* fmt) {
+        // Find the slot owned by the call site or claim a free one, slots are never released
+        size_t start = ((uintptr_t)fmt >> 3) % RATE_SLOT_COUNT;
+        for (int i = 0; i < RATE_PROBE_COUNT; i++) {
+            RateSlot& slot = rateSlots[(start + i) % RATE_SLOT_COUNT];
+            const char* owner = slot.fmt.load(std::memory_order_relaxed);
+            if (!owner && slot.fmt.compare_exchange_strong(owner, fmt, std::memory_order_relaxed)) {
+                return &slot;
+            }
+            if (owner == fmt) { return &slot; }
+        }
+        return NULL;
+    }
+
+    bool rateLimit(const char* fmt, uint32_t& suppressed) {
+        suppressed = 0;
+        int maxCount = rateMaxCount.load(std::memory_order_relaxed);
+        if (!maxCount) { return true; }
+        RateSlot* slot = findRateSlot(fmt);
+        if (!slot) { return true; }
+
+        // Start a new period if the current one is over
+        int64_t now = steadyMs();
+        if (now - slot->periodStart.load(std::memory_order_relaxed) >= ratePeriodMs.load(std::memory_order_relaxed)) {
+            suppressed = slot->suppressed.exchange(0, std::memory_order_relaxed);
+            slot->periodStart.store(now, std::memory_order_relaxed);
+            slot->count.store(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Count the message against the budget of the period
+        if (slot->count.fetch_add(1, std::memory_order_relaxed) < maxCount) { return true; }
+        slot->suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void copyEntry(Entry& dst, const Entry& src) {
+        // Only copy the used part of the entry
+        dst.type = src.type;
+        dst.time = src.time;
+        dst.suppressed = src.suppressed;
+        memcpy(dst.source, src.source, FLOG_MAX_SOURCE);
+        dst.argCount = src.argCount;
+        memcpy(dst.args, src.args, src.argCount * sizeof(Arg));
+        dst.fmtLen = src.fmtLen;
+        dst.textLen = src.textLen;
+        memcpy(dst.text, src.text, src.textLen);
+    }
+
+    bool push(const Entry& entry) {
+        // Claim a free cell
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[pos & cellMask];
+            intptr_t diff = (intptr_t)cell->seq.load(std::memory_order_acquire) - (intptr_t)pos;
+            if (!diff) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+            }
+            else if (diff < 0) {
+                // Queue full
+                return false;
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Fill it and hand it over to the writer
+        copyEntry(cell->entry, entry);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    Entry* front() {
+        Cell* cell = &cells[dequeuePos & cellMask];
+        if (cell->seq.load(std::memory_order_acquire) != dequeuePos + 1) { return NULL; }
+        return &cell->entry;
+    }
+
+    void pop() {
+        cells[dequeuePos & cellMask].seq.store(dequeuePos + cellMask + 1, std::memory_order_release);
+        dequeuePos++;
+    }
+
+    void formatArg(const Entry& e, const Arg& arg, std::string& out) {
+        char buf[256];
+        switch (arg.type) {
+        case ARG_TYPE_BOOL:
+            out += arg.b ? "true" : "false";
+            return;
+        case ARG_TYPE_CHAR:
+            out += arg.c;
+            return;
+        case ARG_TYPE_INT:
+            snprintf(buf, sizeof(buf), "%" PRId64, arg.i);
+            break;
+        case ARG_TYPE_UINT:
+            snprintf(buf, sizeof(buf), "%" PRIu64, arg.u);
+            break;
+        case ARG_TYPE_FLOAT:
+            snprintf(buf, sizeof(buf), "%lf", arg.f);
+            break;
+        case ARG_TYPE_POINTER:
+            snprintf(buf, sizeof(buf), "0x%p", arg.p);
+            break;
+        case ARG_TYPE_STRING:
+            out.append(&e.text[arg.str.offset], arg.str.len);
+            return;
+        }
+        out += buf;
+    }
+
+    void format(const Entry& e, std::string& out) {
+        const char* fmt = e.text;
+        int fmtLen = e.fmtLen;
+        int argCount = e.argCount;
+        out.clear();
 
         // Parse format string
         bool escaped = false;
@@ -107,7 +287,7 @@ namespace flog {
                 if (!formatLen) {
                     // Use format counter as ID if available or print wrong format string
                     if (formatCounter < argCount) {
-                        out += args[formatCounter++];
+                        formatArg(e, e.args[formatCounter++], out);
                     }
                     else {
                         out += "{}";
@@ -120,7 +300,7 @@ namespace flog {
 
                     // Use ID if available or print wrong format string
                     if (formatCounter < argCount) {
-                        out += args[formatCounter];
+                        formatArg(e, e.args[formatCounter], out);
                     }
                     else {
                         out += '{';
@@ -136,124 +316,262 @@ namespace flog {
                 formatLen = 0;
             }
             else {
-                // Add to format buffer 
+                // Add to format buffer
                 if (formatLen < FORMAT_BUF_SIZE) { formatBuf[formatLen++] = c; }
             }
         }
 
+        // Report the messages from the same call site that were rate limited
+        if (e.suppressed) {
+            char buf[64];
+            snprintf(buf, sizeof(buf), " (%" PRIu32 " similar messages suppressed)", e.suppressed);
+            out += buf;
+        }
+    }
+
+    void rotateFile() {
+        fclose(logFile);
+        logFile = NULL;
+        std::string last = logPath + "." + std::to_string(logMaxFiles - 1);
+        remove(last.c_str());
+        for (int i = logMaxFiles - 2; i >= 1; i--) {
+            std::string from = logPath + "." + std::to_string(i);
+            std::string to = logPath + "." + std::to_string(i + 1);
+            rename(from.c_str(), to.c_str());
+        }
+        if (logMaxFiles > 1) {
+            rename(logPath.c_str(), (logPath + ".1").c_str());
+        }
+        else {
+            remove(logPath.c_str());
+        }
+        logFile = fopen(logPath.c_str(), "a");
+        logFileSize = 0;
+    }
+
+    // Must be called with outMtx locked
+    void write(const Entry& e, const std::string& out) {
         // Get time
-        auto now = std::chrono::system_clock::now();
-        auto nowt = std::chrono::system_clock::to_time_t(now);
-        auto nowc = std::localtime(&nowt); // TODO: This is not threadsafe
+        time_t nowt = e.time / 1000000;
+        int ms = (e.time / 1000) % 1000;
+        tm* nowc = std::localtime(&nowt);
 
-        // Write to output
-        {
-            std::lock_guard<std::mutex> lck(outMtx);
-#if defined(_WIN32)
-            // Get output handle and return if invalid
-            int wOutStream = (type == TYPE_ERROR) ? STD_ERROR_HANDLE  : STD_OUTPUT_HANDLE;
-            HANDLE conHndl = GetStdHandle(wOutStream);
-            if (!conHndl || conHndl == INVALID_HANDLE_VALUE) { return; }
+        // Build the source prefix
+        char src[FLOG_MAX_SOURCE + 3] = "";
+        if (e.source[0]) { snprintf(src, sizeof(src), "[%s] ", e.source); }
 
+        // Get output stream depending on type
+        FILE* outStream = (e.type == TYPE_ERROR) ? stderr : stdout;
+
+#if defined(_WIN32)
+        // Get output handle and skip the console if invalid
+        int wOutStream = (e.type == TYPE_ERROR) ? STD_ERROR_HANDLE  : STD_OUTPUT_HANDLE;
+        HANDLE conHndl = GetStdHandle(wOutStream);
+        if (conHndl && conHndl != INVALID_HANDLE_VALUE) {
             // Print beginning of log line
             SetConsoleTextAttribute(conHndl, COLOR_WHITE);
-            fprintf(outStream, "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [", nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, 0);
+            fprintf(outStream, "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [", nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms);
 
-            // Switch color to the log color, print log type and 
-            SetConsoleTextAttribute(conHndl, TYPE_COLORS[type]);
-            fputs(TYPE_STR[type], outStream);
-            
+            // Switch color to the log color, print log type and
+            SetConsoleTextAttribute(conHndl, TYPE_COLORS[e.type]);
+            fputs(TYPE_STR[e.type], outStream);
 
             // Switch back to default color and print rest of log string
             SetConsoleTextAttribute(conHndl, COLOR_WHITE);
-            fprintf(outStream, "] %s\n", out.c_str());
+            fprintf(outStream, "] %s%s\n", src, out.c_str());
+        }
 #elif defined(__ANDROID__)
-            // Print format string
-            __android_log_print(TYPE_PRIORITIES[type], FLOG_ANDROID_TAG, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s\n",
-                    nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, 0, TYPE_COLORS[type], TYPE_STR[type], out.c_str());
+        // Print format string
+        __android_log_print(TYPE_PRIORITIES[e.type], FLOG_ANDROID_TAG, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s%s\n",
+                nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms, TYPE_COLORS[e.type], TYPE_STR[e.type], src, out.c_str());
 #else
-            // Print format string
-            fprintf(outStream, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s\n",
-                    nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, 0, TYPE_COLORS[type], TYPE_STR[type], out.c_str());
+        // Print format string
+        fprintf(outStream, COLOR_WHITE "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s%s" COLOR_WHITE "] %s%s\n",
+                nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms, TYPE_COLORS[e.type], TYPE_STR[e.type], src, out.c_str());
 #endif
+
+        // Write to the log file without colors
+        if (logFile) {
+            int len = fprintf(logFile, "[%02d/%02d/%02d %02d:%02d:%02d.%03d] [%s] %s%s\n",
+                    nowc->tm_mday, nowc->tm_mon + 1, nowc->tm_year + 1900, nowc->tm_hour, nowc->tm_min, nowc->tm_sec, ms, TYPE_STR[e.type], src, out.c_str());
+            if (len > 0) { logFileSize += len; }
+            if (logFileSize >= logMaxSize) { rotateFile(); }
         }
     }
 
-    std::string __toString__(bool value) {
-        return value ? "true" : "false";
+    void reportDropped() {
+        uint64_t count = dropped.exchange(0, std::memory_order_relaxed);
+        if (!count) { return; }
+        Entry e;
+        e.type = TYPE_WARNING;
+        e.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        e.suppressed = 0;
+        e.source[0] = 0;
+        e.argCount = 0;
+        e.fmtLen = 0;
+        e.textLen = 0;
+        write(e, std::to_string(count) + " log messages dropped, the log queue was full");
     }
 
-    std::string __toString__(char value) {
-        return std::string("")+value;
-    }
+    void writerWorker() {
+        std::string out;
+        bool stop = false;
+        while (!stop) {
+            // Check for a stop request before writing, the last pass then sees every entry queued before the request
+            {
+                std::lock_guard<std::mutex> lck(writerMtx);
+                stop = writerStop;
+            }
 
-    std::string __toString__(int8_t value) {
-        char buf[8];
-        sprintf(buf, "%" PRId8, value);
-        return buf;
-    }
+            // Write all queued entries, only holding the output lock for a batch at a time
+            bool any = false;
+            {
+                std::lock_guard<std::mutex> lck(outMtx);
+                for (Entry* e = front(); e; e = front()) {
+                    format(*e, out);
+                    write(*e, out);
+                    pop();
+                    any = true;
+                }
+                reportDropped();
+                if (any) {
+                    fflush(stdout);
+                    if (logFile) { fflush(logFile); }
+                }
+            }
 
-    std::string __toString__(int16_t value) {
-        char buf[16];
-        sprintf(buf, "%" PRId16, value);
-        return buf;
+            // Sleep until woken up by a producer
+            if (stop || any) { continue; }
+            std::unique_lock<std::mutex> lck(writerMtx);
+            if (writerStop) { continue; }
+            writerSleeping = true;
+            if (!front()) { writerCnd.wait_for(lck, std::chrono::milliseconds(WRITER_IDLE_MS)); }
+            writerSleeping = false;
+        }
     }
 
-    std::string __toString__(int32_t value) {
-        char buf[32];
-        sprintf(buf, "%" PRId32, value);
-        return buf;
+    // === Public functions ===
+
+    bool __accept__(Type type, const std::atomic<int>* level, const char* fmt, bool limited, uint32_t& suppressed) {
+        suppressed = 0;
+        int minLevel = level ? level->load(std::memory_order_relaxed) : -1;
+        if (minLevel < 0) { minLevel = globalLevel.load(std::memory_order_relaxed); }
+        if (type < minLevel) { return false; }
+        return !limited || rateLimit(fmt, suppressed);
     }
 
-    std::string __toString__(int64_t value) {
-        char buf[64];
-        sprintf(buf, "%" PRId64, value);
-        return buf;
+    const std::atomic<int>* __sourceLevel__(const char* source) {
+        if (!source) { return NULL; }
+        std::lock_guard<std::mutex> lck(levelMtx);
+        return &sourceLevels().try_emplace(source, -1).first->second;
     }
 
-    std::string __toString__(uint8_t value) {
-        char buf[8];
-        sprintf(buf, "%" PRIu8, value);
-        return buf;
+    void __submit__(Entry& entry) {
+        entry.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        // Queue the entry if the writer is running, registering as a producer so that it doesn't stop under our feet
+        activeProducers.fetch_add(1, std::memory_order_acquire);
+        if (writerRunning.load(std::memory_order_acquire)) {
+            if (!push(entry)) { dropped.fetch_add(1, std::memory_order_relaxed); }
+            activeProducers.fetch_sub(1, std::memory_order_release);
+            if (writerSleeping.load(std::memory_order_relaxed)) { writerCnd.notify_one(); }
+            return;
+        }
+        activeProducers.fetch_sub(1, std::memory_order_release);
+
+        // Otherwise, write it directly
+        std::string out;
+        format(entry, out);
+        std::lock_guard<std::mutex> lck(outMtx);
+        write(entry, out);
     }
 
-    std::string __toString__(uint16_t value) {
-        char buf[16];
-        sprintf(buf, "%" PRIu16, value);
-        return buf;
+    void startWriter(int queueSize) {
+        if (writerRunning) { return; }
+
+        // Allocate the queue, rounding its size up to a power of two
+        size_t size = 1;
+        while (size < (size_t)queueSize) { size <<= 1; }
+        cells = new Cell[size];
+        for (size_t i = 0; i < size; i++) { cells[i].seq.store(i, std::memory_order_relaxed); }
+        cellMask = size - 1;
+        enqueuePos = 0;
+        dequeuePos = 0;
+
+        // Start the writer
+        writerStop = false;
+        writerThread = std::thread(writerWorker);
+        writerRunning = true;
     }
 
-    std::string __toString__(uint32_t value) {
-        char buf[32];
-        sprintf(buf, "%" PRIu32, value);
-        return buf;
+    void stopWriter() {
+        if (!writerRunning) { return; }
+
+        // Stop accepting entries and wait for the producers that were already queuing
+        writerRunning = false;
+        while (activeProducers.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+
+        // Let the writer flush the queue and exit
+        {
+            std::lock_guard<std::mutex> lck(writerMtx);
+            writerStop = true;
+        }
+        writerCnd.notify_one();
+        if (writerThread.joinable()) { writerThread.join(); }
+
+        delete[] cells;
+        cells = NULL;
     }
 
-    std::string __toString__(uint64_t value) {
-        char buf[64];
-        sprintf(buf, "%" PRIu64, value);
-        return buf;
+    bool setFile(const std::string& path, int64_t maxSize, int maxFiles) {
+        std::lock_guard<std::mutex> lck(outMtx);
+        if (logFile) {
+            fclose(logFile);
+            logFile = NULL;
+        }
+        logPath = path;
+        logMaxSize = maxSize;
+        logMaxFiles = std::max<int>(maxFiles, 1);
+        if (path.empty()) { return true; }
+
+        // Append to the existing file
+        logFile = fopen(path.c_str(), "a");
+        if (!logFile) { return false; }
+        fseek(logFile, 0, SEEK_END);
+        logFileSize = ftell(logFile);
+        return true;
     }
 
-    std::string __toString__(float value) {
-        char buf[256];
-        sprintf(buf, "%f", value);
-        return buf;
+    void setLevel(Type level) {
+        globalLevel = level;
     }
 
-    std::string __toString__(double value) {
-        char buf[256];
-        sprintf(buf, "%lf", value);
-        return buf;
+    void setLevel(const std::string& source, Type level) {
+        std::lock_guard<std::mutex> lck(levelMtx);
+        auto [it, created] = sourceLevels().try_emplace(source, level);
+        if (!created) { it->second = level; }
     }
 
-    std::string __toString__(const char* value) {
-        return value;
+    void setRateLimit(int maxCount, int periodMs) {
+        rateMaxCount = std::max<int>(maxCount, 0);
+        ratePeriodMs = std::max<int>(periodMs, 1);
     }
 
-    std::string __toString__(const void* value) {
-        char buf[32];
-        sprintf(buf, "0x%p", value);
-        return buf;
+    bool parseLevel(const std::string& str, Type& level) {
+        for (int i = 0; i < _TYPE_COUNT; i++) {
+            std::string name = TYPE_STR[i];
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            if (str == name) {
+                level = (Type)i;
+                return true;
+            }
+        }
+        return false;
     }
-}
\ No newline at end of file
+
+    // Stop the writer at exit if the application didn't, a joinable thread would otherwise terminate the process
+    struct WriterShutdown {
+        ~WriterShutdown() { stopWriter(); }
+    };
+    WriterShutdown writerShutdown;
+}
@@ -1,8 +1,23 @@
 #pragma once
-#include <vector>
 #include <string>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>
+#include <string.h>
 #include <stdint.h>
 
+// Maximum number of arguments and bytes of text (format string and string arguments) kept per message
+#define FLOG_MAX_ARGS       16
+#define FLOG_MAX_TEXT       448
+
+// Maximum length of the name of a message source, including the terminating null
+#define FLOG_MAX_SOURCE     32
+
+// Source of the messages logged through the FLOG_* macros, sdrpp_module.cmake sets it to the module name
+#ifndef FLOG_SOURCE
+#define FLOG_SOURCE         NULL
+#endif
+
 namespace flog {
     enum Type {
         TYPE_DEBUG,
@@ -12,66 +27,256 @@ namespace flog {
         _TYPE_COUNT
     };
 
-    // IO functions
-    void __log__(Type type, const char* fmt, const std::vector<std::string>& args);
-
-    // Conversion functions
-    std::string __toString__(bool value);
-    std::string __toString__(char value);
-    std::string __toString__(int8_t value);
-    std::string __toString__(int16_t value);
-    std::string __toString__(int32_t value);
-    std::string __toString__(int64_t value);
-    std::string __toString__(uint8_t value);
-    std::string __toString__(uint16_t value);
-    std::string __toString__(uint32_t value);
-    std::string __toString__(uint64_t value);
-    std::string __toString__(float value);
-    std::string __toString__(double value);
-    std::string __toString__(const char* value);
-    std::string __toString__(const void* value);
+    enum ArgType : uint8_t {
+        ARG_TYPE_BOOL,
+        ARG_TYPE_CHAR,
+        ARG_TYPE_INT,
+        ARG_TYPE_UINT,
+        ARG_TYPE_FLOAT,
+        ARG_TYPE_STRING,
+        ARG_TYPE_POINTER
+    };
+
+    struct Arg {
+        ArgType type;
+        union {
+            bool b;
+            char c;
+            int64_t i;
+            uint64_t u;
+            double f;
+            const void* p;
+            struct {
+                uint16_t offset;
+                uint16_t len;
+            } str;
+        };
+    };
+
+    // Message captured at the call site, only formatted by the writer. Strings are copied, nothing is allocated.
+    struct Entry {
+        Type type;
+        int64_t time;
+        uint32_t suppressed;
+        char source[FLOG_MAX_SOURCE];
+        int argCount;
+        Arg args[FLOG_MAX_ARGS];
+        int fmtLen;
+        int textLen;
+        char text[FLOG_MAX_TEXT];
+    };
+
+    // Level and rate limiting checks, returns false if the message must be discarded
+    bool __accept__(Type type, const std::atomic<int>* level, const char* fmt, bool limited, uint32_t& suppressed);
+
+    // Level of a message source, negative to use the global level. The returned pointer stays valid until exit.
+    const std::atomic<int>* __sourceLevel__(const char* source);
+
+    // Queue a captured message or write it directly if the writer isn't running
+    void __submit__(Entry& entry);
+
+    // Argument capture
+    inline void __captureString__(Entry& e, const char* str, size_t len) {
+        Arg& arg = e.args[e.argCount++];
+        arg.type = ARG_TYPE_STRING;
+        len = std::min<size_t>(len, FLOG_MAX_TEXT - e.textLen);
+        memcpy(&e.text[e.textLen], str, len);
+        arg.str.offset = e.textLen;
+        arg.str.len = len;
+        e.textLen += len;
+    }
+
     template <class T>
-    std::string __toString__(const T& value) {
-        return (std::string)value;
+    inline void __capture__(Entry& e, const T& value) {
+        if (e.argCount >= FLOG_MAX_ARGS) { return; }
+        if constexpr (std::is_same_v<T, bool>) {
+            Arg& arg = e.args[e.argCount++];
+            arg.type = ARG_TYPE_BOOL;
+            arg.b = value;
+        }
+        else if constexpr (std::is_same_v<T, char>) {
+            Arg& arg = e.args[e.argCount++];
+            arg.type = ARG_TYPE_CHAR;
+            arg.c = value;
+        }
+        else if constexpr ((std::is_integral_v<T> && std::is_signed_v<T>) || std::is_enum_v<T>) {
+            Arg& arg = e.args[e.argCount++];
+            arg.type = ARG_TYPE_INT;
+            arg.i = (int64_t)value;
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            Arg& arg = e.args[e.argCount++];
+            arg.type = ARG_TYPE_UINT;
+            arg.u = value;
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            Arg& arg = e.args[e.argCount++];
+            arg.type = ARG_TYPE_FLOAT;
+            arg.f = value;
+        }
+        else if constexpr (std::is_convertible_v<T, const char*>) {
+            const char* str = value;
+            if (!str) { str = "(null)"; }
+            __captureString__(e, str, strlen(str));
+        }
+        else if constexpr (std::is_pointer_v<T>) {
+            Arg& arg = e.args[e.argCount++];
+            arg.type = ARG_TYPE_POINTER;
+            arg.p = (const void*)value;
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            __captureString__(e, value.c_str(), value.size());
+        }
+        else {
+            std::string str = (std::string)value;
+            __captureString__(e, str.c_str(), str.size());
+        }
     }
 
-    // Utility to generate a list from arguments
-    inline void __genArgList__(std::vector<std::string>& args) {}
-    template <typename First, typename... Others>
-    inline void __genArgList__(std::vector<std::string>& args, First first, Others... others) {
-        // Add argument
-        args.push_back(__toString__(first));
+    template <typename... Args>
+    void __log__(const char* source, const std::atomic<int>* level, Type type, bool limited, const char* fmt, const Args&... args) {
+        // Drop the message before doing any work if it's filtered out
+        uint32_t suppressed;
+        if (!__accept__(type, level, fmt, limited, suppressed)) { return; }
 
-        // Recursive call that will be unrolled since the function is inline
-        __genArgList__(args, others...);
+        // Capture the source, format string and arguments
+        Entry e;
+        e.type = type;
+        e.suppressed = suppressed;
+        e.source[0] = 0;
+        if (source) {
+            strncpy(e.source, source, FLOG_MAX_SOURCE - 1);
+            e.source[FLOG_MAX_SOURCE - 1] = 0;
+        }
+        e.argCount = 0;
+        e.fmtLen = std::min<int>(strlen(fmt), FLOG_MAX_TEXT);
+        memcpy(e.text, fmt, e.fmtLen);
+        e.textLen = e.fmtLen;
+        (__capture__(e, args), ...);
+        __submit__(e);
     }
 
+    /**
+     * Start the background writer. Until then and after stopWriter(), messages are written by the calling thread.
+     * @param queueSize Maximum number of queued messages, further messages are dropped until the writer catches up.
+    */
+    void startWriter(int queueSize = 4096);
+
+    // Write all queued messages then stop the background writer
+    void stopWriter();
+
+    /**
+     * Also write the log to a file, rotated once it reaches a given size.
+     * @param path Path of the file, the previous files being named path.1 (newest) to path.N. Empty to disable.
+     * @param maxSize Maximum size of a file in bytes.
+     * @param maxFiles Maximum number of files kept, including the current one.
+     * @return True on success.
+    */
+    bool setFile(const std::string& path, int64_t maxSize = 10000000, int maxFiles = 5);
+
+    // Minimum level of the messages written
+    void setLevel(Type level);
+
+    // Minimum level of the messages of a source, overriding the global level
+    void setLevel(const std::string& source, Type level);
+
+    /**
+     * Set the rate limit applied to each call site logging through logLimited().
+     * @param maxCount Maximum number of messages per period, 0 to disable rate limiting.
+     * @param periodMs Period in milliseconds. Suppressed messages are counted and reported with the next allowed one.
+    */
+    void setRateLimit(int maxCount, int periodMs);
+
+    /**
+     * Parse a level name.
+     * @param str One of "debug", "info", "warn" or "error".
+     * @param level Receives the level.
+     * @return True if the name is valid.
+    */
+    bool parseLevel(const std::string& str, Type& level);
+
     // Logging functions
     template <typename... Args>
-    void log(Type type, const char* fmt, Args... args) {
-        std::vector<std::string> _args;
-        _args.reserve(sizeof...(args));
-        __genArgList__(_args, args...);
-        __log__(type, fmt, _args);
+    void log(Type type, const char* fmt, const Args&... args) {
+        __log__(NULL, NULL, type, false, fmt, args...);
+    }
+
+    // Log a message that may repeat at a high rate, subject to the rate limit of its call site
+    template <typename... Args>
+    void logLimited(Type type, const char* fmt, const Args&... args) {
+        __log__(NULL, NULL, type, true, fmt, args...);
     }
 
     template <typename... Args>
-    inline void debug(const char* fmt, Args... args) {
+    inline void debug(const char* fmt, const Args&... args) {
         log(TYPE_DEBUG, fmt, args...);
     }
 
     template <typename... Args>
-    inline void info(const char* fmt, Args... args) {
+    inline void info(const char* fmt, const Args&... args) {
         log(TYPE_INFO, fmt, args...);
     }
 
     template <typename... Args>
-    inline void warn(const char* fmt, Args... args) {
+    inline void warn(const char* fmt, const Args&... args) {
         log(TYPE_WARNING, fmt, args...);
     }
 
     template <typename... Args>
-    inline void error(const char* fmt, Args... args) {
+    inline void error(const char* fmt, const Args&... args) {
         log(TYPE_ERROR, fmt, args...);
     }
-}
\ No newline at end of file
+
+    // Number of arguments referenced by a format string, following the same rules as the writer
+    constexpr int __formatArgCount__(const char* fmt) {
+        int required = 0;
+        int counter = 0;
+        for (int i = 0; fmt[i]; i++) {
+            if (fmt[i] == '\\') {
+                if (!fmt[++i]) { break; }
+                continue;
+            }
+            if (fmt[i] != '{') { continue; }
+
+            // Use the next argument, or the one whose ID starts the placeholder like atoi() would parse it
+            int id = counter;
+            if (fmt[i + 1] != '}') {
+                id = 0;
+                for (i++; fmt[i] >= '0' && fmt[i] <= '9'; i++) { id = id * 10 + (fmt[i] - '0'); }
+                while (fmt[i] && fmt[i] != '}') { i++; }
+                if (!fmt[i]) { break; }
+            }
+            else {
+                i++;
+            }
+            counter = id + 1;
+            if (counter > required) { required = counter; }
+        }
+        return required;
+    }
+
+    // Only used in unevaluated context to count macro arguments
+    template <typename... Args>
+    std::integral_constant<int, sizeof...(Args)> __argCount__(const Args&... args);
+}
+
+/**
+ * Logging macros, tagging messages with FLOG_SOURCE so that their level can be set per module, and checking
+ * at compile time that the format string, which must be a literal, doesn't refer to more arguments than given.
+*/
+#define FLOG_LOG(type, limited, fmt, ...)                                                                                  \
+    do {                                                                                                                   \
+        static_assert(flog::__formatArgCount__(fmt) <= decltype(flog::__argCount__(__VA_ARGS__))::value,                 \
+                      "Log format string refers to more arguments than given");                                          \
+        static_assert(decltype(flog::__argCount__(__VA_ARGS__))::value <= FLOG_MAX_ARGS, "Too many log arguments");      \
+        static const std::atomic<int>* __flogLevel__ = flog::__sourceLevel__(FLOG_SOURCE);                               \
+        flog::__log__(FLOG_SOURCE, __flogLevel__, type, limited, fmt, ##__VA_ARGS__);                                    \
+    } while (0)
+
+#define FLOG_DEBUG(fmt, ...)        FLOG_LOG(flog::TYPE_DEBUG, false, fmt, ##__VA_ARGS__)
+#define FLOG_INFO(fmt, ...)         FLOG_LOG(flog::TYPE_INFO, false, fmt, ##__VA_ARGS__)
+#define FLOG_WARN(fmt, ...)         FLOG_LOG(flog::TYPE_WARNING, false, fmt, ##__VA_ARGS__)
+#define FLOG_ERROR(fmt, ...)        FLOG_LOG(flog::TYPE_ERROR, false, fmt, ##__VA_ARGS__)
+
+// Rate limited variant, see flog::logLimited()
+#define FLOG_LIMITED(type, fmt, ...) FLOG_LOG(type, true, fmt, ##__VA_ARGS__)
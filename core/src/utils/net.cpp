@@ -384,6 +384,39 @@ namespace net {
         return connect(Address(host, port));
     }
 
+#ifndef _WIN32
+    std::shared_ptr<Socket> connectUnix(std::string path) {
+        // Init library if needed
+        init();
+
+        // Check that the path fits in the address
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(sockaddr_un));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("Socket path too long");
+            return NULL;
+        }
+        strcpy(addr.sun_path, path.c_str());
+
+        // Create socket
+        SockHandle_t s = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        // Connect to server
+        if (::connect(s, (sockaddr*)&addr, sizeof(sockaddr_un))) {
+            closeSocket(s);
+            throw std::runtime_error("Could not connect");
+            return NULL;
+        }
+
+        // Enable nonblocking mode
+        setNonblocking(s);
+
+        // Return socket class
+        return std::make_shared<Socket>(s);
+    }
+#endif
+
     std::shared_ptr<Socket> openudp(const Address& raddr, const Address& laddr, bool allowBroadcast) {
         // Init library if needed
         init();
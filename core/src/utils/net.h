@@ -15,6 +15,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <sys/un.h>
 #include <netdb.h>
 #include <signal.h>
 #include <poll.h>
@@ -244,6 +245,15 @@ namespace net {
      */
     std::shared_ptr<Socket> connect(std::string host, int port);  
 
+#ifndef _WIN32
+    /**
+     * Create Unix domain stream socket connection.
+     * @param path Path of the socket.
+     * @return Socket instance on success, Throws runtime_error otherwise.
+     */
+    std::shared_ptr<Socket> connectUnix(std::string path);
+#endif
+
     /**
      * Create UDP socket.
      * @param raddr Remote address. Set to a multicast address to allow multicast.
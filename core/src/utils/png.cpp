@@ -0,0 +1,183 @@
+#include "png.h"
+#include <string.h>
+#include <algorithm>
+
+namespace png {
+    const uint8_t SIGNATURE[8]          = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    const std::streamoff IHDR_OFFSET    = 8;
+    const uint32_t IHDR_LEN             = 13;
+    const int MAX_STORED_BLOCK          = 65535;
+
+    struct CRCTable {
+        CRCTable() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int j = 0; j < 8; j++) { c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1); }
+                table[i] = c;
+            }
+        }
+        uint32_t table[256];
+    };
+    static const CRCTable CRC_TABLE;
+
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+        crc = ~crc;
+        for (size_t i = 0; i < len; i++) { crc = CRC_TABLE.table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8); }
+        return ~crc;
+    }
+
+    static uint32_t adler32(uint32_t adler, const uint8_t* data, size_t len) {
+        uint32_t a = adler & 0xFFFF;
+        uint32_t b = adler >> 16;
+        while (len) {
+            // 5552 is the largest number of bytes that can be summed without overflowing
+            size_t n = std::min<size_t>(len, 5552);
+            len -= n;
+            while (n--) {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    static void putU32(uint8_t* buf, uint32_t val) {
+        buf[0] = val >> 24;
+        buf[1] = val >> 16;
+        buf[2] = val >> 8;
+        buf[3] = val;
+    }
+
+    Writer::~Writer() { close(); }
+
+    bool Writer::open(std::string path, int width, ColorType type) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (file.is_open()) { close(); }
+
+        _width = width;
+        _type = type;
+        bytesPerPixel = (type == COLOR_TYPE_RGBA) ? 4 : ((type == COLOR_TYPE_RGB) ? 3 : 1);
+        linesWritten = 0;
+        adler = 1;
+
+        file = std::ofstream(path, std::ios::out | std::ios::binary);
+        if (!file.is_open()) { return false; }
+        file.write((char*)SIGNATURE, sizeof(SIGNATURE));
+
+        // Write the header with a height of zero, it will be patched when closing
+        uint8_t ihdr[IHDR_LEN];
+        putU32(&ihdr[0], width);
+        putU32(&ihdr[4], 0);
+        ihdr[8] = 8;        // Bit depth
+        ihdr[9] = type;
+        ihdr[10] = 0;       // Deflate compression
+        ihdr[11] = 0;       // Adaptive filtering
+        ihdr[12] = 0;       // No interlacing
+        writeChunk("IHDR", ihdr, IHDR_LEN);
+
+        // Start the zlib stream, no compression
+        const uint8_t zlibHeader[2] = { 0x78, 0x01 };
+        writeChunk("IDAT", zlibHeader, sizeof(zlibHeader));
+
+        return true;
+    }
+
+    bool Writer::isOpen() {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        return file.is_open();
+    }
+
+    void Writer::close() {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (!file.is_open()) { return; }
+
+        // Terminate the deflate stream with an empty final block and the checksum
+        uint8_t end[9] = { 0x01, 0x00, 0x00, 0xFF, 0xFF };
+        putU32(&end[5], adler);
+        writeChunk("IDAT", end, sizeof(end));
+        writeChunk("IEND", NULL, 0);
+
+        // Patch the height and CRC of the header now that it is known
+        uint8_t ihdr[4 + IHDR_LEN];
+        memcpy(ihdr, "IHDR", 4);
+        putU32(&ihdr[4], _width);
+        putU32(&ihdr[8], linesWritten);
+        ihdr[12] = 8;
+        ihdr[13] = _type;
+        ihdr[14] = 0;
+        ihdr[15] = 0;
+        ihdr[16] = 0;
+        uint8_t crc[4];
+        putU32(crc, crc32(0, ihdr, sizeof(ihdr)));
+        file.seekp(IHDR_OFFSET + 4);
+        file.write((char*)ihdr, sizeof(ihdr));
+        file.write((char*)crc, sizeof(crc));
+
+        file.close();
+    }
+
+    void Writer::write(const uint8_t* rgba, int count) {
+        std::lock_guard<std::recursive_mutex> lck(mtx);
+        if (!file.is_open() || count <= 0) { return; }
+
+        // Convert the lines to the output format, each line is prefixed with its filter type (none)
+        int lineSize = 1 + (_width * bytesPerPixel);
+        int rawSize = lineSize * count;
+        int blockCount = (rawSize + MAX_STORED_BLOCK - 1) / MAX_STORED_BLOCK;
+        buffer.resize(rawSize + (5 * blockCount));
+        uint8_t* raw = &buffer[5 * blockCount];
+        for (int i = 0; i < count; i++) {
+            const uint8_t* in = &rgba[i * _width * 4];
+            uint8_t* out = &raw[i * lineSize];
+            *out++ = 0;
+            if (_type == COLOR_TYPE_RGBA) {
+                memcpy(out, in, _width * 4);
+                continue;
+            }
+            for (int j = 0; j < _width; j++) {
+                if (_type == COLOR_TYPE_RGB) {
+                    *out++ = in[0];
+                    *out++ = in[1];
+                    *out++ = in[2];
+                }
+                else {
+                    *out++ = in[0];
+                }
+                in += 4;
+            }
+        }
+        adler = adler32(adler, raw, rawSize);
+
+        // Wrap the data into non-final stored blocks, moving it down in place to make room for the block headers
+        uint8_t* out = buffer.data();
+        for (int offset = 0; offset < rawSize; offset += MAX_STORED_BLOCK) {
+            int len = std::min<int>(rawSize - offset, MAX_STORED_BLOCK);
+            out[0] = 0x00;
+            out[1] = len & 0xFF;
+            out[2] = len >> 8;
+            out[3] = ~len & 0xFF;
+            out[4] = (~len >> 8) & 0xFF;
+            memmove(&out[5], &raw[offset], len);
+            out += 5 + len;
+        }
+        writeChunk("IDAT", buffer.data(), buffer.size());
+
+        linesWritten += count;
+    }
+
+    void Writer::writeChunk(const char type[4], const uint8_t* data, uint32_t len) {
+        uint8_t hdr[8];
+        putU32(hdr, len);
+        memcpy(&hdr[4], type, 4);
+        uint32_t crc = crc32(0, &hdr[4], 4);
+        if (len) { crc = crc32(crc, data, len); }
+        uint8_t crcBuf[4];
+        putU32(crcBuf, crc);
+
+        file.write((char*)hdr, sizeof(hdr));
+        if (len) { file.write((char*)data, len); }
+        file.write((char*)crcBuf, sizeof(crcBuf));
+    }
+}
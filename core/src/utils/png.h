@@ -0,0 +1,57 @@
+#pragma once
+#include <mutex>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace png {
+    enum ColorType {
+        COLOR_TYPE_GRAY = 0,
+        COLOR_TYPE_RGB  = 2,
+        COLOR_TYPE_RGBA = 6
+    };
+
+    /**
+     * Streaming PNG writer, lines can be appended while the image is still being received.
+     * The height is only known when closing, it is patched into the header at that point.
+     * Image data is stored in uncompressed deflate blocks so that no compression library is required.
+    */
+    class Writer {
+    public:
+        Writer() {}
+        ~Writer();
+
+        /**
+         * Create the file and write the header.
+         * @param path Path of the file.
+         * @param width Width of the image in pixels.
+         * @param type Color type stored in the file, input lines are always RGBA.
+         * @return True on success.
+        */
+        bool open(std::string path, int width, ColorType type = COLOR_TYPE_RGB);
+        bool isOpen();
+        void close();
+
+        /**
+         * Append lines to the image.
+         * @param rgba Lines of RGBA pixels.
+         * @param count Number of lines.
+        */
+        void write(const uint8_t* rgba, int count);
+
+        int getLinesWritten() { return linesWritten; }
+
+    private:
+        void writeChunk(const char type[4], const uint8_t* data, uint32_t len);
+
+        std::recursive_mutex mtx;
+        std::ofstream file;
+        int _width;
+        ColorType _type;
+        int bytesPerPixel;
+        int linesWritten = 0;
+        uint32_t adler = 1;
+        std::vector<uint8_t> buffer;
+    };
+}
@@ -0,0 +1,72 @@
+#include "adts.h"
+#include "coding.h"
+
+namespace dab {
+    const int ADTS_HEADER_SIZE  = 7;
+    const int AU_CRC_SIZE       = 2;
+
+    // Sampling frequency index of the AAC core, SBR doubles the output samplerate
+    const int SFI_48000         = 3;
+    const int SFI_32000         = 5;
+    const int SFI_24000         = 6;
+    const int SFI_16000         = 8;
+
+    int getAccessUnitCount(const uint8_t* superframe) {
+        bool dacRate = superframe[2] & 0x40;
+        bool sbr = superframe[2] & 0x20;
+        if (sbr) { return dacRate ? 3 : 2; }
+        return dacRate ? 6 : 4;
+    }
+
+    int superframeToADTS(const uint8_t* superframe, int len, std::vector<uint8_t>& out, AudioFormat* format) {
+        // Parse the header
+        bool dacRate = superframe[2] & 0x40;
+        bool sbr = superframe[2] & 0x20;
+        bool stereo = superframe[2] & 0x10;
+        bool ps = superframe[2] & 0x08;
+        if (format) {
+            format->sampleRate = dacRate ? 48000 : 32000;
+            format->sbr = sbr;
+            format->ps = ps;
+            format->stereo = stereo || ps;
+        }
+
+        // Get the start of each access unit, the first one directly follows the table of the others
+        int auCount = getAccessUnitCount(superframe);
+        int starts[7];
+        starts[0] = 3 + ((auCount - 1) * 12 + 7) / 8;
+        for (int i = 1; i < auCount; i++) {
+            int bit = 24 + (i - 1) * 12;
+            int byte = bit / 8;
+            starts[i] = (bit % 8) ? (((superframe[byte] & 0x0F) << 8) | superframe[byte + 1]) : ((superframe[byte] << 4) | (superframe[byte + 1] >> 4));
+        }
+        starts[auCount] = len;
+
+        int sfi = dacRate ? (sbr ? SFI_24000 : SFI_48000) : (sbr ? SFI_16000 : SFI_32000);
+        int channelConfig = stereo ? 2 : 1;
+
+        int valid = 0;
+        for (int i = 0; i < auCount; i++) {
+            int auLen = starts[i + 1] - starts[i];
+            if (auLen <= AU_CRC_SIZE || starts[i + 1] > len) { continue; }
+            const uint8_t* au = &superframe[starts[i]];
+            if (!checkCRC16(au, auLen)) { continue; }
+
+            // Write the ADTS header (MPEG-4, AAC LC, no CRC) followed by the access unit without its CRC
+            int payloadLen = auLen - AU_CRC_SIZE;
+            int frameLen = ADTS_HEADER_SIZE + payloadLen;
+            uint8_t header[ADTS_HEADER_SIZE];
+            header[0] = 0xFF;
+            header[1] = 0xF1;
+            header[2] = (1 << 6) | (sfi << 2) | (channelConfig >> 2);
+            header[3] = ((channelConfig & 3) << 6) | ((frameLen >> 11) & 3);
+            header[4] = (frameLen >> 3) & 0xFF;
+            header[5] = ((frameLen & 7) << 5) | 0x1F;
+            header[6] = 0xFC;
+            out.insert(out.end(), header, header + ADTS_HEADER_SIZE);
+            out.insert(out.end(), au, au + payloadLen);
+            valid++;
+        }
+        return valid;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace dab {
+    struct AudioFormat {
+        int sampleRate;
+        bool sbr;
+        bool ps;
+        bool stereo;
+    };
+
+    /**
+     * Convert the access units of a DAB+ audio superframe to ADTS frames, a format most AAC decoders and players accept.
+     * @param superframe Superframe, parity excluded.
+     * @param len Size of the superframe in bytes.
+     * @param out Vector the ADTS frames are appended to.
+     * @param format Optional pointer receiving the audio format of the superframe.
+     * @return Number of access units that had a valid CRC, the others are dropped.
+    */
+    int superframeToADTS(const uint8_t* superframe, int len, std::vector<uint8_t>& out, AudioFormat* format = NULL);
+
+    /**
+     * Get the number of access units of a superframe, whether valid or not.
+     * @param superframe Superframe, parity excluded.
+     * @return Number of access units.
+    */
+    int getAccessUnitCount(const uint8_t* superframe);
+}
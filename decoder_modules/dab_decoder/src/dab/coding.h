@@ -0,0 +1,89 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <dsp/fec/viterbi.h>
+
+namespace dab {
+    // Layout of a transmission frame in mode I
+    const int BITS_PER_SYMBOL       = 3072;
+    const int FIC_SYMBOLS           = 3;
+    const int FIC_BLOCKS            = 4;
+    const int FIC_BLOCK_BITS        = 2304;
+    const int FIB_SIZE              = 32;
+    const int FIBS_PER_BLOCK        = 3;
+    const int CIF_COUNT             = 4;
+    const int CIF_BITS              = 55296;
+    const int CU_BITS               = 64;
+    const int CU_COUNT              = 864;
+
+    // Convolutional code, rate 1/4 mother code with a constraint length of 7
+    const int CONV_K                = 7;
+    const int CONV_N                = 4;
+    const int CONV_TAIL             = CONV_K - 1;
+    const uint16_t CONV_POLYS[CONV_N] = { 0x6D, 0x4F, 0x53, 0x6D };    // 133, 171, 145 and 133 octal, bit reversed
+
+    // Delay in CIFs applied by the time interleaver to each bit depending on its index modulo 16
+    const int TIME_INTERLEAVING_DEPTH = 16;
+    const int TIME_INTERLEAVING_DELAYS[TIME_INTERLEAVING_DEPTH] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+
+    typedef dsp::fec::Viterbi<CONV_K, CONV_N> ConvDecoder;
+
+    /**
+     * Append a puncturing vector to a depuncturing pattern.
+     * @param pattern Pattern to append to.
+     * @param index Puncturing vector index, 1 to 24. PI_n keeps 8+n of each 32 symbols.
+     * @param count Number of times the vector is applied.
+    */
+    inline void appendPuncturing(std::vector<uint8_t>& pattern, int index, int count) {
+        // The vectors are built from 8 groups of 4 symbols that get an additional symbol in this order as the index increases
+        static const int GROUP_ORDER[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+        uint8_t vec[32];
+        for (int g = 0; g < 8; g++) {
+            int rank = std::find(GROUP_ORDER, GROUP_ORDER + 8, g) - GROUP_ORDER;
+            int ones = 1 + (index / 8) + ((rank < (index % 8)) ? 1 : 0);
+            for (int i = 0; i < 4; i++) { vec[g * 4 + i] = (i < ones); }
+        }
+        for (int i = 0; i < count; i++) { pattern.insert(pattern.end(), vec, vec + 32); }
+    }
+
+    // Append the puncturing of the 24 symbols produced by the tail bits
+    inline void appendTailPuncturing(std::vector<uint8_t>& pattern) {
+        for (int i = 0; i < 24; i++) { pattern.push_back((i % 4) < 2); }
+    }
+
+    /**
+     * Generate the energy dispersal sequence (PRBS x^9 + x^5 + 1, registers initialized to ones).
+     * @param out Output bytes, bits packed MSB first.
+     * @param bytes Number of bytes to generate.
+    */
+    inline void generatePRBS(uint8_t* out, int bytes) {
+        uint16_t reg = 0x1FF;
+        for (int i = 0; i < bytes; i++) {
+            uint8_t byte = 0;
+            for (int j = 0; j < 8; j++) {
+                int bit = ((reg >> 8) ^ (reg >> 4)) & 1;
+                reg = ((reg << 1) | bit) & 0x1FF;
+                byte = (byte << 1) | bit;
+            }
+            out[i] = byte;
+        }
+    }
+
+    // CRC-16-CCITT with an inverted result as used by the FIBs and the DAB+ access units
+    inline uint16_t crc16(const uint8_t* data, int len) {
+        uint16_t crc = 0xFFFF;
+        for (int i = 0; i < len; i++) {
+            crc ^= (uint16_t)data[i] << 8;
+            for (int j = 0; j < 8; j++) { crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1); }
+        }
+        return ~crc;
+    }
+
+    // Check a block ending with its big endian CRC-16-CCITT
+    inline bool checkCRC16(const uint8_t* data, int len) {
+        uint16_t crc = ((uint16_t)data[len - 2] << 8) | data[len - 1];
+        return crc16(data, len - 2) == crc;
+    }
+}
@@ -0,0 +1,257 @@
+#include "fic.h"
+
+namespace dab {
+    // Each FIC block carries 3 FIBs, punctured with PI_16 then PI_15 and the tail puncturing
+    const int FIC_PI16_VECTORS  = 21 * 4;
+    const int FIC_PI15_VECTORS  = 3 * 4;
+    const int FIB_DATA_SIZE     = 30;
+    const int LABEL_SIZE        = 16;
+
+    // Rate of the moving average of the FIB CRC success
+    const float QUALITY_RATE    = 0.05f;
+
+    // Size in CUs of an EEP sub-channel per unit of n, for each protection level
+    const int EEP_A_SIZE_FACTOR[4] = { 12, 8, 6, 4 };
+    const int EEP_B_SIZE_FACTOR[4] = { 27, 21, 18, 15 };
+
+    // Audio service component type of DAB+
+    const int ASCTY_DABPLUS = 63;
+
+    FICDecoder::FICDecoder() {
+        appendPuncturing(pattern, 16, FIC_PI16_VECTORS);
+        appendPuncturing(pattern, 15, FIC_PI15_VECTORS);
+        appendTailPuncturing(pattern);
+        conv.init(CONV_POLYS, pattern.size() / CONV_N);
+        generatePRBS(prbs, sizeof(prbs));
+    }
+
+    void FICDecoder::process(const uint8_t* soft) {
+        for (int b = 0; b < FIC_BLOCKS; b++) {
+            // Undo the convolutional code and the energy dispersal
+            dsp::fec::depuncture(&soft[b * FIC_BLOCK_BITS], depunctured, pattern.size(), pattern.data(), pattern.size());
+            conv.decode(depunctured, pattern.size(), decoded, CONV_TAIL);
+            for (int i = 0; i < sizeof(decoded); i++) { decoded[i] ^= prbs[i]; }
+
+            // Process the FIBs that passed their CRC
+            std::lock_guard<std::mutex> lck(ensembleMtx);
+            for (int i = 0; i < FIBS_PER_BLOCK; i++) {
+                const uint8_t* fib = &decoded[i * FIB_SIZE];
+                bool valid = checkCRC16(fib, FIB_SIZE);
+                quality += QUALITY_RATE * ((valid ? 1.0f : 0.0f) - quality);
+                if (valid) { processFIB(fib); }
+            }
+        }
+    }
+
+    void FICDecoder::reset() {
+        std::lock_guard<std::mutex> lck(ensembleMtx);
+        ensemble = Ensemble();
+        quality = 0.0f;
+        version++;
+    }
+
+    Ensemble FICDecoder::getEnsemble() {
+        std::lock_guard<std::mutex> lck(ensembleMtx);
+        return ensemble;
+    }
+
+    int FICDecoder::getVersion() {
+        std::lock_guard<std::mutex> lck(ensembleMtx);
+        return version;
+    }
+
+    float FICDecoder::getQuality() {
+        std::lock_guard<std::mutex> lck(ensembleMtx);
+        return quality;
+    }
+
+    void FICDecoder::processFIB(const uint8_t* fib) {
+        int pos = 0;
+        while (pos < FIB_DATA_SIZE) {
+            // An end marker means the rest of the FIB is padding
+            uint8_t header = fib[pos++];
+            if (header == 0xFF) { break; }
+
+            // Parse the FIG header and check that it fits
+            int type = header >> 5;
+            int len = header & 0x1F;
+            if (!len || pos + len > FIB_DATA_SIZE) { break; }
+
+            if (type == 0) {
+                processFIG0(&fib[pos], len);
+            }
+            else if (type == 1) {
+                processFIG1(&fib[pos], len);
+            }
+            pos += len;
+        }
+    }
+
+    void FICDecoder::processFIG0(const uint8_t* data, int len) {
+        bool otherEnsemble = data[0] & 0x40;
+        bool dataServices = data[0] & 0x20;
+        int ext = data[0] & 0x1F;
+        if (otherEnsemble) { return; }
+
+        switch (ext) {
+        case 0:
+            // Ensemble information
+            if (len >= 3) {
+                uint16_t id = ((uint16_t)data[1] << 8) | data[2];
+                if (id != ensemble.id) {
+                    // A different ensemble was tuned, forget everything about the previous one
+                    if (ensemble.id) { ensemble = Ensemble(); }
+                    ensemble.id = id;
+                    version++;
+                }
+            }
+            break;
+        case 1:
+            processSubchannels(&data[1], len - 1);
+            break;
+        case 2:
+            processServices(&data[1], len - 1, dataServices);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void FICDecoder::processFIG1(const uint8_t* data, int len) {
+        int charset = data[0] >> 4;
+        bool otherEnsemble = data[0] & 0x08;
+        int ext = data[0] & 0x07;
+        if (otherEnsemble) { return; }
+
+        // Labels are made of an identifier, 16 characters and a 16bit mask of the characters to use for abbreviations
+        int idLen = (ext == 5) ? 4 : 2;
+        if (len < 1 + idLen + LABEL_SIZE) { return; }
+        uint32_t id = 0;
+        for (int i = 0; i < idLen; i++) { id = (id << 8) | data[1 + i]; }
+        const uint8_t* chars = &data[1 + idLen];
+
+        if (ext == 0) {
+            setLabel(ensemble.label, chars, charset);
+        }
+        else if (ext == 1 || ext == 5) {
+            Service& service = ensemble.services[id];
+            service.id = id;
+            setLabel(service.label, chars, charset);
+        }
+    }
+
+    void FICDecoder::processSubchannels(const uint8_t* data, int len) {
+        int pos = 0;
+        while (pos + 3 <= len) {
+            Subchannel sc;
+            sc.id = data[pos] >> 2;
+            sc.startCU = ((data[pos] & 0x03) << 8) | data[pos + 1];
+            sc.bitrate = 0;
+
+            if (!(data[pos + 2] & 0x80)) {
+                // Short form, UEP table index
+                sc.protection = PROTECTION_UEP;
+                sc.level = data[pos + 2] & 0x3F;
+                sc.sizeCU = 0;
+                pos += 3;
+            }
+            else {
+                // Long form, EEP
+                if (pos + 4 > len) { break; }
+                int option = (data[pos + 2] >> 4) & 0x07;
+                sc.level = (data[pos + 2] >> 2) & 0x03;
+                sc.sizeCU = ((data[pos + 2] & 0x03) << 8) | data[pos + 3];
+                pos += 4;
+                if (option == 0) {
+                    sc.protection = PROTECTION_EEP_A;
+                    sc.bitrate = (sc.sizeCU / EEP_A_SIZE_FACTOR[sc.level]) * 8;
+                }
+                else if (option == 1) {
+                    sc.protection = PROTECTION_EEP_B;
+                    sc.bitrate = (sc.sizeCU / EEP_B_SIZE_FACTOR[sc.level]) * 32;
+                }
+                else {
+                    continue;
+                }
+            }
+
+            // Only count actual changes
+            auto it = ensemble.subchannels.find(sc.id);
+            if (it != ensemble.subchannels.end() && it->second.startCU == sc.startCU && it->second.sizeCU == sc.sizeCU &&
+                it->second.protection == sc.protection && it->second.level == sc.level) {
+                continue;
+            }
+            ensemble.subchannels[sc.id] = sc;
+            version++;
+        }
+    }
+
+    void FICDecoder::processServices(const uint8_t* data, int len, bool dataServices) {
+        int idLen = dataServices ? 4 : 2;
+        int pos = 0;
+        while (pos + idLen + 1 <= len) {
+            uint32_t id = 0;
+            for (int i = 0; i < idLen; i++) { id = (id << 8) | data[pos + i]; }
+            pos += idLen;
+            int componentCount = data[pos++] & 0x0F;
+            if (pos + (componentCount * 2) > len) { break; }
+
+            std::vector<ServiceComponent> components;
+            for (int i = 0; i < componentCount; i++) {
+                const uint8_t* c = &data[pos + (i * 2)];
+                int tmid = c[0] >> 6;
+                ServiceComponent comp;
+                comp.primary = c[1] & 0x02;
+                comp.subchannel = c[1] >> 2;
+                if (tmid == 0) {
+                    int ascty = c[0] & 0x3F;
+                    comp.type = (ascty == ASCTY_DABPLUS) ? COMPONENT_TYPE_DABPLUS_AUDIO : COMPONENT_TYPE_DAB_AUDIO;
+                }
+                else if (tmid == 1) {
+                    comp.type = COMPONENT_TYPE_DATA_STREAM;
+                }
+                else if (tmid == 3) {
+                    comp.type = COMPONENT_TYPE_PACKET_DATA;
+                    comp.subchannel = -1;
+                }
+                else {
+                    continue;
+                }
+                components.push_back(comp);
+            }
+            pos += componentCount * 2;
+
+            // Only count actual changes
+            Service& service = ensemble.services[id];
+            service.id = id;
+            bool changed = (service.components.size() != components.size());
+            for (int i = 0; !changed && i < components.size(); i++) {
+                changed = (service.components[i].type != components[i].type || service.components[i].subchannel != components[i].subchannel);
+            }
+            if (changed) {
+                service.components = components;
+                version++;
+            }
+        }
+    }
+
+    void FICDecoder::setLabel(std::string& label, const uint8_t* chars, int charset) {
+        // Only the ASCII subset of the EBU Latin character set is supported, UTF-8 labels are used as is
+        std::string str;
+        for (int i = 0; i < LABEL_SIZE; i++) {
+            uint8_t c = chars[i];
+            if (charset == 15 || (c >= 0x20 && c < 0x7F)) {
+                str += (char)c;
+            }
+            else {
+                str += '?';
+            }
+        }
+
+        // Remove the padding
+        while (!str.empty() && str.back() == ' ') { str.pop_back(); }
+        if (str == label) { return; }
+        label = str;
+        version++;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include "coding.h"
+
+namespace dab {
+    enum Protection {
+        PROTECTION_UEP,
+        PROTECTION_EEP_A,
+        PROTECTION_EEP_B
+    };
+
+    struct Subchannel {
+        int id;
+        int startCU;
+        int sizeCU;
+        Protection protection;
+
+        // Protection level from 0 (strongest) to 3 for EEP, table index for UEP
+        int level;
+
+        // Bitrate in kbit/s, 0 if unknown
+        int bitrate;
+    };
+
+    enum ComponentType {
+        COMPONENT_TYPE_DAB_AUDIO,
+        COMPONENT_TYPE_DABPLUS_AUDIO,
+        COMPONENT_TYPE_DATA_STREAM,
+        COMPONENT_TYPE_PACKET_DATA
+    };
+
+    struct ServiceComponent {
+        ComponentType type;
+        int subchannel;     // -1 for packet mode components
+        bool primary;
+    };
+
+    struct Service {
+        uint32_t id;
+        std::string label;
+        std::vector<ServiceComponent> components;
+    };
+
+    struct Ensemble {
+        uint16_t id = 0;
+        std::string label;
+        std::map<int, Subchannel> subchannels;
+        std::map<uint32_t, Service> services;
+    };
+
+    /**
+     * Fast Information Channel decoder.
+     * Decodes the FIC of each transmission frame and maintains the description of the ensemble from the
+     * multiplex configuration (FIG type 0) and labels (FIG type 1).
+    */
+    class FICDecoder {
+    public:
+        FICDecoder();
+
+        /**
+         * Decode the FIC of a transmission frame.
+         * @param soft Soft bits of the FIC symbols, FIC_SYMBOLS * BITS_PER_SYMBOL of them.
+        */
+        void process(const uint8_t* soft);
+
+        // Forget everything about the ensemble, typically after retuning
+        void reset();
+
+        /**
+         * Get a copy of the description of the ensemble.
+         * @return Ensemble description.
+        */
+        Ensemble getEnsemble();
+
+        /**
+         * Get a counter incremented each time the description of the ensemble changes.
+         * @return Change counter.
+        */
+        int getVersion();
+
+        /**
+         * Get the ratio of FIBs received with a valid CRC over the last few frames.
+         * @return Ratio between 0 and 1.
+        */
+        float getQuality();
+
+    private:
+        void processFIB(const uint8_t* fib);
+        void processFIG0(const uint8_t* data, int len);
+        void processFIG1(const uint8_t* data, int len);
+        void processSubchannels(const uint8_t* data, int len);
+        void processServices(const uint8_t* data, int len, bool dataServices);
+        void setLabel(std::string& label, const uint8_t* chars, int charset);
+
+        std::vector<uint8_t> pattern;
+        ConvDecoder conv;
+        uint8_t depunctured[(FIBS_PER_BLOCK * FIB_SIZE * 8 + CONV_TAIL) * CONV_N];
+        uint8_t decoded[FIBS_PER_BLOCK * FIB_SIZE];
+        uint8_t prbs[FIBS_PER_BLOCK * FIB_SIZE];
+
+        std::mutex ensembleMtx;
+        Ensemble ensemble;
+        int version = 0;
+        float quality = 0.0f;
+    };
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <dsp/sink.h>
+#include "dab_dsp.h"
+#include "coding.h"
+#include "fic.h"
+
+namespace dab {
+    /**
+     * Turns the demodulated carriers of each transmission frame into soft bits, decodes the FIC and hands the bits of
+     * each bound sub-channel over to its own stream. Sub-channels are decoded by separate blocks so that all the
+     * services of an ensemble can be decoded in parallel.
+    */
+    class FrameDecoder : public dsp::Sink<dsp::complex_t> {
+        using base_type = dsp::Sink<dsp::complex_t>;
+    public:
+        FrameDecoder() {}
+
+        FrameDecoder(dsp::stream<dsp::complex_t>* in) { init(in); }
+
+        ~FrameDecoder() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            dsp::buffer::free(soft);
+        }
+
+        void init(dsp::stream<dsp::complex_t>* in) {
+            // Generate the frequency interleaving permutation, only the values matching a carrier are used
+            int pi = 0;
+            int n = 0;
+            for (int i = 0; i < FFT_SIZE; i++) {
+                if (i) { pi = (13 * pi + 511) % FFT_SIZE; }
+                if (pi < 256 || pi > 1792 || pi == 1024) { continue; }
+
+                // Convert from the carrier number to the index in the demodulated carriers that skip the center one
+                int k = pi - 1024;
+                carrierMap[n++] = (k < 0) ? (k + CARRIER_COUNT / 2) : (k + CARRIER_COUNT / 2 - 1);
+            }
+
+            soft = dsp::buffer::alloc<uint8_t>((FRAME_SYMBOLS - 1) * BITS_PER_SYMBOL);
+
+            base_type::init(in);
+        }
+
+        /**
+         * Send the soft bits of a sub-channel to a stream.
+         * @param stream Stream receiving CIF_COUNT CIFs worth of soft bits per frame.
+         * @param startCU First capacity unit of the sub-channel.
+         * @param sizeCU Number of capacity units of the sub-channel.
+        */
+        void bindSubchannel(dsp::stream<uint8_t>* stream, int startCU, int sizeCU) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream isn't already bound
+            if (std::find_if(outputs.begin(), outputs.end(), [stream](const Output& o) { return o.stream == stream; }) != outputs.end()) {
+                throw std::runtime_error("[FrameDecoder] Tried to bind stream to that is already bound");
+            }
+
+            // Add to the list
+            base_type::tempStop();
+            base_type::registerOutput(stream);
+            outputs.push_back({ stream, startCU, sizeCU });
+            base_type::tempStart();
+        }
+
+        void unbindSubchannel(dsp::stream<uint8_t>* stream) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream is bound
+            auto it = std::find_if(outputs.begin(), outputs.end(), [stream](const Output& o) { return o.stream == stream; });
+            if (it == outputs.end()) {
+                throw std::runtime_error("[FrameDecoder] Tried to unbind stream to that isn't bound");
+            }
+
+            // Remove from the list
+            base_type::tempStop();
+            outputs.erase(it);
+            base_type::unregisterOutput(stream);
+            base_type::tempStart();
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Only complete frames can be decoded
+            if (count != (FRAME_SYMBOLS - 1) * CARRIER_COUNT) {
+                base_type::_in->flush();
+                return count;
+            }
+
+            // Undo the frequency interleaving while converting the QPSK symbols to soft bits,
+            // the real parts give the first half of the bits of a symbol, the imaginary parts the second half
+            for (int l = 0; l < FRAME_SYMBOLS - 1; l++) {
+                const dsp::complex_t* carriers = &base_type::_in->readBuf[l * CARRIER_COUNT];
+                uint8_t* bits = &soft[l * BITS_PER_SYMBOL];
+                for (int n = 0; n < CARRIER_COUNT; n++) {
+                    const dsp::complex_t& c = carriers[carrierMap[n]];
+                    bits[n] = toSoft(c.re);
+                    bits[n + CARRIER_COUNT] = toSoft(c.im);
+                }
+            }
+            base_type::_in->flush();
+
+            // Decode the FIC
+            fic.process(soft);
+
+            // Send the bits of each CIF to the sub-channels
+            const uint8_t* msc = &soft[FIC_SYMBOLS * BITS_PER_SYMBOL];
+            for (const auto& o : outputs) {
+                int bits = o.sizeCU * CU_BITS;
+                for (int i = 0; i < CIF_COUNT; i++) {
+                    memcpy(&o.stream->writeBuf[i * bits], &msc[(i * CIF_BITS) + (o.startCU * CU_BITS)], bits);
+                }
+                if (!o.stream->swap(bits * CIF_COUNT)) { return -1; }
+            }
+
+            return count;
+        }
+
+        FICDecoder fic;
+
+    private:
+        struct Output {
+            dsp::stream<uint8_t>* stream;
+            int startCU;
+            int sizeCU;
+        };
+
+        // A positive value is a zero bit
+        static inline uint8_t toSoft(float val) {
+            return std::clamp<float>(128.0f - (val * SOFT_SCALE), 0.0f, 255.0f);
+        }
+
+        static constexpr float SOFT_SCALE = 127.0f;
+
+        int carrierMap[CARRIER_COUNT];
+        uint8_t* soft;
+        std::vector<Output> outputs;
+    };
+}
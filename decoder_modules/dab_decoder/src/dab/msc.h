@@ -0,0 +1,250 @@
+#pragma once
+#include <dsp/processor.h>
+#include <dsp/fec/reed_solomon.h>
+#include <utils/flog.h>
+#include <atomic>
+#include "coding.h"
+#include "fic.h"
+
+namespace dab {
+    /**
+     * Decodes the soft bits of a sub-channel into its data bytes.
+     * Input is a whole number of CIFs worth of soft bits of the sub-channel, output is the bitrate * 3 bytes
+     * carried by each CIF once the time deinterleaver is filled. Only EEP sub-channels are supported.
+    */
+    class SubchannelDecoder : public dsp::Processor<uint8_t, uint8_t> {
+        using base_type = dsp::Processor<uint8_t, uint8_t>;
+    public:
+        SubchannelDecoder() {}
+
+        SubchannelDecoder(dsp::stream<uint8_t>* in, const Subchannel& subchannel) { init(in, subchannel); }
+
+        ~SubchannelDecoder() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            dsp::buffer::free(history);
+            dsp::buffer::free(deinterleaved);
+            dsp::buffer::free(depunctured);
+        }
+
+        static bool isSupported(const Subchannel& subchannel) {
+            return subchannel.protection != PROTECTION_UEP && subchannel.bitrate > 0;
+        }
+
+        void init(dsp::stream<uint8_t>* in, const Subchannel& subchannel) {
+            _subchannel = subchannel;
+            cifBits = subchannel.sizeCU * CU_BITS;
+            cifBytes = subchannel.bitrate * 3;
+
+            // Generate the depuncturing pattern and check that it matches the size of the sub-channel
+            generatePattern();
+            int kept = std::count(pattern.begin(), pattern.end(), 1);
+            valid = (kept == cifBits && pattern.size() == (cifBytes * 8 + CONV_TAIL) * CONV_N);
+            if (!valid) {
+                flog::error("Unsupported DAB sub-channel configuration (id={}, size={} CUs, bitrate={} kbit/s)", subchannel.id, subchannel.sizeCU, subchannel.bitrate);
+            }
+
+            // Allocate the buffers
+            history = dsp::buffer::alloc<uint8_t>(TIME_INTERLEAVING_DEPTH * cifBits);
+            deinterleaved = dsp::buffer::alloc<uint8_t>(cifBits);
+            depunctured = dsp::buffer::alloc<uint8_t>(pattern.size());
+            prbs.resize(cifBytes);
+            generatePRBS(prbs.data(), cifBytes);
+            conv.init(CONV_POLYS, pattern.size() / CONV_N);
+
+            base_type::init(in);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            cifId = 0;
+            filled = 0;
+            base_type::tempStart();
+        }
+
+        const Subchannel& getSubchannel() { return _subchannel; }
+
+        int process(int count, const uint8_t* in, uint8_t* out) {
+            if (!valid) { return 0; }
+
+            int outCount = 0;
+            for (int offset = 0; offset + cifBits <= count; offset += cifBits) {
+                // Save the CIF in the time deinterleaving history
+                memcpy(&history[cifId * cifBits], &in[offset], cifBits);
+
+                // Bit i of the oldest complete logical frame was sent TIME_INTERLEAVING_DELAYS[i % 16] CIFs after it
+                for (int j = 0; j < TIME_INTERLEAVING_DEPTH; j++) {
+                    const uint8_t* src = &history[((cifId + 1 + TIME_INTERLEAVING_DELAYS[j]) % TIME_INTERLEAVING_DEPTH) * cifBits];
+                    for (int i = j; i < cifBits; i += TIME_INTERLEAVING_DEPTH) { deinterleaved[i] = src[i]; }
+                }
+                cifId = (cifId + 1) % TIME_INTERLEAVING_DEPTH;
+
+                // Wait for the deinterleaver to be filled
+                if (filled < TIME_INTERLEAVING_DEPTH - 1) {
+                    filled++;
+                    continue;
+                }
+
+                // Undo the convolutional code and the energy dispersal
+                dsp::fec::depuncture(deinterleaved, depunctured, pattern.size(), pattern.data(), pattern.size());
+                conv.decode(depunctured, pattern.size(), &out[outCount], CONV_TAIL);
+                for (int i = 0; i < cifBytes; i++) { out[outCount + i] ^= prbs[i]; }
+                outCount += cifBytes;
+            }
+            return outCount;
+        }
+
+        DEFAULT_MULTIRATE_PROC_RUN
+
+    private:
+        void generatePattern() {
+            // Get the number of 128 bit blocks and puncturing vectors of each part of the sub-channel
+            int l1 = 0, l2 = 0, pi1 = 0, pi2 = 0;
+            if (_subchannel.protection == PROTECTION_EEP_A) {
+                int n = _subchannel.bitrate / 8;
+                switch (_subchannel.level) {
+                case 0: l1 = 6*n - 3; l2 = 3; pi1 = 24; pi2 = 23; break;
+                case 1:
+                    if (n == 1) { l1 = 5; l2 = 1; pi1 = 13; pi2 = 12; }
+                    else { l1 = 2*n - 3; l2 = 4*n + 3; pi1 = 14; pi2 = 13; }
+                    break;
+                case 2: l1 = 6*n - 3; l2 = 3; pi1 = 8; pi2 = 7; break;
+                case 3: l1 = 4*n - 3; l2 = 2*n + 3; pi1 = 3; pi2 = 2; break;
+                }
+            }
+            else if (_subchannel.protection == PROTECTION_EEP_B) {
+                const int PI1[4] = { 10, 6, 4, 2 };
+                int n = _subchannel.bitrate / 32;
+                l1 = 24*n - 3;
+                l2 = 3;
+                pi1 = PI1[_subchannel.level];
+                pi2 = pi1 - 1;
+            }
+
+            pattern.clear();
+            if (l1 < 0 || l2 < 0 || !pi1) { return; }
+            appendPuncturing(pattern, pi1, l1 * 4);
+            appendPuncturing(pattern, pi2, l2 * 4);
+            appendTailPuncturing(pattern);
+        }
+
+        Subchannel _subchannel;
+        bool valid = false;
+        int cifBits;
+        int cifBytes;
+
+        uint8_t* history;
+        int cifId = 0;
+        int filled = 0;
+
+        uint8_t* deinterleaved;
+        uint8_t* depunctured;
+        std::vector<uint8_t> pattern;
+        std::vector<uint8_t> prbs;
+        ConvDecoder conv;
+    };
+
+    /**
+     * Finds and corrects the audio superframes of a DAB+ sub-channel.
+     * A superframe spans 5 CIFs and is protected by 10 bytes of RS(120, 110) parity per codeword, the codewords
+     * being byte interleaved. Its start is found by checking the fire code of the header at each CIF boundary.
+     * Output is the 110 * (bitrate / 8) bytes of each superframe, parity excluded.
+    */
+    class SuperframeSync : public dsp::Processor<uint8_t, uint8_t> {
+        using base_type = dsp::Processor<uint8_t, uint8_t>;
+    public:
+        SuperframeSync() {}
+
+        SuperframeSync(dsp::stream<uint8_t>* in, int bitrate) { init(in, bitrate); }
+
+        ~SuperframeSync() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            dsp::buffer::free(frame);
+            dsp::buffer::free(work);
+        }
+
+        void init(dsp::stream<uint8_t>* in, int bitrate) {
+            depth = bitrate / 8;
+            cifBytes = bitrate * 3;
+            frame = dsp::buffer::alloc<uint8_t>(depth * RS_BLOCK_LEN);
+            work = dsp::buffer::alloc<uint8_t>(depth * RS_BLOCK_LEN);
+            rs.init(RS_PRIMITIVE_POLYNOMIAL, 0, 1, RS_BLOCK_LEN - RS_DATA_LEN);
+            base_type::init(in);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            filled = 0;
+            base_type::tempStart();
+        }
+
+        int getSuperframeSize() { return depth * RS_DATA_LEN; }
+        int getSuperframeCount() { return superframes; }
+        int getUncorrectableCount() { return uncorrectable; }
+        bool isSynced() { return synced; }
+
+        int process(int count, const uint8_t* in, uint8_t* out) {
+            int outCount = 0;
+            int superframeBytes = depth * RS_BLOCK_LEN;
+            for (int offset = 0; offset + cifBytes <= count; offset += cifBytes) {
+                // Accumulate 5 CIFs
+                memcpy(&frame[filled], &in[offset], cifBytes);
+                filled += cifBytes;
+                if (filled < superframeBytes) { continue; }
+
+                // Correct the candidate superframe and check its header
+                memcpy(work, frame, superframeBytes);
+                int res = rs.correctInterleaved(work, depth, RS_BLOCK_LEN);
+                if (!checkFirecode(work)) {
+                    // Not the start of a superframe, try again one CIF later
+                    memmove(frame, &frame[cifBytes], superframeBytes - cifBytes);
+                    filled -= cifBytes;
+                    synced = false;
+                    continue;
+                }
+
+                memcpy(&out[outCount], work, depth * RS_DATA_LEN);
+                outCount += depth * RS_DATA_LEN;
+                filled = 0;
+                synced = true;
+                superframes++;
+                if (res < 0) { uncorrectable++; }
+            }
+            return outCount;
+        }
+
+        DEFAULT_MULTIRATE_PROC_RUN
+
+    private:
+        static constexpr int RS_BLOCK_LEN = 120;
+        static constexpr int RS_DATA_LEN = 110;
+        static constexpr uint16_t RS_PRIMITIVE_POLYNOMIAL = 0x11D;
+
+        // The fire code covers bytes 2 to 10 of the superframe and is stored in bytes 0 and 1
+        static bool checkFirecode(const uint8_t* data) {
+            uint16_t crc = 0;
+            for (int i = 2; i < 11; i++) {
+                crc ^= (uint16_t)data[i] << 8;
+                for (int j = 0; j < 8; j++) { crc = (crc & 0x8000) ? ((crc << 1) ^ 0x782F) : (crc << 1); }
+            }
+            uint16_t expected = ((uint16_t)data[0] << 8) | data[1];
+            return crc == expected;
+        }
+
+        int depth;
+        int cifBytes;
+        uint8_t* frame;
+        uint8_t* work;
+        int filled = 0;
+        dsp::fec::ReedSolomon rs;
+
+        std::atomic<int> superframes = 0;
+        std::atomic<int> uncorrectable = 0;
+        std::atomic<bool> synced = false;
+    };
+}
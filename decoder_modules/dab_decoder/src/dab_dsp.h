@@ -5,15 +5,30 @@
 #include "dab_phase_sym.h"
 
 namespace dab {
+    // DAB transmission mode I parameters at 2.048MHz
+    const int FFT_SIZE          = 2048;
+    const int GUARD_SIZE        = 504;
+    const int CARRIER_COUNT     = 1536;
+    const int FRAME_SYMBOLS     = 76;
+
     class CyclicSync : public dsp::Processor<dsp::complex_t, dsp::complex_t> {
         using base_type = dsp::Processor<dsp::complex_t, dsp::complex_t>;
     public:
         CyclicSync() {}
 
         // TODO: The default AGC rate is probably way too fast, plot out the avgCorr to see how much it moves
-        CyclicSync(dsp::stream<dsp::complex_t>* in, double symbolLength, double cyclicPrefixLength, double samplerate, float agcRate = 1e-3) { init(in, symbolLength, cyclicPrefixLength, samplerate, agcRate); }
+        CyclicSync(dsp::stream<dsp::complex_t>* in, double symbolLength, double cyclicPrefixLength, double samplerate, float agcRate = 1e-3, float freqLoopGain = 0.1f) { init(in, symbolLength, cyclicPrefixLength, samplerate, agcRate, freqLoopGain); }
+
+        ~CyclicSync() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            dsp::buffer::free(delayBuf);
+            dsp::buffer::free(prodBuf);
+            dsp::buffer::free(corrBuf);
+            dsp::buffer::free(corrAmps);
+        }
 
-        void init(dsp::stream<dsp::complex_t>* in, double symbolLength, double cyclicPrefixLength, double samplerate, float agcRate = 1e-3) {
+        void init(dsp::stream<dsp::complex_t>* in, double symbolLength, double cyclicPrefixLength, double samplerate, float agcRate = 1e-3, float freqLoopGain = 0.1f) {
             // Computer the number of samples for the symbol and its cyclic prefix
             symbolSamps = round(samplerate * symbolLength);
             prefixSamps = round(samplerate * cyclicPrefixLength);
@@ -22,16 +37,25 @@ namespace dab {
             delayBuf = dsp::buffer::alloc<dsp::complex_t>(STREAM_BUFFER_SIZE + 64000);
             dsp::buffer::clear(delayBuf, symbolSamps);
 
-            // Allocate and clear the history buffer
-            histBuf = dsp::buffer::alloc<dsp::complex_t>(prefixSamps);
-            dsp::buffer::clear(histBuf, prefixSamps);
+            // Allocate and clear the product buffer, the first prefixSamps products are the ones of the previous call
+            prodBuf = dsp::buffer::alloc<dsp::complex_t>(STREAM_BUFFER_SIZE + prefixSamps);
+            dsp::buffer::clear(prodBuf, prefixSamps);
+
+            // Allocate the correlation buffers
+            corrBuf = dsp::buffer::alloc<dsp::complex_t>(STREAM_BUFFER_SIZE);
+            corrAmps = dsp::buffer::alloc<float>(STREAM_BUFFER_SIZE);
 
             // Compute the delay input addresses
             delayBufInput = &delayBuf[symbolSamps];
 
+            // Compute the position of the correlation peak in a correctly timed symbol
+            guardSamps = prefixSamps / 8;
+            expectedPeak = prefixSamps + guardSamps - 1;
+
             // Compute the correlation AGC configuration
             this->agcRate = agcRate;
             agcRateInv = 1.0f - agcRate;
+            this->freqLoopGain = freqLoopGain;
             
             base_type::init(in);
         }
@@ -40,77 +64,104 @@ namespace dab {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            
+            offset = 0.0f;
+            phase = lv_cmake(1.0f, 0.0f);
+            locked = false;
             base_type::tempStart();
         }
 
+        // Get the frequency offset being corrected in rad/samp
+        float getFrequencyOffset() { return offset; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
-            // Copy the data into the normal delay buffer
-            memcpy(delayBufInput, base_type::_in->readBuf, count * sizeof(dsp::complex_t));
+            // Correct the fine frequency offset while copying the data into the delay buffer
+            lv_32fc_t phaseDelta = lv_cmake(cos(offset), sin(offset));
+#if VOLK_VERSION >= 030100
+            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)delayBufInput, (lv_32fc_t*)base_type::_in->readBuf, &phaseDelta, &phase, count);
+#else
+            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)delayBufInput, (lv_32fc_t*)base_type::_in->readBuf, phaseDelta, &phase, count);
+#endif
 
             // Flush the input stream
             base_type::_in->flush();
 
-            // Do cross-correlation
-            for (int i = 0; i < count; i++) {
-                // Get the current history slot
-                dsp::complex_t* slot = &histBuf[histId++];
-
-                // Wrap around the history slot index (TODO: Check that the history buffer's length is correct)
-                histId %= prefixSamps;
-
-                // Kick out last value from the correlation
-                corr -= *slot;
+            // Compute the product of every sample with the one a symbol later
+            volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)&prodBuf[prefixSamps], (lv_32fc_t*)&delayBuf[symbolSamps], (lv_32fc_t*)delayBuf, count);
 
-                // Save input value and compute the new prodct
-                dsp::complex_t val = delayBuf[i];
-                dsp::complex_t prod = val.conj()*delayBuf[i+symbolSamps];
+            // Sum up the products of the previous call from scratch so that rounding errors can't build up over time
+            dsp::complex_t corr = { 0.0f, 0.0f };
+            for (int i = 0; i < prefixSamps; i++) { corr += prodBuf[i]; }
 
-                // Add the new value to the correlation
-                *slot = prod;
-
-                // Add the new value to the history buffer
-                corr += prod;
+            // Slide the correlation window, each new product comes in while the one a prefix earlier goes out
+            for (int i = 0; i < count; i++) {
+                corr += prodBuf[prefixSamps + i] - prodBuf[i];
+                corrBuf[i] = corr;
+            }
+            volk_32fc_magnitude_32f(corrAmps, (lv_32fc_t*)corrBuf, count);
 
-                // Compute sample amplitude
-                float rcorr = corr.amplitude();
+            for (int i = 0; i < count; i++) {
+                float rcorr = corrAmps[i];
 
-                // If a high enough peak is reached, reset the symbol counter
-                if (rcorr > avgCorr && rcorr > peakCorr) { // Note keeping an average level might not be needed
+                // Keep track of the correlation peak of the symbol, it is reached on the last sample of the cyclic prefix
+                if (rcorr > peakCorr) {
                     peakCorr = rcorr;
-                    peakLCorr = lastCorr;
-                    samplesSincePeak = 0;
+                    peakVal = corrBuf[i];
+                    peakPos = symPos;
+
+                    // When not locked, restart the symbol on every new high enough peak
+                    if (!locked && rcorr > 2.0f * avgCorr) {
+                        symPos = peakPos = expectedPeak;
+                    }
                 }
 
-                // If this is the sample right after the peak, save it
-                if (samplesSincePeak == 1) {
-                    peakRCorr = rcorr;
+                // Write the sample to the output once past the cyclic prefix
+                if (symPos >= prefixSamps) {
+                    out.writeBuf[symPos - prefixSamps] = delayBuf[i];
                 }
 
-                // Write the sample to the output
-                out.writeBuf[samplesSincePeak++] = val;
+                // Update the average correlation value
+                avgCorr = agcRate*rcorr + agcRateInv*avgCorr;
 
                 // If the end of the symbol is reached, send it off
-                if (samplesSincePeak >= symbolSamps) {
-                    if (!out.swap(symbolSamps)) {
-                        return -1;
-                    }
-                    samplesSincePeak = 0;
+                if (++symPos < symbolSamps + prefixSamps) { continue; }
+                if (!out.swap(symbolSamps)) {
+                    return -1;
+                }
+                symPos = 0;
+
+                // No peak means there was no signal or a null symbol, the next peak will be acquired again
+                if (peakCorr <= 2.0f * avgCorr) {
+                    locked = false;
+                    timingError = 0.0f;
                     peakCorr = 0;
+                    continue;
                 }
 
-                // Update the average correlation
-                lastCorr = rcorr;
+                // The phase of the correlation peak is how much the remaining frequency offset rotated the samples over a symbol
+                offset -= freqLoopGain * peakVal.phase() / (float)symbolSamps;
 
-                // Update the average correlation value
-                avgCorr = agcRate*rcorr + agcRateInv*avgCorr;
+                // Follow the peak, but only move the symbol when really needed since it corrupts the differential demodulation
+                int error = peakPos - expectedPeak;
+                timingError += 0.1f * ((float)error - timingError);
+                if (!locked || abs(error) > guardSamps) {
+                    symPos = -error;
+                    timingError = 0.0f;
+                }
+                else if (fabsf(timingError) > (float)guardSamps * 0.5f) {
+                    int shift = roundf(timingError);
+                    symPos = -shift;
+                    timingError -= (float)shift;
+                }
+                locked = true;
+                peakCorr = 0;
             }
 
             // Move unused data
             memmove(delayBuf, &delayBuf[count], symbolSamps * sizeof(dsp::complex_t));
+            memmove(prodBuf, &prodBuf[count], prefixSamps * sizeof(dsp::complex_t));
 
             return count;
         }
@@ -119,19 +170,27 @@ namespace dab {
         int symbolSamps;
         int prefixSamps;
 
-        int histId = 0;
-        dsp::complex_t* histBuf;
-
         dsp::complex_t* delayBuf;
         dsp::complex_t* delayBufInput;
+        dsp::complex_t* prodBuf;
+        dsp::complex_t* corrBuf;
+        float* corrAmps;
 
-        dsp::complex_t corr = { 0.0f, 0.0f };
+        // Symbol timing, the symbol starts a few samples before the end of the prefix to leave some margin on both sides
+        int symPos = 0;
+        int guardSamps;
+        int expectedPeak;
+        bool locked = false;
+        float timingError = 0.0f;
 
-        int samplesSincePeak = 0;
-        float lastCorr = 0.0f;
         float peakCorr = 0.0f;
-        float peakLCorr = 0.0f;
-        float peakRCorr = 0.0f;
+        int peakPos = 0;
+        dsp::complex_t peakVal = { 0.0f, 0.0f };
+
+        // Fine frequency correction, the CP correlation can only measure offsets of less than half a carrier
+        float offset = 0.0f;
+        lv_32fc_t phase = lv_cmake(1.0f, 0.0f);
+        float freqLoopGain;
 
         // Note only required for DAB
         float avgCorr = 0.0f;
@@ -139,6 +198,12 @@ namespace dab {
         float agcRateInv;
     };
 
+    /**
+     * Gathers the symbols of a transmission frame, starting after the null symbol, then processes the whole frame at once:
+     * a single batched FFT of all symbols, the coarse frequency offset search on the phase reference symbol and the
+     * differential demodulation of the carriers. The output is one block of (FRAME_SYMBOLS - 1) * CARRIER_COUNT soft
+     * symbols per frame, ordered by symbol then by carrier from the lowest to the highest frequency.
+    */
     class FrameFreqSync : public dsp::Processor<dsp::complex_t, dsp::complex_t> {
         using base_type = dsp::Processor<dsp::complex_t, dsp::complex_t>;
     public:
@@ -146,18 +211,48 @@ namespace dab {
 
         FrameFreqSync(dsp::stream<dsp::complex_t>* in, float agcRate = 0.01f) { init(in, agcRate); }
 
+        ~FrameFreqSync() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            fftwf_destroy_plan(framePlan);
+            fftwf_destroy_plan(corrPlan);
+            fftwf_destroy_plan(corrInvPlan);
+            fftwf_free(frameIn);
+            fftwf_free(frameOut);
+            fftwf_free(corrIn);
+            fftwf_free(corrOut);
+            dsp::buffer::free(amps);
+            dsp::buffer::free(refCorr);
+            dsp::buffer::free(carriers);
+        }
+
         void init(dsp::stream<dsp::complex_t>* in, float agcRate = 0.01f) {
             // Allocate buffers
-            amps = dsp::buffer::alloc<float>(2048);
-            conjRef = dsp::buffer::alloc<dsp::complex_t>(2048);
-            corrIn = (dsp::complex_t*)fftwf_alloc_complex(2048);
-            corrOut = (dsp::complex_t*)fftwf_alloc_complex(2048);
-
-            // Copy the phase reference
-            memcpy(conjRef, DAB_PHASE_SYM_CONJ, 2048 * sizeof(dsp::complex_t));
-
-            // Plan the FFT computation
-            plan = fftwf_plan_dft_1d(2048, (fftwf_complex*)corrIn, (fftwf_complex*)corrOut, FFTW_FORWARD, FFTW_ESTIMATE);
+            amps = dsp::buffer::alloc<float>(FFT_SIZE);
+            refCorr = dsp::buffer::alloc<dsp::complex_t>(FFT_SIZE);
+            carriers = dsp::buffer::alloc<dsp::complex_t>(FRAME_SYMBOLS * CARRIER_COUNT);
+            frameIn = (dsp::complex_t*)fftwf_alloc_complex(FRAME_SYMBOLS * FFT_SIZE);
+            frameOut = (dsp::complex_t*)fftwf_alloc_complex(FRAME_SYMBOLS * FFT_SIZE);
+            corrIn = (dsp::complex_t*)fftwf_alloc_complex(FFT_SIZE);
+            corrOut = (dsp::complex_t*)fftwf_alloc_complex(FFT_SIZE);
+
+            // Plan the FFT computations, measuring overwrites the buffers so this has to be done before filling them
+            int size = FFT_SIZE;
+            framePlan = fftwf_plan_many_dft(1, &size, FRAME_SYMBOLS, (fftwf_complex*)frameIn, NULL, 1, FFT_SIZE, (fftwf_complex*)frameOut, NULL, 1, FFT_SIZE, FFTW_FORWARD, FFTW_MEASURE);
+            corrPlan = fftwf_plan_dft_1d(FFT_SIZE, (fftwf_complex*)corrIn, (fftwf_complex*)corrOut, FFTW_FORWARD, FFTW_MEASURE);
+            corrInvPlan = fftwf_plan_dft_1d(FFT_SIZE, (fftwf_complex*)corrOut, (fftwf_complex*)corrIn, FFTW_BACKWARD, FFTW_MEASURE);
+
+            // Compute the spectrum of the phase reference symbol. The table has its positive carriers one bin too low,
+            // they are moved up so that the center carrier is unused like in the transmitted signal
+            volk_32fc_conjugate_32fc((lv_32fc_t*)corrIn, (lv_32fc_t*)DAB_PHASE_SYM_CONJ, FFT_SIZE);
+            fftwf_execute(corrPlan);
+            memmove(&corrOut[1], corrOut, (CARRIER_COUNT / 2) * sizeof(dsp::complex_t));
+            corrOut[0] = { 0.0f, 0.0f };
+
+            // Precompute the conjugated FFT of its differential spectrum for the coarse frequency search
+            differentiate(corrIn, corrOut);
+            fftwf_execute(corrPlan);
+            volk_32fc_conjugate_32fc((lv_32fc_t*)refCorr, (lv_32fc_t*)corrOut, FFT_SIZE);
 
             // Compute the correlation AGC configuration
             this->agcRate = agcRate;
@@ -170,111 +265,133 @@ namespace dab {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            
+            sym = -1;
+            coarseOffset = 0;
             base_type::tempStart();
         }
 
+        // Get the frequency offset in carriers found on the last phase reference symbol
+        int getCoarseOffset() { return coarseOffset; }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
-            // Apply frequency shift
-            lv_32fc_t phase = lv_cmake(1.0f, 0.0f);
-            lv_32fc_t phaseDelta = lv_cmake(cos(offset), sin(offset));
-#if VOLK_VERSION >= 030100
-            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)_in->readBuf, (lv_32fc_t*)_in->readBuf, phaseDelta, &phase, count);
-#else
-            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)_in->readBuf, (lv_32fc_t*)_in->readBuf, phaseDelta, &phase, count);
-#endif
-
             // Compute the amplitude amplitude of all samples
-            volk_32fc_magnitude_32f(amps, (lv_32fc_t*)_in->readBuf, 2048);
+            volk_32fc_magnitude_32f(amps, (lv_32fc_t*)_in->readBuf, FFT_SIZE);
 
             // Compute the average signal level by adding up all values
             float level = 0.0f;
-            volk_32f_accumulator_s32f(&level, amps, 2048);
+            volk_32f_accumulator_s32f(&level, amps, FFT_SIZE);
 
             // Detect a frame sync condition
-            if (level < avgLvl * 0.5f) {
-                // Reset symbol counter
-                sym = 1;
-
-                // Update the average level
-                avgLvl = agcRate*level + agcRateInv*avgLvl;
-
-                // Flush the input stream and return
-                base_type::_in->flush();
-                return count;
-            }
+            bool nullSym = (level < avgLvl * 0.5f);
 
             // Update the average level
             avgLvl = agcRate*level + agcRateInv*avgLvl;
 
-            // Handle phase reference
-            if (sym == 1) {
-                // Output the symbols (DEBUG ONLY)
-                memcpy(corrIn, _in->readBuf, 2048 * sizeof(dsp::complex_t));
-                fftwf_execute(plan);
-                volk_32fc_magnitude_32f(amps, (lv_32fc_t*)corrOut, 2048);
-                int outCount = 0;
-                dsp::complex_t pi4 = { cos(3.1415926535*0.25), sin(3.1415926535*0.25) };
-                for (int i = -767; i < 768; i++) {
-                    if (!i) { continue; }
-                    int cid0 = ((i-1) >= 0) ? (i-1) : 2048+(i-1);
-                    int cid1 = (i >= 0) ? i : 2048+i;;
-                    out.writeBuf[outCount++] = pi4 * (corrOut[cid1] * corrOut[cid0].conj()) * (1.0f/(amps[cid0]*amps[cid0]));
+            if (nullSym) {
+                // Start a new frame, a partially received frame is lost
+                sym = 0;
+            }
+            else if (sym >= 0) {
+                // Save the symbol and process the frame once complete
+                memcpy(&frameIn[sym * FFT_SIZE], _in->readBuf, FFT_SIZE * sizeof(dsp::complex_t));
+                if (++sym == FRAME_SYMBOLS) {
+                    sym = -1;
+                    if (!processFrame()) { return -1; }
                 }
-                out.swap(outCount);
-
-                // Multiply the samples with the conjugated phase reference signal
-                volk_32fc_x2_multiply_32fc((lv_32fc_t*)corrIn, (lv_32fc_t*)_in->readBuf, (lv_32fc_t*)conjRef, 2048);
-            
-                // Compute the FFT of the product
-                fftwf_execute(plan);
-
-                // Compute the amplitude of the bins
-                volk_32fc_magnitude_32f(amps, (lv_32fc_t*)corrOut, 2048);
+            }
 
-                // Locate highest power bin
-                uint32_t peakId;
-                volk_32f_index_max_32u(&peakId, amps, 2048);
+            // Flush the input stream and return
+            base_type::_in->flush();
+            return count;
+        }
 
-                // Obtain the value of the bins next to the peak
-                float peakL = amps[(peakId + 2047) % 2048];
-                float peakR = amps[(peakId + 1) % 2048];
+    protected:
+        // Compute the product of each bin with the conjugate of the previous one, this removes the effect of a timing offset
+        void differentiate(dsp::complex_t* out, const dsp::complex_t* in) {
+            volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)&out[1], (lv_32fc_t*)&in[1], (lv_32fc_t*)in, FFT_SIZE - 1);
+            dsp::complex_t first = in[0];
+            dsp::complex_t last = in[FFT_SIZE - 1];
+            out[0] = first * last.conj();
+        }
 
-                // Compute the integer frequency offset
-                float offInt = (peakId < 1024) ? (float)peakId : ((float)peakId - 2048.0f);
+        // Copy bins starting at any (possibly negative) index, wrapping around the end of the spectrum
+        void copyBins(dsp::complex_t* out, const dsp::complex_t* bins, int start, int count) {
+            start = ((start % FFT_SIZE) + FFT_SIZE) % FFT_SIZE;
+            int first = std::min<int>(count, FFT_SIZE - start);
+            memcpy(out, &bins[start], first * sizeof(dsp::complex_t));
+            memcpy(&out[first], bins, (count - first) * sizeof(dsp::complex_t));
+        }
 
-                // Compute the frequency offset in rad/samp
-                float off = 3.1415926535f * (offInt + ((peakR - peakL) / (peakR + peakL))) * (1.0f / 1024.0f);
+        bool processFrame() {
+            // Compute the FFT of all symbols at once
+            fftwf_execute(framePlan);
+
+            // Search for the frequency offset by cross-correlating the differential spectrum of the phase reference
+            // symbol with the expected one for all possible shifts at once
+            differentiate(corrIn, frameOut);
+            fftwf_execute(corrPlan);
+            volk_32fc_x2_multiply_32fc((lv_32fc_t*)corrOut, (lv_32fc_t*)corrOut, (lv_32fc_t*)refCorr, FFT_SIZE);
+            fftwf_execute(corrInvPlan);
+            volk_32fc_magnitude_32f(amps, (lv_32fc_t*)corrIn, FFT_SIZE);
+            uint32_t peakId;
+            volk_32f_index_max_32u(&peakId, amps, FFT_SIZE);
+            int offset = (peakId < FFT_SIZE / 2) ? (int)peakId : ((int)peakId - FFT_SIZE);
+            if (offset != coarseOffset) {
+                flog::debug("Coarse frequency offset: {} carriers", offset);
+                coarseOffset = offset;
+            }
 
-                // Run control loop
-                offset -= 0.1f*off;
-                flog::debug("Offset: {} Hz, Error: {} Hz, Avg Level: {}", offset * (0.5f/3.1415926535f)*2.048e6, off * (0.5f/3.1415926535f)*2.048e6, avgLvl);
+            // Extract the active carriers, skipping the center one
+            for (int i = 0; i < FRAME_SYMBOLS; i++) {
+                dsp::complex_t* bins = &frameOut[i * FFT_SIZE];
+                dsp::complex_t* symCarriers = &carriers[i * CARRIER_COUNT];
+                copyBins(symCarriers, bins, offset - (CARRIER_COUNT / 2), CARRIER_COUNT / 2);
+                copyBins(&symCarriers[CARRIER_COUNT / 2], bins, offset + 1, CARRIER_COUNT / 2);
             }
 
-            // Increment the symbol counter
-            sym++;
+            // Normalize to the average power of the phase reference carriers
+            volk_32fc_magnitude_squared_32f(amps, (lv_32fc_t*)carriers, CARRIER_COUNT);
+            float power = 0.0f;
+            volk_32f_accumulator_s32f(&power, amps, CARRIER_COUNT);
+            float scale = (power > 0.0f) ? ((float)CARRIER_COUNT / power) : 0.0f;
 
-            // Flush the input stream and return
-            base_type::_in->flush();
-            return count;
+            // An offset of whole carriers also rotates each symbol compared to the previous one since the guard interval
+            // isn't a multiple of the carrier period, this is compensated along with the normalization
+            float rot = -2.0f * FL_M_PI * (float)(offset * GUARD_SIZE) / (float)FFT_SIZE;
+            lv_32fc_t corr = lv_cmake(scale * cosf(rot), scale * sinf(rot));
+
+            // Demodulate the carriers of all data symbols against the same carriers of the previous symbol
+            int outCount = (FRAME_SYMBOLS - 1) * CARRIER_COUNT;
+            volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)out.writeBuf, (lv_32fc_t*)&carriers[CARRIER_COUNT], (lv_32fc_t*)carriers, outCount);
+#if VOLK_VERSION >= 030100
+            volk_32fc_s32fc_multiply2_32fc((lv_32fc_t*)out.writeBuf, (lv_32fc_t*)out.writeBuf, &corr, outCount);
+#else
+            volk_32fc_s32fc_multiply_32fc((lv_32fc_t*)out.writeBuf, (lv_32fc_t*)out.writeBuf, corr, outCount);
+#endif
+            return out.swap(outCount);
         }
 
-    protected:
-        fftwf_plan plan;
+        fftwf_plan framePlan;
+        fftwf_plan corrPlan;
+        fftwf_plan corrInvPlan;
 
         float* amps;
-        dsp::complex_t* conjRef;
+        dsp::complex_t* refCorr;
+        dsp::complex_t* carriers;
+        dsp::complex_t* frameIn;
+        dsp::complex_t* frameOut;
         dsp::complex_t* corrIn;
         dsp::complex_t* corrOut;
 
-        int sym;
-        float offset = 0.0f;
+        // Index of the next symbol of the frame, -1 when waiting for a null symbol
+        int sym = -1;
+        int coarseOffset = 0;
 
         float avgLvl = 0.0f;
         float agcRate;
         float agcRateInv;
     };
-}
\ No newline at end of file
+}
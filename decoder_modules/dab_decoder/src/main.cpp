@@ -7,12 +7,17 @@
 #include <module.h>
 #include <filesystem>
 #include <dsp/stream.h>
-#include <dsp/buffer/reshaper.h>
-#include <dsp/multirate/rational_resampler.h>
+#include <dsp/routing/doubler.h>
 #include <dsp/sink/handler_sink.h>
 #include <fstream>
 #include <chrono>
+#include <memory>
+#include <set>
 #include "dab_dsp.h"
+#include "dab/frame_decoder.h"
+#include "dab/msc.h"
+#include "dab/adts.h"
+#include <gui/widgets/folder_select.h>
 #include <gui/widgets/constellation_diagram.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
@@ -30,17 +35,31 @@ ConfigManager config;
 #define INPUT_SAMPLE_RATE   2.048e6
 #define VFO_BANDWIDTH       1.6e6
 
-class M17DecoderModule : public ModuleManager::Instance {
+std::string genFileName(std::string prefix, std::string suffix) {
+    time_t now = time(0);
+    tm* ltm = localtime(&now);
+    char buf[1024];
+    sprintf(buf, "%s_%02d-%02d-%02d_%02d-%02d-%02d%s", prefix.c_str(), ltm->tm_hour, ltm->tm_min, ltm->tm_sec, ltm->tm_mday, ltm->tm_mon + 1, ltm->tm_year + 1900, suffix.c_str());
+    return buf;
+}
+
+class DABDecoderModule : public ModuleManager::Instance {
 public:
-    M17DecoderModule(std::string name)  {
+    DABDecoderModule(std::string name) : folderSelect("%ROOT%/recordings") {
         this->name = name;
 
-        file = std::ofstream("sync4.f32", std::ios::out | std::ios::binary);
-
         // Load config
         config.acquire();
-        
-        config.release(true);
+        if (!config.conf.contains(name)) {
+            config.conf[name] = json({});
+        }
+        if (config.conf[name].contains("decodeAll")) {
+            decodeAll = config.conf[name]["decodeAll"];
+        }
+        if (config.conf[name].contains("recPath")) {
+            folderSelect.setPath(config.conf[name]["recPath"]);
+        }
+        config.release();
 
         // Initialize VFO
         vfo = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, VFO_BANDWIDTH, INPUT_SAMPLE_RATE, VFO_BANDWIDTH, VFO_BANDWIDTH, true);
@@ -49,25 +68,33 @@ public:
         // Initialize DSP here
         csync.init(vfo->output, 1e-3, 246e-6, INPUT_SAMPLE_RATE);
         ffsync.init(&csync.out);
-        ns.init(&ffsync.out, handler, this);
+        doubler.init(&ffsync.out);
+        constSink.init(&doubler.outA, constSinkHandler, this);
+        frameDec.init(&doubler.outB);
 
         // Start DSO Here
         csync.start();
         ffsync.start();
-        ns.start();
+        doubler.start();
+        constSink.start();
+        frameDec.start();
 
         gui::menu.registerEntry(name, menuHandler, this, this);
     }
 
-    ~M17DecoderModule() {
+    ~DABDecoderModule() {
         gui::menu.removeEntry(name);
         // Stop DSP Here
         if (enabled) {
             csync.stop();
             ffsync.stop();
-            ns.stop();
+            doubler.stop();
+            constSink.stop();
+            frameDec.stop();
             sigpath::vfoManager.deleteVFO(vfo);
         }
+        stopRecording();
+        removeAllChains();
 
         sigpath::sinkManager.unregisterStream(name);
     }
@@ -85,7 +112,9 @@ public:
         // Start DSP here
         csync.start();
         ffsync.start();
-        ns.start();
+        doubler.start();
+        constSink.start();
+        frameDec.start();
 
         enabled = true;
     }
@@ -94,7 +123,14 @@ public:
         // Stop DSP here
         csync.stop();
         ffsync.stop();
-        ns.stop();
+        doubler.stop();
+        constSink.stop();
+        frameDec.stop();
+
+        // Start over with a new ensemble next time
+        stopRecording();
+        removeAllChains();
+        frameDec.fic.reset();
 
         sigpath::vfoManager.deleteVFO(vfo);
         enabled = false;
@@ -105,38 +141,269 @@ public:
     }
 
 private:
+    // Blocks decoding a single DAB+ sub-channel, each running in its own threads
+    struct Chain {
+        uint32_t serviceId;
+        std::string label;
+
+        dsp::stream<uint8_t> bits;
+        dab::SubchannelDecoder msc;
+        dab::SuperframeSync sync;
+        dsp::sink::Handler<uint8_t> sink;
+
+        std::mutex recMtx;
+        std::ofstream recFile;
+        std::vector<uint8_t> adts;
+        std::atomic<int> validAUs = 0;
+        std::atomic<int> totalAUs = 0;
+    };
+
     static void menuHandler(void* ctx) {
-        M17DecoderModule* _this = (M17DecoderModule*)ctx;
+        DABDecoderModule* _this = (DABDecoderModule*)ctx;
 
         float menuWidth = ImGui::GetContentRegionAvail().x;
 
         if (!_this->enabled) { style::beginDisabled(); }
 
+        ImGui::SetNextItemWidth(menuWidth);
         _this->constDiagram.draw();
 
-        if (!_this->enabled) { style::endDisabled(); }
-    }
+        // Refresh the ensemble and the decoded sub-channels when the FIC announces a change
+        if (_this->enabled && _this->frameDec.fic.getVersion() != _this->ensembleVersion) {
+            _this->ensembleVersion = _this->frameDec.fic.getVersion();
+            _this->ensemble = _this->frameDec.fic.getEnsemble();
+            _this->updateChains();
+        }
+
+        ImGui::Text("Ensemble: %s (0x%04X)", _this->ensemble.label.empty() ? "---" : _this->ensemble.label.c_str(), _this->ensemble.id);
+        ImGui::Text("FIC quality: %d%%", (int)roundf(_this->frameDec.fic.getQuality() * 100.0f));
+
+        if (ImGui::Checkbox(CONCAT("Decode all services##dab_decode_all_", _this->name), &_this->decodeAll)) {
+            _this->updateChains();
+            config.acquire();
+            config.conf[_this->name]["decodeAll"] = _this->decodeAll;
+            config.release(true);
+        }
 
-    std::ofstream file;
+        if (ImGui::BeginTable(CONCAT("##dab_services_", _this->name), 3, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Service", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Type");
+            ImGui::TableSetupColumn("Status");
+            ImGui::TableHeadersRow();
+            for (const auto& [id, service] : _this->ensemble.services) {
+                ImGui::TableNextRow();
+                int subchannel = -1;
+                bool supported = _this->getAudioSubchannel(service, subchannel);
+
+                ImGui::TableSetColumnIndex(0);
+                if (!supported || _this->decodeAll) { style::beginDisabled(); }
+                bool selected = _this->decodeAll || _this->selected.find(id) != _this->selected.end();
+                std::string label = service.label.empty() ? "Unnamed" : service.label;
+                if (ImGui::Checkbox(CONCAT(label, "##dab_srv_" + std::to_string(id) + _this->name), &selected)) {
+                    if (selected) { _this->selected.insert(id); }
+                    else { _this->selected.erase(id); }
+                    _this->updateChains();
+                }
+                if (!supported || _this->decodeAll) { style::endDisabled(); }
+
+                ImGui::TableSetColumnIndex(1);
+                ImGui::TextUnformatted(_this->getServiceType(service));
+
+                ImGui::TableSetColumnIndex(2);
+                auto it = _this->chains.find(subchannel);
+                if (it == _this->chains.end()) {
+                    ImGui::TextUnformatted(supported ? "Idle" : "Unsupported");
+                }
+                else if (!it->second->sync.isSynced()) {
+                    ImGui::TextUnformatted("Syncing");
+                }
+                else {
+                    ImGui::Text("%d kbit/s, %d/%d AUs", it->second->msc.getSubchannel().bitrate, (int)it->second->validAUs, (int)it->second->totalAUs);
+                }
+            }
+            ImGui::EndTable();
+        }
+
+        if (_this->folderSelect.render("##dab_rec_" + _this->name)) {
+            if (_this->folderSelect.pathIsValid()) {
+                config.acquire();
+                config.conf[_this->name]["recPath"] = _this->folderSelect.path;
+                config.release(true);
+            }
+        }
+
+        if (!_this->folderSelect.pathIsValid() && _this->enabled) { style::beginDisabled(); }
+
+        if (_this->recording) {
+            if (ImGui::Button(CONCAT("Stop##dab_rec_", _this->name), ImVec2(menuWidth, 0))) {
+                _this->stopRecording();
+            }
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Recording %d services", (int)_this->chains.size());
+        }
+        else {
+            if (ImGui::Button(CONCAT("Record##dab_rec_", _this->name), ImVec2(menuWidth, 0))) {
+                _this->startRecording();
+            }
+            ImGui::TextUnformatted("Idle");
+        }
 
-    static void handler(dsp::complex_t* data, int count, void* ctx) {
-        M17DecoderModule* _this = (M17DecoderModule*)ctx;
-        //_this->file.write((char*)data, count * sizeof(dsp::complex_t));
+        if (!_this->folderSelect.pathIsValid() && _this->enabled) { style::endDisabled(); }
 
+        if (!_this->enabled) { style::endDisabled(); }
+    }
+
+    static void constSinkHandler(dsp::complex_t* data, int count, void* ctx) {
+        DABDecoderModule* _this = (DABDecoderModule*)ctx;
         dsp::complex_t* buf = _this->constDiagram.acquireBuffer();
         memcpy(buf, data, 1024 * sizeof(dsp::complex_t));
         _this->constDiagram.releaseBuffer();
     }
 
+    static void superframeHandler(uint8_t* data, int count, void* ctx) {
+        Chain* chain = (Chain*)ctx;
+        int superframeSize = chain->sync.getSuperframeSize();
+        for (int i = 0; i + superframeSize <= count; i += superframeSize) {
+            std::lock_guard<std::mutex> lck(chain->recMtx);
+            chain->adts.clear();
+            chain->validAUs += dab::superframeToADTS(&data[i], superframeSize, chain->adts);
+            chain->totalAUs += dab::getAccessUnitCount(&data[i]);
+            if (chain->recFile.is_open()) {
+                chain->recFile.write((char*)chain->adts.data(), chain->adts.size());
+            }
+        }
+    }
+
+    // Find the sub-channel carrying the primary DAB+ audio component of a service if it can be decoded
+    bool getAudioSubchannel(const dab::Service& service, int& subchannel) {
+        for (const auto& comp : service.components) {
+            if (!comp.primary || comp.type != dab::COMPONENT_TYPE_DABPLUS_AUDIO) { continue; }
+            auto it = ensemble.subchannels.find(comp.subchannel);
+            if (it == ensemble.subchannels.end()) { return false; }
+            subchannel = comp.subchannel;
+            return dab::SubchannelDecoder::isSupported(it->second);
+        }
+        return false;
+    }
+
+    const char* getServiceType(const dab::Service& service) {
+        for (const auto& comp : service.components) {
+            if (!comp.primary) { continue; }
+            switch (comp.type) {
+            case dab::COMPONENT_TYPE_DAB_AUDIO:     return "DAB";
+            case dab::COMPONENT_TYPE_DABPLUS_AUDIO: return "DAB+";
+            default:                                return "Data";
+            }
+        }
+        return "---";
+    }
+
+    void updateChains() {
+        // List the sub-channels that should be decoded
+        std::map<int, uint32_t> wanted;
+        for (const auto& [id, service] : ensemble.services) {
+            if (!decodeAll && selected.find(id) == selected.end()) { continue; }
+            int subchannel;
+            if (getAudioSubchannel(service, subchannel)) { wanted[subchannel] = id; }
+        }
+
+        // Remove the chains that are no longer wanted or whose sub-channel was reconfigured
+        for (auto it = chains.begin(); it != chains.end();) {
+            const dab::Subchannel& cur = it->second->msc.getSubchannel();
+            auto sc = ensemble.subchannels.find(it->first);
+            bool changed = (sc == ensemble.subchannels.end() || sc->second.startCU != cur.startCU || sc->second.sizeCU != cur.sizeCU ||
+                            sc->second.protection != cur.protection || sc->second.level != cur.level);
+            if (wanted.find(it->first) != wanted.end() && !changed) {
+                it++;
+                continue;
+            }
+            removeChain(it->second.get());
+            it = chains.erase(it);
+        }
+
+        // Create the missing ones
+        for (const auto& [subchannel, serviceId] : wanted) {
+            if (chains.find(subchannel) != chains.end()) { continue; }
+            const dab::Subchannel& sc = ensemble.subchannels[subchannel];
+            auto chain = std::make_unique<Chain>();
+            chain->serviceId = serviceId;
+            chain->label = ensemble.services[serviceId].label;
+            chain->msc.init(&chain->bits, sc);
+            chain->sync.init(&chain->msc.out, sc.bitrate);
+            chain->sink.init(&chain->sync.out, superframeHandler, chain.get());
+            if (recording) { openRecording(chain.get()); }
+            chain->msc.start();
+            chain->sync.start();
+            chain->sink.start();
+            frameDec.bindSubchannel(&chain->bits, sc.startCU, sc.sizeCU);
+            flog::info("DAB: Decoding service '{}' from sub-channel {} ({} kbit/s)", chain->label, subchannel, sc.bitrate);
+            chains[subchannel] = std::move(chain);
+        }
+    }
+
+    void removeChain(Chain* chain) {
+        frameDec.unbindSubchannel(&chain->bits);
+        chain->msc.stop();
+        chain->sync.stop();
+        chain->sink.stop();
+        std::lock_guard<std::mutex> lck(chain->recMtx);
+        if (chain->recFile.is_open()) { chain->recFile.close(); }
+    }
+
+    void removeAllChains() {
+        for (auto& [subchannel, chain] : chains) { removeChain(chain.get()); }
+        chains.clear();
+        ensemble = dab::Ensemble();
+        ensembleVersion = -1;
+    }
+
+    void openRecording(Chain* chain) {
+        std::string label = chain->label.empty() ? std::to_string(chain->serviceId) : chain->label;
+        std::replace_if(label.begin(), label.end(), [](char c) { return !isalnum((unsigned char)c); }, '_');
+        std::string filename = genFileName(folderSelect.expandString(folderSelect.path) + "/dab_" + label, ".aac");
+        std::lock_guard<std::mutex> lck(chain->recMtx);
+        chain->recFile = std::ofstream(filename, std::ios::binary);
+        if (chain->recFile.is_open()) {
+            flog::info("Recording to '{0}'", filename);
+        }
+        else {
+            flog::error("Could not open file for recording!");
+        }
+    }
+
+    void startRecording() {
+        recording = true;
+        for (auto& [subchannel, chain] : chains) { openRecording(chain.get()); }
+    }
+
+    void stopRecording() {
+        recording = false;
+        for (auto& [subchannel, chain] : chains) {
+            std::lock_guard<std::mutex> lck(chain->recMtx);
+            if (chain->recFile.is_open()) { chain->recFile.close(); }
+        }
+    }
+
     std::string name;
     bool enabled = true;
 
     dab::CyclicSync csync;
     dab::FrameFreqSync ffsync;
-    dsp::sink::Handler<dsp::complex_t> ns;
+    dsp::routing::Doubler<dsp::complex_t> doubler;
+    dsp::sink::Handler<dsp::complex_t> constSink;
+    dab::FrameDecoder frameDec;
 
     ImGui::ConstellationDiagram constDiagram;
 
+    // Ensemble as last seen by the UI and the chains decoding its services, keyed by sub-channel
+    dab::Ensemble ensemble;
+    int ensembleVersion = -1;
+    std::set<uint32_t> selected;
+    bool decodeAll = false;
+    std::map<int, std::unique_ptr<Chain>> chains;
+
+    FolderSelect folderSelect;
+    bool recording = false;
+
     // DSP Chain
     VFOManager::VFO* vfo;
 };
@@ -150,11 +417,11 @@ MOD_EXPORT void _INIT_() {
 }
 
 MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
-    return new M17DecoderModule(name);
+    return new DABDecoderModule(name);
 }
 
 MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
-    delete (M17DecoderModule*)instance;
+    delete (DABDecoderModule*)instance;
 }
 
 MOD_EXPORT void _END_() {
@@ -1,12 +1,8 @@
 #pragma once
 #include <dsp/block.h>
+#include <dsp/fec/reed_solomon.h>
 #include <inttypes.h>
 
-// WTF???
-extern "C" {
-#include <correct.h>
-}
-
 const uint8_t toDB[] = {
     0x00, 0x7b, 0xaf, 0xd4, 0x99, 0xe2, 0x36, 0x4d, 0xfa, 0x81, 0x55, 0x2e, 0x63, 0x18, 0xcc, 0xb7, 0x86, 0xfd, 0x29, 0x52, 0x1f,
     0x64, 0xb0, 0xcb, 0x7c, 0x07, 0xd3, 0xa8, 0xe5, 0x9e, 0x4a, 0x31, 0xec, 0x97, 0x43, 0x38, 0x75, 0x0e, 0xda, 0xa1, 0x16, 0x6d, 0xb9, 0xc2, 0x8f, 0xf4,
@@ -68,10 +64,8 @@ namespace dsp {
         void init(stream<uint8_t>* in) {
             _in = in;
 
-            for (int i = 0; i < 5; i++) { memset(buffers[i], 0, 255); }
-            for (int i = 0; i < 5; i++) { memset(outBuffers[i], 0, 255); }
-            rs = correct_reed_solomon_create(correct_rs_primitive_polynomial_ccsds, 120, 11, 16);
-            if (rs == NULL) { printf("Error creating the reed solomon decoder\n"); }
+            memset(buffer, 0, 255 * 5);
+            rs.init(fec::RS_PRIMITIVE_POLYNOMIAL_CCSDS, 120, 11, 16);
 
             generic_block<FalconRS>::registerInput(_in);
             generic_block<FalconRS>::registerOutput(&out);
@@ -83,42 +77,20 @@ namespace dsp {
 
             uint8_t* data = _in->readBuf + 4;
 
-            // Deinterleave
+            // Convert from the dual basis
             for (int i = 0; i < 255 * 5; i++) {
-                buffers[i % 5][i / 5] = fromDB[data[i]];
+                buffer[i] = fromDB[data[i]];
             }
 
-            // Reed the solomon :weary:
-            int result = 0;
-            result = correct_reed_solomon_decode(rs, buffers[0], 255, outBuffers[0]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[1], 255, outBuffers[1]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[2], 255, outBuffers[2]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[3], 255, outBuffers[3]);
-            if (result == -1) {
-                _in->flush();
-                return count;
-            }
-            result = correct_reed_solomon_decode(rs, buffers[4], 255, outBuffers[4]);
-            if (result == -1) {
+            // Reed the solomon :weary: (the 5 codewords are corrected in place while still interleaved)
+            if (rs.correctInterleaved(buffer, 5, 255) < 0) {
                 _in->flush();
                 return count;
             }
 
-            // Reinterleave
+            // Convert back to the dual basis and derandomize
             for (int i = 0; i < 255 * 5; i++) {
-                out.writeBuf[i] = toDB[outBuffers[i % 5][i / 5]] ^ randVals[i % 255];
+                out.writeBuf[i] = toDB[buffer[i]] ^ randVals[i % 255];
             }
 
             out.swap(255 * 5);
@@ -131,9 +103,8 @@ namespace dsp {
 
     private:
         int count;
-        uint8_t buffers[5][255];
-        uint8_t outBuffers[5][255];
-        correct_reed_solomon* rs;
+        uint8_t buffer[255 * 5];
+        fec::ReedSolomon rs;
 
         stream<uint8_t>* _in;
     };
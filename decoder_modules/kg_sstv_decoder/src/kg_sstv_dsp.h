@@ -5,12 +5,9 @@
 #include <dsp/routing.h>
 #include <dsp/demodulator.h>
 #include <dsp/sink.h>
+#include <dsp/fec/viterbi.h>
 #include <utils/flog.h>
 
-extern "C" {
-#include <correct.h>
-}
-
 #define KGSSTV_DEVIATION        300
 #define KGSSTV_BAUDRATE         1200
 #define KGSSTV_RRC_ALPHA        0.7f
@@ -52,7 +49,7 @@ const uint8_t KGSSTV_SCRAMBLING_BYTES[] = {
     0b00000010
 };
 
-static const correct_convolutional_polynomial_t kgsstv_polynomial[] = {0155, 0117};
+const uint16_t kgsstv_polynomial[2] = {0155, 0117};
 
 #define KGSSTV_SYNC_WORD_SIZE       sizeof(KGSSTV_SYNC_WORD)
 #define KGSSTV_SYNC_SCRAMBLING_SIZE sizeof(KGSSTV_SCRAMBLING)
@@ -119,8 +116,7 @@ namespace kgsstv {
         void init(dsp::stream<float>* in) {
             _in = in;
 
-            // TODO: Destroy
-            conv = correct_convolutional_create(2, 7, kgsstv_polynomial);
+            conv.init(kgsstv_polynomial, 62);
             memset(convTmp, 0x00, 1024);
 
             dsp::generic_block<Deframer>::registerInput(_in);
@@ -191,7 +187,7 @@ namespace kgsstv {
                         }
 
                         // Decode convolutional code
-                        int convOutCount = correct_convolutional_decode_soft(conv, convTmp, 124, out.writeBuf);
+                        int convOutCount = conv.decode(convTmp, 124, out.writeBuf) / 8;
 
                         flog::warn("Frames written: {0}, frameBytes: {1}", ++framesWritten, convOutCount);
                         if (!out.swap(7)) {
@@ -211,7 +207,7 @@ namespace kgsstv {
 
     private:
         dsp::stream<float>* _in;
-        correct_convolutional* conv = NULL;
+        dsp::fec::Viterbi<7> conv;
         uint8_t convTmp[1024];
 
         int match = 0;
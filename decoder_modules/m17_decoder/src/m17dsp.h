@@ -4,15 +4,12 @@
 #include <dsp/sink/null_sink.h>
 #include <dsp/demod/gfsk.h>
 #include <dsp/routing/doubler.h>
+#include <dsp/fec/viterbi.h>
 #include <volk/volk.h>
 #include <codec2.h>
 #include <golay24.h>
 #include <lsf_decode.h>
 
-extern "C" {
-#include <correct.h>
-}
-
 #define M17_DEVIATION     2400.0f
 #define M17_BAUDRATE      4800.0f
 #define M17_RRC_ALPHA     0.5f
@@ -90,7 +87,7 @@ const uint8_t M17_PUNCTURING_P1[61] = { 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1
 
 const uint8_t M17_PUNCTURING_P2[12] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0 };
 
-static const correct_convolutional_polynomial_t correct_conv_m17_polynomial[] = { 0b11001, 0b10111 };
+const uint16_t M17_CONV_POLYNOMIAL[2] = { 0b11001, 0b10111 };
 
 namespace dsp {
     class M17Slice4FSK : public block {
@@ -284,7 +281,6 @@ namespace dsp {
         ~M17LSFDecoder() {
             if (!block::_block_init) { return; }
             block::stop();
-            correct_convolutional_destroy(conv);
         }
 
         void init(stream<uint8_t>* in, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
@@ -292,7 +288,7 @@ namespace dsp {
             _handler = handler;
             _ctx = ctx;
 
-            conv = correct_convolutional_create(2, 5, correct_conv_m17_polynomial);
+            conv.init(M17_CONV_POLYNOMIAL, M17_ENCODED_LSF_SIZE / 2);
 
             block::registerInput(_in);
             block::_block_init = true;
@@ -312,26 +308,14 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            // Depuncture the data
-            int inOffset = 0;
-            for (int i = 0; i < M17_ENCODED_LSF_SIZE; i++) {
-                if (!M17_PUNCTURING_P1[i % 61]) {
-                    depunctured[i] = 0;
-                    continue;
-                }
-                depunctured[i] = _in->readBuf[inOffset++];
-            }
+            // Depuncture the data, punctured bits are erasures
+            fec::hardToSoft(_in->readBuf, soft, std::min<int>(count, M17_CUT_FRAME_SIZE));
+            fec::depuncture(soft, depunctured, M17_ENCODED_LSF_SIZE, M17_PUNCTURING_P1, 61);
 
             _in->flush();
 
-            // Pack into bytes
-            memset(packed, 0, 61);
-            for (int i = 0; i < M17_ENCODED_LSF_SIZE; i++) {
-                packed[i / 8] |= depunctured[i] << (7 - (i % 8));
-            }
-
             // Run through convolutional decoder
-            correct_convolutional_decode(conv, packed, M17_ENCODED_LSF_SIZE, lsf);
+            conv.decode(depunctured, M17_ENCODED_LSF_SIZE, lsf);
 
             // Decode it and call the handler
             M17LSF decLsf = M17DecodeLSF(lsf);
@@ -346,11 +330,11 @@ namespace dsp {
         void (*_handler)(M17LSF& lsf, void* ctx);
         void* _ctx;
 
+        uint8_t soft[M17_CUT_FRAME_SIZE];
         uint8_t depunctured[488];
-        uint8_t packed[61];
         uint8_t lsf[30];
 
-        correct_convolutional* conv;
+        fec::Viterbi<5> conv;
     };
 
     class M17PayloadFEC : public block {
@@ -362,13 +346,12 @@ namespace dsp {
         ~M17PayloadFEC() {
             if (!block::_block_init) { return; }
             block::stop();
-            correct_convolutional_destroy(conv);
         }
 
         void init(stream<uint8_t>* in) {
             _in = in;
 
-            conv = correct_convolutional_create(2, 5, correct_conv_m17_polynomial);
+            conv.init(M17_CONV_POLYNOMIAL, M17_ENCODED_PAYLOAD_SIZE / 2);
 
             block::registerInput(_in);
             block::registerOutput(&out);
@@ -389,25 +372,12 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            // Depuncture the data
-            int inOffset = 0;
-            for (int i = 0; i < M17_ENCODED_PAYLOAD_SIZE; i++) {
-                if (!M17_PUNCTURING_P2[i % 12]) {
-                    depunctured[i] = 0;
-                    continue;
-                }
-                depunctured[i] = _in->readBuf[inOffset++];
-            }
-
-            // Pack into bytes
-            memset(packed, 0, 37);
-            for (int i = 0; i < M17_ENCODED_PAYLOAD_SIZE; i++) {
-                if (!(i % 8)) { packed[i / 8] = 0; }
-                packed[i / 8] |= depunctured[i] << (7 - (i % 8));
-            }
+            // Depuncture the data, punctured bits are erasures
+            fec::hardToSoft(_in->readBuf, soft, std::min<int>(count, M17_CUT_FRAME_SIZE));
+            fec::depuncture(soft, depunctured, M17_ENCODED_PAYLOAD_SIZE, M17_PUNCTURING_P2, 12);
 
             // Run through convolutional decoder
-            correct_convolutional_decode(conv, packed, M17_ENCODED_PAYLOAD_SIZE, out.writeBuf);
+            conv.decode(depunctured, M17_ENCODED_PAYLOAD_SIZE, out.writeBuf);
 
             _in->flush();
 
@@ -420,10 +390,10 @@ namespace dsp {
     private:
         stream<uint8_t>* _in;
 
+        uint8_t soft[M17_CUT_FRAME_SIZE];
         uint8_t depunctured[296];
-        uint8_t packed[37];
 
-        correct_convolutional* conv;
+        fec::Viterbi<5> conv;
     };
 
     class M17Codec2Decode : public block {
@@ -258,7 +258,25 @@ private:
     static void lsfHandler(M17LSF& lsf, void* ctx) {
         M17DecoderModule* _this = (M17DecoderModule*)ctx;
         std::lock_guard lck(_this->lsfMtx);
-        _this->lastUpdated = std::chrono::high_resolution_clock::now();
+
+        // The LSF is repeated all along a transmission, only publish it when a new one starts
+        auto now = std::chrono::high_resolution_clock::now();
+        bool stale = std::chrono::duration_cast<std::chrono::milliseconds>(now - _this->lastUpdated).count() > 1000;
+        bool changed = (lsf.rawSrc != _this->lsf.rawSrc) || (lsf.rawDst != _this->lsf.rawDst) || (lsf.rawType != _this->lsf.rawType);
+        if ((stale || changed) && sigpath::messageBus.hasSubscribers()) {
+            DecodedMessage msg("M17", "lsf", gui::waterfall.getCenterFrequency() + _this->vfo->getOffset());
+            msg.addText("src", lsf.src);
+            msg.addText("dst", lsf.dst);
+            msg.addText("mode", lsf.isStream ? "Stream" : "Packet");
+            msg.addText("dataType", M17DataTypesTxt[lsf.dataType]);
+            msg.addText("encryption", M17EncryptionTypesTxt[lsf.encryptionType]);
+            msg.addInt("encryptionSubType", lsf.encryptionSubType);
+            msg.addInt("can", lsf.channelAccessNum);
+            msg.addBytes("meta", lsf.meta, sizeof(lsf.meta));
+            sigpath::messageBus.publish(msg);
+        }
+
+        _this->lastUpdated = now;
         _this->lsf = lsf;
     }
 
@@ -1,5 +1,29 @@
 #pragma once
 #include <signal_path/vfo_manager.h>
+#include <signal_path/signal_path.h>
+#include <string>
+#include <chrono>
+#include <stdint.h>
+
+// Decoded message along with where and when it was received
+struct PagerMessage {
+    std::chrono::system_clock::time_point time;
+    double frequency;
+    const char* protocol;
+    uint32_t address;
+    std::string type;
+    std::string text;
+};
+
+// Send a decoded message to the outputs listening on the message bus
+inline void publishPagerMessage(const char* protocol, double frequency, uint32_t address, const char* type, const std::string& text) {
+    if (!sigpath::messageBus.hasSubscribers()) { return; }
+    DecodedMessage msg(protocol, "page", frequency);
+    msg.addInt("address", address);
+    msg.addText("format", type);
+    msg.addText("text", text);
+    sigpath::messageBus.publish(msg);
+}
 
 class Decoder {
 public:
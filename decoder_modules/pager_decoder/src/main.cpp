@@ -9,6 +9,7 @@
 #include <utils/optionlist.h>
 #include "decoder.h"
 #include "pocsag/decoder.h"
+#include "pocsag/multi_decoder.h"
 #include "flex/decoder.h"
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
@@ -26,6 +27,7 @@ ConfigManager config;
 enum Protocol {
     PROTOCOL_INVALID = -1,
     PROTOCOL_POCSAG,
+    PROTOCOL_POCSAG_MULTI,
     PROTOCOL_FLEX
 };
 
@@ -36,14 +38,26 @@ public:
 
         // Define protocols
         protocols.define("POCSAG", PROTOCOL_POCSAG);
+        protocols.define("POCSAG (Multi-channel)", PROTOCOL_POCSAG_MULTI);
         //protocols.define("FLEX", PROTOCOL_FLEX);
 
         // Initialize VFO with default values
         vfo = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, 12500, 24000, 12500, 12500, true);
         vfo->setSnapInterval(1);
 
+        // Load config
+        Protocol savedProto = PROTOCOL_POCSAG;
+        config.acquire();
+        if (config.conf[name].contains("protocol")) {
+            std::string protoStr = config.conf[name]["protocol"];
+            if (protocols.keyExists(protoStr)) {
+                savedProto = protocols.value(protocols.keyId(protoStr));
+            }
+        }
+        config.release();
+
         // Select the protocol
-        selectProtocol(PROTOCOL_POCSAG);
+        selectProtocol(savedProto);
 
         gui::menu.registerEntry(name, menuHandler, this, this);
     }
@@ -98,6 +112,9 @@ public:
         case PROTOCOL_POCSAG:
             decoder = std::make_unique<POCSAGDecoder>(name, vfo);
             break;
+        case PROTOCOL_POCSAG_MULTI:
+            decoder = std::make_unique<MultiPOCSAGDecoder>(name, vfo, &config);
+            break;
         case PROTOCOL_FLEX:
             decoder = std::make_unique<FLEXDecoder>(name, vfo);
             break;
@@ -111,6 +128,10 @@ public:
 
         // Save selected protocol
         proto = newProto;
+        protoId = protocols.valueId(newProto);
+        config.acquire();
+        config.conf[name]["protocol"] = protocols.key(protoId);
+        config.release(true);
     }
 
 private:
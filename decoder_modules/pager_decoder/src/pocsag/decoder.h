@@ -2,6 +2,7 @@
 #include "../decoder.h"
 #include <signal_path/vfo_manager.h>
 #include <utils/optionlist.h>
+#include <gui/gui.h>
 #include <gui/widgets/symbol_diagram.h>
 #include <gui/style.h>
 #include <dsp/sink/handler_sink.h>
@@ -25,6 +26,7 @@ public:
         // Init DSP
         vfo->setBandwidthLimits(12500, 12500, true);
         vfo->setSampleRate(SAMPLERATE, 12500);
+        vfo->setSnapInterval(1);
         dsp.init(vfo->output, SAMPLERATE, BAUDRATE);
         reshape.init(&dsp.soft, BAUDRATE, (BAUDRATE / 30.0) - BAUDRATE);
         dataHandler.init(&dsp.out, _dataHandler, this);
@@ -85,6 +87,8 @@ private:
 
     void messageHandler(pocsag::Address addr, pocsag::MessageType type, const std::string& msg) {
         flog::debug("[{}]: '{}'", (uint32_t)addr, msg);
+        double freq = gui::waterfall.getCenterFrequency() + vfo->getOffset();
+        publishPagerMessage("POCSAG", freq, addr, (type == pocsag::MESSAGE_TYPE_NUMERIC) ? "Numeric" : "Alphanumeric", msg);
     }
 
     std::string name;
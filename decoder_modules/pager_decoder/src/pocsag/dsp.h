@@ -73,4 +73,82 @@ private:
     dsp::clock_recovery::MM<float> recov;
 
     double _samplerate;
-};
\ No newline at end of file
+};
+
+/**
+ * Lightweight FSK demodulator for one channel of a channelizer.
+ * Same processing as the discriminator and boxcar matched filter of POCSAGDSP but without streams or block thread,
+ * working in place on buffers provided by the caller so that many channels can be processed by a single thread with
+ * a few hundred bytes of state each. The clock recovery of all channels is done at once by the caller.
+*/
+class POCSAGChannelDemod {
+public:
+    POCSAGChannelDemod() {}
+
+    POCSAGChannelDemod(double samplerate, double baudrate, double offset = 0.0) { init(samplerate, baudrate, offset); }
+
+    void init(double samplerate, double baudrate, double offset = 0.0) {
+        _samplerate = samplerate;
+        invDeviation = 1.0f / dsp::math::hzToRads(-4500.0, samplerate);
+        setOffset(offset);
+        setBaudrate(baudrate);
+    }
+
+    // Correct a channel that isn't exactly at the center of its channelizer bin
+    void setOffset(double offset) {
+        float delta = -dsp::math::hzToRads(offset, _samplerate);
+        rotate = (offset != 0.0);
+        phaseDelta = lv_cmake(cosf(delta), sinf(delta));
+        rotPhase = lv_cmake(1.0f, 0.0f);
+    }
+
+    void setBaudrate(double baudrate) {
+        boxLen = std::clamp<int>(roundf(_samplerate / baudrate), 1, MAX_BOX_LEN);
+        boxSum = 0.0f;
+        boxId = 0;
+        memset(box, 0, sizeof(box));
+    }
+
+    /**
+     * Demodulate a block of samples.
+     * @param count Number of input samples.
+     * @param in Input samples, overwritten.
+     * @param out Soft output samples, count of them.
+    */
+    void process(int count, dsp::complex_t* in, float* out) {
+        if (rotate) {
+#if VOLK_VERSION >= 030100
+            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)in, (lv_32fc_t*)in, &phaseDelta, &rotPhase, count);
+#else
+            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)in, (lv_32fc_t*)in, phaseDelta, &rotPhase, count);
+#endif
+        }
+
+        // Discriminator followed by a running average over a symbol
+        for (int i = 0; i < count; i++) {
+            float cphase = in[i].phase();
+            float val = dsp::math::normalizePhase(cphase - phase) * invDeviation;
+            phase = cphase;
+            boxSum += val - box[boxId];
+            box[boxId] = val;
+            if (++boxId >= boxLen) { boxId = 0; }
+            out[i] = boxSum / (float)boxLen;
+        }
+    }
+
+private:
+    static constexpr int MAX_BOX_LEN = 64;
+
+    double _samplerate;
+    float invDeviation;
+
+    bool rotate = false;
+    lv_32fc_t phaseDelta;
+    lv_32fc_t rotPhase;
+
+    float phase = 0.0f;
+    float box[MAX_BOX_LEN];
+    float boxSum = 0.0f;
+    int boxLen = 1;
+    int boxId = 0;
+};
@@ -0,0 +1,247 @@
+#pragma once
+#include "../decoder.h"
+#include <signal_path/vfo_manager.h>
+#include <utils/optionlist.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <config.h>
+#include <deque>
+#include <mutex>
+#include "multi_dsp.h"
+
+#define MULTI_MAX_MESSAGES  100
+
+class MultiPOCSAGDecoder : public Decoder {
+public:
+    MultiPOCSAGDecoder(const std::string& name, VFOManager::VFO* vfo, ConfigManager* config) {
+        this->name = name;
+        this->vfo = vfo;
+        this->config = config;
+
+        // Define baudrate options
+        baudrates.define(512, "512 Baud", 512);
+        baudrates.define(1200, "1200 Baud", 1200);
+        baudrates.define(2400, "2400 Baud", 2400);
+
+        // Define the spans, all multiples of the channel spacing
+        spans.define(32, "400KHz", 32);
+        spans.define(64, "800KHz", 64);
+        spans.define(128, "1.6MHz", 128);
+        spans.define(256, "3.2MHz", 256);
+
+        // Load config
+        config->acquire();
+        json& conf = config->conf[name];
+        if (conf.contains("multiBaudrate") && baudrates.keyExists(conf["multiBaudrate"])) {
+            brId = baudrates.keyId(conf["multiBaudrate"]);
+        }
+        if (conf.contains("multiSpan") && spans.keyExists(conf["multiSpan"])) {
+            spanId = spans.keyId(conf["multiSpan"]);
+        }
+        if (conf.contains("multiChannels")) {
+            for (double freq : conf["multiChannels"]) { frequencies.push_back(freq); }
+        }
+        config->release();
+
+        // Init DSP
+        dsp.init(vfo->output, spans.value(spanId), baudrates.value(brId));
+        dsp.onMessage.bind(&MultiPOCSAGDecoder::messageHandler, this);
+        configureVFO();
+
+        // Follow the tuning and the VFO to keep the channels on their frequency
+        retuneHandler.ctx = this;
+        retuneHandler.handler = retuneHandlerFunc;
+        offsetChangedHandler.ctx = this;
+        offsetChangedHandler.handler = offsetChangedHandlerFunc;
+    }
+
+    ~MultiPOCSAGDecoder() {
+        stop();
+    }
+
+    void showMenu() {
+        ImGui::LeftLabel("Span");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##pager_decoder_multi_span_" + name).c_str(), &spanId, spans.txt)) {
+            dsp.setChannelCount(spans.value(spanId));
+            configureVFO();
+            saveConfig();
+        }
+
+        ImGui::LeftLabel("Baudrate");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##pager_decoder_multi_br_" + name).c_str(), &brId, baudrates.txt)) {
+            dsp.setBaudrate(baudrates.value(brId));
+            saveConfig();
+        }
+
+        // Channel list
+        ImGui::LeftLabel("Frequency (MHz)");
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize("Add").x - (2.0f * ImGui::GetStyle().FramePadding.x) - ImGui::GetStyle().ItemSpacing.x);
+        ImGui::InputDouble(("##pager_decoder_multi_freq_" + name).c_str(), &newFreq, 0.0, 0.0, "%.5f");
+        ImGui::SameLine();
+        if (ImGui::Button(("Add##pager_decoder_multi_add_" + name).c_str())) {
+            double freq = round(newFreq * 1e6);
+            if (std::find(frequencies.begin(), frequencies.end(), freq) == frequencies.end()) {
+                frequencies.push_back(freq);
+                std::sort(frequencies.begin(), frequencies.end());
+                updateChannels();
+                saveConfig();
+            }
+        }
+
+        std::vector<int> counts = dsp.getMessageCounts();
+        int removeId = -1;
+        int inBandId = 0;
+        if (ImGui::BeginTable(("##pager_decoder_multi_chans_" + name).c_str(), 3, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Frequency", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupColumn("Messages");
+            ImGui::TableSetupColumn("##remove");
+            ImGui::TableHeadersRow();
+            for (int i = 0; i < frequencies.size(); i++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%.5f MHz", frequencies[i] / 1e6);
+                ImGui::TableSetColumnIndex(1);
+                if (dsp.isInBand(frequencies[i] - center)) {
+                    ImGui::Text("%d", (inBandId < counts.size()) ? counts[inBandId] : 0);
+                    inBandId++;
+                }
+                else {
+                    ImGui::TextUnformatted("Out of band");
+                }
+                ImGui::TableSetColumnIndex(2);
+                if (ImGui::Button(("X##pager_decoder_multi_rem_" + name + std::to_string(i)).c_str())) {
+                    removeId = i;
+                }
+            }
+            ImGui::EndTable();
+        }
+        if (removeId >= 0) {
+            frequencies.erase(frequencies.begin() + removeId);
+            updateChannels();
+            saveConfig();
+        }
+
+        // Recent messages
+        std::lock_guard<std::mutex> lck(msgMtx);
+        if (ImGui::BeginTable(("##pager_decoder_multi_msgs_" + name).c_str(), 4, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
+            ImGui::TableSetupColumn("Time");
+            ImGui::TableSetupColumn("Frequency");
+            ImGui::TableSetupColumn("Address");
+            ImGui::TableSetupColumn("Message", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableHeadersRow();
+            for (auto it = messages.rbegin(); it != messages.rend(); it++) {
+                time_t t = std::chrono::system_clock::to_time_t(it->time);
+                tm* ltm = localtime(&t);
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%02d:%02d:%02d", ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.5f", it->frequency / 1e6);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%u", it->address);
+                ImGui::TableSetColumnIndex(3);
+                ImGui::TextUnformatted(it->text.c_str());
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    void setVFO(VFOManager::VFO* vfo) {
+        this->vfo = vfo;
+        configureVFO();
+        dsp.setInput(vfo->output);
+    }
+
+    void start() {
+        if (running) { return; }
+        sigpath::sourceManager.onRetune.bindHandler(&retuneHandler);
+        vfo->onOffsetChanged.bindHandler(&offsetChangedHandler);
+        center = gui::waterfall.getCenterFrequency() + vfo->getOffset();
+        updateChannels();
+        dsp.start();
+        running = true;
+    }
+
+    void stop() {
+        if (!running) { return; }
+        dsp.stop();
+        sigpath::sourceManager.onRetune.unbindHandler(&retuneHandler);
+        vfo->onOffsetChanged.unbindHandler(&offsetChangedHandler);
+        running = false;
+    }
+
+private:
+    void configureVFO() {
+        double sr = dsp.getSamplerate();
+        double bw = sr - (2.0 * POCSAGMultiDSP::CHANNEL_SPACING);
+        vfo->setBandwidthLimits(bw, bw, true);
+        vfo->setSampleRate(sr, bw);
+        vfo->setSnapInterval(POCSAGMultiDSP::CHANNEL_SPACING);
+    }
+
+    void updateCenter(double centerFreq) {
+        double newCenter = centerFreq + vfo->getOffset();
+        if (newCenter == center) { return; }
+        center = newCenter;
+        updateChannels();
+    }
+
+    void updateChannels() {
+        std::vector<POCSAGMultiDSP::ChannelConfig> configs;
+        for (double freq : frequencies) { configs.push_back({ freq, freq - center }); }
+        dsp.setChannels(configs);
+    }
+
+    void saveConfig() {
+        config->acquire();
+        json& conf = config->conf[name];
+        conf["multiBaudrate"] = baudrates.key(brId);
+        conf["multiSpan"] = spans.key(spanId);
+        conf["multiChannels"] = frequencies;
+        config->release(true);
+    }
+
+    static void retuneHandlerFunc(double freq, void* ctx) {
+        MultiPOCSAGDecoder* _this = (MultiPOCSAGDecoder*)ctx;
+        _this->updateCenter(freq);
+    }
+
+    static void offsetChangedHandlerFunc(double offset, void* ctx) {
+        MultiPOCSAGDecoder* _this = (MultiPOCSAGDecoder*)ctx;
+        _this->updateCenter(gui::waterfall.getCenterFrequency());
+    }
+
+    void messageHandler(const PagerMessage& msg) {
+        flog::info("[POCSAG {}MHz] [{}]: '{}'", msg.frequency / 1e6, msg.address, msg.text);
+        publishPagerMessage(msg.protocol, msg.frequency, msg.address, msg.type.c_str(), msg.text);
+        std::lock_guard<std::mutex> lck(msgMtx);
+        messages.push_back(msg);
+        if (messages.size() > MULTI_MAX_MESSAGES) { messages.pop_front(); }
+    }
+
+    std::string name;
+    VFOManager::VFO* vfo;
+    ConfigManager* config;
+    bool running = false;
+
+    POCSAGMultiDSP dsp;
+    EventHandler<double> retuneHandler;
+    EventHandler<double> offsetChangedHandler;
+
+    // Absolute frequency of the center of the VFO, only known while running
+    double center = 0.0;
+    std::vector<double> frequencies;
+    double newFreq = 0.0;
+
+    std::mutex msgMtx;
+    std::deque<PagerMessage> messages;
+
+    int brId = 2;
+    int spanId = 1;
+
+    OptionList<int, int> baudrates;
+    OptionList<int, int> spans;
+};
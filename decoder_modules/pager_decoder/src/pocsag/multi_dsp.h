@@ -0,0 +1,222 @@
+#pragma once
+#include <dsp/sink.h>
+#include <dsp/channel/polyphase_channelizer.h>
+#include <dsp/taps/low_pass.h>
+#include <dsp/clock_recovery/multi_mm.h>
+#include <dsp/digital/binary_slicer.h>
+#include <utils/new_event.h>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include "../decoder.h"
+#include "dsp.h"
+#include "pocsag.h"
+
+/**
+ * Decodes many POCSAG channels from a single wideband stream.
+ * A polyphase channelizer shared by all channels splits the input into 12.5KHz wide channels, then each decoded
+ * frequency only costs a lightweight demodulator and a decoder running at the channel rate, all in the same thread.
+ * The clock recovery of all channels is done in a single call, interleaving the channels.
+*/
+class POCSAGMultiDSP : public dsp::Sink<dsp::complex_t> {
+    using base_type = dsp::Sink<dsp::complex_t>;
+public:
+    struct ChannelConfig {
+        double frequency;
+        double offset;      // Relative to the center of the input
+    };
+
+    POCSAGMultiDSP() {}
+
+    /**
+     * Create a multi-channel decoder.
+     * @param in Input stream, centered on the decoded band.
+     * @param channelCount Number of channelizer bins, the samplerate of the input must be channelCount * CHANNEL_SPACING.
+     * @param baudrate Baudrate of all channels.
+    */
+    POCSAGMultiDSP(dsp::stream<dsp::complex_t>* in, int channelCount, double baudrate) { init(in, channelCount, baudrate); }
+
+    ~POCSAGMultiDSP() {
+        if (!base_type::_block_init) { return; }
+        base_type::stop();
+        channels.clear();
+    }
+
+    void init(dsp::stream<dsp::complex_t>* in, int channelCount, double baudrate) {
+        _samplerate = channelCount * CHANNEL_SPACING;
+        _baudrate = baudrate;
+
+        dsp::tap<float> proto = generatePrototype();
+        channelizer.init(NULL, channelCount, proto);
+        dsp::taps::free(proto);
+        recov.init(0, getOmega(), 1e-4, 1.0, 0.05);
+
+        base_type::init(in);
+    }
+
+    /**
+     * Set the list of decoded channels. The offsets must be given again after changing the channel count.
+     * @param configs Frequency and offset of each channel. Channels outside of the usable bandwidth are ignored.
+    */
+    void setChannels(const std::vector<ChannelConfig>& configs) {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        base_type::tempStop();
+        channels.clear();
+        channelIds.clear();
+        for (const auto& conf : configs) {
+            if (!isInBand(conf.offset)) { continue; }
+            auto chan = std::make_unique<Channel>();
+            chan->frequency = conf.frequency;
+            double residual;
+            channelIds.push_back(channelizer.getChannel(conf.offset, _samplerate, &residual));
+            chan->demod.init(CHANNEL_SPACING * 2.0, _baudrate, residual);
+            Channel* c = chan.get();
+            chan->decoder.onMessage.bind([this, c](pocsag::Address addr, pocsag::MessageType type, const std::string& msg) {
+                PagerMessage pmsg;
+                pmsg.time = std::chrono::system_clock::now();
+                pmsg.frequency = c->frequency;
+                pmsg.protocol = "POCSAG";
+                pmsg.address = addr;
+                pmsg.type = (type == pocsag::MESSAGE_TYPE_NUMERIC) ? "Numeric" : "Alphanumeric";
+                pmsg.text = msg;
+                c->messages++;
+                onMessage(pmsg);
+            });
+            channels.push_back(std::move(chan));
+        }
+        outPtrs.resize(channels.size());
+        softPtrs.resize(channels.size());
+        symbolPtrs.resize(channels.size());
+        symbolCounts.resize(channels.size());
+        for (int i = 0; i < channels.size(); i++) {
+            outPtrs[i] = channels[i]->samples;
+            softPtrs[i] = channels[i]->soft;
+            symbolPtrs[i] = channels[i]->symbols;
+        }
+        recov.setChannelCount(channels.size(), getOmega());
+        base_type::tempStart();
+    }
+
+    void setChannelCount(int channelCount) {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        base_type::tempStop();
+        _samplerate = channelCount * CHANNEL_SPACING;
+        dsp::tap<float> proto = generatePrototype();
+        channelizer.setChannelCount(channelCount, proto);
+        dsp::taps::free(proto);
+        channels.clear();
+        channelIds.clear();
+        outPtrs.clear();
+        softPtrs.clear();
+        symbolPtrs.clear();
+        symbolCounts.clear();
+        recov.setChannelCount(0, getOmega());
+        base_type::tempStart();
+    }
+
+    void setBaudrate(double baudrate) {
+        assert(base_type::_block_init);
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        base_type::tempStop();
+        _baudrate = baudrate;
+        for (auto& chan : channels) { chan->demod.setBaudrate(baudrate); }
+        recov.setChannelCount(channels.size(), getOmega());
+        base_type::tempStart();
+    }
+
+    // Check if a channel can be decoded, the edges of the band being attenuated by the VFO
+    bool isInBand(double offset) {
+        return fabs(offset) <= (_samplerate / 2.0) - CHANNEL_SPACING;
+    }
+
+    double getSamplerate() { return _samplerate; }
+
+    /**
+     * Get the number of messages decoded on each channel in band, in the order they were given.
+     * @return Message count of each channel.
+    */
+    std::vector<int> getMessageCounts() {
+        std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+        std::vector<int> counts;
+        for (const auto& chan : channels) { counts.push_back(chan->messages); }
+        return counts;
+    }
+
+    int run() {
+        int count = base_type::_in->read();
+        if (count < 0) { return -1; }
+
+        // Work in chunks so that the per-channel buffers stay small
+        const dsp::complex_t* in = base_type::_in->readBuf;
+        for (int i = 0; i < count; i += CHUNK_SIZE) {
+            int len = std::min<int>(CHUNK_SIZE, count - i);
+            int chanCount = channelizer.process(len, &in[i], outPtrs.data(), channelIds.data(), channels.size());
+            for (auto& chan : channels) { chan->demod.process(chanCount, chan->samples, chan->soft); }
+            recov.process(chanCount, softPtrs.data(), symbolPtrs.data(), symbolCounts.data());
+            for (int j = 0; j < channels.size(); j++) {
+                auto& chan = channels[j];
+                dsp::digital::BinarySlicer::process(symbolCounts[j], chan->symbols, chan->bits);
+                chan->decoder.process(chan->bits, symbolCounts[j]);
+            }
+        }
+
+        base_type::_in->flush();
+        return count;
+    }
+
+    NewEvent<const PagerMessage&> onMessage;
+
+    static constexpr double CHANNEL_SPACING = 12500.0;
+
+private:
+    double getOmega() {
+        return (CHANNEL_SPACING * 2.0) / _baudrate;
+    }
+
+    // Keep the passband flat up to the channel edges, the overlap between channels is removed by the matched filter
+    dsp::tap<float> generatePrototype() {
+        return dsp::taps::lowPass(CHANNEL_SPACING * 0.8, CHANNEL_SPACING * 0.4, _samplerate);
+    }
+
+    static constexpr int CHUNK_SIZE = 8192;
+    static constexpr int MAX_CHUNK_OUTPUT = CHUNK_SIZE + 1;
+
+    struct Channel {
+        Channel() {
+            samples = dsp::buffer::alloc<dsp::complex_t>(MAX_CHUNK_OUTPUT);
+            soft = dsp::buffer::alloc<float>(MAX_CHUNK_OUTPUT);
+            symbols = dsp::buffer::alloc<float>(MAX_CHUNK_OUTPUT);
+            bits = dsp::buffer::alloc<uint8_t>(MAX_CHUNK_OUTPUT);
+        }
+
+        ~Channel() {
+            dsp::buffer::free(samples);
+            dsp::buffer::free(soft);
+            dsp::buffer::free(symbols);
+            dsp::buffer::free(bits);
+        }
+
+        double frequency;
+        POCSAGChannelDemod demod;
+        pocsag::Decoder decoder;
+        std::atomic<int> messages = 0;
+
+        dsp::complex_t* samples;
+        float* soft;
+        float* symbols;
+        uint8_t* bits;
+    };
+
+    double _samplerate;
+    double _baudrate;
+    dsp::channel::PolyphaseChannelizer channelizer;
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::vector<int> channelIds;
+    std::vector<dsp::complex_t*> outPtrs;
+    dsp::clock_recovery::MultiMM<float> recov;
+    std::vector<const float*> softPtrs;
+    std::vector<float*> symbolPtrs;
+    std::vector<int> symbolCounts;
+};
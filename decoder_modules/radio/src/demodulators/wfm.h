@@ -3,6 +3,7 @@
 #include <dsp/demod/broadcast_fm.h>
 #include "../rds_demod.h"
 #include <gui/widgets/symbol_diagram.h>
+#include <signal_path/signal_path.h>
 #include <fstream>
 #include <rds.h>
 
@@ -56,6 +57,9 @@ namespace demod {
             if (config->conf[name][getName()].contains("rdsInfo")) {
                 _rdsInfo = config->conf[name][getName()]["rdsInfo"];
             }
+            if (config->conf[name][getName()].contains("rdsSoftCorrection")) {
+                _rdsSoftCorrection = config->conf[name][getName()]["rdsSoftCorrection"];
+            }
             if (config->conf[name][getName()].contains("rdsRegion")) {
                 rdsRegionStr = config->conf[name][getName()]["rdsRegion"];
             }
@@ -75,6 +79,8 @@ namespace demod {
             demod.init(input, bandwidth / 2.0f, getIFSampleRate(), _stereo, _lowPass, _rds);
             rdsDemod.init(&demod.rdsOut, _rdsInfo);
             hs.init(&rdsDemod.out, rdsHandler, this);
+            rdsDecode.onGroup.bind(&WFM::groupHandler, this);
+            rdsDecode.setSoftCorrection(_rdsSoftCorrection);
             reshape.init(&rdsDemod.soft, 4096, (1187 / 30) - 4096);
             diagHandler.init(&reshape.out, _diagHandler, this);
 
@@ -135,6 +141,12 @@ namespace demod {
                 _config->conf[name][getName()]["rdsRegion"] = rdsRegions.key(rdsRegionId);
                 _config->release(true);
             }
+            if (ImGui::Checkbox(("Soft RDS Error Correction##_radio_wfm_rds_soft_" + name).c_str(), &_rdsSoftCorrection)) {
+                rdsDecode.setSoftCorrection(_rdsSoftCorrection);
+                _config->acquire();
+                _config->conf[name][getName()]["rdsSoftCorrection"] = _rdsSoftCorrection;
+                _config->release(true);
+            }
             if (!_rds) { ImGui::EndDisabled(); }
 
             float menuWidth = ImGui::GetContentRegionAvail().x;
@@ -290,6 +302,21 @@ namespace demod {
             _this->rdsDecode.process(data, count);
         }
 
+        void groupHandler(const uint16_t* blocks, const bool* available) {
+            if (!sigpath::messageBus.hasSubscribers() || !available[1]) { return; }
+
+            // Publish the raw blocks along with the group type, eg. "2A"
+            DecodedMessage msg("RDS", "group", frequency);
+            char group[8];
+            sprintf(group, "%d%c", blocks[1] >> 12, ((blocks[1] >> 11) & 1) ? 'B' : 'A');
+            msg.addText("group", group);
+            const char* names[4] = { "pi", "b", "c", "d" };
+            for (int i = 0; i < 4; i++) {
+                if (available[i]) { msg.addInt(names[i], blocks[i]); }
+            }
+            sigpath::messageBus.publish(msg);
+        }
+
         static void _diagHandler(float* data, int count, void* ctx) {
             WFM* _this = (WFM*)ctx;
             float* buf = _this->diag.acquireBuffer();
@@ -299,6 +326,10 @@ namespace demod {
 
         static void fftRedraw(ImGui::WaterFall::FFTRedrawArgs args, void* ctx) {
             WFM* _this = (WFM*)ctx;
+
+            // Keep track of the tuned frequency for the published RDS groups
+            _this->frequency = gui::waterfall.getCenterFrequency() + sigpath::vfoManager.getOffset(_this->name);
+
             if (!_this->_rds) { return; }
 
             // Generate string depending on RDS mode
@@ -354,6 +385,7 @@ namespace demod {
         bool _lowPass = true;
         bool _rds = false;
         bool _rdsInfo = false;
+        bool _rdsSoftCorrection = false;
         float muGain = 0.01;
         float omegaGain = (0.01*0.01)/4.0;
 
@@ -363,6 +395,8 @@ namespace demod {
         OptionList<std::string, RDSRegion> rdsRegions;
 
 
+        std::atomic<double> frequency = 0.0;
+
         std::string name;
     };
 }
\ No newline at end of file
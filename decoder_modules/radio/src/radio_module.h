@@ -49,6 +49,12 @@ public:
         ifnrPresets.define("Voice", IFNR_PRESET_VOICE);
         ifnrPresets.define("Narrow Band", IFNR_PRESET_NARROW_BAND);
 
+        fmifnrQualities.define("High Quality", dsp::noise_reduction::FMIF::QUALITY_HIGH);
+        fmifnrQualities.define("Low CPU", dsp::noise_reduction::FMIF::QUALITY_LOW);
+
+        nbModes.define("Scale", dsp::noise_reduction::NoiseBlanker::MODE_SCALE);
+        nbModes.define("Interpolate", dsp::noise_reduction::NoiseBlanker::MODE_INTERPOLATE);
+
         // Initialize the config if it doesn't exist
         bool created = false;
         config.acquire();
@@ -244,6 +250,11 @@ private:
             if (ImGui::SliderFloat(("##_radio_nb_lvl_" + _this->name).c_str(), &_this->nbLevel, _this->MIN_NB, _this->MAX_NB, "%.3fdB")) {
                 _this->setNBLevel(_this->nbLevel);
             }
+            ImGui::LeftLabel("Blanking");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::Combo(("##_radio_nb_mode_" + _this->name).c_str(), &_this->nbModeId, _this->nbModes.txt)) {
+                _this->setNBMode(_this->nbModes[_this->nbModeId]);
+            }
             if (!_this->nbEnabled && _this->enabled) { style::endDisabled(); }
         }
         
@@ -274,6 +285,13 @@ private:
                 }
                 if (!_this->FMIFNREnabled && _this->enabled) { style::endDisabled(); }
             }
+            if (!_this->FMIFNREnabled && _this->enabled) { style::beginDisabled(); }
+            ImGui::LeftLabel("NR Quality");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::Combo(("##_radio_fmifnr_quality_" + _this->name).c_str(), &_this->fmifnrQualityId, _this->fmifnrQualities.txt)) {
+                _this->setFMIFNRQuality(_this->fmifnrQualities[_this->fmifnrQualityId]);
+            }
+            if (!_this->FMIFNREnabled && _this->enabled) { style::endDisabled(); }
         }
 
         // Demodulator specific menu
@@ -368,9 +386,11 @@ private:
         FMIFNRAllowed = selectedDemod->getFMIFNRAllowed();
         FMIFNREnabled = false;
         fmIFPresetId = ifnrPresets.valueId(IFNR_PRESET_VOICE);
+        fmifnrQualityId = fmifnrQualities.valueId(dsp::noise_reduction::FMIF::QUALITY_HIGH);
         nbAllowed = selectedDemod->getNBAllowed();
         nbEnabled = false;
         nbLevel = 0.0f;
+        nbModeId = nbModes.valueId(dsp::noise_reduction::NoiseBlanker::MODE_SCALE);
         double ifSamplerate = selectedDemod->getIFSampleRate();
         config.acquire();
         if (config.conf[name][selectedDemod->getName()].contains("bandwidth")) {
@@ -405,12 +425,24 @@ private:
                 fmIFPresetId = ifnrPresets.keyId(presetOpt);
             }
         }
+        if (config.conf[name][selectedDemod->getName()].contains("fmifnrQuality")) {
+            std::string qualityOpt = config.conf[name][selectedDemod->getName()]["fmifnrQuality"];
+            if (fmifnrQualities.keyExists(qualityOpt)) {
+                fmifnrQualityId = fmifnrQualities.keyId(qualityOpt);
+            }
+        }
         if (config.conf[name][selectedDemod->getName()].contains("noiseBlankerEnabled")) {
             nbEnabled = config.conf[name][selectedDemod->getName()]["noiseBlankerEnabled"];
         }
         if (config.conf[name][selectedDemod->getName()].contains("noiseBlankerLevel")) {
             nbLevel = config.conf[name][selectedDemod->getName()]["noiseBlankerLevel"];
         }
+        if (config.conf[name][selectedDemod->getName()].contains("noiseBlankerMode")) {
+            std::string modeOpt = config.conf[name][selectedDemod->getName()]["noiseBlankerMode"];
+            if (nbModes.keyExists(modeOpt)) {
+                nbModeId = nbModes.keyId(modeOpt);
+            }
+        }
         config.release();
 
         // Configure VFO
@@ -427,10 +459,12 @@ private:
         // Configure noise blanker
         nb.setRate(500.0 / ifSamplerate);
         setNBLevel(nbLevel);
+        setNBMode(nbModes[nbModeId]);
         setNBEnabled(nbAllowed && nbEnabled);
 
         // Configure FM IF Noise Reduction
         setIFNRPreset((selectedDemodID == RADIO_DEMOD_NFM) ? ifnrPresets[fmIFPresetId] : IFNR_PRESET_BROADCAST);
+        setFMIFNRQuality(fmifnrQualities[fmifnrQualityId]);
         setFMIFNREnabled(FMIFNRAllowed ? FMIFNREnabled : false);
 
         // Configure squelch
@@ -451,6 +485,7 @@ private:
         else {
             // Disable everything if post processing is disabled
             afChain.disableAllBlocks([=](dsp::stream<dsp::stereo_t>* out){ stream.setInput(out); });
+            stream.setHopLatency("Resampler", 0.0);
         }
 
         // Start new demodulator
@@ -493,6 +528,9 @@ private:
         deemp.setSamplerate(audioSampleRate);
 
         afChain.start();
+
+        // Report the delay of the resampler filter to the audio stream
+        stream.setHopLatency("Resampler", resamp.getDelay());
     }
 
     void setDeemphasisMode(DeemphasisMode mode) {
@@ -529,6 +567,16 @@ private:
         config.release(true);
     }
 
+    void setNBMode(dsp::noise_reduction::NoiseBlanker::Mode mode) {
+        nbModeId = nbModes.valueId(mode);
+        nb.setMode(mode);
+
+        // Save config
+        config.acquire();
+        config.conf[name][selectedDemod->getName()]["noiseBlankerMode"] = nbModes.key(nbModeId);
+        config.release(true);
+    }
+
     void setSquelchEnabled(bool enable) {
         squelchEnabled = enable;
         if (!selectedDemod) { return; }
@@ -579,6 +627,17 @@ private:
         config.release(true);
     }
 
+    void setFMIFNRQuality(dsp::noise_reduction::FMIF::Quality quality) {
+        fmifnrQualityId = fmifnrQualities.valueId(quality);
+        if (!selectedDemod) { return; }
+        fmnr.setQuality(quality);
+
+        // Save config
+        config.acquire();
+        config.conf[name][selectedDemod->getName()]["fmifnrQuality"] = fmifnrQualities.key(fmifnrQualityId);
+        config.release(true);
+    }
+
     static void vfoUserChangedBandwidthHandler(double newBw, void* ctx) {
         RadioModule* _this = (RadioModule*)ctx;
         _this->setBandwidth(newBw);
@@ -669,6 +728,8 @@ private:
 
     OptionList<std::string, DeemphasisMode> deempModes;
     OptionList<std::string, IFNRPreset> ifnrPresets;
+    OptionList<std::string, dsp::noise_reduction::FMIF::Quality> fmifnrQualities;
+    OptionList<std::string, dsp::noise_reduction::NoiseBlanker::Mode> nbModes;
 
     double audioSampleRate = 48000.0;
     float minBandwidth;
@@ -688,6 +749,7 @@ private:
     bool FMIFNRAllowed;
     bool FMIFNREnabled = false;
     int fmIFPresetId;
+    int fmifnrQualityId = 0;
 
     bool notchEnabled = false;
     float notchPos = 0;
@@ -696,6 +758,7 @@ private:
     bool nbAllowed;
     bool nbEnabled = false;
     float nbLevel = 10.0f;
+    int nbModeId = 0;
 
     const double MIN_NB = 1.0;
     const double MAX_NB = 10.0;
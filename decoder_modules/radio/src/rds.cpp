@@ -2,6 +2,7 @@
 #include <string.h>
 #include <map>
 #include <algorithm>
+#include <limits.h>
 
 #include <utils/flog.h>
 
@@ -122,18 +123,79 @@ namespace rds {
     const int DATA_LEN = 16;
     const int POLY_LEN = 10;
 
+    // Number of least reliable bits flipped by the soft decision error correction
+    const int SOFT_CORRECTION_BITS = 5;
+
+    // Bit-serial syndrome calculation, only used to generate the lookup tables
+    static uint16_t lfsrSyndrome(uint32_t block) {
+        uint16_t syn = 0;
+
+        // Calculate the syndrome using a LFSR
+        for (int i = BLOCK_LEN - 1; i >= 0; i--) {
+            // Shift the syndrome and keep the output
+            uint8_t outBit = (syn >> (POLY_LEN - 1)) & 1;
+            syn = (syn << 1) & 0b1111111111;
+
+            // Apply LFSR polynomial
+            syn ^= LFSR_POLY * outBit;
+
+            // Apply input polynomial.
+            syn ^= IN_POLY * ((block >> i) & 1);
+        }
+
+        return syn;
+    }
+
+    // The syndrome is linear in the block bits, so it can be computed as the XOR of per-byte partial syndromes
+    struct SyndromeTables {
+        SyndromeTables() {
+            // Partial syndrome of each byte of the block and of each single bit
+            for (int b = 0; b < 4; b++) {
+                for (int v = 0; v < 256; v++) { bytes[b][v] = lfsrSyndrome((uint32_t)v << (8 * b)); }
+            }
+            for (int i = 0; i < BLOCK_LEN; i++) { bits[i] = lfsrSyndrome(1 << i); }
+
+            // Block type of each offset word syndrome
+            for (int i = 0; i < 1024; i++) { types[i] = -1; }
+            for (auto const& [syn, type] : SYNDROMES) { types[syn] = type; }
+
+            // Error pattern of every burst of up to 5 bits, the RDS code guarantees they all have a unique syndrome
+            for (int i = 0; i < 1024; i++) { bursts[i] = 0; }
+            for (int len = 1; len <= 5; len++) {
+                int innerCount = (len > 2) ? (1 << (len - 2)) : 1;
+                for (int inner = 0; inner < innerCount; inner++) {
+                    uint32_t pattern = (len > 1) ? ((1 << (len - 1)) | (inner << 1) | 1) : 1;
+                    for (int pos = 0; pos + len <= BLOCK_LEN; pos++) {
+                        uint32_t err = pattern << pos;
+                        uint16_t syn = lfsrSyndrome(err);
+                        if (!bursts[syn]) { bursts[syn] = err; }
+                    }
+                }
+            }
+        }
+
+        uint16_t bytes[4][256];
+        uint16_t bits[BLOCK_LEN];
+        int8_t types[1024];
+        uint32_t bursts[1024];
+    };
+
+    static const SyndromeTables TABLES;
+
     void Decoder::process(uint8_t* symbols, int count) {
         for (int i = 0; i < count; i++) {
-            // Shift in the bit
+            // Shift in the bit and its reliability
             shiftReg = ((shiftReg << 1) & 0x3FFFFFF) | (symbols[i] & 1);
+            relHistory[relHead] = symbols[i] >> 1;
+            relHead = (relHead + 1) % BLOCK_LEN;
 
             // Skip if we need to shift in new data
             if (--skip > 0) { continue; }
 
             // Calculate the syndrome and update sync status
             uint16_t syn = calcSyndrome(shiftReg);
-            auto synIt = SYNDROMES.find(syn);
-            bool knownSyndrome = synIt != SYNDROMES.end();
+            int8_t synType = TABLES.types[syn];
+            bool knownSyndrome = synType >= 0;
             sync = std::clamp<int>(knownSyndrome ? ++sync : --sync, 0, 4);
             
             // If we're still no longer in sync, try to resync
@@ -142,13 +204,13 @@ namespace rds {
             // Figure out which block we've got
             BlockType type;
             if (knownSyndrome) {
-                type = SYNDROMES[syn];
+                type = (BlockType)synType;
             }
             else {
                 type = (BlockType)((lastType + 1) % _BLOCK_TYPE_COUNT);
             }
 
-            // Save block while correcting errors (NOT YET) <- idk why the "not yet is here", TODO: find why
+            // Save block while correcting errors
             blocks[type] = correctErrors(shiftReg, type, blockAvail[type]);
 
             // If block type is A, decode it directly, otherwise, update continous count
@@ -179,51 +241,75 @@ namespace rds {
     }
 
     uint16_t Decoder::calcSyndrome(uint32_t block) {
-        uint16_t syn = 0;
-
-        // Calculate the syndrome using a LFSR
-        for (int i = BLOCK_LEN - 1; i >= 0; i--) {
-            // Shift the syndrome and keep the output
-            uint8_t outBit = (syn >> (POLY_LEN - 1)) & 1;
-            syn = (syn << 1) & 0b1111111111;
-
-            // Apply LFSR polynomial
-            syn ^= LFSR_POLY * outBit;
-
-            // Apply input polynomial.
-            syn ^= IN_POLY * ((block >> i) & 1);
-        }
-
-        return syn;
+        return TABLES.bytes[0][block & 0xFF] ^ TABLES.bytes[1][(block >> 8) & 0xFF] ^ TABLES.bytes[2][(block >> 16) & 0xFF] ^ TABLES.bytes[3][(block >> 24) & 0x03];
     }
 
-    uint32_t Decoder::correctErrors(uint32_t block, BlockType type, bool& recovered) {        
+    uint32_t Decoder::correctErrors(uint32_t block, BlockType type, bool& recovered) {
         // Subtract the offset from block
         block ^= (uint32_t)OFFSETS[type];
-        uint32_t out = block;
 
-        // Calculate syndrome of corrected block
+        // Nothing to do if the block is error free
         uint16_t syn = calcSyndrome(block);
+        recovered = true;
+        if (!syn) { return block; }
 
-        // Use the syndrome register to do error correction if errors are present
-        uint8_t errorFound = 0;
-        if (syn) {
-            for (int i = DATA_LEN - 1; i >= 0; i--) {
-                // Check if the 5 leftmost bits are all zero
-                errorFound |= !(syn & 0b11111);
+        // Look up the burst error of up to 5 bits matching the syndrome
+        uint32_t err = TABLES.bursts[syn];
 
-                // Write output
-                uint8_t outBit = (syn >> (POLY_LEN - 1)) & 1;
-                out ^= (errorFound & outBit) << (i + POLY_LEN);
+        // Try flipping the least reliable bits and keep whichever correction is the most likely
+        if (softCorrection) {
+            uint32_t softErr = softCorrect(syn);
+            if (softErr && (!err || flipCost(softErr) < flipCost(err))) { err = softErr; }
+        }
 
-                // Shift syndrome
-                syn = (syn << 1) & 0b1111111111;
-                syn ^= LFSR_POLY * outBit * !errorFound;
+        recovered = err;
+        return block ^ err;
+    }
+
+    int Decoder::flipCost(uint32_t err) {
+        int cost = 0;
+        for (int i = 0; i < BLOCK_LEN; i++) {
+            if (err & (1 << i)) { cost += relHistory[(relHead - 1 - i + BLOCK_LEN) % BLOCK_LEN]; }
+        }
+        return cost;
+    }
+
+    uint32_t Decoder::softCorrect(uint16_t syn) {
+        // Find the least reliable bits of the block, bit 0 being the newest one
+        int pos[SOFT_CORRECTION_BITS];
+        uint8_t rel[SOFT_CORRECTION_BITS];
+        int found = 0;
+        for (int i = 0; i < BLOCK_LEN; i++) {
+            uint8_t r = relHistory[(relHead - 1 - i + BLOCK_LEN) % BLOCK_LEN];
+            int j = std::min<int>(found, SOFT_CORRECTION_BITS - 1);
+            if (found == SOFT_CORRECTION_BITS && r >= rel[j]) { continue; }
+            for (; j > 0 && rel[j - 1] > r; j--) {
+                rel[j] = rel[j - 1];
+                pos[j] = pos[j - 1];
             }
+            rel[j] = r;
+            pos[j] = i;
+            found = std::min<int>(found + 1, SOFT_CORRECTION_BITS);
         }
-        recovered = !(syn & 0b11111);
 
-        return out;
+        // Walk all flip combinations in gray code order so that each candidate only costs one XOR,
+        // and keep the one that clears the syndrome while flipping the least total reliability
+        uint32_t best = 0;
+        int bestCost = INT_MAX;
+        uint32_t flips = 0;
+        int cost = 0;
+        for (int n = 1; n < (1 << SOFT_CORRECTION_BITS); n++) {
+            int b = 0;
+            while (!(n & (1 << b))) { b++; }
+            flips ^= 1 << pos[b];
+            syn ^= TABLES.bits[pos[b]];
+            cost += (flips & (1 << pos[b])) ? rel[b] : -rel[b];
+            if (!syn && cost < bestCost) {
+                best = flips;
+                bestCost = cost;
+            }
+        }
+        return best;
     }
 
     void Decoder::decodeBlockA() {
@@ -373,6 +459,17 @@ namespace rds {
     }
 
     void Decoder::decodeGroup() {
+        // Report the raw group, version B groups carrying block C' instead of block C
+        BlockType typeC = ((blocks[BLOCK_TYPE_B] >> 21) & 1) ? BLOCK_TYPE_CP : BLOCK_TYPE_C;
+        const BlockType types[4] = { BLOCK_TYPE_A, BLOCK_TYPE_B, typeC, BLOCK_TYPE_D };
+        uint16_t words[4];
+        bool avail[4];
+        for (int i = 0; i < 4; i++) {
+            words[i] = (blocks[types[i]] >> 10) & 0xFFFF;
+            avail[i] = blockAvail[types[i]];
+        }
+        onGroup(words, avail);
+
         // Make sure blocks B is available
         if (!blockAvail[BLOCK_TYPE_B]) { return; }
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <chrono>
 #include <mutex>
+#include <utils/new_event.h>
 
 #define RDS_BLOCK_A_TIMEOUT_MS  5000.0
 #define RDS_BLOCK_B_TIMEOUT_MS  5000.0
@@ -213,8 +214,16 @@ namespace rds {
 
     class Decoder {
     public:
+        /**
+         * Process demodulated bits.
+         * @param symbols Bits in the LSB, the upper 7 bits optionally carrying the reliability of the bit.
+         * @param count Number of bits.
+        */
         void process(uint8_t* symbols, int count);
 
+        // Use bit reliabilities to correct blocks that have more errors than the code can correct on its own
+        void setSoftCorrection(bool enabled) { softCorrection = enabled; }
+
         bool piCodeValid() { std::lock_guard<std::mutex> lck(blockAMtx); return blockAValid(); }
         uint16_t getPICode() { std::lock_guard<std::mutex> lck(blockAMtx); return piCode; }
         uint8_t getCountryCode() { std::lock_guard<std::mutex> lck(blockAMtx); return countryCode; }
@@ -236,9 +245,17 @@ namespace rds {
         bool programTypeNameValid() { std::lock_guard<std::mutex> lck(group10Mtx); return group10Valid(); }
         std::string getProgramTypeName() { std::lock_guard<std::mutex> lck(group10Mtx); return programTypeName; }
 
+        /**
+         * Called with the raw content of every group received along with block A.
+         * handler(blocks, available) where blocks are the 16bit information words of blocks A, B, C (or C') and D.
+        */
+        NewEvent<const uint16_t*, const bool*> onGroup;
+
     private:
         static uint16_t calcSyndrome(uint32_t block);
-        static uint32_t correctErrors(uint32_t block, BlockType type, bool& recovered);
+        uint32_t correctErrors(uint32_t block, BlockType type, bool& recovered);
+        uint32_t softCorrect(uint16_t syn);
+        int flipCost(uint32_t err);
         void decodeBlockA();
         void decodeBlockB();
         void decodeGroup0();
@@ -263,6 +280,9 @@ namespace rds {
         int contGroup = 0;
         uint32_t blocks[_BLOCK_TYPE_COUNT];
         bool blockAvail[_BLOCK_TYPE_COUNT];
+        uint8_t relHistory[26] = {};
+        int relHead = 0;
+        bool softCorrection = false;
 
         // Block A (All groups)
         std::mutex blockAMtx;
@@ -8,6 +8,8 @@
 #include <dsp/clock_recovery/mm.h>
 #include <dsp/digital/binary_slicer.h>
 #include <dsp/digital/differential_decoder.h>
+#include <algorithm>
+#include <math.h>
 
 class RDSDemod : public dsp::Processor<dsp::complex_t, uint8_t> {
     using base_type = dsp::Processor<dsp::complex_t, uint8_t>;
@@ -58,6 +60,7 @@ public:
         costas2.reset();
         recov.reset();
         diff.reset();
+        lastReliability = 0;
         base_type::tempStart();
     }
 
@@ -70,6 +73,14 @@ public:
         count = recov.process(count, softOut, softOut);
         count = dsp::digital::BinarySlicer::process(count, softOut, diff.out.readBuf);
         count = diff.process(count, diff.out.readBuf, hardOut);
+
+        // Pack the reliability of each bit above it, a differential bit is only as reliable as the weakest of its two symbols
+        for (int i = 0; i < count; i++) {
+            uint8_t rel = std::min<float>(fabsf(softOut[i]) * 64.0f, 127.0f);
+            hardOut[i] |= std::min<uint8_t>(rel, lastReliability) << 1;
+            lastReliability = rel;
+        }
+
         return count;
     }
 
@@ -91,6 +102,7 @@ public:
 
 private:
     bool enableSoft = false;
+    uint8_t lastReliability = 0;
     
     dsp::loop::FastAGC<dsp::complex_t> agc;
     dsp::loop::Costas<2> costas;
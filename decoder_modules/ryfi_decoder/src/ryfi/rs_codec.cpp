@@ -2,18 +2,13 @@
 
 namespace ryfi {
     RSEncoder::RSEncoder(dsp::stream<uint8_t>* in) {
-        // Create the convolutional encoder instance
-        rs = correct_reed_solomon_create(correct_rs_primitive_polynomial_ccsds, 1, 1, 32);
-        
+        // Create the reed-solomon codec
+        rs.init(dsp::fec::RS_PRIMITIVE_POLYNOMIAL_CCSDS, 1, 1, RS_BLOCK_ENC_SIZE - RS_BLOCK_DEC_SIZE);
+
         // Init the base class
         base_type::init(in);
     }
 
-    RSEncoder::~RSEncoder() {
-        // Destroy the convolutional encoder instance
-        correct_reed_solomon_destroy(rs);
-    }
-
     int RSEncoder::encode(const uint8_t* in, uint8_t* out, int count) {
         // Check the size
         assert(count == RS_BLOCK_COUNT*RS_BLOCK_DEC_SIZE);
@@ -22,7 +17,7 @@ namespace ryfi {
         uint8_t block[RS_BLOCK_ENC_SIZE];
         for (int i = 0; i < RS_BLOCK_COUNT; i++) {
             // Encode block
-            correct_reed_solomon_encode(rs, &in[i*RS_BLOCK_DEC_SIZE], RS_BLOCK_DEC_SIZE, block);
+            rs.encode(&in[i*RS_BLOCK_DEC_SIZE], RS_BLOCK_DEC_SIZE, block);
 
             // Interleave into the frame
             int k = 0;
@@ -51,18 +46,13 @@ namespace ryfi {
     }
 
     RSDecoder::RSDecoder(dsp::stream<uint8_t>* in) {
-        // Create the convolutional encoder instance
-        rs = correct_reed_solomon_create(correct_rs_primitive_polynomial_ccsds, 1, 1, 32);
-        
+        // Create the reed-solomon codec
+        rs.init(dsp::fec::RS_PRIMITIVE_POLYNOMIAL_CCSDS, 1, 1, RS_BLOCK_ENC_SIZE - RS_BLOCK_DEC_SIZE);
+
         // Init the base class
         base_type::init(in);
     }
 
-    RSDecoder::~RSDecoder() {
-        // Destroy the convolutional encoder instance
-        correct_reed_solomon_destroy(rs);
-    }
-
     int RSDecoder::decode(uint8_t* in, uint8_t* out, int count) {
         // Check the size
         assert(count == RS_BLOCK_COUNT*RS_BLOCK_ENC_SIZE);
@@ -72,18 +62,15 @@ namespace ryfi {
             in[i] ^= RS_SCRAMBLER_SEQ[i];
         }
 
-        // Go through each block
-        uint8_t block[RS_BLOCK_ENC_SIZE];
+        // Correct all blocks in place while still interleaved and return if decoding fails
+        if (rs.correctInterleaved(in, RS_BLOCK_COUNT, RS_BLOCK_ENC_SIZE) < 0) { return 0; }
+
+        // Deinterleave the data out of the frame
         for (int i = 0; i < RS_BLOCK_COUNT; i++) {
-            // Deinterleave out of the frame
-            int k = 0;
-            for (int j = i; j < count; j += RS_BLOCK_COUNT) {
-                block[k++] = in[j];
+            uint8_t* block = &out[i*RS_BLOCK_DEC_SIZE];
+            for (int j = 0; j < RS_BLOCK_DEC_SIZE; j++) {
+                block[j] = in[j*RS_BLOCK_COUNT + i];
             }
-
-            // Decode block and return if decoding fails
-            int res = correct_reed_solomon_decode(rs, block, RS_BLOCK_ENC_SIZE, &out[i*RS_BLOCK_DEC_SIZE]);
-            if (res < 0) { return 0; }
         }
 
         return RS_BLOCK_COUNT*RS_BLOCK_DEC_SIZE;
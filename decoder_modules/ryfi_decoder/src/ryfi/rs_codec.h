@@ -2,10 +2,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "dsp/processor.h"
-
-extern "C" {
-    #include "correct.h"
-}
+#include "dsp/fec/reed_solomon.h"
 
 namespace ryfi {
     // Size of an encoded reed-solomon block.
@@ -32,9 +29,6 @@ namespace ryfi {
         */
         RSEncoder(dsp::stream<uint8_t>* in = NULL);
 
-        // Destructor
-        ~RSEncoder();
-
         /**
          * Encode data.
          * @param in Input bytes.
@@ -47,7 +41,7 @@ namespace ryfi {
     private:
         int run();
 
-        correct_reed_solomon* rs;
+        dsp::fec::ReedSolomon rs;
     };
 
     /**
@@ -62,9 +56,6 @@ namespace ryfi {
         */
         RSDecoder(dsp::stream<uint8_t>* in = NULL);
 
-        // Destructor
-        ~RSDecoder();
-
         /**
          * Decode data.
          * @param in Input bytes.
@@ -77,6 +68,6 @@ namespace ryfi {
     private:
         int run();
 
-        correct_reed_solomon* rs;
+        dsp::fec::ReedSolomon rs;
     };
 }
\ No newline at end of file
@@ -93,6 +93,12 @@ private:
     void onBearing(float nbearing, float nquality) {
         bearing = (180.0f * nbearing / FL_M_PI);
         quality = nquality * 100.0f;
+
+        if (!sigpath::messageBus.hasSubscribers()) { return; }
+        DecodedMessage msg("VOR", "bearing", gui::waterfall.getCenterFrequency() + vfo->getOffset());
+        msg.addFloat("bearing", bearing);
+        msg.addFloat("quality", quality);
+        sigpath::messageBus.publish(msg);
     }
 
     std::string name;
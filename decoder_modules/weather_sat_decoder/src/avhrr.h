@@ -0,0 +1,200 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+#include <algorithm>
+
+namespace avhrr {
+    // Layout of the AVHRR earth view data in an HRPT minor frame, pixels are stored with their 5 channels interleaved
+    const int FRAME_WORD_COUNT = 11090;
+    const int EARTH_DATA_OFFSET = 750;
+    const int PIXEL_COUNT = 2048;
+    const int CHANNEL_COUNT = 5;
+    const int COUNT_RANGE = 1024;
+
+    // Number of lines between two updates of the stretch from the histogram
+    const int STRETCH_UPDATE_INTERVAL = 32;
+
+    // Only one pixel out of this many is counted in the histogram
+    const int HISTOGRAM_DECIMATION = 4;
+
+    /**
+     * Converts the AVHRR data of HRPT minor frames into image lines.
+     * All channel lines and the composite line are produced in a single pass over the frame, each 10bit count being
+     * turned into a ready to store RGBA pixel by a per-channel lookup table. The tables combine an optional calibration
+     * (count to physical value) with either a fixed range or a histogram stretch computed from the received counts.
+     * Output pixels are written as 32bit words, which assumes a little endian host like the rest of the image code.
+    */
+    class Imager {
+    public:
+        Imager() {
+            for (int c = 0; c < CHANNEL_COUNT; c++) {
+                calibrated[c] = false;
+                rebuildLUT(c);
+            }
+            memset(histogram, 0, sizeof(histogram));
+        }
+
+        /**
+         * Select the channels used for the composite image.
+         * @param red Channel index (0 to 4) of the red component.
+         * @param green Channel index of the green component.
+         * @param blue Channel index of the blue component.
+        */
+        void setComposite(int red, int green, int blue) {
+            std::lock_guard<std::mutex> lck(mtx);
+            compRed = red;
+            compGreen = green;
+            compBlue = blue;
+        }
+
+        /**
+         * Calibrate a channel.
+         * @param channel Channel index (0 to 4).
+         * @param values Physical value (albedo, brightness temperature...) of each of the 1024 counts.
+         * @param min Value displayed as black when not stretching.
+         * @param max Value displayed as white when not stretching.
+        */
+        void setCalibration(int channel, const float* values, float min, float max) {
+            std::lock_guard<std::mutex> lck(mtx);
+            memcpy(calibration[channel], values, sizeof(calibration[channel]));
+            calibMin[channel] = min;
+            calibMax[channel] = max;
+            calibrated[channel] = true;
+            rebuildLUT(channel);
+        }
+
+        void clearCalibration(int channel) {
+            std::lock_guard<std::mutex> lck(mtx);
+            calibrated[channel] = false;
+            rebuildLUT(channel);
+        }
+
+        /**
+         * Enable or disable the histogram stretch.
+         * @param enabled True to map the given percentiles of the counts received so far to black and white.
+         * @param low Fraction of the pixels displayed as black.
+         * @param high Fraction of the pixels displayed as white or darker.
+        */
+        void setStretch(bool enabled, float low = 0.01f, float high = 0.99f) {
+            std::lock_guard<std::mutex> lck(mtx);
+            stretch = enabled;
+            stretchLow = low;
+            stretchHigh = high;
+            for (int c = 0; c < CHANNEL_COUNT; c++) { rebuildLUT(c); }
+        }
+
+        // Forget the counts received so far, typically at the start of a new pass
+        void resetHistogram() {
+            std::lock_guard<std::mutex> lck(mtx);
+            memset(histogram, 0, sizeof(histogram));
+            linesSinceUpdate = 0;
+            for (int c = 0; c < CHANNEL_COUNT; c++) { rebuildLUT(c); }
+        }
+
+        /**
+         * Produce the image lines of a minor frame.
+         * @param frame Minor frame, one 10bit word per element.
+         * @param channels One RGBA line of 2048 pixels per channel.
+         * @param composite RGBA line of 2048 pixels for the composite.
+        */
+        void process(const uint16_t* frame, uint8_t* const channels[CHANNEL_COUNT], uint8_t* composite) {
+            std::lock_guard<std::mutex> lck(mtx);
+            const uint16_t* in = &frame[EARTH_DATA_OFFSET];
+            uint32_t* out0 = (uint32_t*)channels[0];
+            uint32_t* out1 = (uint32_t*)channels[1];
+            uint32_t* out2 = (uint32_t*)channels[2];
+            uint32_t* out3 = (uint32_t*)channels[3];
+            uint32_t* out4 = (uint32_t*)channels[4];
+            uint32_t* comp = (uint32_t*)composite;
+            const uint8_t* red = levels[compRed];
+            const uint8_t* green = levels[compGreen];
+            const uint8_t* blue = levels[compBlue];
+
+            for (int i = 0; i < PIXEL_COUNT; i++) {
+                uint16_t w[CHANNEL_COUNT];
+                for (int c = 0; c < CHANNEL_COUNT; c++) { w[c] = in[c] & (COUNT_RANGE - 1); }
+                in += CHANNEL_COUNT;
+
+                out0[i] = pixels[0][w[0]];
+                out1[i] = pixels[1][w[1]];
+                out2[i] = pixels[2][w[2]];
+                out3[i] = pixels[3][w[3]];
+                out4[i] = pixels[4][w[4]];
+                comp[i] = 0xFF000000 | ((uint32_t)blue[w[compBlue]] << 16) | ((uint32_t)green[w[compGreen]] << 8) | red[w[compRed]];
+            }
+
+            // Follow the distribution of the counts, a subset of the pixels is plenty to get the percentiles
+            if (!stretch) { return; }
+            const uint16_t* earth = &frame[EARTH_DATA_OFFSET];
+            for (int i = 0; i < PIXEL_COUNT; i += HISTOGRAM_DECIMATION) {
+                for (int c = 0; c < CHANNEL_COUNT; c++) { histogram[c][earth[(i * CHANNEL_COUNT) + c] & (COUNT_RANGE - 1)]++; }
+            }
+            if (++linesSinceUpdate >= STRETCH_UPDATE_INTERVAL) {
+                linesSinceUpdate = 0;
+                for (int c = 0; c < CHANNEL_COUNT; c++) { rebuildLUT(c); }
+            }
+        }
+
+    private:
+        inline float countValue(int channel, int count) {
+            return calibrated[channel] ? calibration[channel][count] : (float)count;
+        }
+
+        void rebuildLUT(int channel) {
+            // Range mapped to black and white
+            float low = calibrated[channel] ? calibMin[channel] : 0.0f;
+            float high = calibrated[channel] ? calibMax[channel] : (float)COUNT_RANGE;
+            if (stretch) {
+                uint64_t total = 0;
+                for (int i = 0; i < COUNT_RANGE; i++) { total += histogram[channel][i]; }
+                if (total) {
+                    uint64_t lowCount = total * stretchLow;
+                    uint64_t highCount = total * stretchHigh;
+                    uint64_t sum = 0;
+                    int lowIdx = -1, highIdx = COUNT_RANGE - 1;
+                    for (int i = 0; i < COUNT_RANGE; i++) {
+                        sum += histogram[channel][i];
+                        if (lowIdx < 0 && sum > lowCount) { lowIdx = i; }
+                        if (sum >= highCount) {
+                            highIdx = i;
+                            break;
+                        }
+                    }
+                    low = countValue(channel, std::max<int>(lowIdx, 0));
+                    high = countValue(channel, highIdx);
+                }
+            }
+
+            // Generate the gray levels and the matching RGBA pixels, an inverted range gives an inverted image
+            float scale = (high != low) ? (255.0f / (high - low)) : 0.0f;
+            for (int i = 0; i < COUNT_RANGE; i++) {
+                float val = (countValue(channel, i) - low) * scale;
+                uint8_t level = std::clamp<float>(val, 0.0f, 255.0f);
+                levels[channel][i] = level;
+                pixels[channel][i] = 0xFF000000 | ((uint32_t)level << 16) | ((uint32_t)level << 8) | level;
+            }
+        }
+
+        std::mutex mtx;
+
+        uint32_t pixels[CHANNEL_COUNT][COUNT_RANGE];
+        uint8_t levels[CHANNEL_COUNT][COUNT_RANGE];
+
+        bool calibrated[CHANNEL_COUNT];
+        float calibration[CHANNEL_COUNT][COUNT_RANGE];
+        float calibMin[CHANNEL_COUNT];
+        float calibMax[CHANNEL_COUNT];
+
+        bool stretch = false;
+        float stretchLow = 0.01f;
+        float stretchHigh = 0.99f;
+        uint32_t histogram[CHANNEL_COUNT][COUNT_RANGE];
+        int linesSinceUpdate = 0;
+
+        // Default to the 221 false color composite
+        int compRed = 1;
+        int compGreen = 1;
+        int compBlue = 0;
+    };
+}
@@ -23,6 +23,8 @@
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+ConfigManager config;
+
 SDRPP_MOD_INFO{
     /* Name:            */ "weather_sat_decoder",
     /* Description:     */ "Weather Satellite Decoder for SDR++",
@@ -44,6 +46,13 @@ public:
     WeatherSatDecoderModule(std::string name) {
         this->name = name;
 
+        // Load config
+        config.acquire();
+        if (!config.conf.contains(name)) {
+            config.conf[name] = json({});
+        }
+        config.release();
+
         vfo = sigpath::vfoManager.createVFO(name, ImGui::WaterfallVFO::REF_CENTER, 0, 1000000, 1000000, 1000000, 1000000, true);
 
         decoders["NOAA HRPT"] = new NOAAHRPTDecoder(vfo, name);
@@ -131,7 +140,10 @@ private:
 };
 
 MOD_EXPORT void _INIT_() {
-    // Nothing
+    json def = json({});
+    config.setPath((std::string)core::args["root"] + "/weather_sat_decoder_config.json");
+    config.load(def);
+    config.enableAutoSave();
 }
 
 MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
@@ -143,5 +155,6 @@ MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
 }
 
 MOD_EXPORT void _END_() {
-    // Nothing either
+    config.disableAutoSave();
+    config.save();
 }
\ No newline at end of file
@@ -6,18 +6,39 @@
 #include <dsp/noaa/tip.h>
 #include <dsp/sink.h>
 #include <gui/widgets/symbol_diagram.h>
+#include "avhrr.h"
 #include <gui/widgets/line_push_image.h>
+#include <gui/widgets/folder_select.h>
 #include <gui/gui.h>
+#include <gui/style.h>
+#include <time.h>
 
 #define NOAA_HRPT_VFO_SR 3000000.0f
 #define NOAA_HRPT_VFO_BW 2000000.0f
 
+// Number of image lines kept in memory, about 11 minutes of pass. Older lines are only kept in saved images.
+#define NOAA_HRPT_MAX_LINES 4096
+
 class NOAAHRPTDecoder : public SatDecoder {
 public:
-    NOAAHRPTDecoder(VFOManager::VFO* vfo, std::string name) : avhrrRGBImage(2048, 256), avhrr1Image(2048, 256), avhrr2Image(2048, 256), avhrr3Image(2048, 256), avhrr4Image(2048, 256), avhrr5Image(2048, 256), symDiag(0.5f) {
+    NOAAHRPTDecoder(VFOManager::VFO* vfo, std::string name) : avhrrRGBImage(2048, 256, NOAA_HRPT_MAX_LINES),
+                                                                 avhrr1Image(2048, 256, NOAA_HRPT_MAX_LINES),
+                                                                 avhrr2Image(2048, 256, NOAA_HRPT_MAX_LINES),
+                                                                 avhrr3Image(2048, 256, NOAA_HRPT_MAX_LINES),
+                                                                 avhrr4Image(2048, 256, NOAA_HRPT_MAX_LINES),
+                                                                 avhrr5Image(2048, 256, NOAA_HRPT_MAX_LINES),
+                                                                 symDiag(0.5f),
+                                                                 imageFolder("%ROOT%/recordings") {
         _vfo = vfo;
         _name = name;
 
+        // Load config
+        config.acquire();
+        if (config.conf[name].contains("noaaHrptImagePath")) {
+            imageFolder.setPath(config.conf[name]["noaaHrptImagePath"]);
+        }
+        config.release();
+
         // Core DSP
         demod.init(vfo->output, NOAA_HRPT_VFO_SR, 665400.0f * 2.0f, 0.02e-3, (0.06f * 0.06f) / 2.0f, 32, 0.6f, (0.01f * 0.01f) / 4.0f, 0.01f, 0.005);
 
@@ -31,16 +52,20 @@ public:
         deframe.init(&dataStream, 11090 * 10 * 2, (uint8_t*)dsp::noaa::HRPTSyncWord, 60);
         manDec.init(&deframe.out, false);
         packer.init(&manDec.out);
-        demux.init(&packer.out);
+        frameSplit.init(&packer.out);
+        frameSplit.bindStream(&demuxStream);
+        frameSplit.bindStream(&avhrrStream);
+        demux.init(&demuxStream);
         tipDemux.init(&demux.TIPOut);
         hirsDemux.init(&tipDemux.HIRSOut);
 
-        // All Sinks
-        avhrr1Sink.init(&demux.AVHRRChan1Out, avhrr1Handler, this);
-        avhrr2Sink.init(&demux.AVHRRChan2Out, avhrr2Handler, this);
-        avhrr3Sink.init(&demux.AVHRRChan3Out, avhrr3Handler, this);
-        avhrr4Sink.init(&demux.AVHRRChan4Out, avhrr4Handler, this);
-        avhrr5Sink.init(&demux.AVHRRChan5Out, avhrr5Handler, this);
+        // All Sinks, AVHRR images are generated from the whole frame instead of the demuxed channels
+        avhrrSink.init(&avhrrStream, avhrrHandler, this);
+        avhrr1Sink.init(&demux.AVHRRChan1Out);
+        avhrr2Sink.init(&demux.AVHRRChan2Out);
+        avhrr3Sink.init(&demux.AVHRRChan3Out);
+        avhrr4Sink.init(&demux.AVHRRChan4Out);
+        avhrr5Sink.init(&demux.AVHRRChan5Out);
 
         sbuvSink.init(&tipDemux.SBUVOut);
         dcsSink.init(&tipDemux.DCSOut);
@@ -77,6 +102,7 @@ public:
     };
 
     void start() {
+        imager.resetHistogram();
         demod.start();
 
         split.start();
@@ -86,10 +112,12 @@ public:
         deframe.start();
         manDec.start();
         packer.start();
+        frameSplit.start();
         demux.start();
         tipDemux.start();
         hirsDemux.start();
 
+        avhrrSink.start();
         avhrr1Sink.start();
         avhrr2Sink.start();
         avhrr3Sink.start();
@@ -122,16 +150,9 @@ public:
         hirs18Sink.start();
         hirs19Sink.start();
         hirs20Sink.start();
-
-        compositeThread = std::thread(&NOAAHRPTDecoder::avhrrCompositeWorker, this);
     };
 
     void stop() {
-        compositeIn1.stopReader();
-        compositeIn1.stopWriter();
-        compositeIn2.stopReader();
-        compositeIn2.stopWriter();
-
         demod.stop();
 
         split.stop();
@@ -141,10 +162,12 @@ public:
         deframe.stop();
         manDec.stop();
         packer.stop();
+        frameSplit.stop();
         demux.stop();
         tipDemux.stop();
         hirsDemux.stop();
 
+        avhrrSink.stop();
         avhrr1Sink.stop();
         avhrr2Sink.stop();
         avhrr3Sink.stop();
@@ -177,15 +200,6 @@ public:
         hirs18Sink.stop();
         hirs19Sink.stop();
         hirs20Sink.stop();
-
-        if (compositeThread.joinable()) {
-            compositeThread.join();
-        }
-
-        compositeIn1.clearReadStop();
-        compositeIn1.clearWriteStop();
-        compositeIn2.clearReadStop();
-        compositeIn2.clearWriteStop();
     };
 
     void setVFO(VFOManager::VFO* vfo) {
@@ -194,20 +208,40 @@ public:
     };
 
     virtual bool canRecord() {
-        return false;
+        return true;
     }
 
-    // bool startRecording(std::string recPath) {
-
-    // };
-
-    // void stopRecording() {
-
-    // };
+    bool startRecording(std::string recPath) {
+        _recPath = recPath;
+
+        // Stream each image to its own file as it is decoded
+        char buf[64];
+        time_t now = time(0);
+        tm* ltm = localtime(&now);
+        snprintf(buf, sizeof(buf), "noaa_hrpt_%02d-%02d-%02d_%02d-%02d-%02d", ltm->tm_mday, ltm->tm_mon + 1, ltm->tm_year + 1900, ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
+        std::string prefix = recPath + "/" + buf;
+        bool ok = avhrrRGBImage.save(prefix + "_avhrr_rgb221.png");
+        ok = ok && avhrr1Image.save(prefix + "_avhrr_1.png");
+        ok = ok && avhrr2Image.save(prefix + "_avhrr_2.png");
+        ok = ok && avhrr3Image.save(prefix + "_avhrr_3.png");
+        ok = ok && avhrr4Image.save(prefix + "_avhrr_4.png");
+        ok = ok && avhrr5Image.save(prefix + "_avhrr_5.png");
+        if (!ok) { stopRecording(); }
+        return ok;
+    }
 
-    // bool isRecording() {
+    void stopRecording() {
+        avhrrRGBImage.stopSave();
+        avhrr1Image.stopSave();
+        avhrr2Image.stopSave();
+        avhrr3Image.stopSave();
+        avhrr4Image.stopSave();
+        avhrr5Image.stopSave();
+    }
 
-    // };
+    bool isRecording() {
+        return avhrrRGBImage.isSaving();
+    }
 
     void drawMenu(float menuWidth) {
         ImGui::SetNextItemWidth(menuWidth);
@@ -284,108 +318,53 @@ public:
         }
 
         ImGui::Checkbox("Show Image", &showWindow);
-    };
+        if (ImGui::Checkbox(("Histogram Stretch##_noaa_hrpt_stretch_" + _name).c_str(), &stretch)) {
+            imager.setStretch(stretch);
+        }
 
-private:
-    // AVHRR Data Handlers
-    void avhrrCompositeWorker() {
-        compositeIn1.flush();
-        compositeIn2.flush();
-        while (true) {
-            if (compositeIn1.read() < 0) { return; }
-            if (compositeIn2.read() < 0) { return; }
-
-            uint8_t* buf = avhrrRGBImage.acquireNextLine();
-            float rg, b;
-            for (int i = 0; i < 2048; i++) {
-                b = ((float)compositeIn1.readBuf[i] * 255.0f) / 1024.0f;
-                rg = ((float)compositeIn2.readBuf[i] * 255.0f) / 1024.0f;
-                buf[(i * 4)] = rg;
-                buf[(i * 4) + 1] = rg;
-                buf[(i * 4) + 2] = b;
-                buf[(i * 4) + 3] = 255;
+        // Image saving
+        bool recording = isRecording();
+        if (recording) { style::beginDisabled(); }
+        if (imageFolder.render("##_noaa_hrpt_img_folder_" + _name) && imageFolder.pathIsValid()) {
+            config.acquire();
+            config.conf[_name]["noaaHrptImagePath"] = imageFolder.path;
+            config.release(true);
+        }
+        if (recording) { style::endDisabled(); }
+        if (!recording) {
+            if (!imageFolder.pathIsValid()) { style::beginDisabled(); }
+            if (ImGui::Button(("Save Images##_noaa_hrpt_save_" + _name).c_str(), ImVec2(menuWidth, 0))) {
+                startRecording(imageFolder.expandString(imageFolder.path));
             }
-            avhrrRGBImage.releaseNextLine();
-
-            compositeIn1.flush();
-            compositeIn2.flush();
+            if (!imageFolder.pathIsValid()) { style::endDisabled(); }
         }
-    }
-
-    static void avhrr1Handler(uint16_t* data, int count, void* ctx) {
-        NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
-        uint8_t* buf = _this->avhrr1Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
+        else if (ImGui::Button(("Stop Saving##_noaa_hrpt_save_" + _name).c_str(), ImVec2(menuWidth, 0))) {
+            stopRecording();
         }
-        _this->avhrr1Image.releaseNextLine();
-
-        memcpy(_this->compositeIn1.writeBuf, data, count * sizeof(uint16_t));
-        _this->compositeIn1.swap(count);
-    }
+    };
 
-    static void avhrr2Handler(uint16_t* data, int count, void* ctx) {
+private:
+    // AVHRR Data Handler, produces all channel lines and the composite from a single pass over the frame
+    static void avhrrHandler(uint16_t* data, int count, void* ctx) {
         NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
-        uint8_t* buf = _this->avhrr2Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
-        _this->avhrr2Image.releaseNextLine();
+        if (count < avhrr::FRAME_WORD_COUNT) { return; }
 
-        memcpy(_this->compositeIn2.writeBuf, data, count * sizeof(uint16_t));
-        _this->compositeIn2.swap(count);
-    }
+        uint8_t* channels[avhrr::CHANNEL_COUNT];
+        channels[0] = _this->avhrr1Image.acquireNextLine();
+        channels[1] = _this->avhrr2Image.acquireNextLine();
+        channels[2] = _this->avhrr3Image.acquireNextLine();
+        channels[3] = _this->avhrr4Image.acquireNextLine();
+        channels[4] = _this->avhrr5Image.acquireNextLine();
+        uint8_t* composite = _this->avhrrRGBImage.acquireNextLine();
 
-    static void avhrr3Handler(uint16_t* data, int count, void* ctx) {
-        NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
-        uint8_t* buf = _this->avhrr3Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
-        _this->avhrr3Image.releaseNextLine();
-    }
+        _this->imager.process(data, channels, composite);
 
-    static void avhrr4Handler(uint16_t* data, int count, void* ctx) {
-        NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
-        uint8_t* buf = _this->avhrr4Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
+        _this->avhrr1Image.releaseNextLine();
+        _this->avhrr2Image.releaseNextLine();
+        _this->avhrr3Image.releaseNextLine();
         _this->avhrr4Image.releaseNextLine();
-    }
-
-    static void avhrr5Handler(uint16_t* data, int count, void* ctx) {
-        NOAAHRPTDecoder* _this = (NOAAHRPTDecoder*)ctx;
-        uint8_t* buf = _this->avhrr5Image.acquireNextLine();
-        float val;
-        for (int i = 0; i < 2048; i++) {
-            val = ((float)data[i] * 255.0f) / 1024.0f;
-            buf[(i * 4)] = val;
-            buf[(i * 4) + 1] = val;
-            buf[(i * 4) + 2] = val;
-            buf[(i * 4) + 3] = 255;
-        }
         _this->avhrr5Image.releaseNextLine();
+        _this->avhrrRGBImage.releaseNextLine();
     }
 
     // HIRS Data Handlers
@@ -491,16 +470,20 @@ private:
     dsp::ManchesterDeframer deframe;
     dsp::ManchesterDecoder manDec;
     dsp::BitPacker packer;
+    dsp::stream<uint16_t> demuxStream;
+    dsp::stream<uint16_t> avhrrStream;
+    dsp::Splitter<uint16_t> frameSplit;
     dsp::noaa::HRPTDemux demux;
     dsp::noaa::TIPDemux tipDemux;
     dsp::noaa::HIRSDemux hirsDemux;
 
-    // AHVRR Handlers
-    dsp::HandlerSink<uint16_t> avhrr1Sink;
-    dsp::HandlerSink<uint16_t> avhrr2Sink;
-    dsp::HandlerSink<uint16_t> avhrr3Sink;
-    dsp::HandlerSink<uint16_t> avhrr4Sink;
-    dsp::HandlerSink<uint16_t> avhrr5Sink;
+    // AHVRR Handlers, the demuxed channels are unused
+    dsp::HandlerSink<uint16_t> avhrrSink;
+    dsp::NullSink<uint16_t> avhrr1Sink;
+    dsp::NullSink<uint16_t> avhrr2Sink;
+    dsp::NullSink<uint16_t> avhrr3Sink;
+    dsp::NullSink<uint16_t> avhrr4Sink;
+    dsp::NullSink<uint16_t> avhrr5Sink;
 
     // (at the moment) Unused TIP handlers
     dsp::NullSink<uint8_t> sbuvSink;
@@ -542,10 +525,10 @@ private:
     ImGui::LinePushImage avhrr5Image;
 
     ImGui::SymbolDiagram symDiag;
+    FolderSelect imageFolder;
 
-    dsp::stream<uint16_t> compositeIn1;
-    dsp::stream<uint16_t> compositeIn2;
-    std::thread compositeThread;
+    avhrr::Imager imager;
+    bool stretch = false;
 
     bool showWindow = false;
 };
\ No newline at end of file
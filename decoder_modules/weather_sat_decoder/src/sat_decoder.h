@@ -1,6 +1,9 @@
 #pragma once
 #include <string>
 #include <signal_path/vfo_manager.h>
+#include <config.h>
+
+extern ConfigManager config;
 
 class SatDecoder {
 public:
@@ -92,6 +92,8 @@ cp $build_dir/misc_modules/frequency_manager/Release/frequency_manager.dll sdrpp
 
 cp $build_dir/misc_modules/iq_exporter/Release/iq_exporter.dll sdrpp_windows_x64/modules/
 
+cp $build_dir/misc_modules/message_output/Release/message_output.dll sdrpp_windows_x64/modules/
+
 cp $build_dir/misc_modules/recorder/Release/recorder.dll sdrpp_windows_x64/modules/
 
 cp $build_dir/misc_modules/rigctl_client/Release/rigctl_client.dll sdrpp_windows_x64/modules/
@@ -0,0 +1,603 @@
+#include "bookmark_db.h"
+#include <json.hpp>
+#include <utils/flog.h>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+using nlohmann::json;
+
+// File header, followed by records made of a 32bit length and that many bytes
+#define BOOKMARK_DB_MAGIC       "SDRPPBKM"
+#define BOOKMARK_DB_MAGIC_LEN   8
+#define BOOKMARK_DB_VERSION     1
+#define BOOKMARK_DB_HEADER_LEN  (BOOKMARK_DB_MAGIC_LEN + 4)
+
+// Don't bother compacting small files
+#define BOOKMARK_DB_MIN_GARBAGE 1024
+
+namespace {
+    // Bounds checked reader for the record payloads
+    class RecordReader {
+    public:
+        RecordReader(const uint8_t* data, size_t len) : data(data), len(len) {}
+
+        template <class T>
+        bool get(T& val) {
+            if (len - pos < sizeof(T)) { return false; }
+            memcpy(&val, &data[pos], sizeof(T));
+            pos += sizeof(T);
+            return true;
+        }
+
+        bool getString(std::string& str) {
+            uint16_t strLen;
+            if (!get(strLen) || len - pos < strLen) { return false; }
+            str.assign((const char*)&data[pos], strLen);
+            pos += strLen;
+            return true;
+        }
+
+        bool getBookmark(FrequencyBookmark& bm) {
+            int32_t mode;
+            if (!get(bm.frequency) || !get(bm.bandwidth) || !get(mode)) { return false; }
+            bm.mode = mode;
+            bm.selected = false;
+            return true;
+        }
+
+    private:
+        const uint8_t* data;
+        size_t len;
+        size_t pos = 0;
+    };
+
+    // SAX handler picking the bookmarks out of an export file as they are parsed
+    class ImportHandler : public nlohmann::json_sax<json> {
+    public:
+        ImportHandler(std::function<void(const std::string&, const FrequencyBookmark&)> handler) : handler(handler) {}
+
+        bool null() { return true; }
+        bool boolean(bool val) { return true; }
+        bool number_integer(number_integer_t val) { return number((double)val); }
+        bool number_unsigned(number_unsigned_t val) { return number((double)val); }
+        bool number_float(number_float_t val, const string_t& s) { return number((double)val); }
+        bool string(string_t& val) { return true; }
+        bool binary(binary_t& val) { return true; }
+        bool start_array(std::size_t elements) { depth++; return true; }
+        bool end_array() { depth--; return true; }
+
+        bool start_object(std::size_t elements) {
+            if (depth == 1 && key1 == "bookmarks") {
+                inBookmarks = true;
+                foundBookmarks = true;
+            }
+            if (depth == 2 && inBookmarks) {
+                fields = 0;
+                bm.selected = false;
+            }
+            depth++;
+            return true;
+        }
+
+        bool end_object() {
+            depth--;
+            if (depth == 2 && inBookmarks) {
+                if (fields == FIELD_ALL) {
+                    handler(name, bm);
+                }
+                else {
+                    flog::warn("Bookmark '{}' is missing attributes, skipping", name);
+                }
+            }
+            if (depth == 1) { inBookmarks = false; }
+            return true;
+        }
+
+        bool key(string_t& val) {
+            if (depth == 1) { key1 = val; }
+            else if (depth == 2 && inBookmarks) { name = val; }
+            else if (depth == 3 && inBookmarks) { field = val; }
+            return true;
+        }
+
+        bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::detail::exception& ex) {
+            flog::error("Error while parsing bookmarks: {}", ex.what());
+            return false;
+        }
+
+        bool foundBookmarks = false;
+
+    private:
+        enum {
+            FIELD_FREQUENCY = (1 << 0),
+            FIELD_BANDWIDTH = (1 << 1),
+            FIELD_MODE = (1 << 2),
+            FIELD_ALL = FIELD_FREQUENCY | FIELD_BANDWIDTH | FIELD_MODE
+        };
+
+        bool number(double val) {
+            if (depth != 3 || !inBookmarks) { return true; }
+            if (field == "frequency") {
+                bm.frequency = val;
+                fields |= FIELD_FREQUENCY;
+            }
+            else if (field == "bandwidth") {
+                bm.bandwidth = val;
+                fields |= FIELD_BANDWIDTH;
+            }
+            else if (field == "mode") {
+                bm.mode = (int)val;
+                fields |= FIELD_MODE;
+            }
+            return true;
+        }
+
+        std::function<void(const std::string&, const FrequencyBookmark&)> handler;
+        int depth = 0;
+        bool inBookmarks = false;
+        std::string key1;
+        std::string name;
+        std::string field;
+        FrequencyBookmark bm;
+        int fields = 0;
+    };
+
+    // Split a CSV line, handling quoted fields
+    void splitCSV(const std::string& line, std::vector<std::string>& fields) {
+        fields.clear();
+        std::string field;
+        bool quoted = false;
+        for (int i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    field += '"';
+                    i++;
+                }
+                else if (c == '"') {
+                    quoted = false;
+                }
+                else {
+                    field += c;
+                }
+            }
+            else if (c == '"') {
+                quoted = true;
+            }
+            else if (c == ',') {
+                fields.push_back(field);
+                field.clear();
+            }
+            else if (c != '\r') {
+                field += c;
+            }
+        }
+        fields.push_back(field);
+    }
+
+    bool parseNumber(const std::string& str, double& val) {
+        const char* start = str.c_str();
+        char* end;
+        val = strtod(start, &end);
+        if (end == start) { return false; }
+        while (isspace(*end)) { end++; }
+        return *end == 0;
+    }
+
+    std::string toLower(const std::string& str) {
+        std::string low = str;
+        std::transform(low.begin(), low.end(), low.begin(), [](unsigned char c) { return tolower(c); });
+        return low;
+    }
+
+    bool parseMode(const std::string& str, int& mode) {
+        double val;
+        if (parseNumber(str, val)) {
+            mode = (int)val;
+            return (mode >= 0 && mode < 8);
+        }
+        std::string low = toLower(str);
+        for (int i = 0; i < 8; i++) {
+            if (low == toLower(demodModeList[i])) {
+                mode = i;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+BookmarkDB::~BookmarkDB() {
+    close();
+}
+
+bool BookmarkDB::open(const std::string& path) {
+    close();
+    this->path = path;
+    lists.clear();
+    recordCount = 0;
+    liveCount = 0;
+
+    // Read the whole log and replay it
+    if (std::filesystem::exists(path)) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        uint32_t version = 0;
+        if (data.size() >= BOOKMARK_DB_HEADER_LEN) { memcpy(&version, &data[BOOKMARK_DB_MAGIC_LEN], sizeof(uint32_t)); }
+        if (data.size() < BOOKMARK_DB_HEADER_LEN || memcmp(data.data(), BOOKMARK_DB_MAGIC, BOOKMARK_DB_MAGIC_LEN) || version != BOOKMARK_DB_VERSION) {
+            flog::error("Bookmark database '{}' is invalid, moving it to '{}.bad' and starting over", path, path);
+            std::filesystem::rename(path, path + ".bad");
+        }
+        else {
+            // Drop a record that was cut short
+            size_t valid = BOOKMARK_DB_HEADER_LEN + replay(&data[BOOKMARK_DB_HEADER_LEN], data.size() - BOOKMARK_DB_HEADER_LEN);
+            if (valid != data.size()) {
+                flog::warn("Bookmark database '{}' has {} bytes of incomplete records, dropping them", path, data.size() - valid);
+                std::filesystem::resize_file(path, valid);
+            }
+        }
+    }
+    if (!std::filesystem::exists(path)) {
+        std::ofstream out(path, std::ios::binary);
+        uint32_t version = BOOKMARK_DB_VERSION;
+        out.write(BOOKMARK_DB_MAGIC, BOOKMARK_DB_MAGIC_LEN);
+        out.write((const char*)&version, sizeof(uint32_t));
+        out.close();
+    }
+
+    if (recordCount - liveCount > std::max<int64_t>(liveCount, BOOKMARK_DB_MIN_GARBAGE)) {
+        compact();
+    }
+
+    file.open(path, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        flog::error("Could not open bookmark database '{}' for writing", path);
+        return false;
+    }
+    return true;
+}
+
+void BookmarkDB::close() {
+    if (!file.is_open()) { return; }
+    file.close();
+    if (recordCount - liveCount > std::max<int64_t>(liveCount, BOOKMARK_DB_MIN_GARBAGE)) {
+        compact();
+    }
+}
+
+bool BookmarkDB::listExists(const std::string& list) {
+    return lists.find(list) != lists.end();
+}
+
+void BookmarkDB::createList(const std::string& list, bool showOnWaterfall) {
+    if (listExists(list)) { return; }
+    lists[list].showOnWaterfall = showOnWaterfall;
+    liveCount++;
+    append(listRecord(list, showOnWaterfall));
+}
+
+void BookmarkDB::deleteList(const std::string& list) {
+    auto it = lists.find(list);
+    if (it == lists.end()) { return; }
+    liveCount -= 1 + it->second.bookmarks.size();
+    lists.erase(it);
+
+    std::string rec(1, RECORD_TYPE_DELETE_LIST);
+    putString(rec, list);
+    append(rec);
+}
+
+void BookmarkDB::renameList(const std::string& list, const std::string& newName) {
+    auto it = lists.find(list);
+    if (it == lists.end() || listExists(newName)) { return; }
+    lists[newName] = std::move(it->second);
+    lists.erase(it);
+
+    std::string rec(1, RECORD_TYPE_RENAME_LIST);
+    putString(rec, list);
+    putString(rec, newName);
+    append(rec);
+}
+
+void BookmarkDB::setListShown(const std::string& list, bool showOnWaterfall) {
+    auto it = lists.find(list);
+    if (it == lists.end()) { return; }
+    it->second.showOnWaterfall = showOnWaterfall;
+
+    std::string rec(1, RECORD_TYPE_SHOW_LIST);
+    putString(rec, list);
+    rec += (char)showOnWaterfall;
+    append(rec);
+}
+
+void BookmarkDB::setBookmark(const std::string& list, const std::string& name, const FrequencyBookmark& bm) {
+    auto it = lists.find(list);
+    if (it == lists.end()) { return; }
+    auto& bookmarks = it->second.bookmarks;
+    if (bookmarks.find(name) == bookmarks.end()) { liveCount++; }
+    FrequencyBookmark& stored = bookmarks[name];
+    stored = bm;
+    stored.selected = false;
+    append(bookmarkRecord(list, name, bm));
+}
+
+void BookmarkDB::removeBookmark(const std::string& list, const std::string& name) {
+    auto it = lists.find(list);
+    if (it == lists.end() || !it->second.bookmarks.erase(name)) { return; }
+    liveCount--;
+
+    std::string rec(1, RECORD_TYPE_REMOVE_BOOKMARK);
+    putString(rec, list);
+    putString(rec, name);
+    append(rec);
+}
+
+void BookmarkDB::search(const std::string& list, const std::string& query, std::vector<std::string>& names) {
+    names.clear();
+    auto it = lists.find(list);
+    if (it == lists.end()) { return; }
+    auto& bookmarks = it->second.bookmarks;
+
+    if (query.empty()) {
+        names.reserve(bookmarks.size());
+        for (auto const& [name, bm] : bookmarks) { names.push_back(name); }
+        return;
+    }
+
+    // Exact prefix matches are contiguous in the map
+    for (auto bit = bookmarks.lower_bound(query); bit != bookmarks.end() && bit->first.compare(0, query.size(), query) == 0; bit++) {
+        names.push_back(bit->first);
+    }
+
+    // Then everything else containing the query, ignoring case
+    std::string lowQuery = toLower(query);
+    for (auto const& [name, bm] : bookmarks) {
+        if (name.compare(0, query.size(), query) == 0) { continue; }
+        if (toLower(name).find(lowQuery) != std::string::npos) { names.push_back(name); }
+    }
+}
+
+int BookmarkDB::importJSON(const std::string& path, const std::string& list) {
+    if (!listExists(list)) { return -1; }
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        flog::error("Could not open '{}'", path);
+        return -1;
+    }
+
+    int count = 0;
+    ImportHandler handler([&](const std::string& name, const FrequencyBookmark& bm) {
+        if (addImported(list, name, bm)) { count++; }
+    });
+    beginBatch();
+    json::sax_parse(in, &handler);
+    endBatch();
+
+    if (!handler.foundBookmarks) {
+        flog::error("File does not contains any bookmarks");
+        return -1;
+    }
+    return count;
+}
+
+int BookmarkDB::importCSV(const std::string& path, const std::string& list) {
+    if (!listExists(list)) { return -1; }
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        flog::error("Could not open '{}'", path);
+        return -1;
+    }
+
+    int count = 0;
+    int lineNum = 0;
+    std::string line;
+    std::vector<std::string> fields;
+    beginBatch();
+    while (std::getline(in, line)) {
+        lineNum++;
+        splitCSV(line, fields);
+        if (fields.size() == 1 && fields[0].empty()) { continue; }
+
+        FrequencyBookmark bm;
+        bm.bandwidth = 0;
+        bm.mode = 7;
+        bm.selected = false;
+        if (fields.size() < 2 || !parseNumber(fields[1], bm.frequency)) {
+            if (lineNum > 1) { flog::warn("Invalid frequency on line {} of '{}', skipping", lineNum, path); }
+            continue;
+        }
+        if (fields.size() > 2 && !fields[2].empty() && !parseNumber(fields[2], bm.bandwidth)) {
+            flog::warn("Invalid bandwidth on line {} of '{}', skipping", lineNum, path);
+            continue;
+        }
+        if (fields.size() > 3 && !fields[3].empty() && !parseMode(fields[3], bm.mode)) {
+            flog::warn("Invalid mode on line {} of '{}', skipping", lineNum, path);
+            continue;
+        }
+        if (addImported(list, fields[0], bm)) { count++; }
+    }
+    endBatch();
+    return count;
+}
+
+bool BookmarkDB::exportJSON(const std::string& path, const std::string& list, const std::vector<std::string>& names) {
+    auto it = lists.find(list);
+    if (it == lists.end()) { return false; }
+
+    json exported = json::object();
+    exported["bookmarks"] = json::object();
+    for (auto const& name : names) {
+        auto bit = it->second.bookmarks.find(name);
+        if (bit == it->second.bookmarks.end()) { continue; }
+        exported["bookmarks"][name]["frequency"] = bit->second.frequency;
+        exported["bookmarks"][name]["bandwidth"] = bit->second.bandwidth;
+        exported["bookmarks"][name]["mode"] = bit->second.mode;
+    }
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        flog::error("Could not open '{}'", path);
+        return false;
+    }
+    out << exported;
+    out.close();
+    return true;
+}
+
+void BookmarkDB::beginBatch() {
+    batch = true;
+}
+
+bool BookmarkDB::endBatch() {
+    batch = false;
+    if (!file.is_open()) { return false; }
+    file.flush();
+    return file.good();
+}
+
+void BookmarkDB::compact() {
+    bool wasOpen = file.is_open();
+    if (wasOpen) { file.close(); }
+
+    // Write the live records to a temporary file and swap it in, so that a crash leaves either the old or the new one
+    std::string tmpPath = path + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    uint32_t version = BOOKMARK_DB_VERSION;
+    out.write(BOOKMARK_DB_MAGIC, BOOKMARK_DB_MAGIC_LEN);
+    out.write((const char*)&version, sizeof(uint32_t));
+    std::string rec;
+    for (auto const& [listName, list] : lists) {
+        rec = listRecord(listName, list.showOnWaterfall);
+        uint32_t len = rec.size();
+        out.write((const char*)&len, sizeof(uint32_t));
+        out.write(rec.data(), rec.size());
+        for (auto const& [name, bm] : list.bookmarks) {
+            rec = bookmarkRecord(listName, name, bm);
+            len = rec.size();
+            out.write((const char*)&len, sizeof(uint32_t));
+            out.write(rec.data(), rec.size());
+        }
+    }
+    out.close();
+
+    if (out.fail()) {
+        flog::error("Could not compact bookmark database '{}'", path);
+        std::filesystem::remove(tmpPath);
+    }
+    else {
+        std::filesystem::rename(tmpPath, path);
+        recordCount = liveCount;
+    }
+
+    if (wasOpen) { file.open(path, std::ios::binary | std::ios::app); }
+}
+
+size_t BookmarkDB::replay(const uint8_t* data, size_t len) {
+    size_t pos = 0;
+    std::string list, name, newName;
+    FrequencyBookmark bm;
+    while (len - pos >= sizeof(uint32_t)) {
+        uint32_t recLen;
+        memcpy(&recLen, &data[pos], sizeof(uint32_t));
+        if (recLen == 0 || len - pos - sizeof(uint32_t) < recLen) { break; }
+        RecordReader rd(&data[pos + sizeof(uint32_t)], recLen);
+        pos += sizeof(uint32_t) + recLen;
+        recordCount++;
+
+        uint8_t type;
+        rd.get(type);
+        if (type == RECORD_TYPE_CREATE_LIST) {
+            uint8_t shown;
+            if (!rd.getString(list) || !rd.get(shown)) { continue; }
+            if (!listExists(list)) { liveCount++; }
+            lists[list].showOnWaterfall = shown;
+        }
+        else if (type == RECORD_TYPE_DELETE_LIST) {
+            if (!rd.getString(list)) { continue; }
+            auto it = lists.find(list);
+            if (it == lists.end()) { continue; }
+            liveCount -= 1 + it->second.bookmarks.size();
+            lists.erase(it);
+        }
+        else if (type == RECORD_TYPE_RENAME_LIST) {
+            if (!rd.getString(list) || !rd.getString(newName)) { continue; }
+            auto it = lists.find(list);
+            if (it == lists.end() || listExists(newName)) { continue; }
+            lists[newName] = std::move(it->second);
+            lists.erase(it);
+        }
+        else if (type == RECORD_TYPE_SHOW_LIST) {
+            uint8_t shown;
+            if (!rd.getString(list) || !rd.get(shown)) { continue; }
+            auto it = lists.find(list);
+            if (it != lists.end()) { it->second.showOnWaterfall = shown; }
+        }
+        else if (type == RECORD_TYPE_SET_BOOKMARK) {
+            if (!rd.getString(list) || !rd.getString(name) || !rd.getBookmark(bm)) { continue; }
+            auto it = lists.find(list);
+            if (it == lists.end()) { continue; }
+            auto& bookmarks = it->second.bookmarks;
+            if (bookmarks.find(name) == bookmarks.end()) { liveCount++; }
+            bookmarks[name] = bm;
+        }
+        else if (type == RECORD_TYPE_REMOVE_BOOKMARK) {
+            if (!rd.getString(list) || !rd.getString(name)) { continue; }
+            auto it = lists.find(list);
+            if (it != lists.end() && it->second.bookmarks.erase(name)) { liveCount--; }
+        }
+    }
+    return pos;
+}
+
+void BookmarkDB::append(const std::string& record) {
+    recordCount++;
+    if (!file.is_open()) { return; }
+    uint32_t len = record.size();
+    file.write((const char*)&len, sizeof(uint32_t));
+    file.write(record.data(), record.size());
+    if (!batch) { file.flush(); }
+}
+
+bool BookmarkDB::addImported(const std::string& list, const std::string& name, const FrequencyBookmark& bm) {
+    auto& bookmarks = lists[list].bookmarks;
+    if (bookmarks.find(name) != bookmarks.end()) {
+        flog::warn("Bookmark with the name '{0}' already exists in list, skipping", name);
+        return false;
+    }
+    setBookmark(list, name, bm);
+    return true;
+}
+
+void BookmarkDB::putString(std::string& rec, const std::string& str) {
+    uint16_t len = std::min<size_t>(str.size(), UINT16_MAX);
+    rec.append((const char*)&len, sizeof(uint16_t));
+    rec.append(str.data(), len);
+}
+
+void BookmarkDB::putBookmark(std::string& rec, const FrequencyBookmark& bm) {
+    int32_t mode = bm.mode;
+    rec.append((const char*)&bm.frequency, sizeof(double));
+    rec.append((const char*)&bm.bandwidth, sizeof(double));
+    rec.append((const char*)&mode, sizeof(int32_t));
+}
+
+std::string BookmarkDB::listRecord(const std::string& list, bool showOnWaterfall) {
+    std::string rec(1, RECORD_TYPE_CREATE_LIST);
+    putString(rec, list);
+    rec += (char)showOnWaterfall;
+    return rec;
+}
+
+std::string BookmarkDB::bookmarkRecord(const std::string& list, const std::string& name, const FrequencyBookmark& bm) {
+    std::string rec(1, RECORD_TYPE_SET_BOOKMARK);
+    putString(rec, list);
+    putString(rec, name);
+    putBookmark(rec, bm);
+    return rec;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <string>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+extern const char* demodModeList[8];
+
+struct FrequencyBookmark {
+    double frequency;
+    double bandwidth;
+    int mode;
+    bool selected;
+};
+
+/**
+ * Bookmark store of the frequency manager.
+ * The lists are held in memory and persisted to an append-only log of binary records, so that adding, editing or
+ * removing a bookmark writes a few dozen bytes instead of re-serializing every list. The log is replayed on open and
+ * rewritten (to a temporary file renamed over the old one) once it holds more overwritten records than live ones.
+ * A record torn by a crash is dropped on the next open. Not thread safe, meant to be used from the UI thread only.
+*/
+class BookmarkDB {
+public:
+    struct List {
+        bool showOnWaterfall = true;
+        std::map<std::string, FrequencyBookmark> bookmarks;
+    };
+
+    ~BookmarkDB();
+
+    /**
+     * Open a database, creating it if it doesn't exist.
+     * @param path Path of the database file.
+     * @return True on success.
+    */
+    bool open(const std::string& path);
+
+    /**
+     * Close the database, compacting it first if worth it.
+    */
+    void close();
+
+    const std::map<std::string, List>& getLists() { return lists; }
+    bool listExists(const std::string& list);
+    void createList(const std::string& list, bool showOnWaterfall = true);
+    void deleteList(const std::string& list);
+    void renameList(const std::string& list, const std::string& newName);
+    void setListShown(const std::string& list, bool showOnWaterfall);
+
+    /**
+     * Add a bookmark or replace an existing one.
+     * @param list Name of the list, must exist.
+     * @param name Name of the bookmark.
+     * @param bm Bookmark.
+    */
+    void setBookmark(const std::string& list, const std::string& name, const FrequencyBookmark& bm);
+    void removeBookmark(const std::string& list, const std::string& name);
+
+    /**
+     * Find bookmarks by name. Names starting with the query come first (found with a binary search), followed by the
+     * names containing it anywhere, ignoring case.
+     * @param list Name of the list.
+     * @param query Text to search for, an empty query returns every bookmark.
+     * @param names Receives the names of the matching bookmarks.
+    */
+    void search(const std::string& list, const std::string& query, std::vector<std::string>& names);
+
+    /**
+     * Import bookmarks from a JSON export without loading the whole document, existing names are skipped.
+     * @param path Path of the JSON file.
+     * @param list Name of the destination list.
+     * @return Number of bookmarks imported, -1 on error.
+    */
+    int importJSON(const std::string& path, const std::string& list);
+
+    /**
+     * Import bookmarks from a CSV file with name, frequency, bandwidth and mode columns, existing names are skipped.
+     * The mode is either a number or a demodulator name. A first line not starting with a frequency is taken as a header.
+     * @param path Path of the CSV file.
+     * @param list Name of the destination list.
+     * @return Number of bookmarks imported, -1 on error.
+    */
+    int importCSV(const std::string& path, const std::string& list);
+
+    /**
+     * Export bookmarks in the JSON format understood by importJSON().
+     * @param path Path of the JSON file.
+     * @param list Name of the list.
+     * @param names Names of the bookmarks to export.
+     * @return True on success.
+    */
+    bool exportJSON(const std::string& path, const std::string& list, const std::vector<std::string>& names);
+
+    /**
+     * Stop flushing the file after every record, for bulk changes. Must be followed by endBatch().
+    */
+    void beginBatch();
+
+    /**
+     * Flush the records written since beginBatch().
+     * @return True if the database is open and every record so far reached the file.
+    */
+    bool endBatch();
+
+    /**
+     * Rewrite the file with only the live records.
+    */
+    void compact();
+
+private:
+    enum RecordType {
+        RECORD_TYPE_CREATE_LIST,
+        RECORD_TYPE_DELETE_LIST,
+        RECORD_TYPE_RENAME_LIST,
+        RECORD_TYPE_SHOW_LIST,
+        RECORD_TYPE_SET_BOOKMARK,
+        RECORD_TYPE_REMOVE_BOOKMARK
+    };
+
+    size_t replay(const uint8_t* data, size_t len);
+    void append(const std::string& record);
+    bool addImported(const std::string& list, const std::string& name, const FrequencyBookmark& bm);
+
+    static void putString(std::string& rec, const std::string& str);
+    static void putBookmark(std::string& rec, const FrequencyBookmark& bm);
+    static std::string listRecord(const std::string& list, bool showOnWaterfall);
+    static std::string bookmarkRecord(const std::string& list, const std::string& name, const FrequencyBookmark& bm);
+
+    std::string path;
+    std::ofstream file;
+    std::map<std::string, List> lists;
+
+    // Records in the file and records a compaction would write, used to tell when compacting is worth it
+    int64_t recordCount = 0;
+    int64_t liveCount = 0;
+
+    bool batch = false;
+};
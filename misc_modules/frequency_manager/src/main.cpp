@@ -13,6 +13,9 @@
 #include <utils/freq_formatting.h>
 #include <gui/dialogs/dialog_box.h>
 #include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include "bookmark_db.h"
 
 SDRPP_MOD_INFO{
     /* Name:            */ "frequency_manager",
@@ -22,22 +25,26 @@ SDRPP_MOD_INFO{
     /* Max instances    */ 1
 };
 
-struct FrequencyBookmark {
-    double frequency;
-    double bandwidth;
-    int mode;
-    bool selected;
-};
-
 struct WaterfallBookmark {
     std::string listName;
     std::string bookmarkName;
     FrequencyBookmark bookmark;
+    float nameWidth;
+};
+
+// Label drawn on the FFT, either a single bookmark or a cluster of bookmarks too close to tell apart
+struct BookmarkLabel {
+    int first;
+    int count;
+    double centerXpos;
+    std::string text;
+    ImVec2 textSize;
 };
 
 ConfigManager config;
+BookmarkDB bookmarkDB;
 
-const char* demodModeList[] = {
+const char* demodModeList[8] = {
     "NFM",
     "WFM",
     "AM",
@@ -177,10 +184,12 @@ private:
                 // If editing, delete the original one
                 if (editOpen) {
                     bookmarks.erase(firstEditedBookmarkName);
+                    bookmarkDB.removeBookmark(selectedListName, firstEditedBookmarkName);
                 }
                 bookmarks[editedBookmarkName] = editedBookmark;
+                bookmarkDB.setBookmark(selectedListName, editedBookmarkName, editedBookmark);
 
-                saveByName(selectedListName);
+                bookmarksChanged();
             }
             if (applyDisabled) { style::endDisabled(); }
             ImGui::SameLine();
@@ -217,17 +226,13 @@ private:
             if (ImGui::Button("Apply")) {
                 open = false;
 
-                config.acquire();
                 if (renameListOpen) {
-                    config.conf["lists"][editedListName] = config.conf["lists"][firstEditedListName];
-                    config.conf["lists"].erase(firstEditedListName);
+                    bookmarkDB.renameList(firstEditedListName, editedListName);
                 }
                 else {
-                    config.conf["lists"][editedListName]["showOnWaterfall"] = true;
-                    config.conf["lists"][editedListName]["bookmarks"] = json::object();
+                    bookmarkDB.createList(editedListName);
                 }
-                refreshWaterfallBookmarks(false);
-                config.release(true);
+                refreshWaterfallBookmarks();
                 refreshLists();
                 loadByName(editedListName);
             }
@@ -252,14 +257,11 @@ private:
         bool open = true;
 
         if (ImGui::BeginPopup(id.c_str(), ImGuiWindowFlags_NoResize)) {
-            // No need to lock config since we're not modifying anything and there's only one instance
-            for (auto [listName, list] : config.conf["lists"].items()) {
-                bool shown = list["showOnWaterfall"];
+            for (auto const& [listName, list] : bookmarkDB.getLists()) {
+                bool shown = list.showOnWaterfall;
                 if (ImGui::Checkbox((listName + "##freq_manager_sel_list_").c_str(), &shown)) {
-                    config.acquire();
-                    config.conf["lists"][listName]["showOnWaterfall"] = shown;
-                    refreshWaterfallBookmarks(false);
-                    config.release(true);
+                    bookmarkDB.setListShown(listName, shown);
+                    refreshWaterfallBookmarks();
                 }
             }
 
@@ -275,32 +277,86 @@ private:
         listNames.clear();
         listNamesTxt = "";
 
-        config.acquire();
-        for (auto [_name, list] : config.conf["lists"].items()) {
+        for (auto const& [_name, list] : bookmarkDB.getLists()) {
             listNames.push_back(_name);
             listNamesTxt += _name;
             listNamesTxt += '\0';
         }
-        config.release();
     }
 
-    void refreshWaterfallBookmarks(bool lockConfig = true) {
-        if (lockConfig) { config.acquire(); }
+    void refreshWaterfallBookmarks() {
         waterfallBookmarks.clear();
-        for (auto [listName, list] : config.conf["lists"].items()) {
-            if (!((bool)list["showOnWaterfall"])) { continue; }
+        for (auto const& [listName, list] : bookmarkDB.getLists()) {
+            if (!list.showOnWaterfall) { continue; }
             WaterfallBookmark wbm;
             wbm.listName = listName;
-            for (auto [bookmarkName, bm] : config.conf["lists"][listName]["bookmarks"].items()) {
+            for (auto const& [bookmarkName, bm] : list.bookmarks) {
                 wbm.bookmarkName = bookmarkName;
-                wbm.bookmark.frequency = config.conf["lists"][listName]["bookmarks"][bookmarkName]["frequency"];
-                wbm.bookmark.bandwidth = config.conf["lists"][listName]["bookmarks"][bookmarkName]["bandwidth"];
-                wbm.bookmark.mode = config.conf["lists"][listName]["bookmarks"][bookmarkName]["mode"];
+                wbm.bookmark = bm;
                 wbm.bookmark.selected = false;
                 waterfallBookmarks.push_back(wbm);
             }
         }
-        if (lockConfig) { config.release(); }
+
+        // Sort by frequency so that the visible bookmarks can be found with a binary search
+        std::stable_sort(waterfallBookmarks.begin(), waterfallBookmarks.end(), [](const WaterfallBookmark& a, const WaterfallBookmark& b) {
+            return a.bookmark.frequency < b.bookmark.frequency;
+        });
+        labelFontSize = 0.0f;
+    }
+
+    /**
+     * Build the labels of the bookmarks visible on the FFT.
+     * Only the bookmarks within the visible range (plus half a label) are looked at. Bookmarks closer together than
+     * CLUSTER_DISTANCE pixels are merged into a single label giving their count, so that the number of labels is bounded
+     * by the width of the FFT no matter how many bookmarks there are.
+    */
+    void updateVisibleLabels(double lowFreq, double highFreq, double freqToPixelRatio, float minX) {
+        visibleLabels.clear();
+        if (waterfallBookmarks.empty()) { return; }
+
+        // Measure the names once, and again only if the font changes
+        float fontSize = ImGui::GetFontSize();
+        if (fontSize != labelFontSize) {
+            maxNameWidth = 0.0f;
+            for (auto& bm : waterfallBookmarks) {
+                bm.nameWidth = ImGui::CalcTextSize(bm.bookmarkName.c_str()).x;
+                maxNameWidth = std::max<float>(maxNameWidth, bm.nameWidth);
+            }
+            labelFontSize = fontSize;
+        }
+
+        auto freqLess = [](const WaterfallBookmark& bm, double freq) { return bm.bookmark.frequency < freq; };
+        double margin = ((maxNameWidth / 2.0) + 5.0) / freqToPixelRatio;
+        double clusterFreq = (CLUSTER_DISTANCE * style::uiScale) / freqToPixelRatio;
+        int count = waterfallBookmarks.size();
+        int i = std::lower_bound(waterfallBookmarks.begin(), waterfallBookmarks.end(), lowFreq - margin, freqLess) - waterfallBookmarks.begin();
+        while (i < count && waterfallBookmarks[i].bookmark.frequency <= highFreq + margin) {
+            // Everything within the cluster distance of this bookmark goes into the same label
+            double freq = waterfallBookmarks[i].bookmark.frequency;
+            int end = std::lower_bound(waterfallBookmarks.begin() + i + 1, waterfallBookmarks.end(), freq + clusterFreq, freqLess) - waterfallBookmarks.begin();
+
+            BookmarkLabel label;
+            label.first = i;
+            label.count = end - i;
+            label.centerXpos = minX + std::round((freq - lowFreq) * freqToPixelRatio);
+            if (label.count == 1) {
+                label.text = waterfallBookmarks[i].bookmarkName;
+                label.textSize = ImVec2(waterfallBookmarks[i].nameWidth, fontSize);
+            }
+            else {
+                label.text = std::to_string(label.count) + " bookmarks";
+                label.textSize = ImGui::CalcTextSize(label.text.c_str());
+            }
+            visibleLabels.push_back(label);
+            i = end;
+        }
+    }
+
+    void getLabelRect(const BookmarkLabel& label, ImVec2 min, ImVec2 max, ImVec2& rectMin, ImVec2& rectMax) {
+        float top = (bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) ? (max.y - label.textSize.y) : min.y;
+        rectMin = ImVec2(label.centerXpos - (label.textSize.x / 2) - 5, top);
+        rectMax = ImVec2(label.centerXpos + (label.textSize.x / 2) + 5, top + label.textSize.y);
     }
 
     void loadFirst() {
@@ -314,6 +370,7 @@ private:
 
     void loadByName(std::string listName) {
         bookmarks.clear();
+        searchDirty = true;
         if (std::find(listNames.begin(), listNames.end(), listName) == listNames.end()) {
             selectedListName = "";
             selectedListId = 0;
@@ -322,28 +379,13 @@ private:
         }
         selectedListId = std::distance(listNames.begin(), std::find(listNames.begin(), listNames.end(), listName));
         selectedListName = listName;
-        config.acquire();
-        for (auto [bmName, bm] : config.conf["lists"][listName]["bookmarks"].items()) {
-            FrequencyBookmark fbm;
-            fbm.frequency = bm["frequency"];
-            fbm.bandwidth = bm["bandwidth"];
-            fbm.mode = bm["mode"];
-            fbm.selected = false;
-            bookmarks[bmName] = fbm;
-        }
-        config.release();
+        bookmarks = bookmarkDB.getLists().at(listName).bookmarks;
     }
 
-    void saveByName(std::string listName) {
-        config.acquire();
-        config.conf["lists"][listName]["bookmarks"] = json::object();
-        for (auto [bmName, bm] : bookmarks) {
-            config.conf["lists"][listName]["bookmarks"][bmName]["frequency"] = bm.frequency;
-            config.conf["lists"][listName]["bookmarks"][bmName]["bandwidth"] = bm.bandwidth;
-            config.conf["lists"][listName]["bookmarks"][bmName]["mode"] = bm.mode;
-        }
-        refreshWaterfallBookmarks(false);
-        config.release(true);
+    // Update what depends on the bookmarks of the selected list after they were edited
+    void bookmarksChanged() {
+        searchDirty = true;
+        refreshWaterfallBookmarks();
     }
 
     static void menuHandler(void* ctx) {
@@ -401,10 +443,8 @@ private:
         if (ImGui::GenericDialog(("freq_manager_del_list_confirm" + _this->name).c_str(), _this->deleteListOpen, GENERIC_DIALOG_BUTTONS_YES_NO, [_this]() {
                 ImGui::Text("Deleting list named \"%s\". Are you sure?", _this->selectedListName.c_str());
             }) == GENERIC_DIALOG_BUTTON_YES) {
-            config.acquire();
-            config.conf["lists"].erase(_this->selectedListName);
-            _this->refreshWaterfallBookmarks(false);
-            config.release(true);
+            bookmarkDB.deleteList(_this->selectedListName);
+            _this->refreshWaterfallBookmarks();
             _this->refreshLists();
             _this->selectedListId = std::clamp<int>(_this->selectedListId, 0, _this->listNames.size());
             if (_this->listNames.size() > 0) {
@@ -480,37 +520,60 @@ private:
         if (ImGui::GenericDialog(("freq_manager_del_list_confirm" + _this->name).c_str(), _this->deleteBookmarksOpen, GENERIC_DIALOG_BUTTONS_YES_NO, [_this]() {
                 ImGui::TextUnformatted("Deleting selected bookmaks. Are you sure?");
             }) == GENERIC_DIALOG_BUTTON_YES) {
-            for (auto& _name : selectedNames) { _this->bookmarks.erase(_name); }
-            _this->saveByName(_this->selectedListName);
+            bookmarkDB.beginBatch();
+            for (auto& _name : selectedNames) {
+                _this->bookmarks.erase(_name);
+                bookmarkDB.removeBookmark(_this->selectedListName, _name);
+            }
+            bookmarkDB.endBatch();
+            _this->bookmarksChanged();
         }
 
-        // Bookmark list
+        // Search
+        ImGui::SetNextItemWidth(menuWidth);
+        if (ImGui::InputTextWithHint(("##_freq_mgr_search_" + _this->name).c_str(), "Search", _this->searchBuf, sizeof(_this->searchBuf))) {
+            _this->searchDirty = true;
+        }
+        if (_this->searchDirty) {
+            bookmarkDB.search(_this->selectedListName, _this->searchBuf, _this->shownNames);
+            _this->searchDirty = false;
+        }
+
+        // Bookmark list, only the visible rows are drawn
         if (ImGui::BeginTable(("freq_manager_bkm_table" + _this->name).c_str(), 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
             ImGui::TableSetupColumn("Name");
             ImGui::TableSetupColumn("Bookmark");
             ImGui::TableSetupScrollFreeze(2, 1);
             ImGui::TableHeadersRow();
-            for (auto& [name, bm] : _this->bookmarks) {
-                ImGui::TableNextRow();
-                ImGui::TableSetColumnIndex(0);
-                ImVec2 min = ImGui::GetCursorPos();
-
-                if (ImGui::Selectable((name + "##_freq_mgr_bkm_name_" + _this->name).c_str(), &bm.selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_SelectOnClick)) {
-                    // if shift or control isn't pressed, deselect all others
-                    if (!ImGui::GetIO().KeyShift && !ImGui::GetIO().KeyCtrl) {
-                        for (auto& [_name, _bm] : _this->bookmarks) {
-                            if (name == _name) { continue; }
-                            _bm.selected = false;
+            ImGuiListClipper clipper;
+            clipper.Begin(_this->shownNames.size());
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    const std::string& name = _this->shownNames[row];
+                    auto it = _this->bookmarks.find(name);
+                    if (it == _this->bookmarks.end()) { continue; }
+                    FrequencyBookmark& bm = it->second;
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImVec2 min = ImGui::GetCursorPos();
+
+                    if (ImGui::Selectable((name + "##_freq_mgr_bkm_name_" + _this->name).c_str(), &bm.selected, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_SelectOnClick)) {
+                        // if shift or control isn't pressed, deselect all others
+                        if (!ImGui::GetIO().KeyShift && !ImGui::GetIO().KeyCtrl) {
+                            for (auto& [_name, _bm] : _this->bookmarks) {
+                                if (name == _name) { continue; }
+                                _bm.selected = false;
+                            }
                         }
                     }
-                }
-                if (ImGui::TableGetHoveredColumn() >= 0 && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
-                    applyBookmark(bm, gui::waterfall.selectedVFO);
-                }
+                    if (ImGui::TableGetHoveredColumn() >= 0 && ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                        applyBookmark(bm, gui::waterfall.selectedVFO);
+                    }
 
-                ImGui::TableSetColumnIndex(1);
-                ImGui::Text("%s %s", utils::formatFreq(bm.frequency).c_str(), demodModeList[bm.mode]);
-                ImVec2 max = ImGui::GetCursorPos();
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%s %s", utils::formatFreq(bm.frequency).c_str(), demodModeList[bm.mode]);
+                    ImVec2 max = ImGui::GetCursorPos();
+                }
             }
             ImGui::EndTable();
         }
@@ -531,18 +594,13 @@ private:
         ImGui::TableSetColumnIndex(0);
         if (ImGui::Button(("Import##_freq_mgr_imp_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0)) && !_this->importOpen) {
             _this->importOpen = true;
-            _this->importDialog = new pfd::open_file("Import bookmarks", "", { "JSON Files (*.json)", "*.json", "All Files", "*" }, pfd::opt::multiselect);
+            _this->importDialog = new pfd::open_file("Import bookmarks", "", { "JSON Files (*.json)", "*.json", "CSV Files (*.csv)", "*.csv", "All Files", "*" }, pfd::opt::multiselect);
         }
 
         ImGui::TableSetColumnIndex(1);
         if (selectedNames.size() == 0 && _this->selectedListName != "") { style::beginDisabled(); }
         if (ImGui::Button(("Export##_freq_mgr_exp_" + _this->name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0)) && !_this->exportOpen) {
-            _this->exportedBookmarks = json::object();
-            config.acquire();
-            for (auto& _name : selectedNames) {
-                _this->exportedBookmarks["bookmarks"][_name] = config.conf["lists"][_this->selectedListName]["bookmarks"][_name];
-            }
-            config.release();
+            _this->exportedNames = selectedNames;
             _this->exportOpen = true;
             _this->exportDialog = new pfd::save_file("Export bookmarks", "", { "JSON Files (*.json)", "*.json", "All Files", "*" });
         }
@@ -606,48 +664,23 @@ private:
         FrequencyManagerModule* _this = (FrequencyManagerModule*)ctx;
         if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_OFF) { return; }
 
-        if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_TOP) {
-            for (auto const bm : _this->waterfallBookmarks) {
-                double centerXpos = args.min.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
-
-                if (bm.bookmark.frequency >= args.lowFreq && bm.bookmark.frequency <= args.highFreq) {
-                    args.window->DrawList->AddLine(ImVec2(centerXpos, args.min.y), ImVec2(centerXpos, args.max.y), IM_COL32(255, 255, 0, 255));
-                }
-
-                ImVec2 nameSize = ImGui::CalcTextSize(bm.bookmarkName.c_str());
-                ImVec2 rectMin = ImVec2(centerXpos - (nameSize.x / 2) - 5, args.min.y);
-                ImVec2 rectMax = ImVec2(centerXpos + (nameSize.x / 2) + 5, args.min.y + nameSize.y);
-                ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.min.x, args.max.x), rectMin.y);
-                ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.min.x, args.max.x), rectMax.y);
-
-                if (clampedRectMax.x - clampedRectMin.x > 0) {
-                    args.window->DrawList->AddRectFilled(clampedRectMin, clampedRectMax, IM_COL32(255, 255, 0, 255));
-                }
-                if (rectMin.x >= args.min.x && rectMax.x <= args.max.x) {
-                    args.window->DrawList->AddText(ImVec2(centerXpos - (nameSize.x / 2), args.min.y), IM_COL32(0, 0, 0, 255), bm.bookmarkName.c_str());
-                }
+        _this->updateVisibleLabels(args.lowFreq, args.highFreq, args.freqToPixelRatio, args.min.x);
+        for (auto const& label : _this->visibleLabels) {
+            double freq = _this->waterfallBookmarks[label.first].bookmark.frequency;
+            if (freq >= args.lowFreq && freq <= args.highFreq) {
+                args.window->DrawList->AddLine(ImVec2(label.centerXpos, args.min.y), ImVec2(label.centerXpos, args.max.y), IM_COL32(255, 255, 0, 255));
             }
-        }
-        else if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) {
-            for (auto const bm : _this->waterfallBookmarks) {
-                double centerXpos = args.min.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
-
-                if (bm.bookmark.frequency >= args.lowFreq && bm.bookmark.frequency <= args.highFreq) {
-                    args.window->DrawList->AddLine(ImVec2(centerXpos, args.min.y), ImVec2(centerXpos, args.max.y), IM_COL32(255, 255, 0, 255));
-                }
 
-                ImVec2 nameSize = ImGui::CalcTextSize(bm.bookmarkName.c_str());
-                ImVec2 rectMin = ImVec2(centerXpos - (nameSize.x / 2) - 5, args.max.y - nameSize.y);
-                ImVec2 rectMax = ImVec2(centerXpos + (nameSize.x / 2) + 5, args.max.y);
-                ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.min.x, args.max.x), rectMin.y);
-                ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.min.x, args.max.x), rectMax.y);
+            ImVec2 rectMin, rectMax;
+            _this->getLabelRect(label, args.min, args.max, rectMin, rectMax);
+            ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.min.x, args.max.x), rectMin.y);
+            ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.min.x, args.max.x), rectMax.y);
 
-                if (clampedRectMax.x - clampedRectMin.x > 0) {
-                    args.window->DrawList->AddRectFilled(clampedRectMin, clampedRectMax, IM_COL32(255, 255, 0, 255));
-                }
-                if (rectMin.x >= args.min.x && rectMax.x <= args.max.x) {
-                    args.window->DrawList->AddText(ImVec2(centerXpos - (nameSize.x / 2), args.max.y - nameSize.y), IM_COL32(0, 0, 0, 255), bm.bookmarkName.c_str());
-                }
+            if (clampedRectMax.x - clampedRectMin.x > 0) {
+                args.window->DrawList->AddRectFilled(clampedRectMin, clampedRectMax, IM_COL32(255, 255, 0, 255));
+            }
+            if (rectMin.x >= args.min.x && rectMax.x <= args.max.x) {
+                args.window->DrawList->AddText(ImVec2(rectMin.x + 5, rectMin.y), IM_COL32(0, 0, 0, 255), label.text.c_str());
             }
         }
     }
@@ -666,49 +699,22 @@ private:
             return;
         }
 
-        // First check that the mouse clicked outside of any label. Also get the bookmark that's hovered
-        bool inALabel = false;
-        WaterfallBookmark hoveredBookmark;
-        std::string hoveredBookmarkName;
-
-        if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_TOP) {
-            int count = _this->waterfallBookmarks.size();
-            for (int i = count - 1; i >= 0; i--) {
-                auto& bm = _this->waterfallBookmarks[i];
-                double centerXpos = args.fftRectMin.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
-                ImVec2 nameSize = ImGui::CalcTextSize(bm.bookmarkName.c_str());
-                ImVec2 rectMin = ImVec2(centerXpos - (nameSize.x / 2) - 5, args.fftRectMin.y);
-                ImVec2 rectMax = ImVec2(centerXpos + (nameSize.x / 2) + 5, args.fftRectMin.y + nameSize.y);
-                ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.fftRectMin.x, args.fftRectMax.x), rectMin.y);
-                ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.fftRectMin.x, args.fftRectMax.x), rectMax.y);
-
-                if (ImGui::IsMouseHoveringRect(clampedRectMin, clampedRectMax)) {
-                    inALabel = true;
-                    hoveredBookmark = bm;
-                    hoveredBookmarkName = bm.bookmarkName;
-                    break;
-                }
-            }
-        }
-        else if (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) {
-            int count = _this->waterfallBookmarks.size();
-            for (int i = count - 1; i >= 0; i--) {
-                auto& bm = _this->waterfallBookmarks[i];
-                double centerXpos = args.fftRectMin.x + std::round((bm.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
-                ImVec2 nameSize = ImGui::CalcTextSize(bm.bookmarkName.c_str());
-                ImVec2 rectMin = ImVec2(centerXpos - (nameSize.x / 2) - 5, args.fftRectMax.y - nameSize.y);
-                ImVec2 rectMax = ImVec2(centerXpos + (nameSize.x / 2) + 5, args.fftRectMax.y);
-                ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.fftRectMin.x, args.fftRectMax.x), rectMin.y);
-                ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.fftRectMin.x, args.fftRectMax.x), rectMax.y);
-
-                if (ImGui::IsMouseHoveringRect(clampedRectMin, clampedRectMax)) {
-                    inALabel = true;
-                    hoveredBookmark = bm;
-                    hoveredBookmarkName = bm.bookmarkName;
-                    break;
-                }
+        // First check that the mouse clicked outside of any label. Also get the label that's hovered, the last drawn one being on top
+        _this->updateVisibleLabels(args.lowFreq, args.highFreq, args.freqToPixelRatio, args.fftRectMin.x);
+        const BookmarkLabel* hoveredLabel = NULL;
+        for (int i = _this->visibleLabels.size() - 1; i >= 0; i--) {
+            auto& label = _this->visibleLabels[i];
+            ImVec2 rectMin, rectMax;
+            _this->getLabelRect(label, args.fftRectMin, args.fftRectMax, rectMin, rectMax);
+            ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.fftRectMin.x, args.fftRectMax.x), rectMin.y);
+            ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.fftRectMin.x, args.fftRectMax.x), rectMax.y);
+
+            if (ImGui::IsMouseHoveringRect(clampedRectMin, clampedRectMax)) {
+                hoveredLabel = &label;
+                break;
             }
         }
+        bool inALabel = (hoveredLabel != NULL);
 
         // Check if mouse was already down
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !inALabel) {
@@ -724,20 +730,35 @@ private:
 
         gui::waterfall.inputHandled = true;
 
-        double centerXpos = args.fftRectMin.x + std::round((hoveredBookmark.bookmark.frequency - args.lowFreq) * args.freqToPixelRatio);
-        ImVec2 nameSize = ImGui::CalcTextSize(hoveredBookmarkName.c_str());
-        ImVec2 rectMin = ImVec2(centerXpos - (nameSize.x / 2) - 5, (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) ? (args.fftRectMax.y - nameSize.y) : args.fftRectMin.y);
-        ImVec2 rectMax = ImVec2(centerXpos + (nameSize.x / 2) + 5, (_this->bookmarkDisplayMode == BOOKMARK_DISP_MODE_BOTTOM) ? args.fftRectMax.y : args.fftRectMin.y + nameSize.y);
-        ImVec2 clampedRectMin = ImVec2(std::clamp<double>(rectMin.x, args.fftRectMin.x, args.fftRectMax.x), rectMin.y);
-        ImVec2 clampedRectMax = ImVec2(std::clamp<double>(rectMax.x, args.fftRectMin.x, args.fftRectMax.x), rectMax.y);
+        // A cluster can't be applied, only list what's in it
+        if (hoveredLabel->count > 1) {
+            if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+                _this->mouseClickedInLabel = true;
+            }
+            ImGui::BeginTooltip();
+            ImGui::Text("%d bookmarks", hoveredLabel->count);
+            ImGui::Separator();
+            int shown = std::min<int>(hoveredLabel->count, MAX_CLUSTER_TOOLTIP_NAMES);
+            for (int i = 0; i < shown; i++) {
+                auto& bm = _this->waterfallBookmarks[hoveredLabel->first + i];
+                ImGui::Text("%s (%s)", bm.bookmarkName.c_str(), utils::formatFreq(bm.bookmark.frequency).c_str());
+            }
+            if (hoveredLabel->count > shown) {
+                ImGui::Text("...");
+            }
+            ImGui::TextUnformatted("Zoom in or use the bookmark list to select one");
+            ImGui::EndTooltip();
+            return;
+        }
 
+        WaterfallBookmark& hoveredBookmark = _this->waterfallBookmarks[hoveredLabel->first];
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
             _this->mouseClickedInLabel = true;
             applyBookmark(hoveredBookmark.bookmark, gui::waterfall.selectedVFO);
         }
 
         ImGui::BeginTooltip();
-        ImGui::TextUnformatted(hoveredBookmarkName.c_str());
+        ImGui::TextUnformatted(hoveredBookmark.bookmarkName.c_str());
         ImGui::Separator();
         ImGui::Text("List: %s", hoveredBookmark.listName.c_str());
         ImGui::Text("Frequency: %s", utils::formatFreq(hoveredBookmark.bookmark.frequency).c_str());
@@ -746,49 +767,24 @@ private:
         ImGui::EndTooltip();
     }
 
-    json exportedBookmarks;
+    std::vector<std::string> exportedNames;
     bool importOpen = false;
     bool exportOpen = false;
     pfd::open_file* importDialog;
     pfd::save_file* exportDialog;
 
     void importBookmarks(std::string path) {
-        std::ifstream fs(path);
-        json importBookmarks;
-        fs >> importBookmarks;
-
-        if (!importBookmarks.contains("bookmarks")) {
-            flog::error("File does not contains any bookmarks");
-            return;
-        }
-
-        if (!importBookmarks["bookmarks"].is_object()) {
-            flog::error("Bookmark attribute is invalid");
-            return;
-        }
-
-        // Load every bookmark
-        for (auto const [_name, bm] : importBookmarks["bookmarks"].items()) {
-            if (bookmarks.find(_name) != bookmarks.end()) {
-                flog::warn("Bookmark with the name '{0}' already exists in list, skipping", _name);
-                continue;
-            }
-            FrequencyBookmark fbm;
-            fbm.frequency = bm["frequency"];
-            fbm.bandwidth = bm["bandwidth"];
-            fbm.mode = bm["mode"];
-            fbm.selected = false;
-            bookmarks[_name] = fbm;
-        }
-        saveByName(selectedListName);
-
-        fs.close();
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        int count = (ext == ".csv") ? bookmarkDB.importCSV(path, selectedListName) : bookmarkDB.importJSON(path, selectedListName);
+        if (count < 0) { return; }
+        flog::info("Imported {} bookmarks from '{}'", count, path);
+        loadByName(selectedListName);
+        refreshWaterfallBookmarks();
     }
 
     void exportBookmarks(std::string path) {
-        std::ofstream fs(path);
-        fs << exportedBookmarks;
-        fs.close();
+        bookmarkDB.exportJSON(path, selectedListName, exportedNames);
     }
 
     std::string name;
@@ -807,6 +803,11 @@ private:
 
     std::map<std::string, FrequencyBookmark> bookmarks;
 
+    // Names of the bookmarks of the selected list matching the search
+    char searchBuf[1024] = "";
+    std::vector<std::string> shownNames;
+    bool searchDirty = true;
+
     std::string editedBookmarkName = "";
     std::string firstEditedBookmarkName = "";
     FrequencyBookmark editedBookmark;
@@ -819,7 +820,15 @@ private:
     std::string editedListName;
     std::string firstEditedListName;
 
+    // Distance in pixels under which bookmarks are merged into one label
+    static constexpr float CLUSTER_DISTANCE = 20.0f;
+    static constexpr int MAX_CLUSTER_TOOLTIP_NAMES = 10;
+
+    // Sorted by frequency
     std::vector<WaterfallBookmark> waterfallBookmarks;
+    std::vector<BookmarkLabel> visibleLabels;
+    float labelFontSize = 0.0f;
+    float maxNameWidth = 0.0f;
 
     int bookmarkDisplayMode = 0;
 };
@@ -828,27 +837,60 @@ MOD_EXPORT void _INIT_() {
     json def = json({});
     def["selectedList"] = "General";
     def["bookmarkDisplayMode"] = BOOKMARK_DISP_MODE_TOP;
-    def["lists"]["General"]["showOnWaterfall"] = true;
-    def["lists"]["General"]["bookmarks"] = json::object();
 
     config.setPath(core::args["root"].s() + "/frequency_manager_config.json");
     config.load(def);
     config.enableAutoSave();
+    bool dbOpen = bookmarkDB.open(core::args["root"].s() + "/frequency_manager_bookmarks.db");
+    if (!dbOpen) { flog::error("Could not open the bookmark database, changes to bookmarks won't be saved"); }
 
     // Check if of list and convert if they're the old type
     config.acquire();
     if (!config.conf.contains("bookmarkDisplayMode")) {
         config.conf["bookmarkDisplayMode"] = BOOKMARK_DISP_MODE_TOP;
     }
-    for (auto [listName, list] : config.conf["lists"].items()) {
-        if (list.contains("bookmarks") && list.contains("showOnWaterfall") && list["showOnWaterfall"].is_boolean()) { continue; }
-        json newList;
-        newList = json::object();
-        newList["showOnWaterfall"] = true;
-        newList["bookmarks"] = list;
-        config.conf["lists"][listName] = newList;
+
+    // Move the lists out of the config into the bookmark database
+    if (config.conf.contains("lists")) {
+        for (auto [listName, list] : config.conf["lists"].items()) {
+            if (list.contains("bookmarks") && list.contains("showOnWaterfall") && list["showOnWaterfall"].is_boolean()) { continue; }
+            json newList;
+            newList = json::object();
+            newList["showOnWaterfall"] = true;
+            newList["bookmarks"] = list;
+            config.conf["lists"][listName] = newList;
+        }
+
+        // Bookmarks already in the database are left alone, so that a migration interrupted before is completed
+        flog::info("Moving bookmark lists from the config to the bookmark database");
+        bookmarkDB.beginBatch();
+        for (auto [listName, list] : config.conf["lists"].items()) {
+            if (!bookmarkDB.listExists(listName)) { bookmarkDB.createList(listName, list["showOnWaterfall"]); }
+            auto& existing = bookmarkDB.getLists().at(listName).bookmarks;
+            for (auto [bmName, bm] : list["bookmarks"].items()) {
+                if (existing.find(bmName) != existing.end()) { continue; }
+                FrequencyBookmark fbm;
+                fbm.frequency = bm["frequency"];
+                fbm.bandwidth = bm["bandwidth"];
+                fbm.mode = bm["mode"];
+                fbm.selected = false;
+                bookmarkDB.setBookmark(listName, bmName, fbm);
+            }
+        }
+
+        // Only drop the lists from the config once they're safely stored, otherwise they stay the reference
+        if (bookmarkDB.endBatch()) {
+            config.conf.erase("lists");
+        }
+        else {
+            flog::error("Could not write the bookmarks to the database, keeping them in the config");
+        }
     }
     config.release(true);
+
+    if (bookmarkDB.getLists().empty()) {
+        bookmarkDB.createList("General");
+    }
 }
 
 MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
@@ -862,4 +904,5 @@ MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
 MOD_EXPORT void _END_() {
     config.disableAutoSave();
     config.save();
+    bookmarkDB.close();
 }
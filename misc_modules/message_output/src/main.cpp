@@ -0,0 +1,544 @@
+#include <utils/net.h>
+#include <imgui.h>
+#include <module.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <utils/optionlist.h>
+#include <utils/flog.h>
+#include <signal_path/signal_path.h>
+#include <gui/dialogs/dialog_box.h>
+#include <core.h>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <stdio.h>
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "message_output",
+    /* Description:     */ "Write the messages decoded by other modules to a file or a socket",
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ -1
+};
+
+ConfigManager config;
+
+#define RECONNECT_INTERVAL_MS   2000
+
+enum Destination {
+    DESTINATION_FILE,
+    DESTINATION_TCP_SERVER,
+    DESTINATION_TCP_CLIENT,
+    DESTINATION_UDP,
+    DESTINATION_UNIX
+};
+
+enum Format {
+    FORMAT_JSON_LINES,
+    FORMAT_BINARY
+};
+
+class MessageOutputModule : public ModuleManager::Instance {
+public:
+    MessageOutputModule(std::string name) {
+        this->name = name;
+
+        // Define destinations
+        destinations.define("File", DESTINATION_FILE);
+        destinations.define("TCP (Server)", DESTINATION_TCP_SERVER);
+        destinations.define("TCP (Client)", DESTINATION_TCP_CLIENT);
+        destinations.define("UDP", DESTINATION_UDP);
+#ifndef _WIN32
+        destinations.define("Unix Socket", DESTINATION_UNIX);
+#endif
+
+        // Define formats
+        formats.define("JSON Lines", FORMAT_JSON_LINES);
+        formats.define("Binary", FORMAT_BINARY);
+
+        // Load config
+        std::string root = (std::string)core::args["root"];
+        std::string pathStr = root + "/messages.jsonl";
+        std::string unixPathStr = "/tmp/sdrpp_messages.sock";
+        bool autoStart = false;
+        config.acquire();
+        if (config.conf[name].contains("destination")) {
+            std::string destStr = config.conf[name]["destination"];
+            if (destinations.keyExists(destStr)) { dest = destinations.value(destinations.keyId(destStr)); }
+        }
+        if (config.conf[name].contains("format")) {
+            std::string formatStr = config.conf[name]["format"];
+            if (formats.keyExists(formatStr)) { format = formats.value(formats.keyId(formatStr)); }
+        }
+        if (config.conf[name].contains("path")) {
+            pathStr = config.conf[name]["path"];
+        }
+        if (config.conf[name].contains("maxFileSize")) {
+            maxFileSize = config.conf[name]["maxFileSize"];
+            maxFileSize = std::max<int>(maxFileSize, 1);
+        }
+        if (config.conf[name].contains("maxFiles")) {
+            maxFiles = config.conf[name]["maxFiles"];
+            maxFiles = std::max<int>(maxFiles, 1);
+        }
+        if (config.conf[name].contains("host")) {
+            std::string hostStr = config.conf[name]["host"];
+            strcpy(hostname, hostStr.c_str());
+        }
+        if (config.conf[name].contains("port")) {
+            port = config.conf[name]["port"];
+            port = std::clamp<int>(port, 1, 65535);
+        }
+        if (config.conf[name].contains("unixPath")) {
+            unixPathStr = config.conf[name]["unixPath"];
+        }
+        if (config.conf[name].contains("running")) {
+            autoStart = config.conf[name]["running"];
+        }
+        config.release();
+        strcpy(path, pathStr.c_str());
+        strcpy(unixPath, unixPathStr.c_str());
+
+        // Set menu IDs
+        destId = destinations.valueId(dest);
+        formatId = formats.valueId(format);
+
+        // Allocate the serialization buffer once, big enough for any message in any format
+        buffer = new uint8_t[std::max<int>(MESSAGE_MAX_JSON_LEN, MESSAGE_MAX_BINARY_LEN)];
+
+        // Start if needed
+        if (autoStart) { start(); }
+
+        // Register menu entry
+        gui::menu.registerEntry(name, menuHandler, this, this);
+    }
+
+    ~MessageOutputModule() {
+        // Un-register menu entry
+        gui::menu.removeEntry(name);
+
+        // Stop output
+        stop();
+
+        // Free buffer
+        delete[] buffer;
+    }
+
+    void postInit() {}
+
+    void enable() {
+        // Restart output if it was running
+        if (wasRunning) { start(); }
+
+        // Mark as running
+        enabled = true;
+    }
+
+    void disable() {
+        // Save running state
+        wasRunning = running;
+
+        // Stop output
+        stop();
+
+        // Mark as disabled
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    void start() {
+        if (running) { return; }
+
+        // Open the file or socket
+        try {
+            if (dest == DESTINATION_FILE) {
+                openFile();
+            }
+            else if (dest == DESTINATION_TCP_SERVER) {
+                // Create listener
+                listener = net::listen(hostname, port);
+
+                // Start listen worker
+                listenWorkerThread = std::thread(&MessageOutputModule::listenWorker, this);
+            }
+            else if (dest == DESTINATION_UDP) {
+                // Open UDP socket
+                connect();
+            }
+            else {
+                // The server might not be up yet, the worker keeps trying to connect
+                try { connect(); }
+                catch (const std::exception& e) {
+                    flog::warn("[MessageOutput] Could not connect yet: {}", e.what());
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            flog::error("[MessageOutput] Could not start output: {}", e.what());
+            errorStr = e.what();
+            showError = true;
+            closeAll();
+            return;
+        }
+
+        // Start receiving messages
+        running = true;
+        sigpath::messageBus.subscribe(&sub);
+        workerThread = std::thread(&MessageOutputModule::worker, this);
+    }
+
+    void stop() {
+        if (!running) { return; }
+
+        // Stop receiving messages
+        sigpath::messageBus.unsubscribe(&sub);
+        running = false;
+        if (workerThread.joinable()) { workerThread.join(); }
+
+        // Close everything
+        closeAll();
+    }
+
+private:
+    static void menuHandler(void* ctx) {
+        MessageOutputModule* _this = (MessageOutputModule*)ctx;
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        // Error message box
+        ImGui::GenericDialog(("##message_output_err_" + _this->name).c_str(), _this->showError, GENERIC_DIALOG_BUTTONS_OK, [=](){
+            ImGui::Text("Error: %s", _this->errorStr.c_str());
+        });
+
+        if (!_this->enabled) { ImGui::BeginDisabled(); }
+
+        if (_this->running) { ImGui::BeginDisabled(); }
+
+        // Destination selector
+        ImGui::LeftLabel("Destination");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##message_output_dest_" + _this->name).c_str(), &_this->destId, _this->destinations.txt)) {
+            _this->dest = _this->destinations.value(_this->destId);
+            config.acquire();
+            config.conf[_this->name]["destination"] = _this->destinations.key(_this->destId);
+            config.release(true);
+        }
+
+        // Format selector
+        ImGui::LeftLabel("Format");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##message_output_format_" + _this->name).c_str(), &_this->formatId, _this->formats.txt)) {
+            _this->format = _this->formats.value(_this->formatId);
+            config.acquire();
+            config.conf[_this->name]["format"] = _this->formats.key(_this->formatId);
+            config.release(true);
+        }
+
+        if (_this->dest == DESTINATION_FILE) {
+            // File path and rotation
+            ImGui::LeftLabel("Path");
+            ImGui::FillWidth();
+            if (ImGui::InputText(("##message_output_path_" + _this->name).c_str(), _this->path, sizeof(_this->path))) {
+                config.acquire();
+                config.conf[_this->name]["path"] = _this->path;
+                config.release(true);
+            }
+            ImGui::LeftLabel("Max file size (MB)");
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##message_output_max_size_" + _this->name).c_str(), &_this->maxFileSize)) {
+                _this->maxFileSize = std::max<int>(_this->maxFileSize, 1);
+                config.acquire();
+                config.conf[_this->name]["maxFileSize"] = _this->maxFileSize;
+                config.release(true);
+            }
+            ImGui::LeftLabel("Files kept");
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##message_output_max_files_" + _this->name).c_str(), &_this->maxFiles)) {
+                _this->maxFiles = std::max<int>(_this->maxFiles, 1);
+                config.acquire();
+                config.conf[_this->name]["maxFiles"] = _this->maxFiles;
+                config.release(true);
+            }
+        }
+        else if (_this->dest == DESTINATION_UNIX) {
+            // Socket path
+            ImGui::LeftLabel("Socket path");
+            ImGui::FillWidth();
+            if (ImGui::InputText(("##message_output_unix_path_" + _this->name).c_str(), _this->unixPath, sizeof(_this->unixPath))) {
+                config.acquire();
+                config.conf[_this->name]["unixPath"] = _this->unixPath;
+                config.release(true);
+            }
+        }
+        else {
+            // Hostname and port field
+            if (ImGui::InputText(("##message_output_host_" + _this->name).c_str(), _this->hostname, sizeof(_this->hostname))) {
+                config.acquire();
+                config.conf[_this->name]["host"] = _this->hostname;
+                config.release(true);
+            }
+            ImGui::SameLine();
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##message_output_port_" + _this->name).c_str(), &_this->port, 0, 0)) {
+                _this->port = std::clamp<int>(_this->port, 1, 65535);
+                config.acquire();
+                config.conf[_this->name]["port"] = _this->port;
+                config.release(true);
+            }
+        }
+
+        if (_this->running) { ImGui::EndDisabled(); }
+
+        // Start/Stop buttons
+        if (_this->running || (!_this->enabled && _this->wasRunning)) {
+            if (ImGui::Button(("Stop##message_output_stop_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
+                _this->stop();
+                config.acquire();
+                config.conf[_this->name]["running"] = false;
+                config.release(true);
+            }
+        }
+        else {
+            if (ImGui::Button(("Start##message_output_start_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
+                _this->start();
+                config.acquire();
+                config.conf[_this->name]["running"] = true;
+                config.release(true);
+            }
+        }
+
+        // Status text
+        ImGui::TextUnformatted("Status:");
+        ImGui::SameLine();
+        if (!_this->enabled) {
+            ImGui::TextUnformatted("Disabled");
+        }
+        else if (!_this->running) {
+            ImGui::TextUnformatted("Idle");
+        }
+        else if (_this->connected) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), (_this->dest == DESTINATION_FILE) ? "Writing" : "Sending");
+        }
+        else if (_this->dest == DESTINATION_TCP_SERVER) {
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Listening");
+        }
+        else {
+            ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Connecting");
+        }
+        ImGui::Text("Messages: %llu (%llu dropped)", (unsigned long long)_this->written, (unsigned long long)_this->sub.getDropped());
+
+        if (!_this->enabled) { ImGui::EndDisabled(); }
+    }
+
+    void worker() {
+        auto lastConnect = std::chrono::steady_clock::now();
+        while (running) {
+            // Retry connecting to the server if needed
+            if ((dest == DESTINATION_TCP_CLIENT || dest == DESTINATION_UNIX) && !connected) {
+                auto now = std::chrono::steady_clock::now();
+                if (now - lastConnect >= std::chrono::milliseconds(RECONNECT_INTERVAL_MS)) {
+                    lastConnect = now;
+                    try { connect(); }
+                    catch (const std::exception& e) {}
+                }
+            }
+
+            // Wait for messages
+            if (!sub.wait(100)) { continue; }
+
+            // Write all pending messages, messages are dropped while there is nowhere to send them
+            const DecodedMessage* msg;
+            while ((msg = sub.read()) != NULL) {
+                int len = (format == FORMAT_JSON_LINES) ? msg->toJSON((char*)buffer, MESSAGE_MAX_JSON_LEN) : msg->toBinary(buffer, MESSAGE_MAX_BINARY_LEN);
+                if (dest == DESTINATION_FILE) {
+                    writeFile(buffer, len);
+                }
+                else {
+                    sendAll(buffer, len);
+                }
+            }
+            if (file) { fflush(file); }
+        }
+    }
+
+    void listenWorker() {
+        while (true) {
+            // Accept a client
+            auto newSock = listener->accept();
+            if (!newSock) { break; }
+
+            // Update socket
+            std::lock_guard lck(sockMtx);
+            sock = newSock;
+            connected = true;
+        }
+    }
+
+    void connect() {
+        std::shared_ptr<net::Socket> newSock;
+        if (dest == DESTINATION_TCP_CLIENT) {
+            newSock = net::connect(hostname, port);
+        }
+        else if (dest == DESTINATION_UDP) {
+            newSock = net::openudp(hostname, port, "0.0.0.0", 0, true);
+        }
+#ifndef _WIN32
+        else if (dest == DESTINATION_UNIX) {
+            newSock = net::connectUnix(unixPath);
+        }
+#endif
+        std::lock_guard lck(sockMtx);
+        sock = newSock;
+        connected = (bool)sock;
+    }
+
+    void sendAll(const uint8_t* data, int len) {
+        std::lock_guard lck(sockMtx);
+        if (!sock) { return; }
+
+        // Datagrams are sent whole, streams may need several writes on a non-blocking socket
+        int sent = 0;
+        while (sent < len && sock->isOpen() && running) {
+            int ret = sock->send(&data[sent], len - sent);
+            if (ret > 0) {
+                sent += ret;
+                if (sock->type() == net::SOCKET_TYPE_UDP) { break; }
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        if (sent) { written++; }
+
+        // Forget the socket once the remote end is gone
+        if (!sock->isOpen()) {
+            sock.reset();
+            connected = false;
+        }
+    }
+
+    void openFile() {
+        file = fopen(path, "ab");
+        if (!file) { throw std::runtime_error("Could not open file"); }
+        fileSize = ftell(file);
+        connected = true;
+    }
+
+    void writeFile(const uint8_t* data, int len) {
+        if (!file) { return; }
+        fwrite(data, 1, len, file);
+        fileSize += len;
+        written++;
+
+        // Rotate once the file reaches its maximum size, path.1 being the newest of the previous files
+        if (fileSize < (int64_t)maxFileSize * 1000000) { return; }
+        fclose(file);
+        file = NULL;
+        std::error_code ec;
+        std::string base = path;
+        std::filesystem::remove(base + "." + std::to_string(maxFiles - 1), ec);
+        for (int i = maxFiles - 2; i >= 1; i--) {
+            std::filesystem::rename(base + "." + std::to_string(i), base + "." + std::to_string(i + 1), ec);
+        }
+        if (maxFiles > 1) {
+            std::filesystem::rename(base, base + ".1", ec);
+        }
+        else {
+            std::filesystem::remove(base, ec);
+        }
+        try {
+            openFile();
+        }
+        catch (const std::exception& e) {
+            flog::error("[MessageOutput] Could not reopen '{}' after rotating it", base);
+            connected = false;
+        }
+    }
+
+    void closeAll() {
+        // Stop listener
+        if (listener) {
+            listener->stop();
+            if (listenWorkerThread.joinable()) { listenWorkerThread.join(); }
+            listener.reset();
+        }
+
+        // Close socket and free it
+        {
+            std::lock_guard lck(sockMtx);
+            if (sock) {
+                sock->close();
+                sock.reset();
+            }
+        }
+
+        // Close file
+        if (file) {
+            fclose(file);
+            file = NULL;
+        }
+
+        connected = false;
+    }
+
+    std::string name;
+    bool enabled = true;
+
+    Destination dest = DESTINATION_FILE;
+    int destId;
+    Format format = FORMAT_JSON_LINES;
+    int formatId;
+    char path[4096];
+    int maxFileSize = 10;
+    int maxFiles = 5;
+    char hostname[1024] = "localhost";
+    int port = 4321;
+    char unixPath[1024];
+    std::atomic<bool> running = false;
+    bool wasRunning = false;
+
+    bool showError = false;
+    std::string errorStr = "";
+
+    OptionList<std::string, Destination> destinations;
+    OptionList<std::string, Format> formats;
+
+    MessageSubscriber sub;
+    std::thread workerThread;
+    uint8_t* buffer = NULL;
+    std::atomic<uint64_t> written = 0;
+    std::atomic<bool> connected = false;
+
+    FILE* file = NULL;
+    int64_t fileSize = 0;
+
+    std::thread listenWorkerThread;
+
+    std::mutex sockMtx;
+    std::shared_ptr<net::Socket> sock;
+    std::shared_ptr<net::Listener> listener;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    std::string root = (std::string)core::args["root"];
+    config.setPath(root + "/message_output_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new MessageOutputModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
+    delete (MessageOutputModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
@@ -153,7 +153,7 @@ private:
 
                 // Check if we are waiting for a tune
                 if (tuning) {
-                    flog::warn("Tuning");
+                    FLOG_WARN("Tuning");
                     if ((std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTuneTime)).count() > tuningTime) {
                         tuning = false;
                     }
@@ -175,7 +175,7 @@ private:
                 double vfoWidth = sigpath::vfoManager.getBandwidth(gui::waterfall.selectedVFO);
 
                 if (receiving) {
-                    flog::warn("Receiving");
+                    FLOG_WARN("Receiving");
                 
                     float maxLevel = getMaxLevel(data, current, vfoWidth, dataWidth, wfStart, wfWidth);
                     if (maxLevel >= level) {
@@ -186,7 +186,7 @@ private:
                     }
                 }
                 else {
-                    flog::warn("Seeking signal");
+                    FLOG_LIMITED(flog::TYPE_WARNING, "Seeking signal");
                     double bottomLimit = current;
                     double topLimit = current;
                     
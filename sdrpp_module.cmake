@@ -15,5 +15,8 @@ set_target_properties(${PROJECT_NAME} PROPERTIES PREFIX "")
 # Set compile arguments
 target_compile_options(${PROJECT_NAME} PRIVATE ${SDRPP_MODULE_COMPILER_FLAGS})
 
+# Tag the messages logged through the FLOG_* macros with the module name
+target_compile_definitions(${PROJECT_NAME} PRIVATE FLOG_SOURCE="${PROJECT_NAME}")
+
 # Install directives
 install(TARGETS ${PROJECT_NAME} DESTINATION lib/sdrpp/plugins)
\ No newline at end of file
@@ -3,8 +3,6 @@
 #include <gui/gui.h>
 #include <signal_path/signal_path.h>
 #include <signal_path/sink.h>
-#include <dsp/buffer/packer.h>
-#include <dsp/convert/stereo_to_mono.h>
 #include <utils/flog.h>
 #include <RtAudio.h>
 #include <config.h>
@@ -27,9 +25,9 @@ public:
     AudioSink(SinkManager::Stream* stream, std::string streamName) {
         _stream = stream;
         _streamName = streamName;
-        s2m.init(_stream->sinkOut);
-        monoPacker.init(&s2m.out, 512);
-        stereoPacker.init(_stream->sinkOut, 512);
+
+        // The device runs on its own clock, let the stream compensate the drift
+        _stream->enableDriftCompensation(0.05);
 
 #if RTAUDIO_VERSION_MAJOR >= 6
         audio.setErrorCallback(&errorCallback);
@@ -135,9 +133,8 @@ public:
             srId = defaultId;
         }
 
-        _stream->setSampleRate(sampleRate);
-
         if (running) { doStop(); }
+        _stream->setSampleRate(sampleRate);
         if (running) { doStart(); }
     }
 
@@ -155,11 +152,9 @@ public:
         ImGui::SetNextItemWidth(menuWidth);
         if (ImGui::Combo(("##_audio_sink_sr_" + _streamName).c_str(), &srId, sampleRatesTxt.c_str())) {
             sampleRate = sampleRates[srId];
+            if (running) { doStop(); }
             _stream->setSampleRate(sampleRate);
-            if (running) {
-                doStop();
-                doStart();
-            }
+            if (running) { doStart(); }
             config.acquire();
             config.conf[_streamName]["devices"][devList[devId].name] = sampleRate;
             config.release(true);
@@ -187,16 +182,17 @@ private:
         RtAudio::StreamParameters parameters;
         parameters.deviceId = deviceIds[devId];
         parameters.nChannels = 2;
-        unsigned int bufferFrames = sampleRate / 60;
+        unsigned int bufferFrames = _stream->getDeviceBufferSize();
         RtAudio::StreamOptions opts;
         opts.flags = RTAUDIO_MINIMIZE_LATENCY;
         opts.streamName = _streamName;
 
         try {
             audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &bufferFrames, &callback, this, &opts);
-            stereoPacker.setSampleCount(bufferFrames);
             audio.startStream();
-            stereoPacker.start();
+
+            // The backend may have picked a different buffer size
+            _stream->setHopLatency("Device", (double)bufferFrames / (double)sampleRate);
         }
         catch (const std::exception& e) {
             flog::error("Could not open audio device {0}", e.what());
@@ -208,31 +204,17 @@ private:
     }
 
     void doStop() {
-        s2m.stop();
-        monoPacker.stop();
-        stereoPacker.stop();
-        monoPacker.out.stopReader();
-        stereoPacker.out.stopReader();
         audio.stopStream();
         audio.closeStream();
-        monoPacker.out.clearReadStop();
-        stereoPacker.out.clearReadStop();
     }
 
     static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
         AudioSink* _this = (AudioSink*)userData;
-        int count = _this->stereoPacker.out.read();
-        if (count < 0) { return 0; }
-
-        memcpy(outputBuffer, _this->stereoPacker.out.readBuf, nBufferFrames * sizeof(dsp::stereo_t));
-        _this->stereoPacker.out.flush();
+        _this->_stream->readAudio((dsp::stereo_t*)outputBuffer, nBufferFrames);
         return 0;
     }
 
     SinkManager::Stream* _stream;
-    dsp::convert::StereoToMono s2m;
-    dsp::buffer::Packer<float> monoPacker;
-    dsp::buffer::Packer<dsp::stereo_t> stereoPacker;
 
     std::string _streamName;
 
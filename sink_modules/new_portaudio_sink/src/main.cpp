@@ -4,8 +4,6 @@
 #include <signal_path/signal_path.h>
 #include <signal_path/sink.h>
 #include <portaudio.h>
-#include <dsp/buffer/packer.h>
-#include <dsp/convert/stereo_to_mono.h>
 #include <utils/flog.h>
 #include <config.h>
 #include <algorithm>
@@ -13,8 +11,8 @@
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
-#define BLOCK_SIZE_DIVIDER 60
 #define AUDIO_LATENCY      1.0 / 60.0
+#define STREAM_LATENCY     0.05
 
 SDRPP_MOD_INFO{
     /* Name:            */ "new_portaudio_sink",
@@ -51,14 +49,9 @@ public:
         std::string selected = config.conf[_streamName]["device"];
         config.release(true);
 
-        // Register the play state handler
-        playStateHandler.handler = playStateChangeHandler;
-        playStateHandler.ctx = this;
-        gui::mainWindow.onPlayStateChange.bindHandler(&playStateHandler);
-
-        // Initialize DSP blocks
-        packer.init(_stream->sinkOut, 1024);
-        s2m.init(&packer.out);
+        // Pull audio from the stream's drift compensator, the device runs on its own clock
+        _stream->enableDriftCompensation(STREAM_LATENCY);
+        monoBuf = dsp::buffer::alloc<dsp::stereo_t>(STREAM_BUFFER_SIZE);
 
         // Refresh devices and select the one from the config
         refreshDevices();
@@ -67,7 +60,7 @@ public:
 
     ~AudioSink() {
         stop();
-        gui::mainWindow.onPlayStateChange.unbindHandler(&playStateHandler);
+        dsp::buffer::free(monoBuf);
     }
 
     void start() {
@@ -76,28 +69,18 @@ public:
         // Get device and samplerate
         AudioDevice_t& dev = devices[deviceNames[devId]];
         double sampleRate = dev.sampleRates[srId];
-        int blockSize = sampleRate / BLOCK_SIZE_DIVIDER;
 
         // Set the SDR++ stream sample rate
         _stream->setSampleRate(sampleRate);
-
-        // Update the block size on the packer
-        packer.setSampleCount(blockSize);
-
-        // Clear read stop signals
-        packer.out.clearReadStop();
-        s2m.out.clearReadStop();
+        int blockSize = _stream->getDeviceBufferSize();
 
         // Open the stream
         PaError err;
         if (dev.deviceInfo->maxOutputChannels == 1) {
-            packer.start();
-            s2m.start();
             stereo = false;
             err = Pa_OpenStream(&devStream, NULL, &dev.outputParams, sampleRate, blockSize, paNoFlag, _mono_cb, this);
         }
         else {
-            packer.start();
             stereo = true;
             err = Pa_OpenStream(&devStream, NULL, &dev.outputParams, sampleRate, blockSize, paNoFlag, _stereo_cb, this);
         }
@@ -110,6 +93,10 @@ public:
 
         flog::info("Starting PortAudio stream at {0} S/s", sampleRate);
 
+        // Report the latency of the device, PortAudio knows better than the block size
+        const PaStreamInfo* info = Pa_GetStreamInfo(devStream);
+        _stream->setHopLatency("Device", info ? info->outputLatency : ((double)blockSize / sampleRate));
+
         // Start stream
         Pa_StartStream(devStream);
 
@@ -119,14 +106,6 @@ public:
     void stop() {
         if (!running || selectedDevName.empty()) { return; }
 
-        // Send stop signal to the streams
-        packer.out.stopReader();
-        s2m.out.stopReader();
-
-        // Stop DSP
-        packer.stop();
-        s2m.stop();
-
         // Stop stream
         Pa_AbortStream(devStream);
 
@@ -170,28 +149,6 @@ public:
     bool stereo = false;
 
 private:
-    static void playStateChangeHandler(bool newState, void* ctx) {
-        AudioSink* _this = (AudioSink*)ctx;
-
-        // Wake up reader to send nulls instead of data in preparation for shutoff
-        if (newState) {
-            if (_this->stereo) {
-                _this->packer.out.stopReader();
-            }
-            else {
-                _this->s2m.out.stopReader();
-            }
-        }
-        else {
-            if (_this->stereo) {
-                _this->packer.out.clearReadStop();
-            }
-            else {
-                _this->s2m.out.clearReadStop();
-            }
-        }
-    }
-
     void refreshDevices() {
         // Clear current list
         devices.clear();
@@ -334,14 +291,15 @@ private:
         // For OSX, mute audio when not playing
         if (!gui::mainWindow.isPlaying()) {
             memset(output, 0, frameCount * sizeof(float));
-            _this->s2m.out.flush();
             return 0;
         }
 
         // Write to buffer
-        _this->s2m.out.read();
-        memcpy(output, _this->s2m.out.readBuf, frameCount * sizeof(float));
-        _this->s2m.out.flush();
+        float* out = (float*)output;
+        _this->_stream->readAudio(_this->monoBuf, frameCount);
+        for (int i = 0; i < frameCount; i++) {
+            out[i] = (_this->monoBuf[i].l + _this->monoBuf[i].r) / 2.0f;
+        }
         return 0;
     }
 
@@ -352,14 +310,11 @@ private:
         // For OSX, mute audio when not playing
         if (!gui::mainWindow.isPlaying()) {
             memset(output, 0, frameCount * sizeof(dsp::stereo_t));
-            _this->packer.out.flush();
             return 0;
         }
 
         // Write to buffer
-        _this->packer.out.read();
-        memcpy(output, _this->packer.out.readBuf, frameCount * sizeof(dsp::stereo_t));
-        _this->packer.out.flush();
+        _this->_stream->readAudio((dsp::stereo_t*)output, frameCount);
         return 0;
     }
 
@@ -374,12 +329,9 @@ private:
     std::string selectedDevName;
 
     SinkManager::Stream* _stream;
-    dsp::buffer::Packer<dsp::stereo_t> packer;
-    dsp::convert::StereoToMono s2m;
+    dsp::stereo_t* monoBuf;
 
     PaStream* devStream;
-
-    EventHandler<bool> playStateHandler;
 };
 
 class AudioSinkModule : public ModuleManager::Instance {
@@ -75,41 +75,72 @@ namespace server {
         }
 
         if (!diffId.empty()) {
-            // Save ID
-            SmGui::DrawListElem elemId;
-            elemId.type = SmGui::DRAW_LIST_ELEM_TYPE_STRING;
-            elemId.str = diffId;
-
-            // Encore packet
-            int size = 0;
-            s_cmd_data[size++] = syncRequired;
-            size += SmGui::DrawList::storeItem(elemId, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
-            size += SmGui::DrawList::storeItem(diffValue, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
-
-            // Send
             if (syncRequired) {
+                // Actions must reach the server in order
+                flushUIAction();
+
                 flog::warn("Action requires resync");
                 auto waiter = awaitCommandAck(COMMAND_UI_ACTION);
-                sendCommand(COMMAND_UI_ACTION, size);
+                sendUIAction(diffId, diffValue, true);
+                bool resync = false;
                 if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
-                    std::lock_guard lck(dlMtx);
-                    dl.load(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
+                    resync = !loadUI(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
                 }
                 else {
                     flog::error("Timeout out after asking for UI");
                 }
                 waiter->handled();
+
+                // The update couldn't be applied, get the whole UI again
+                if (resync) { getUI(); }
                 flog::warn("Resync done");
             }
+            else if (diffValue.type == SmGui::DRAW_LIST_ELEM_TYPE_INT || diffValue.type == SmGui::DRAW_LIST_ELEM_TYPE_FLOAT ||
+                     diffValue.type == SmGui::DRAW_LIST_ELEM_TYPE_STRING) {
+                // Dragging a slider changes its value every frame, only the latest one needs to be sent
+                if (!pendingId.empty() && pendingId != diffId) { flushUIAction(); }
+                pendingId = diffId;
+                pendingValue = diffValue;
+            }
             else {
-                flog::warn("Action does not require resync");
-                sendCommand(COMMAND_UI_ACTION, size);
+                // Clicks can't be merged
+                flushUIAction();
+                sendUIAction(diffId, diffValue, false);
             }
         }
+
+        // Send the latest value once the value stopped changing or enough time has passed since the last action
+        if (!pendingId.empty() && (diffId.empty() || std::chrono::steady_clock::now() - lastActionTime >= std::chrono::milliseconds(UI_BATCH_INTERVAL_MS))) {
+            flushUIAction();
+        }
+    }
+
+    void Client::sendUIAction(const std::string& id, SmGui::DrawListElem& value, bool sendback) {
+        // Save ID
+        SmGui::DrawListElem elemId;
+        elemId.type = SmGui::DRAW_LIST_ELEM_TYPE_STRING;
+        elemId.str = id;
+
+        // Encode packet
+        int size = 0;
+        s_cmd_data[size++] = sendback;
+        size += SmGui::DrawList::storeItem(elemId, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
+        size += SmGui::DrawList::storeItem(value, &s_cmd_data[size], SERVER_MAX_PACKET_SIZE - size);
+
+        // Send
+        sendCommand(COMMAND_UI_ACTION, size);
+        lastActionTime = std::chrono::steady_clock::now();
+    }
+
+    void Client::flushUIAction() {
+        if (pendingId.empty()) { return; }
+        if (isOpen()) { sendUIAction(pendingId, pendingValue, false); }
+        pendingId.clear();
     }
 
     void Client::setFrequency(double freq) {
         if (!isOpen()) { return; }
+        flushUIAction();
         *(double*)s_cmd_data = freq;
         sendCommand(COMMAND_SET_FREQUENCY, sizeof(double));
         auto waiter = awaitCommandAck(COMMAND_SET_FREQUENCY);
@@ -123,29 +154,36 @@ namespace server {
 
     void Client::setSampleType(dsp::compression::PCMType type) {
         if (!isOpen()) { return; }
+        flushUIAction();
         s_cmd_data[0] = type;
         sendCommand(COMMAND_SET_SAMPLE_TYPE, 1);
     }
 
     void Client::setCompression(bool enabled) {
         if (!isOpen()) { return; }
+        flushUIAction();
          s_cmd_data[0] = enabled;
         sendCommand(COMMAND_SET_COMPRESSION, 1);
     }
 
     void Client::start() {
         if (!isOpen()) { return; }
+        flushUIAction();
         sendCommand(COMMAND_START, 0);
         getUI();
     }
 
     void Client::stop() {
         if (!isOpen()) { return; }
+        flushUIAction();
         sendCommand(COMMAND_STOP, 0);
         getUI();
     }
 
     void Client::close() {
+        // The last value set in the menu must reach the server before disconnecting
+        flushUIAction();
+
         // Stop worker
         decompIn.stopWriter();
         if (sock) { sock->close(); }
@@ -183,6 +221,9 @@ namespace server {
                     currentSampleRate = *(double*)r_cmd_data;
                     core::setInputSampleRate(currentSampleRate);
                 }
+                else if (r_cmd_hdr->cmd == COMMAND_SET_UI_PROTOCOL && r_pkt_hdr->size == sizeof(PacketHeader) + sizeof(CommandHeader) + 1) {
+                    uiProtocol = (UIProtocol)r_cmd_data[0];
+                }
                 else if (r_cmd_hdr->cmd == COMMAND_DISCONNECT) {
                     flog::error("Asked to disconnect by the server");
                     serverBusy = true;
@@ -237,11 +278,18 @@ namespace server {
 
     int Client::getUI() {
         if (!isOpen()) { return -1; }
+
+        // A value sent after the reply would be overwritten by it
+        flushUIAction();
+
+        // Announce the highest UI protocol supported, the server switches to it with COMMAND_SET_UI_PROTOCOL
         auto waiter = awaitCommandAck(COMMAND_GET_UI);
-        sendCommand(COMMAND_GET_UI, 0);
+        s_cmd_data[0] = UI_PROTOCOL_VERSION;
+        sendCommand(COMMAND_GET_UI, 1);
         if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
-            std::lock_guard lck(dlMtx);
-            dl.load(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
+            if (!loadUI(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader))) {
+                flog::error("Invalid UI received from the server");
+            }
         }
         else {
             if (!serverBusy) { flog::error("Timeout out after asking for UI"); };
@@ -252,6 +300,37 @@ namespace server {
         return 0;
     }
 
+    bool Client::loadUI(uint8_t* data, int len) {
+        std::lock_guard lck(dlMtx);
+        if (uiProtocol != UI_PROTOCOL_DELTA) {
+            return dl.load(data, len) >= 0;
+        }
+
+        // Parse update header
+        if (len < sizeof(UIUpdateHeader)) { return false; }
+        UIUpdateHeader* hdr = (UIUpdateHeader*)data;
+        uint8_t* payload = &data[sizeof(UIUpdateHeader)];
+        int payloadLen = len - sizeof(UIUpdateHeader);
+
+        if (hdr->type == UI_UPDATE_FULL) {
+            if (dl.load(payload, payloadLen) < 0) { return false; }
+        }
+        else if (hdr->type == UI_UPDATE_DELTA) {
+            // A delta only applies to the list it was computed from, eg. a reply that timed out was missed
+            if (hdr->baseVersion != uiVersion) {
+                flog::warn("UI update is based on version {0} instead of {1}, resyncing", hdr->baseVersion, uiVersion);
+                return false;
+            }
+            if (dl.loadDelta(payload, payloadLen) < 0) { return false; }
+        }
+        else {
+            return false;
+        }
+
+        uiVersion = hdr->version;
+        return true;
+    }
+
     void Client::sendPacket(PacketType type, int len) {
         s_pkt_hdr->type = type;
         s_pkt_hdr->size = sizeof(PacketHeader) + len;
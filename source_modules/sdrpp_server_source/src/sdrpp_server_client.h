@@ -16,6 +16,9 @@
 
 #define PROTOCOL_TIMEOUT_MS             10000
 
+// Minimum time between two UI actions sent while a value is being dragged
+#define UI_BATCH_INTERVAL_MS            50
+
 namespace server {
     class PacketWaiter {
     public:
@@ -103,6 +106,9 @@ namespace server {
         void worker();
 
         int getUI();
+        bool loadUI(uint8_t* data, int len);
+        void sendUIAction(const std::string& id, SmGui::DrawListElem& value, bool sendback);
+        void flushUIAction();
 
         void sendPacket(PacketType type, int len);
         void sendCommand(Command cmd, int len);
@@ -137,6 +143,15 @@ namespace server {
         SmGui::DrawList dl;
         std::mutex dlMtx;
 
+        // UI sync state, see UIUpdateHeader
+        UIProtocol uiProtocol = UI_PROTOCOL_FULL;
+        uint32_t uiVersion = 0;
+
+        // Latest value of the widget being dragged, not sent yet
+        std::string pendingId;
+        SmGui::DrawListElem pendingValue;
+        std::chrono::steady_clock::time_point lastActionTime;
+
         ZSTD_DCtx* dctx;
 
         std::thread workerThread;